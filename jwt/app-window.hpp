@@ -34,6 +34,8 @@ namespace jwt {
 
     AppWindow();
 
+    using CustomWindow<AppWindow>::On;
+
     template<typename Callable>
     auto On(const CloseTag&, Callable c) -> decltype(onClose_.connect(c)) {
       return onClose_.connect(c);
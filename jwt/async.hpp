@@ -0,0 +1,121 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "executor.hpp"
+#include "task.hpp"
+#include "window.hpp"
+
+/**
+ * @file
+ *
+ * async.hpp connects tasks (see task.hpp) to the rest of JWT:
+ * - WorkerPool, an Executor backed by the Windows thread pool
+ * - Spawn(Window&, ...), which runs a task on behalf of a window
+ *
+ * Together they let a handler do background work without nesting callbacks:
+ * ~~~~~~{.cpp}
+ * button.On(Click, [&]() {
+ *   Spawn(dlg, [&]() -> Task<> {
+ *     SetEnabled(button, false);
+ *
+ *     co_await SwitchToWorker();
+ *     std::wstring text = LoadReport();      // on a pool thread
+ *
+ *     co_await SwitchTo(dlg);                // back on dlg's thread
+ *     SetText(edit, text);
+ *     SetEnabled(button, true);
+ *   });
+ * });
+ * ~~~~~~
+ * If dlg is destroyed while the report is loading, `co_await SwitchTo(dlg)`
+ * throws TaskCancelled instead of resuming, the task unwinds & nothing
+ * touches the destroyed controls. SwitchTo(dlg) doesn't touch dlg itself
+ * either: the task was spawned for dlg, so it already holds dlg's pump.
+ */
+
+namespace jwt {
+
+  /**
+   * Executor that runs WorkItems on the process-wide Windows thread pool.
+   *
+   * Items must not throw: there is nobody on a pool thread to report to.
+   * Coroutine resumptions never do, since tasks capture their exceptions.
+   */
+  struct WorkerPool
+    : Executor
+  {
+    virtual void Post(WorkItem*);
+  };
+
+  /**
+   * Gets the shared WorkerPool.
+   */
+  WorkerPool& DefaultWorkerPool();
+
+#if JWT_HAS_COROUTINES
+
+  /**
+   * Resumes the current task on a worker thread.
+   */
+  inline ResumeOnAwaiter SwitchToWorker() {
+    return ResumeOn(DefaultWorkerPool());
+  }
+
+  namespace detail {
+    inline Executor& OwningPumpOf(const void* w) {
+      return static_cast<const Window*>(w)->OwningPump();
+    }
+  }
+
+  /**
+   * Resumes the current task on the thread that owns w. Like every hop, it
+   * throws TaskCancelled if the task's token has been cancelled.
+   *
+   * If the task was spawned for w (see Spawn below), w isn't touched: the
+   * task kept w's pump when it was spawned, & w may be gone by now. For any
+   * other window, w's pump is looked up from the calling thread, so w must
+   * be alive there.
+   */
+  inline ResumeOnAwaiter SwitchTo(const Window& w) {
+    return ResumeOnAwaiter(&w, &detail::OwningPumpOf);
+  }
+
+  /**
+   * Starts a task on behalf of w. The task is bound to w.Lifetime(), takes
+   * w's pump as its home (see SwitchTo), & exceptions escaping it (other
+   * than TaskCancelled) are reported to w's pump, so they surface from
+   * Pump() like any other handler exception. Must be called on w's thread.
+   */
+  void Spawn(const Window& w, Task<void> t);
+
+  /**
+   * As above, calling f to create the task; f is usually a coroutine lambda.
+   * f is kept alive until the task finishes, so its captures remain valid
+   * across suspensions.
+   */
+  template<typename Callable>
+  void Spawn(const Window& w, Callable f) {
+    Spawn(w, detail::InvokeOwned(std::move(f)));
+  }
+
+#endif
+
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+/**
+ * @file
+ *
+ * box.hpp contains Box, an integer rectangle for the portable models
+ * (WindowlessModel, SceneGraph) that can't use measurement.hpp's Rect,
+ * which depends on Windows.
+ */
+
+namespace jwt {
+
+  /**
+   * An integer rectangle: (x, y) is the top left, & the right & bottom
+   * edges (x + w, y + h) are outside it. A box with no area is Empty.
+   */
+  struct Box {
+    int x;
+    int y;
+    int w;
+    int h;
+
+    bool Empty() const { return w <= 0 || h <= 0; }
+
+    bool Contains(int px, int py) const {
+      return px >= x && py >= y && px < x + w && py < y + h;
+    }
+
+    bool Intersects(const Box& b) const {
+      return x < b.x + b.w && b.x < x + w && y < b.y + b.h && b.y < y + h;
+    }
+
+    /**
+     * The overlap of the two boxes; Empty if there is none.
+     */
+    Box Intersect(const Box& b) const {
+      int l = (x > b.x) ? x : b.x;
+      int t = (y > b.y) ? y : b.y;
+      int r = (x + w < b.x + b.w) ? x + w : b.x + b.w;
+      int bt = (y + h < b.y + b.h) ? y + h : b.y + b.h;
+
+      Box o = { l, t, r - l, bt - t };
+      if (o.Empty()) {
+        o.w = o.h = 0;
+      }
+      return o;
+    }
+
+    /**
+     * The smallest box containing both; an Empty box adds nothing.
+     */
+    Box Union(const Box& b) const {
+      if (Empty()) {
+        return b;
+      }
+      if (b.Empty()) {
+        return *this;
+      }
+
+      int l = (x < b.x) ? x : b.x;
+      int t = (y < b.y) ? y : b.y;
+      int r = (x + w > b.x + b.w) ? x + w : b.x + b.w;
+      int bt = (y + h > b.y + b.h) ? y + h : b.y + b.h;
+
+      Box u = { l, t, r - l, bt - t };
+      return u;
+    }
+
+    long long Area() const { return (Empty()) ? 0 : (long long) w * h; }
+  };
+
+  inline bool operator== (const Box& a, const Box& b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+  }
+
+  inline bool operator!= (const Box& a, const Box& b) {
+    return !(a == b);
+  }
+
+}
\ No newline at end of file
@@ -23,6 +23,7 @@
 #include "dialog.hpp"
 #include "defer-create.hpp"
 #include "event-types.hpp"
+#include "resources.hpp"
 
 /**
  * @file
@@ -103,6 +104,14 @@ namespace jwt {
      */
     Button(Window& parent, const std::wstring&, DWORD buttonStyles = 0);
 
+    /**
+     * As above, but the HWND isn't created until the button (or the parent
+     * hiding it) is shown or the HWND is needed; until then text, bounds &
+     * style are just recorded. Worth it for pages full of controls that may
+     * never be opened.
+     */
+    Button(const lazy_create_t&, Window& parent, const std::wstring& = L"", DWORD buttonStyles = 0);
+
     /**
      * Creates button wrapper attached to a button within a dialog.
      * The buttonId specifies the control.
@@ -115,6 +124,8 @@ namespace jwt {
      */
     template<typename Callable>
     auto On(const ClickTag&, Callable c) -> decltype(onClick_.connect(c)) {
+      Reflect(REFLECT_COMMAND, true);
+      ReflectOnly<Button>(REFLECT_COMMAND, BN_CLICKED);
       return onClick_.connect(c);
     }
 
@@ -126,7 +137,12 @@ namespace jwt {
     LRESULT HandleReflectedMessage(HWND, UINT, WPARAM, LPARAM);
 
   private:
+    friend Button& SetIcon(Button&, WORD);
+
     boost::signals2::signal<void()> onClick_;
+
+    // Keeps the icon set by SetIcon loaded while the button shows it
+    ResourceRef icon_;
   };
 
 // Split buttons only exist on Vista and later
@@ -164,6 +180,8 @@ namespace jwt {
     auto On(const SecondaryActionTag&, Callable c)
       -> decltype(onDropdown_.connect(c))
     {
+      Reflect(REFLECT_NOTIFY, true);
+      ReflectOnly<SplitButton>(REFLECT_NOTIFY, BCN_DROPDOWN);
       return onDropdown_.connect(c);
     }
 
@@ -179,7 +197,8 @@ namespace jwt {
 
   /**
    * Loads an icon resource from the current module & associates it with
-   * the specified button.
+   * the specified button. The icon comes from the shared resource cache (see
+   * resources.hpp), so many buttons showing the same icon load it once.
    */
   Button& SetIcon(Button&, WORD iconId);
 
@@ -0,0 +1,158 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ *
+ * command-state.hpp contains CommandStateRegistry, which works out which
+ * commands have changed enabled/checked state since they were last pushed
+ * to the UI.
+ *
+ * It has no Windows dependencies; see CommandUpdater for the UI side.
+ */
+
+namespace jwt {
+
+  struct CommandState {
+    bool enabled;
+    bool checked;
+
+    CommandState(bool enabled = true, bool checked = false)
+      : enabled(enabled), checked(checked)
+    {}
+  };
+
+  inline bool operator== (const CommandState& a, const CommandState& b) {
+    return a.enabled == b.enabled && a.checked == b.checked;
+  }
+
+  inline bool operator!= (const CommandState& a, const CommandState& b) {
+    return !(a == b);
+  }
+
+  /**
+   * Maps command ids to providers that compute their state on demand.
+   *
+   * Invalidate() says that the state of some (or all) commands may have
+   * changed; nothing is evaluated until Update(), which calls the provider of
+   * each invalidated command & hands the Sink only the commands whose state
+   * differs from what was last pushed. A burst of model changes therefore
+   * costs one evaluation per command & one push per actual change.
+   * ~~~~~~{.cpp}
+   * registry.Provide(IDM_SAVE, [&]() { return CommandState(doc.Dirty()); });
+   * registry.Provide(IDM_WRAP, [&]() { return CommandState(true, view.Wrap()); });
+   *
+   * doc.OnChange([&]() { registry.Invalidate(IDM_SAVE); });
+   * ...
+   * registry.Update(sink);    // typically when the UI is idle
+   * ~~~~~~
+   * Providers may call Provide, Remove & Invalidate. A command invalidated
+   * during Update after it has been evaluated is evaluated again by the
+   * next Update.
+   */
+  struct CommandStateRegistry {
+    typedef std::function<CommandState()> Provider;
+
+    /**
+     * Receives changed states during Update.
+     */
+    struct Sink {
+      virtual void Push(int id, const CommandState&) = 0;
+
+    protected:
+      ~Sink() {}
+    };
+
+    CommandStateRegistry();
+
+    /**
+     * Sets (or replaces) the provider for id & invalidates it.
+     */
+    void Provide(int id, Provider);
+    void Remove(int id);
+
+    void Invalidate();
+    void Invalidate(int id);
+
+    /**
+     * Returns true if Update has something to evaluate.
+     */
+    bool Pending() const { return allStale_ || !stale_.empty(); }
+
+    /**
+     * Evaluates every invalidated command & pushes those whose state
+     * changed.
+     * @return the number of commands pushed
+     */
+    std::size_t Update(Sink&);
+
+    /**
+     * Forgets what has been pushed, so the next Update pushes every
+     * command. Use it when a new menu or toolbar starts being updated.
+     */
+    void Repush();
+
+    /**
+     * Gets the state last pushed for id.
+     * @return false if id is unknown or hasn't been pushed yet
+     */
+    bool Pushed(int id, CommandState&) const;
+
+    std::size_t Size() const { return entries_.size(); }
+
+    /**
+     * Totals since construction: provider calls & pushes.
+     */
+    std::size_t Evaluations() const { return evaluations_; }
+    std::size_t Pushes() const { return pushes_; }
+
+  private:
+    CommandStateRegistry(const CommandStateRegistry&) = delete;
+    CommandStateRegistry& operator= (const CommandStateRegistry&) = delete;
+
+    struct Entry {
+      int id;
+      std::shared_ptr<const Provider> provider;
+      CommandState last;
+      bool pushed;
+      bool stale;
+    };
+
+    bool Refresh(std::size_t slot, Sink&);
+
+    std::vector<Entry> entries_;
+    std::unordered_map<int, std::size_t> index_;
+
+    // Ids invalidated one at a time; ignored when everything is stale
+    std::vector<int> stale_;
+    std::vector<int> pass_;
+    bool allStale_;
+
+    std::size_t evaluations_;
+    std::size_t pushes_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "command-state.hpp"
+#include "executor.hpp"
+#include "timer-service.hpp"
+#include "window.hpp"
+#include <vector>
+
+namespace jwt {
+
+  struct Toolbar;
+
+  /**
+   * Keeps the enabled/checked state of toolbar buttons & menu items in step
+   * with the application, without pushing anything until the UI is idle.
+   * ~~~~~~{.cpp}
+   * CommandUpdater commands(w.OwningPump());
+   * commands.AttachMenu(w);
+   * commands.AttachToolbar(toolbar);
+   *
+   * commands.Provide(IDM_SAVE, [&]() { return CommandState(doc.Dirty()); });
+   * doc.OnChange([&]() { commands.Invalidate(IDM_SAVE); });
+   * ~~~~~~
+   * Ids are the ones used with On(Command, id, ...). Invalidate schedules a
+   * single update pass that runs once the pump has drained its queue (it
+   * uses a zero-delay timer, see TimerService); however many invalidations
+   * arrive first, each command's provider is called once & only commands
+   * whose state actually changed are sent to the targets.
+   *
+   * Attached windows are dropped automatically when they are destroyed.
+   * HMENUs attached with AttachMenu(HMENU) must be detached before they are
+   * destroyed.
+   */
+  struct CommandUpdater {
+    explicit CommandUpdater(MessagePump&);
+    ~CommandUpdater();
+
+    template<typename Callable>
+    void Provide(int id, Callable c) {
+      registry_.Provide(id, c);
+      Schedule();
+    }
+
+    void Remove(int id) { registry_.Remove(id); }
+
+    void Invalidate();
+    void Invalidate(int id);
+
+    /**
+     * Runs the update pass now rather than waiting for the pump to idle.
+     */
+    void Update();
+
+    /**
+     * Targets. Attaching one pushes every command to all targets on the
+     * next pass; a fresh target doesn't know anything has been pushed.
+     */
+    void AttachToolbar(Toolbar&);
+    void AttachMenu(Window&);
+    void AttachMenu(HMENU);
+
+    void Detach(const Window&);
+    void Detach(HMENU);
+
+    const CommandStateRegistry& Registry() const { return registry_; }
+
+  private:
+    CommandUpdater(const CommandUpdater&) = delete;
+    CommandUpdater& operator= (const CommandUpdater&) = delete;
+
+    struct Pusher;
+    friend struct Pusher;
+
+    struct WindowTarget {
+      Window* window;
+      CancellationToken alive;
+      bool menuBar;           // else a toolbar
+    };
+
+    void Attached();
+    void Schedule();
+
+    MessagePump& pump_;
+    CommandStateRegistry registry_;
+    TimerService::TimerId pass_;
+
+    std::vector<WindowTarget> windows_;
+    std::vector<HMENU> menus_;
+  };
+
+}
\ No newline at end of file
@@ -25,9 +25,17 @@ namespace jwt {
 
   template<typename UniqueTag>
   CustomWindow<UniqueTag>::~CustomWindow() {
-    if (GetWindowLongPtr(hWnd_, GWLP_USERDATA)) {
+    if (hWnd_ && GetWindowLongPtr(hWnd_, GWLP_USERDATA) == (LONG_PTR) this) {
+      // Detach before queueing: the window is destroyed after the current
+      // dispatch (see MessagePump::DestroyLater) & until then gets default
+      // handling only, so nothing reaches this half-destroyed wrapper. Its
+      // WM_DESTROY won't come through PrivateWndProc either, so do that
+      // bookkeeping now.
       SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) nullptr);
-      DestroyWindow(hWnd_);
+      ForgetWaitingOn(hWnd_);
+      OwningPump().Shortcuts().RemoveTarget((std::uintptr_t) hWnd_);
+
+      OwningPump().DestroyLater(hWnd_);
     }
   }
 
@@ -76,8 +84,11 @@ namespace jwt {
         // app != nullptr means that DestroyWindow was called externally
         // Set GWL_USERDATA to nullptr to make the destructor aware that it doesn't need to
         // destroy the window itself
+        //
+        // The wrapper is deleted after the current dispatch rather than here,
+        // since we may be inside one of its own handlers
         SetWindowLongPtr(h, GWLP_USERDATA, (LONG_PTR) nullptr);
-        delete wnd;
+        wnd->OwningPump().DeleteLater(wnd);
       }
       else {
         // app == nullptr means that this message was triggered from the destructor
@@ -104,12 +115,20 @@ namespace jwt {
     if (m == WM_NCCREATE) {
       hWnd_ = h;
     }
+    else if (m == WM_SHOWWINDOW && w) {
+      RealizeWaitingOn(h);
+    }
+    else if (m == WM_DESTROY) {
+      ForgetWaitingOn(h);
+      OwningPump().Shortcuts().RemoveTarget((std::uintptr_t) h);
+    }
 
     try {
+      messages_.Dispatch(m, w, l);
       return WndProc(h, m, w, l);
     }
     catch (...) {
-      DefaultPump().ReportException(std::current_exception());
+      OwningPump().ReportException(std::current_exception());
       return DefWindowProc(h, m, w, l);
     }
   }
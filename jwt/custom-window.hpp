@@ -22,6 +22,7 @@
 #include <assert.h>
 #include "window.hpp"
 #include "message-pump.hpp"
+#include "messages.hpp"
 
 namespace jwt {
 
@@ -29,6 +30,15 @@ namespace jwt {
   struct CustomWindow
     : Window
   {
+    /**
+     * Registers a typed handler for the message decoded by Msg. See
+     * messages.hpp for the available crackers.
+     */
+    template<typename Msg, typename Callable>
+    boost::signals2::connection On(const MessageTag<Msg>&, Callable c) {
+      return messages_.Connect<Msg>(c);
+    }
+
   protected:
     CustomWindow() {}
     virtual ~CustomWindow();
@@ -39,6 +49,7 @@ namespace jwt {
 
   private:
     static ATOM atom_;
+    MessageSignals messages_;
 
     CustomWindow(const CustomWindow&) = delete;
     CustomWindow& operator= (const CustomWindow&) = delete;
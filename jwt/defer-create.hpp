@@ -24,4 +24,12 @@ namespace jwt {
 
   extern const defer_create_t defer_create;
 
+  /**
+   * Passed to a wrapper's constructor to create its HWND lazily; see
+   * Window::CreateLazily.
+   */
+  struct lazy_create_t {};
+
+  extern const lazy_create_t lazy_create;
+
 }
\ No newline at end of file
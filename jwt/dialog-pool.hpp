@@ -0,0 +1,125 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "dialog.hpp"
+#include "message-pump.hpp"
+#include "timer-service.hpp"
+#include "warm-pool.hpp"
+#include <memory>
+
+namespace jwt {
+
+  /**
+   * Keeps hidden, fully-constructed dialogs ready so that opening one is
+   * instant:
+   * ~~~~~~{.cpp}
+   * DialogPool<OptionsDialog> options(
+   *   [&]() { return std::unique_ptr<OptionsDialog>(new OptionsDialog(mainWindow)); },
+   *   [](OptionsDialog& d) { d.LoadDefaults(); },
+   *   2, 512 * 1024, 1024 * 1024
+   * );
+   *
+   * auto d = options.Acquire();
+   * SetVisible(*d, true);
+   * ...
+   * options.Release(std::move(d));     // hidden, reset & kept
+   * ~~~~~~
+   * Dialogs are built one per idle slice (a zero-delay timer, which runs once
+   * the pump's queue has drained) so warming never holds up input. An Acquire
+   * with nothing ready builds the dialog on the spot, then the pool refills in
+   * the background.
+   *
+   * T must derive from Dialog. The factory should build the dialog hidden (no
+   * WS_VISIBLE in its template); the pool hides it anyway. The reset function
+   * is called on release, after the dialog has been hidden. Budgeting is as
+   * for WarmPool: give a rough per-dialog cost & a total.
+   *
+   * The pool & its dialogs belong to the pump's thread.
+   */
+  template<typename T>
+  struct DialogPool {
+    typedef typename WarmPool<T>::Factory Factory;
+    typedef typename WarmPool<T>::Reset Reset;
+
+    DialogPool(Factory factory, Reset reset, std::size_t maxReady, std::size_t dialogBytes, std::size_t budgetBytes,
+      MessagePump& pump = DefaultPump())
+      : pool_(Hidden(std::move(factory)), std::move(reset), maxReady, dialogBytes, budgetBytes),
+      pump_(pump), warm_(TimerService::INVALID_TIMER)
+    {
+      ScheduleWarm();
+    }
+
+    ~DialogPool() {
+      if (warm_ != TimerService::INVALID_TIMER) {
+        pump_.CancelTimer(warm_);
+      }
+    }
+
+    std::unique_ptr<T> Acquire() {
+      std::unique_ptr<T> d = pool_.Acquire();
+      ScheduleWarm();
+      return d;
+    }
+
+    void Release(std::unique_ptr<T> d) {
+      if (d) {
+        SetVisible(*d, false);
+        pool_.Release(std::move(d));
+      }
+    }
+
+    void SetBudget(std::size_t budgetBytes) {
+      pool_.SetBudget(budgetBytes);
+      ScheduleWarm();
+    }
+
+    const WarmPool<T>& Pool() const { return pool_; }
+
+  private:
+    DialogPool(const DialogPool&) = delete;
+    DialogPool& operator= (const DialogPool&) = delete;
+
+    static Factory Hidden(Factory f) {
+      return [f]() {
+        std::unique_ptr<T> d = f();
+        SetVisible(*d, false);
+        return d;
+      };
+    }
+
+    void ScheduleWarm() {
+      if (warm_ == TimerService::INVALID_TIMER && pool_.NeedsWarming()) {
+        warm_ = pump_.Timers().Once(0, [this]() {
+          warm_ = TimerService::INVALID_TIMER;
+
+          // Build one, then yield so pending input goes first
+          pool_.WarmOne();
+          ScheduleWarm();
+        });
+      }
+    }
+
+    WarmPool<T> pool_;
+    MessagePump& pump_;
+    TimerService::TimerId warm_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file
+ *
+ * dialog-template.hpp contains DialogTemplateBuilder, which lays out a
+ * dialog template (DLGTEMPLATEEX) in memory so that a dialog can be built
+ * in code & still be created with a single call.
+ *
+ * It has no Windows dependencies; see Dialog(const DialogTemplateBuilder&)
+ * for the UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * Builds an extended dialog template:
+   * ~~~~~~{.cpp}
+   * DialogTemplateBuilder t(L"Settings", 0, 0, 200, 120, WS_POPUP | WS_CAPTION | WS_SYSMENU);
+   * t.Font(L"MS Shell Dlg", 8);
+   *
+   * for (int i = 0; i < fields; ++i) {
+   *   t.Control(DialogTemplateBuilder::STATIC, names[i], -1, 5, 5 + 14 * i, 60, 12, WS_CHILD | WS_VISIBLE);
+   *   t.Control(DialogTemplateBuilder::EDIT, L"", IDC_FIRST + i, 70, 5 + 14 * i, 120, 12, WS_CHILD | WS_VISIBLE | WS_BORDER);
+   * }
+   *
+   * Dialog d(parent, t);
+   * Edit e(d, IDC_FIRST);
+   * ~~~~~~
+   * Coordinates are in dialog units, styles are the usual WS_/DS_/control
+   * styles. Everything is appended to one buffer as it is added, in the
+   * exact little-endian, UTF-16 layout Windows expects, so Data() can be
+   * handed straight to CreateDialogIndirectParam. Font must be called
+   * before the first control, since the font follows the dialog's header.
+   */
+  struct DialogTemplateBuilder {
+    /**
+     * Predefined window classes, which the template stores as ordinals.
+     */
+    enum ClassOrdinal {
+      BUTTON = 0x0080,
+      EDIT = 0x0081,
+      STATIC = 0x0082,
+      LISTBOX = 0x0083,
+      SCROLLBAR = 0x0084,
+      COMBOBOX = 0x0085
+    };
+
+    enum {
+      MAX_CONTROLS = 0xFFFF
+    };
+
+    DialogTemplateBuilder(const std::wstring& title, short x, short y, short cx, short cy,
+      std::uint32_t style, std::uint32_t exStyle = 0);
+
+    /**
+     * Sets the dialog font (& adds DS_SETFONT to the style).
+     */
+    DialogTemplateBuilder& Font(const std::wstring& typeface, std::uint16_t points,
+      std::uint16_t weight = 0, bool italic = false, std::uint8_t charset = 1);
+
+    DialogTemplateBuilder& Control(ClassOrdinal, const std::wstring& text, std::uint32_t id,
+      short x, short y, short cx, short cy, std::uint32_t style, std::uint32_t exStyle = 0);
+
+    DialogTemplateBuilder& Control(const std::wstring& className, const std::wstring& text, std::uint32_t id,
+      short x, short y, short cx, short cy, std::uint32_t style, std::uint32_t exStyle = 0);
+
+    /**
+     * Reserves room for controls that will be added, to avoid reallocating
+     * the buffer as a large template grows.
+     */
+    void Reserve(std::size_t controls, std::size_t averageTextLength = 16);
+
+    std::size_t Count() const { return count_; }
+
+    /**
+     * The template: a DLGTEMPLATEEX followed by its DLGITEMTEMPLATEEXs.
+     * Always complete; valid until the builder is next changed.
+     */
+    const std::uint8_t* Data() const { return buffer_.data(); }
+    std::size_t Size() const { return buffer_.size(); }
+
+  private:
+    enum {
+      DS_SETFONT = 0x40,
+      STYLE_OFFSET = 12,
+      COUNT_OFFSET = 16
+    };
+
+    void Word(std::uint16_t);
+    void DWord(std::uint32_t);
+    void String(const std::wstring&);
+    void Ordinal(std::uint16_t);
+    void Align();
+    void Patch(std::size_t offset, std::uint32_t value, std::size_t bytes);
+
+    void Item(std::uint32_t id, short x, short y, short cx, short cy, std::uint32_t style, std::uint32_t exStyle);
+    void Finish(const std::wstring& text);
+
+    std::vector<std::uint8_t> buffer_;
+    std::size_t count_;
+    std::uint32_t style_;
+  };
+
+}
\ No newline at end of file
@@ -21,7 +21,10 @@
 #include "libraries.hpp"
 #include "window.hpp"
 #include "defer-create.hpp"
+#include "dialog-template.hpp"
 #include "event-types.hpp"
+#include "messages.hpp"
+#include <unordered_map>
 
 namespace jwt {
 
@@ -30,8 +33,22 @@ namespace jwt {
   {
     Dialog(int resourceId);
     Dialog(Window& parent, int resourceId);
+
+    /**
+     * Creates the dialog from an in-memory template rather than a resource.
+     * Controls are then wrapped by id as usual, e.g. Button(dialog, IDOK).
+     * The builder isn't needed once the constructor returns.
+     */
+    Dialog(const DialogTemplateBuilder&);
+    Dialog(Window& parent, const DialogTemplateBuilder&);
     ~Dialog();
 
+    /**
+     * The control with the given id, as GetDlgItem, but looked up in a table
+     * built once at WM_INITDIALOG rather than by walking the children. The
+     * table follows children created & destroyed later (via
+     * WM_PARENTNOTIFY) & falls back to GetDlgItem for anything it misses.
+     */
     HWND Item(int id);
 
     template<typename Callable>
@@ -53,17 +70,33 @@ namespace jwt {
       });
     }
 
+    /**
+     * Registers a typed handler for the message decoded by Msg. See
+     * messages.hpp for the available crackers.
+     */
+    template<typename Msg, typename Callable>
+    boost::signals2::connection On(const MessageTag<Msg>&, Callable c) {
+      return messages_.Connect<Msg>(c);
+    }
+
   protected:
     Dialog(const defer_create_t&);
 
     void Create(int resourceId);
     void Create(Window& parent, int resourceId);
+    void Create(const DialogTemplateBuilder&);
+    void Create(Window& parent, const DialogTemplateBuilder&);
 
     virtual INT_PTR DlgProc(HWND, UINT, WPARAM, LPARAM);
 
   private:
     boost::signals2::signal<void()> onClose_;
     boost::signals2::signal<void(const CommandEvent&)> onCommand_;
+    MessageSignals messages_;
+    std::unordered_map<int, HWND> items_;
+
+    void IndexItems();
+    void TrackItem(WPARAM, LPARAM);
 
     INT_PTR PrivateDlgProc(HWND, UINT, WPARAM, LPARAM);
     static INT_PTR CALLBACK DlgProcAdapter(HWND, UINT, WPARAM, LPARAM);
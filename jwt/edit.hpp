@@ -30,6 +30,11 @@ namespace jwt {
     : Window
   {
     Edit(Window& parent, const std::wstring&, DWORD flags = 0);
+
+    /**
+     * Creates the HWND lazily; see Window::CreateLazily.
+     */
+    Edit(const lazy_create_t&, Window& parent, const std::wstring&, DWORD flags = 0);
     Edit(Dialog& parent, int buttonId);
 
   protected:
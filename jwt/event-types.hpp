@@ -55,4 +55,8 @@ namespace jwt {
   struct ChangeTag {
   };
   extern const ChangeTag Change;
+
+  struct LatestChangeTag {
+  };
+  extern const LatestChangeTag LatestChange;
 }
\ No newline at end of file
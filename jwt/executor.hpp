@@ -0,0 +1,122 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+
+/**
+ * @file
+ *
+ * executor.hpp contains the small vocabulary shared by everything that moves
+ * work between threads: WorkItem, Executor & cancellation tokens.
+ *
+ * None of it depends on Windows; MessagePump and WorkerPool are the Windows
+ * executors.
+ */
+
+namespace jwt {
+
+  /**
+   * A unit of work handed to an Executor.
+   *
+   * WorkItems are intrusive: the executor links them through `next` rather
+   * than copying them into a container, so posting one never allocates. The
+   * item must stay alive until `run` has been called; it is usually a member
+   * of whatever is waiting for the work to happen (e.g. an awaiter in a
+   * coroutine frame).
+   */
+  struct WorkItem {
+    WorkItem* next;
+    void (*run)(WorkItem*);
+
+    explicit WorkItem(void (*r)(WorkItem*) = nullptr)
+      : next(nullptr), run(r)
+    {}
+  };
+
+  /**
+   * Something that runs WorkItems.
+   *
+   * Post may be called from any thread. The executor calls `item->run(item)`
+   * exactly once, on whatever thread(s) it represents, & must not touch the
+   * item afterwards: running it may well destroy it.
+   */
+  struct Executor {
+    virtual void Post(WorkItem*) = 0;
+
+  protected:
+    ~Executor() {}
+  };
+
+  /**
+   * Thrown into a coroutine when it resumes after its CancellationToken has
+   * been cancelled. Spawned tasks swallow it silently.
+   */
+  struct TaskCancelled
+    : std::exception
+  {
+    const char* what() const throw() {
+      return "The task was cancelled";
+    }
+  };
+
+  /**
+   * Read-only view of a CancellationSource. A default-constructed token can
+   * never be cancelled.
+   */
+  struct CancellationToken {
+    CancellationToken() {}
+
+    bool Cancelled() const {
+      return state_ && state_->load(std::memory_order_acquire);
+    }
+
+    bool CanBeCancelled() const { return (bool) state_; }
+
+  private:
+    friend struct CancellationSource;
+
+    explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> s)
+      : state_(std::move(s))
+    {}
+
+    std::shared_ptr<const std::atomic<bool>> state_;
+  };
+
+  /**
+   * Owns a cancellation flag & hands out tokens that observe it. Cancelling
+   * is one-way & may be done from any thread.
+   */
+  struct CancellationSource {
+    CancellationSource()
+      : state_(std::make_shared<std::atomic<bool>>(false))
+    {}
+
+    void Cancel() { state_->store(true, std::memory_order_release); }
+    bool Cancelled() const { return state_->load(std::memory_order_acquire); }
+
+    CancellationToken Token() const { return CancellationToken(state_); }
+
+  private:
+    std::shared_ptr<std::atomic<bool>> state_;
+  };
+
+}
\ No newline at end of file
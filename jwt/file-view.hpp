@@ -0,0 +1,143 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "custom-window.hpp"
+#include "defer-create.hpp"
+#include "line-index.hpp"
+#include "mapped-file.hpp"
+#include "timer-service.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace jwt {
+
+  /**
+   * A read-only view of a text file of any size, e.g. a multi-gigabyte log.
+   *
+   * Usage
+   * -----
+   * ~~~~~~{.cpp}
+   * FileView view(parent);
+   * if (!view.Open(L"C:\\logs\\server.log")) { ... }
+   *
+   * view.GoToOffset(offset);          // works at once
+   * if (!view.GoToLine(1000000)) {    // works once indexing gets there
+   *   ...
+   * }
+   * ~~~~~~
+   * The file is memory-mapped (see MappedFile) & only the lines on screen
+   * are read & drawn. Scrolling walks newlines from the top line, so it
+   * doesn't need the line index; the scroll bar is proportional to the byte
+   * offset. A LineIndexer builds the LineIndex on the DefaultWorkerPool in
+   * the background, after which line numbers (GoToLine, TopLine) are
+   * available; until then they are for the part indexed so far.
+   *
+   * Text is taken as UTF-8 & drawn in the system's fixed-pitch font, up to
+   * MAX_COLUMNS characters of each line.
+   */
+  struct FileView
+    : CustomWindow<FileView>
+  {
+    enum {
+      MAX_COLUMNS = 1024,
+
+      /**
+       * How often the scroll bar is brought up to date while indexing, in
+       * milliseconds.
+       */
+      POLL_INTERVAL = 250
+    };
+
+    friend struct CustomWindow<FileView>;
+    static const wchar_t* CLASS_NAME;
+
+    static void Register();
+
+    explicit FileView(Window& parent);
+    ~FileView();
+
+    /**
+     * Closes any file already open & starts indexing the new one.
+     * @return false if the file couldn't be opened or mapped
+     */
+    bool Open(const MappedFile::Path&);
+    void Close();
+
+    const MappedFile& File() const { return file_; }
+
+    /**
+     * nullptr unless a file is open.
+     */
+    const LineIndex* Index() const { return index_.get(); }
+
+    std::uint64_t TopOffset() const { return top_; }
+
+    /**
+     * Gets the number of the top line.
+     * @return false if indexing hasn't reached it yet
+     */
+    bool TopLine(std::uint64_t& line) const;
+
+    /**
+     * Scrolls line to the top.
+     * @return false if indexing hasn't reached it yet
+     */
+    bool GoToLine(std::uint64_t line);
+
+    /**
+     * Scrolls the line containing offset to the top.
+     */
+    void GoToOffset(std::uint64_t offset);
+
+  protected:
+    explicit FileView(const defer_create_t&);
+
+    void Create(Window& parent);
+    LRESULT WndProc(HWND, UINT, WPARAM, LPARAM);
+
+  private:
+    MappedFile file_;
+    std::unique_ptr<LineIndex> index_;
+    std::unique_ptr<LineIndexer> indexer_;
+    TimerService::TimerId poll_;
+
+    std::uint64_t top_;       // offset of the first line shown
+    std::uint64_t unit_;      // bytes per scroll bar unit
+    int lineHeight_;
+
+    std::vector<wchar_t> text_;
+
+    int VisibleLines();
+    void Measure();
+
+    std::uint64_t LastLineStart() const;
+    void SetTop(std::uint64_t offset);
+    void ScrollLines(std::int64_t n);
+
+    void ConfigScrollbar();
+    void HandleScroll(int action);
+    void HandleKey(WPARAM vk);
+
+    void Paint();
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ *
+ * grid-model.hpp contains the data side of a virtualized Grid:
+ * GridProvider, which supplies the cells, RowIndex, which maps between
+ * rows & pixel offsets, & CellCache, which keeps recently fetched cells.
+ *
+ * They have no Windows dependencies; see Grid for the UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * The source of a Grid's rows. Only the rows on screen (give or take a
+   * block) are ever fetched, so a provider can front a result set of any
+   * size.
+   */
+  struct GridProvider {
+    virtual std::uint64_t Rows() const = 0;
+    virtual int Columns() const = 0;
+    virtual std::wstring Header(int column) const = 0;
+
+    /**
+     * Fills cells with count rows from first on, row by row, Columns()
+     * strings to a row. cells is empty on entry.
+     */
+    virtual void Fetch(std::uint64_t first, std::uint32_t count, std::vector<std::wstring>& cells) = 0;
+
+  protected:
+    ~GridProvider() {}
+  };
+
+  /**
+   * Row heights & offsets for any number of rows, most of which have the
+   * default height.
+   *
+   * Rows are grouped in blocks of BLOCK_ROWS. A Fenwick tree over the blocks
+   * holds how far each block's height differs from the default, so a row's
+   * offset (Offset) & the row at an offset (RowAt) take O(log blocks) plus a
+   * scan of one block; changing a height (SetHeight) is O(log blocks). Only
+   * rows with a height of their own are stored individually, so 50 million
+   * rows of the default height cost about 6 MB.
+   *
+   * Offsets are 64-bit: 50 million 20 pixel rows are a billion pixels tall,
+   * which no Win32 scroll bar can address directly.
+   */
+  struct RowIndex {
+    enum {
+      BLOCK_ROWS = 64,
+      DEFAULT_HEIGHT = 20
+    };
+
+    explicit RowIndex(int defaultHeight = DEFAULT_HEIGHT, std::uint64_t count = 0);
+
+    std::uint64_t Count() const { return count_; }
+
+    /**
+     * Adding rows gives them the default height; removing them forgets the
+     * heights of the rows removed.
+     */
+    void SetCount(std::uint64_t);
+
+    int DefaultHeight() const { return defaultHeight_; }
+
+    int Height(std::uint64_t row) const;
+
+    /**
+     * A height of 0 hides a row.
+     */
+    void SetHeight(std::uint64_t row, int height);
+
+    /**
+     * Forgets every row's own height.
+     */
+    void ResetHeights();
+
+    /**
+     * The y of the top of row; Offset(Count()) is Total().
+     */
+    std::int64_t Offset(std::uint64_t row) const;
+    std::int64_t Total() const { return Offset(count_); }
+
+    /**
+     * The row y falls in, clamped to the rows there are. Count() must be
+     * > 0.
+     */
+    std::uint64_t RowAt(std::int64_t y) const;
+
+  private:
+    typedef std::vector<std::pair<std::uint32_t, int>> Overrides;   // (row in block, height), sorted
+
+    std::int64_t BlockDelta(std::uint64_t block) const;
+    void AddDelta(std::uint64_t block, std::int64_t delta);
+    void Rebuild();
+
+    int defaultHeight_;
+    std::uint64_t count_;
+
+    std::vector<std::int64_t> tree_;                    // 1-based Fenwick tree of block deltas
+    std::unordered_map<std::uint64_t, Overrides> heights_;
+  };
+
+  /**
+   * Cells fetched from a GridProvider, BLOCK_ROWS rows at a time, with the
+   * least recently used blocks dropped beyond maxBlocks.
+   *
+   * Scrolling a row into view fetches its whole block, so the rows around
+   * it are already there when they follow.
+   */
+  struct CellCache {
+    enum {
+      BLOCK_ROWS = 64,
+      DEFAULT_MAX_BLOCKS = 64
+    };
+
+    explicit CellCache(GridProvider&, std::size_t maxBlocks = DEFAULT_MAX_BLOCKS);
+
+    GridProvider& Provider() { return *provider_; }
+
+    /**
+     * Switches to another provider, forgetting every cached cell.
+     */
+    void SetProvider(GridProvider&);
+
+    /**
+     * The text of a cell, fetching its block if need be. The reference is
+     * good until the next call that fetches.
+     */
+    const std::wstring& Cell(std::uint64_t row, int column);
+
+    /**
+     * Forgets every cached cell, or those of rows [first, first + count),
+     * e.g. after the provider's data has changed.
+     */
+    void Invalidate();
+    void Invalidate(std::uint64_t first, std::uint64_t count);
+
+    std::size_t MaxBlocks() const { return maxBlocks_; }
+    void SetMaxBlocks(std::size_t);
+
+    std::size_t Blocks() const { return blocks_.size(); }
+
+    /**
+     * Counts since construction of cells served from the cache & blocks
+     * fetched from the provider.
+     */
+    std::uint64_t Hits() const { return hits_; }
+    std::uint64_t Fetches() const { return fetches_; }
+
+  private:
+    CellCache(const CellCache&) = delete;
+    CellCache& operator= (const CellCache&) = delete;
+
+    struct Block {
+      std::vector<std::wstring> cells;
+      int columns;
+      std::list<std::uint64_t>::iterator lru;
+    };
+
+    Block& Fetch(std::uint64_t block);
+    void Trim();
+
+    GridProvider* provider_;
+    std::size_t maxBlocks_;
+
+    std::unordered_map<std::uint64_t, Block> blocks_;
+    std::list<std::uint64_t> lru_;      // most recently used first
+
+    std::wstring empty_;
+
+    std::uint64_t hits_;
+    std::uint64_t fetches_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "custom-window.hpp"
+#include "defer-create.hpp"
+#include "grid-model.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace jwt {
+
+  /**
+   * A read-only table over a GridProvider of any size: only the rows in
+   * view are fetched or drawn, so 50 million rows cost no more to show than
+   * fifty.
+   *
+   * Usage
+   * -----
+   * ~~~~~~{.cpp}
+   * struct Results : GridProvider { ... };
+   *
+   * Results results(query);
+   * Grid grid(parent, results);
+   *
+   * grid.ColumnWidth(0, 200);
+   * grid.Rows().SetHeight(42, 60);    // rows may differ in height
+   * grid.TopRow(1000000);             // jump to a row
+   *
+   * // Later, when the result set has changed:
+   * grid.Refresh();
+   * ~~~~~~
+   * Row positions come from Rows() (a RowIndex) & cell text from Cells() (a
+   * CellCache), both of which are sized to the provider at construction &
+   * by Refresh.
+   *
+   * The header row has the rows' default height; drag the right edge of a
+   * column's header to resize it. The grid scrolls with its scroll bars,
+   * the mouse wheel & the arrow, Page Up/Down, Home & End keys. Scroll bars
+   * can only count to 2^31, so for very tall grids each scroll bar unit is
+   * several pixels.
+   */
+  struct Grid
+    : CustomWindow<Grid>
+  {
+    enum {
+      DEFAULT_COLUMN_WIDTH = 100,
+      MIN_COLUMN_WIDTH = 8
+    };
+
+    friend struct CustomWindow<Grid>;
+    static const wchar_t* CLASS_NAME;
+
+    static void Register();
+
+    Grid(Window& parent, GridProvider&);
+
+    GridProvider& Provider() { return *provider_; }
+
+    /**
+     * Shows another provider's rows, as if by Refresh. A Grid created by a
+     * dialog has an empty one until this is called.
+     */
+    Grid& Provider(GridProvider&);
+
+    RowIndex& Rows() { return rows_; }
+    CellCache& Cells() { return cells_; }
+
+    int ColumnWidth(int column) const;
+    Grid& ColumnWidth(int column, int width);
+
+    /**
+     * The first row (partly) in view; setting it scrolls that row to the
+     * top, as far as the grid can scroll.
+     */
+    std::uint64_t TopRow() const;
+    Grid& TopRow(std::uint64_t row);
+
+    /**
+     * Re-reads the number of rows & columns from the provider & drops every
+     * cached cell. Row heights & column widths are kept where they still
+     * apply.
+     */
+    void Refresh();
+
+    /**
+     * Call after changing row heights through Rows().
+     */
+    void Relayout();
+
+  protected:
+    explicit Grid(const defer_create_t&);
+
+    void Create(Window& parent);
+    LRESULT WndProc(HWND, UINT, WPARAM, LPARAM);
+
+  private:
+    GridProvider* provider_;
+    RowIndex rows_;
+    CellCache cells_;
+    std::vector<int> widths_;
+
+    std::int64_t y_;          // of the top of the body, in RowIndex offsets
+    int x_;
+    int yUnit_;               // pixels per vertical scroll bar unit
+
+    int resizing_;            // column being resized, or -1
+    int dragFrom_;
+    int dragWidth_;
+    bool overEdge_;
+
+    int HeaderHeight() const { return rows_.DefaultHeight(); }
+    int TotalWidth() const;
+    int ColumnLeft(int column) const;
+    int EdgeAt(int x, int y) const;
+
+    void ConfigScrollbars();
+    void ScrollTo(int x, std::int64_t y);
+
+    void HandleScroll(bool vertical, int action);
+    void HandleKey(WPARAM vk);
+
+    void Paint();
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+
+namespace jwt {
+
+  /**
+   * Gets an image list holding the images of a bitmap resource, loading it
+   * the first time any caller asks for that (module, resource, width) &
+   * returning the same list from then on, on any thread.
+   *
+   * The images are cut into squares imageWidth pixels wide; the top-left
+   * pixel's colour is treated as transparent. Lists live until the process
+   * exits, so controls may share them freely but must not destroy them.
+   * Controls given an image list with TB_SETIMAGELIST, LVM_SETIMAGELIST &
+   * the like don't take ownership, so this is what they expect.
+   *
+   * @param module the module holding the resource; nullptr for the exe
+   */
+  HIMAGELIST SharedImageList(UINT resourceId, int imageWidth, HINSTANCE module = nullptr);
+
+  /**
+   * Number of distinct image lists loaded so far.
+   */
+  std::size_t SharedImageListCount();
+}
\ No newline at end of file
@@ -33,15 +33,46 @@
 #include "window.hpp"
 
 #include "app-window.hpp"
+#include "async.hpp"
+#include "box.hpp"
 #include "button.hpp"
+#include "command-state.hpp"
+#include "command-updater.hpp"
 #include "custom-window.hpp"
 #include "dialog.hpp"
+#include "dialog-pool.hpp"
+#include "dialog-template.hpp"
 #include "edit.hpp"
+#include "executor.hpp"
+#include "file-view.hpp"
+#include "grid.hpp"
+#include "grid-model.hpp"
+#include "image-list-cache.hpp"
+#include "line-index.hpp"
 #include "list-box.hpp"
+#include "mailbox.hpp"
+#include "mapped-file.hpp"
 #include "message-pump.hpp"
+#include "messages.hpp"
+#include "raster.hpp"
 #include "rebar.hpp"
+#include "resource-cache.hpp"
+#include "resources.hpp"
+#include "scene-graph.hpp"
+#include "scene-window.hpp"
 #include "scroll-pane.hpp"
+#include "setter-cache.hpp"
+#include "shortcut-table.hpp"
+#include "shortcuts.hpp"
 #include "status-bar.hpp"
+#include "status-model.hpp"
+#include "task.hpp"
+#include "tile-cache.hpp"
+#include "timer-service.hpp"
 #include "toolbar.hpp"
 #include "track-bar.hpp"
+#include "warm-pool.hpp"
+#include "windowless-host.hpp"
+#include "windowless-model.hpp"
 #include "progress-bar.hpp"
+#include "progress-channel.hpp"
\ No newline at end of file
@@ -0,0 +1,185 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "executor.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @file
+ *
+ * line-index.hpp contains LineIndex, which finds where the lines of a large
+ * buffer start, & LineIndexer, which builds one in the background on an
+ * Executor.
+ *
+ * Both are portable; they only depend on executor.hpp. See FileView for the
+ * UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * Line numbers & line start offsets for a buffer (usually a MappedFile)
+   * that is indexed a piece at a time, & can be queried while it is.
+   *
+   * Only the start of every STRIDE'th line is stored; the lines in between
+   * are found by scanning forward from there. That keeps a 10 GB log with
+   * 100 million lines to a 12 MB index, & costs a scan of at most STRIDE
+   * lines per lookup. Newlines are found 32 bytes at a time with SSE2 where
+   * it is available.
+   *
+   * A line ends at '\n'; a '\r' before it is part of the line's text (see
+   * Line, which drops it). Scan must only be called from one thread at a
+   * time; the queries may be called from any thread, & answer from what
+   * has been indexed so far.
+   */
+  struct LineIndex {
+    enum {
+      STRIDE = 64
+    };
+
+    /**
+     * data must stay valid, & unchanged, for the LineIndex's lifetime.
+     */
+    LineIndex(const char* data, std::uint64_t size);
+
+    const char* Data() const { return data_; }
+    std::uint64_t Size() const { return size_; }
+
+    /**
+     * Indexes up to bytes more of the buffer.
+     * @return the number of bytes indexed
+     */
+    std::uint64_t Scan(std::uint64_t bytes);
+
+    std::uint64_t Indexed() const { return indexed_.load(std::memory_order_acquire); }
+    bool Done() const { return Indexed() == size_; }
+
+    /**
+     * Number of lines starting in the part indexed so far; once Done, the
+     * number of lines in the buffer. A final line without a '\n' counts; an
+     * empty buffer has no lines.
+     */
+    std::uint64_t Lines() const;
+
+    /**
+     * Gets the offset of the start of line.
+     * @return false if line hasn't been reached yet
+     */
+    bool LineStart(std::uint64_t line, std::uint64_t& offset) const;
+
+    /**
+     * Gets the number of the line containing offset.
+     * @return false if offset hasn't been reached yet
+     */
+    bool LineAt(std::uint64_t offset, std::uint64_t& line) const;
+
+    /**
+     * Gets the text of line, without its '\n' (or "\r\n").
+     * @return false if line hasn't been reached yet
+     */
+    bool Line(std::uint64_t line, const char*& text, std::size_t& length) const;
+
+    /**
+     * Finds the start of the line containing offset by scanning backwards;
+     * works whether or not that part has been indexed.
+     */
+    static std::uint64_t StartOfLine(const char* data, std::uint64_t offset);
+
+    /**
+     * Returns the position just past the n'th newline in [p, end) & takes
+     * the number found from n; if there are fewer, returns end.
+     */
+    static const char* SkipNewlines(const char* p, const char* end, std::uint64_t& n);
+
+    static std::uint64_t CountNewlines(const char* begin, const char* end);
+
+  private:
+    LineIndex(const LineIndex&) = delete;
+    LineIndex& operator= (const LineIndex&) = delete;
+
+    std::uint64_t LinesLocked() const;
+
+    const char* data_;
+    std::uint64_t size_;
+
+    // Guards the two below; the scanning itself is done outside it
+    mutable std::mutex lock_;
+    std::vector<std::uint64_t> starts_;     // of lines 0, STRIDE, 2 * STRIDE...
+    std::uint64_t newlines_;
+
+    std::atomic<std::uint64_t> indexed_;
+  };
+
+  /**
+   * Indexes a LineIndex in chunks on an Executor, one WorkItem per chunk, so
+   * a long index doesn't keep a pool thread from other work.
+   * ~~~~~~{.cpp}
+   * LineIndex index(file.Data(), file.Size());
+   * LineIndexer indexer(DefaultWorkerPool(), index);
+   * indexer.Start();
+   *
+   * // Meanwhile, on the UI thread:
+   * std::uint64_t offset;
+   * if (index.LineStart(line, offset)) { ... }
+   * ~~~~~~
+   * Destroying the indexer stops it & waits for the chunk in progress, so
+   * it must be destroyed before the LineIndex.
+   */
+  struct LineIndexer
+    : private WorkItem
+  {
+    enum {
+      DEFAULT_CHUNK = 8 * 1024 * 1024
+    };
+
+    LineIndexer(Executor&, LineIndex&, std::size_t chunkBytes = DEFAULT_CHUNK);
+    ~LineIndexer();
+
+    /**
+     * Starts (or resumes) indexing; does nothing if it is already running.
+     */
+    void Start();
+
+    /**
+     * Stops after the chunk in progress; returns without waiting.
+     */
+    void Stop() { stop_.store(true, std::memory_order_release); }
+
+    bool Running() const { return running_.load(std::memory_order_acquire); }
+
+  private:
+    LineIndexer(const LineIndexer&) = delete;
+    LineIndexer& operator= (const LineIndexer&) = delete;
+
+    static void Run(WorkItem*);
+
+    Executor& executor_;
+    LineIndex& index_;
+    std::size_t chunk_;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> stop_;
+  };
+
+}
\ No newline at end of file
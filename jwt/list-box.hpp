@@ -30,6 +30,12 @@ namespace jwt {
     : Window
   {
     ListBox(Window& parent);
+
+    /**
+     * Creates the HWND lazily; see Window::CreateLazily. Adding strings
+     * realizes it.
+     */
+    ListBox(const lazy_create_t&, Window& parent);
     ListBox(Dialog& parent, int buttonId);
 
   protected:
@@ -0,0 +1,283 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "executor.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+
+/**
+ * @file
+ *
+ * mailbox.hpp contains Mailbox, a single-slot "latest value wins" channel,
+ * & MailboxWorker, which feeds one to an Executor.
+ *
+ * Both are portable; they only depend on executor.hpp.
+ */
+
+namespace jwt {
+
+  /**
+   * A single-slot, lock-free mailbox between one producer & one consumer.
+   *
+   * Posting overwrites any value the consumer hasn't taken yet, so a slow
+   * consumer only ever sees the most recent value. Every post is numbered; a
+   * consumer working on an older value can ask whether it has become stale &
+   * give up early.
+   *
+   * Implementation note: this is a triple buffer. The producer writes into a
+   * slot it owns & then swaps it with the shared middle slot; the consumer
+   * swaps its own slot with the middle one when that is marked fresh. Neither
+   * side ever waits for the other & nothing is allocated after construction.
+   * T must be default-constructible & move-assignable.
+   */
+  template<typename T>
+  struct Mailbox {
+    Mailbox()
+      : front_(0), back_(2), middle_(1), posted_(0)
+    {}
+
+    /**
+     * Producer only. Replaces any value not yet taken.
+     * @return the generation of the posted value
+     */
+    std::uint64_t Post(T v) {
+      Slot& s = slots_[back_];
+      std::uint64_t generation = posted_.fetch_add(1, std::memory_order_relaxed) + 1;
+
+      s.value = std::move(v);
+      s.generation = generation;
+
+      back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+      return generation;
+    }
+
+    /**
+     * Consumer only. Takes the latest value if there is one that hasn't been
+     * taken (or made stale by Cancel) already.
+     */
+    bool Take(T& value, std::uint64_t& generation) {
+      while (middle_.load(std::memory_order_relaxed) & FRESH) {
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+
+        Slot& s = slots_[front_];
+        if (!Stale(s.generation)) {
+          value = std::move(s.value);
+          generation = s.generation;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * Returns true if something has been posted (or Cancel called) since the
+     * value with this generation. May be called from any thread.
+     */
+    bool Stale(std::uint64_t generation) const {
+      return posted_.load(std::memory_order_acquire) != generation;
+    }
+
+    bool HasFresh() const {
+      return (middle_.load(std::memory_order_acquire) & FRESH) != 0;
+    }
+
+    /**
+     * Makes the current value stale without posting a new one. May be called
+     * from any thread.
+     */
+    void Cancel() {
+      posted_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+  private:
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator= (const Mailbox&) = delete;
+
+    enum {
+      INDEX = 0x3,
+      FRESH = 0x4
+    };
+
+    struct Slot {
+      T value;
+      std::uint64_t generation;
+
+      Slot() : value(), generation(0) {}
+    };
+
+    Slot slots_[3];
+
+    unsigned int front_;                  // consumer's slot
+    unsigned int back_;                   // producer's slot
+    std::atomic<unsigned int> middle_;    // shared slot | FRESH
+
+    std::atomic<std::uint64_t> posted_;
+  };
+
+  /**
+   * Passed to a MailboxWorker handler so it can abandon work that a newer
+   * value has made pointless.
+   */
+  template<typename T>
+  struct StaleToken {
+    StaleToken(const Mailbox<T>& m, std::uint64_t generation)
+      : mailbox_(m), generation_(generation)
+    {}
+
+    bool Stale() const { return mailbox_.Stale(generation_); }
+
+  private:
+    const Mailbox<T>& mailbox_;
+    std::uint64_t generation_;
+  };
+
+  /**
+   * Runs a handler on an Executor for the latest submitted value, never more
+   * than one at a time:
+   * ~~~~~~{.cpp}
+   * MailboxWorker<int> preview(DefaultWorkerPool(), [](int& zoom, const StaleToken<int>& t) {
+   *   for (auto& tile : Tiles()) {
+   *     if (t.Stale()) return;     // the user has moved on
+   *     Render(tile, zoom);
+   *   }
+   * });
+   *
+   * slider.On(LatestChange, [&](const TrackChange& c) {
+   *   preview.Submit(c.value);
+   * });
+   * ~~~~~~
+   * Values submitted while the handler is busy replace each other; when it
+   * returns it is called again with whichever is latest. Submit is for a
+   * single producer thread (normally the UI thread) & posts at most one
+   * WorkItem however fast values arrive.
+   *
+   * The handler must not throw. Destroying the worker cancels the current
+   * value & waits for a running handler to return, so it must not be
+   * destroyed from inside the handler. A WorkItem that is posted but hasn't
+   * started (say the worker is destroyed on its executor's thread) is
+   * detached instead: it frees the worker's state when it runs, without
+   * calling the handler.
+   */
+  template<typename T>
+  struct MailboxWorker {
+    typedef std::function<void(T&, const StaleToken<T>&)> Handler;
+
+    MailboxWorker(Executor& e, Handler h)
+      : executor_(e), state_(new State(std::move(h)))
+    {}
+
+    ~MailboxWorker() {
+      State* s = state_;
+      s->mailbox.Cancel();
+
+      // Pairs with the check in Run: either a Run that is about to start sees
+      // detached & leaves the handler alone, or it is counted in active &
+      // waited for here.
+      s->detached.store(true, std::memory_order_seq_cst);
+      while (s->active.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+      }
+
+      // Nothing can call the handler now; destroy it (& what it captured)
+      // here rather than on the executor's thread.
+      s->handler = nullptr;
+      Release(s);
+    }
+
+    void Submit(T v) {
+      state_->mailbox.Post(std::move(v));
+
+      if (!state_->scheduled.exchange(true, std::memory_order_acq_rel)) {
+        state_->refs.fetch_add(1, std::memory_order_relaxed);
+        executor_.Post(state_);
+      }
+    }
+
+    /**
+     * Makes the value being worked on (if any) stale.
+     */
+    void Cancel() { state_->mailbox.Cancel(); }
+
+  private:
+    MailboxWorker(const MailboxWorker&) = delete;
+    MailboxWorker& operator= (const MailboxWorker&) = delete;
+
+    // Shared by the worker & the WorkItem it has posted, if any; each holds
+    // a reference & the last one out deletes it.
+    struct State
+      : WorkItem
+    {
+      explicit State(Handler h)
+        : WorkItem(&Run), handler(std::move(h)), scheduled(false), detached(false), active(0), refs(1)
+      {}
+
+      Handler handler;
+      Mailbox<T> mailbox;
+
+      std::atomic<bool> scheduled;
+      std::atomic<bool> detached;
+      std::atomic<int> active;
+      std::atomic<int> refs;
+    };
+
+    static void Release(State* s) {
+      if (s->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete s;
+      }
+    }
+
+    static void Run(WorkItem* w) {
+      State* s = static_cast<State*>(w);
+      s->active.fetch_add(1, std::memory_order_seq_cst);
+
+      while (!s->detached.load(std::memory_order_seq_cst)) {
+        T value;
+        std::uint64_t generation;
+
+        while (s->mailbox.Take(value, generation)) {
+          s->handler(value, StaleToken<T>(s->mailbox, generation));
+        }
+
+        // A Submit that raced with the last Take saw scheduled still set &
+        // didn't post; look again now that it's clear, & carry on if there's
+        // something new & nobody else has been scheduled to take it.
+        s->scheduled.store(false, std::memory_order_seq_cst);
+
+        if (!s->mailbox.HasFresh() || s->scheduled.exchange(true, std::memory_order_acq_rel)) {
+          break;
+        }
+      }
+
+      // The destructor may proceed once active reaches zero. A counter,
+      // since the Run that lost the exchange above may still be finishing
+      // when the next one starts. The reference this posting held goes
+      // last: it may be the one that frees the state.
+      s->active.fetch_sub(1, std::memory_order_seq_cst);
+      Release(s);
+    }
+
+    Executor& executor_;
+    State* state_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @file
+ *
+ * mapped-file.hpp contains MappedFile, a read-only memory mapping of a
+ * whole file.
+ *
+ * It is portable: the Windows build maps with CreateFileMapping, others
+ * with mmap. See FileView for the UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * A file mapped read-only into memory, all of it, for as long as the
+   * MappedFile is open. Pages are read in as they are touched, so opening a
+   * 10 GB file costs no more than opening a small one.
+   *
+   * The whole file has to fit in the address space: in a 32-bit process,
+   * Open fails for files beyond a gigabyte or so. Other processes may
+   * still write to the file (a log being appended to, say) but the mapping
+   * keeps the size it had when opened.
+   */
+  struct MappedFile {
+#ifdef _WIN32
+    typedef std::wstring Path;
+#else
+    typedef std::string Path;
+#endif
+
+    MappedFile();
+    ~MappedFile();
+
+    /**
+     * Closes any file already open.
+     * @return false if the file couldn't be opened or mapped
+     */
+    bool Open(const Path&);
+    void Close();
+
+    bool IsOpen() const { return open_; }
+
+    /**
+     * The mapped bytes; nullptr for an empty file.
+     */
+    const char* Data() const { return data_; }
+    std::uint64_t Size() const { return size_; }
+
+  private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+
+    const char* data_;
+    std::uint64_t size_;
+    bool open_;
+
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#else
+    int fd_;
+#endif
+  };
+
+}
\ No newline at end of file
@@ -19,32 +19,285 @@
 #pragma once
 
 #include "libraries.hpp"
+#include "executor.hpp"
+#include "shortcut-table.hpp"
+#include "timer-wheel.hpp"
+#include "wait-set.hpp"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
 
 namespace jwt {
-  struct MessagePump {
+
+  struct TimerService;
+  struct Window;
+
+  /**
+   * Thrown by MessagePump::RaiseReportedException when more than one
+   * exception was reported before the pump got the chance to raise them.
+   *
+   * The exceptions are held in the order they were reported; use
+   * std::rethrow_exception to inspect each one.
+   */
+  struct AggregateException
+    : std::exception
+  {
+    explicit AggregateException(std::vector<std::exception_ptr> exceptions)
+      : exceptions_(std::move(exceptions))
+    {}
+
+    const char* what() const throw() {
+      return "Multiple exceptions were reported during message dispatch";
+    }
+
+    const std::vector<std::exception_ptr>& Exceptions() const {
+      return exceptions_;
+    }
+
+  private:
+    std::vector<std::exception_ptr> exceptions_;
+  };
+
+  /**
+   * MessagePump runs the message loop for a single thread.
+   *
+   * Each thread that creates windows has its own pump; use DefaultPump() to
+   * get the one for the calling thread. Windows remember the pump of the
+   * thread that created them (see Window::OwningPump) so that dialog
+   * registration & exception reporting always go to the right loop, even
+   * when several UI threads are running.
+   *
+   * Those windows share ownership of the pump with their thread, so a pump
+   * outlives every window created on its thread, static ones included.
+   *
+   * Waiting on kernel objects
+   * -------------------------
+   * As well as messages, the pump can wait on kernel handles (events,
+   * processes, change notifications...) & an I/O completion port, calling
+   * back on the pump's thread when they are signalled:
+   * ~~~~~~{.cpp}
+   * HANDLE h = FindFirstChangeNotification(dir, FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE);
+   *
+   * DefaultPump().AddWait(h, [h]() {
+   *   Reload();
+   *   FindNextChangeNotification(h);
+   * });
+   * ~~~~~~
+   * This avoids the usual helper thread whose only job is to PostMessage back
+   * to the UI thread.
+   *
+   * Every handle that is signalled when the pump wakes is serviced before it
+   * blocks again, so a busy one (cross-thread Posts, say) can't starve the
+   * others. The bookkeeping lives in WaitSet (wait-set.hpp).
+   *
+   * Timers
+   * ------
+   * Timers() gives access to the pump's TimerService, which runs window-less
+   * one-shot & periodic timers off a single kernel timer registered with
+   * AddWait.
+   *
+   * Keyboard shortcuts
+   * ------------------
+   * Shortcuts() holds code-defined shortcuts for this thread's windows (see
+   * AddShortcut in shortcuts.hpp). They are looked up in one hash table on
+   * key-down messages only, before dialog navigation & HACCEL tables, &
+   * sent straight to the target window as a WM_COMMAND from an accelerator.
+   *
+   * Deferred destruction
+   * --------------------
+   * DestroyLater & DeleteLater queue a window (or its wrapper) to be torn
+   * down once the message being dispatched has been handled, rather than in
+   * the middle of it. The queue is flushed as a batch: windows whose
+   * ancestors are also queued are left for the ancestor to take with it, &
+   * each affected parent's redrawing is suspended until the batch is done,
+   * so closing a pane of a thousand controls repaints its parent once.
+   * CustomWindow's destructor uses DestroyLater; DeleteLater makes it safe
+   * to get rid of a window from inside one of its own handlers.
+   *
+   * Posting work
+   * ------------
+   * MessagePump is an Executor: Post may be called from any thread & runs the
+   * WorkItem on the pump's thread. This is how coroutines hop back to the UI
+   * thread (see task.hpp & async.hpp). Posted work, like waits, is only run
+   * by Pump() itself; it is held up while a modal loop (MessageBox, menu
+   * tracking...) is running.
+   */
+  struct MessagePump
+    : Executor, std::enable_shared_from_this<MessagePump>
+  {
+
+    typedef std::function<void()> WaitCallback;
+    typedef std::function<void(const OVERLAPPED_ENTRY&)> CompletionCallback;
 
     MessagePump();
+    ~MessagePump();
 
     int Pump();
 
+    /**
+     * The id of the thread this pump belongs to.
+     */
+    DWORD ThreadId() const { return threadId_; }
+
+    /**
+     * Looks up the pump belonging to the specified thread.
+     * @return the pump, or nullptr if that thread has not created one.
+     */
+    static MessagePump* ForThread(DWORD threadId);
+
     void AddDialog(HWND);
     void RemoveDialog(HWND);
 
     void AddAccelerator(HACCEL);
     void RemoveAccelerator(HACCEL);
 
+    ShortcutTable& Shortcuts() { return shortcuts_; }
+    const ShortcutTable& Shortcuts() const { return shortcuts_; }
+
+    /**
+     * Calls c on this pump's thread whenever h is signalled. The handle stays
+     * registered until RemoveWait is called, so auto-reset objects (or ones
+     * that are re-armed in the callback) are the natural fit.
+     *
+     * At most MAXIMUM_WAIT_OBJECTS - 3 handles may be registered (slots are
+     * reserved for posted work & the completion port), TimerService's
+     * included; std::length_error is thrown beyond that.
+     */
+    void AddWait(HANDLE h, WaitCallback c);
+    void RemoveWait(HANDLE h);
+
+    /**
+     * Associates a handle opened for overlapped I/O with this pump's
+     * completion port. c is called on the pump's thread for each completion
+     * packet; packets are drained in batches on each wake.
+     *
+     * @return the completion key; pass to RemoveCompletionHandler.
+     */
+    ULONG_PTR AddCompletionHandler(HANDLE file, CompletionCallback c);
+    void RemoveCompletionHandler(ULONG_PTR key);
+
+    /**
+     * Calls DestroyWindow on h after the current dispatch. The caller should
+     * already have detached any wrapper from h.
+     */
+    void DestroyLater(HWND h);
+
+    /**
+     * Deletes w after the current dispatch. w must have been allocated with
+     * new & must not be used by the caller afterwards.
+     */
+    void DeleteLater(Window* w);
+
+    /**
+     * Tears down everything queued by DestroyLater & DeleteLater now. Pump()
+     * calls this after each message & wait; there is rarely a need to call
+     * it directly.
+     */
+    void FlushDestroyQueue();
+
+    size_t PendingDestroys() const { return destroyQueue_.size() + deleteQueue_.size(); }
+
+    /**
+     * Queues a WorkItem to run on this pump's thread. Thread-safe & lock-free;
+     * items run in the order they were posted. Exceptions thrown by an item
+     * are reported (see ReportException) rather than lost.
+     *
+     * Items still queued when the pump is destroyed are never run.
+     */
+    virtual void Post(WorkItem*);
+
+    /**
+     * Gets this pump's TimerService, creating it on first use. Timers fire on
+     * the pump's thread from inside Pump().
+     */
+    TimerService& Timers();
+
+    /**
+     * Cancels a timer started through Timers(). Unlike Timers().Cancel it
+     * never creates the service, which makes it the one for destructors.
+     *
+     * @return false if the timer has already fired or been cancelled
+     */
+    bool CancelTimer(TimerWheel::TimerId);
+
+    /**
+     * Queues an exception thrown inside a WndProc/DlgProc so that it can be
+     * rethrown once control has returned from Windows. May be called any
+     * number of times before the exceptions are raised.
+     */
     void ReportException(std::exception_ptr);
-    void RaiseReportedException();
+
+    /**
+     * Returns true if there are reported exceptions that have not been
+     * raised yet. This is a single relaxed load so can be called after every
+     * message.
+     */
+    bool HasReportedException() const {
+      return pendingCount_.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * Rethrows any reported exceptions & clears the queue. A single exception
+     * is rethrown as-is; several are wrapped in an AggregateException.
+     */
+    void RaiseReportedException() {
+      if (HasReportedException()) {
+        RaisePendingExceptions();
+      }
+    }
 
   private:
     MessagePump(const MessagePump&) = delete;
     MessagePump& operator= (const MessagePump&) = delete;
 
+    enum {
+      COMPLETION_BATCH_SIZE = 64,
+      MAX_SHORTCUT_SCOPES = 16,
+      RESERVED_WAITS = 2          // the post event & completion port
+    };
+
+    void RaisePendingExceptions();
+
+    void Dispatch(MSG&);
+    bool DispatchShortcut(const MSG&);
+    void Wait();
+    void AddInternalWait(HANDLE, WaitCallback);
+    void DrainCompletionPort();
+    void RunPosted();
+
+    DWORD threadId_;
     bool dlgOrAccelChanged_;
     std::vector<HWND> dialogs_;
     std::vector<HACCEL> accelerators_;
-    std::exception_ptr currentException_;
+    ShortcutTable shortcuts_;
+
+    size_t userWaits_;          // registered through AddWait
+    WaitSet<HANDLE> waits_;
+
+    HANDLE completionPort_;
+    ULONG_PTR nextCompletionKey_;
+    std::map<ULONG_PTR, CompletionCallback> completionHandlers_;
+
+    std::unique_ptr<TimerService> timers_;
+
+    std::vector<HWND> destroyQueue_;
+    std::vector<Window*> deleteQueue_;
+    bool flushingDestroys_;
+
+    // Intrusive LIFO pushed by any thread; the event is set by whoever makes
+    // it non-empty.
+    std::atomic<WorkItem*> posted_;
+    HANDLE postEvent_;
+
+    std::atomic<unsigned int> pendingCount_;
+    std::vector<std::exception_ptr> pendingExceptions_;
   };
 
+  /**
+   * Gets the MessagePump for the calling thread, creating it on first use.
+   * Must not be called once the thread's thread-local objects have been
+   * destroyed; a Window's destructor should use its OwningPump instead.
+   */
   MessagePump& DefaultPump();
 }
\ No newline at end of file
@@ -0,0 +1,280 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "measurement.hpp"
+#include "event-types.hpp"
+
+/**
+ * @file
+ *
+ * messages.hpp contains "message crackers": small structs that decode the
+ * WPARAM/LPARAM pair of a specific window message into named fields.
+ *
+ * They are intended to replace the hand-written decoding that otherwise
+ * litters WndProcs and HandleReflectedMessage overrides:
+ * ~~~~~~{.cpp}
+ * // Before:
+ * if (HIWORD(w) == BN_CLICKED) { ... }
+ * NMBCDROPDOWN* n = (NMBCDROPDOWN*) l;
+ *
+ * // After:
+ * if (CommandMsg(w, l).code == BN_CLICKED) { ... }
+ * NotifyMsg<NMBCDROPDOWN> n(w, l);
+ * ~~~~~~
+ *
+ * Every cracker follows the same shape:
+ * - A static `Matches(UINT)` that says which message id(s) it decodes
+ * - A constructor taking `(UINT, WPARAM, LPARAM)` so generic code can decode
+ *   any cracker uniformly, plus a `(WPARAM, LPARAM)` convenience constructor
+ *   where the message id carries no extra information.
+ *
+ * Crackers that only hold integers are `constexpr` all the way through. Those
+ * that expose pointers keep the raw LPARAM and convert on access since
+ * pointer casts are not allowed in constant expressions.
+ *
+ * Typed subscription
+ * ------------------
+ * Windows that support it (see CustomWindow and Dialog) allow handlers to be
+ * registered against a cracker type:
+ * ~~~~~~{.cpp}
+ * w.On(Message<SizeMsg>, [](const SizeMsg& s) {
+ *   Relayout(s.Size());
+ * });
+ * ~~~~~~
+ * The message is decoded once per dispatch, however many handlers are
+ * connected. A window with no typed handlers pays a single empty() test.
+ */
+
+namespace jwt {
+
+  /**
+   * Decodes WM_SIZE.
+   */
+  struct SizeMsg {
+    UINT type;
+    int width;
+    int height;
+
+    static constexpr bool Matches(UINT m) { return m == WM_SIZE; }
+
+    constexpr SizeMsg(WPARAM w, LPARAM l)
+      : type((UINT) w), width(LOWORD(l)), height(HIWORD(l))
+    {}
+
+    constexpr SizeMsg(UINT, WPARAM w, LPARAM l)
+      : SizeMsg(w, l)
+    {}
+
+    Dimension Size() const { return Dimension(width, height); }
+  };
+
+  /**
+   * Decodes WM_SIZING. The rectangle may be modified by the handler; changes
+   * are seen by Windows once the WndProc returns.
+   */
+  struct SizingMsg {
+    UINT edge;
+    LPARAM lParam;
+
+    static constexpr bool Matches(UINT m) { return m == WM_SIZING; }
+
+    constexpr SizingMsg(WPARAM w, LPARAM l)
+      : edge((UINT) w), lParam(l)
+    {}
+
+    constexpr SizingMsg(UINT, WPARAM w, LPARAM l)
+      : SizingMsg(w, l)
+    {}
+
+    RECT* Bounds() const { return (RECT*) lParam; }
+  };
+
+  /**
+   * Decodes WM_COMMAND.
+   *
+   * Note that the source of the command is determined by the LPARAM, not the
+   * notification code: BN_CLICKED is 0, which is indistinguishable from a menu
+   * command if you only look at HIWORD(w).
+   */
+  struct CommandMsg {
+    WORD code;
+    WORD id;
+    LPARAM lParam;
+
+    static constexpr bool Matches(UINT m) { return m == WM_COMMAND; }
+
+    constexpr CommandMsg(WPARAM w, LPARAM l)
+      : code(HIWORD(w)), id(LOWORD(w)), lParam(l)
+    {}
+
+    constexpr CommandMsg(UINT, WPARAM w, LPARAM l)
+      : CommandMsg(w, l)
+    {}
+
+    constexpr CommandEvent::Type Source() const {
+      return (lParam)
+        ? CommandEvent::CONTROL
+        : (code == 1)
+        ? CommandEvent::ACCELERATOR
+        : CommandEvent::MENU;
+    }
+
+    constexpr bool FromControl() const { return lParam != 0; }
+
+    HWND Control() const { return (HWND) lParam; }
+
+    CommandEvent Event() const { return CommandEvent(Source(), id, lParam); }
+  };
+
+  /**
+   * Decodes WM_NOTIFY. T is the notification structure, which must begin with
+   * an NMHDR (as all common control notification structures do).
+   */
+  template<typename T = NMHDR>
+  struct NotifyMsg {
+    LPARAM lParam;
+
+    static constexpr bool Matches(UINT m) { return m == WM_NOTIFY; }
+
+    constexpr NotifyMsg(WPARAM, LPARAM l)
+      : lParam(l)
+    {}
+
+    constexpr NotifyMsg(UINT, WPARAM w, LPARAM l)
+      : NotifyMsg(w, l)
+    {}
+
+    T* Info() const { return (T*) lParam; }
+    const NMHDR& Header() const { return *(const NMHDR*) lParam; }
+
+    UINT Code() const { return Header().code; }
+    HWND From() const { return Header().hwndFrom; }
+  };
+
+  /**
+   * Decodes WM_HSCROLL and WM_VSCROLL.
+   *
+   * `position` is only meaningful for SB_THUMBPOSITION and SB_THUMBTRACK and
+   * is limited to 16 bits; use GetScrollInfo for the full-range value.
+   */
+  struct ScrollMsg {
+    bool vertical;
+    int action;
+    int position;
+    LPARAM lParam;
+
+    static constexpr bool Matches(UINT m) {
+      return m == WM_HSCROLL || m == WM_VSCROLL;
+    }
+
+    constexpr ScrollMsg(UINT m, WPARAM w, LPARAM l)
+      : vertical(m == WM_VSCROLL), action(LOWORD(w)), position((short) HIWORD(w)), lParam(l)
+    {}
+
+    constexpr bool FromControl() const { return lParam != 0; }
+
+    HWND Bar() const { return (HWND) lParam; }
+  };
+
+  /**
+   * Tag type used to select the typed-message overload of On(...).
+   * Use the Message<T> variable rather than constructing one yourself.
+   */
+  template<typename Msg>
+  struct MessageTag {
+  };
+
+  template<typename Msg>
+  const MessageTag<Msg> Message = {};
+
+  /**
+   * Holds the typed handlers registered against a single window.
+   *
+   * Implementation note: there is one signal per cracker type, not per
+   * handler, so decoding happens once and is shared by every handler of that
+   * type. The list is scanned linearly; in practice a window has a handful of
+   * typed handlers at most.
+   */
+  struct MessageSignals {
+
+    template<typename Msg, typename Callable>
+    boost::signals2::connection Connect(Callable c) {
+      typedef boost::signals2::signal<void(const Msg&)> SignalT;
+
+      for (auto& e : entries_) {
+        if (e.key == &Key<Msg>::key) {
+          return static_cast<SignalT*>(e.signal.get())->connect(c);
+        }
+      }
+
+      std::shared_ptr<SignalT> s = std::make_shared<SignalT>();
+      Entry e = { &Key<Msg>::key, &Msg::Matches, &Fire<Msg>, s };
+      entries_.push_back(e);
+
+      return s->connect(c);
+    }
+
+    void Dispatch(UINT m, WPARAM w, LPARAM l) {
+      if (entries_.empty()) {
+        return;
+      }
+
+      for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].matches(m)) {
+          // Copy the signal reference: a handler may connect a new message
+          // type and cause entries_ to reallocate underneath us.
+          std::shared_ptr<void> s = entries_[i].signal;
+          entries_[i].fire(s.get(), m, w, l);
+        }
+      }
+    }
+
+    bool Empty() const { return entries_.empty(); }
+
+  private:
+    template<typename Msg>
+    struct Key {
+      static char key;
+    };
+
+    struct Entry {
+      const char* key;
+      bool (*matches)(UINT);
+      void (*fire)(void*, UINT, WPARAM, LPARAM);
+      std::shared_ptr<void> signal;
+    };
+
+    template<typename Msg>
+    static void Fire(void* s, UINT m, WPARAM w, LPARAM l) {
+      typedef boost::signals2::signal<void(const Msg&)> SignalT;
+
+      SignalT* signal = static_cast<SignalT*>(s);
+      if (!signal->empty()) {
+        (*signal)(Msg(m, w, l));
+      }
+    }
+
+    std::vector<Entry> entries_;
+  };
+
+  template<typename Msg>
+  char MessageSignals::Key<Msg>::key = 0;
+}
\ No newline at end of file
@@ -23,14 +23,39 @@
 #include "dialog.hpp"
 #include "defer-create.hpp"
 #include "event-types.hpp"
+#include "progress-channel.hpp"
+#include "timer-service.hpp"
 
 namespace jwt {
 
   struct ProgressBar
     : Window
   {
+    enum {
+      FRAME_INTERVAL = 16
+    };
+
     ProgressBar(Window& parent);
     ProgressBar(Dialog& parent, int ctrlId);
+    ~ProgressBar();
+
+    /**
+     * Drives the bar from a ProgressChannel. The channel is sampled on this
+     * bar's thread every interval milliseconds (once a frame by default) &
+     * PBM_SETPOS is only sent when the position, rounded to the bar's width
+     * in pixels, has changed. Sampling is skipped while the bar is hidden.
+     *
+     * While bound, the bar's range is managed by the binding; don't call
+     * SetRange or SetValue yourself. The channel must outlive the binding.
+     */
+    void Bind(ProgressChannel&, DWORD interval = FRAME_INTERVAL);
+    void Unbind();
+
+    /**
+     * Number of messages sent to the bar by the current binding; useful to
+     * check how much the binding is saving.
+     */
+    unsigned int BoundUpdates() const { return binding_.sampler.Updates(); }
 
   protected:
     ProgressBar(const defer_create_t&);
@@ -40,6 +65,17 @@ namespace jwt {
     LRESULT HandleReflectedMessage(HWND, UINT, WPARAM, LPARAM);
 
   private:
+    struct Binding {
+      ProgressChannel* channel;
+      TimerService::TimerId timer;
+      ProgressSampler sampler;
+
+      Binding() : channel(nullptr), timer(TimerService::INVALID_TIMER) {}
+    };
+
+    void Sample();
+
+    Binding binding_;
   };
 
   ProgressBar& SetMarquee(ProgressBar&, bool);
@@ -0,0 +1,142 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @file
+ *
+ * progress-channel.hpp contains ProgressChannel, which carries progress from
+ * worker threads to the UI without a message per update.
+ *
+ * It has no Windows dependencies; see ProgressBar::Bind for the UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * Lock-free progress counters written by any number of threads & sampled
+   * by the UI.
+   * ~~~~~~{.cpp}
+   * ProgressChannel progress;
+   * progress.SetTotal(files.size());
+   * bar.Bind(progress);
+   *
+   * // On any number of workers, at any rate:
+   * Process(file);
+   * progress.Add();
+   * ~~~~~~
+   * Add() is a relaxed increment of a counter striped across cache lines, so
+   * many writers don't contend on one line. Reads sum the stripes; they are
+   * meant for a sampler running once a frame, not for hot loops.
+   *
+   * Values read while writers are active are a consistent-enough snapshot for
+   * display: each counter is read atomically but the three are not read
+   * together.
+   */
+  struct ProgressChannel {
+    ProgressChannel();
+
+    /**
+     * Adds n completed units.
+     */
+    void Add(std::uint64_t n = 1);
+
+    void SetTotal(std::uint64_t total) { total_.store(total, std::memory_order_relaxed); }
+    void AddTotal(std::uint64_t n) { total_.fetch_add(n, std::memory_order_relaxed); }
+
+    /**
+     * Marquee mode: the amount of work isn't known (yet).
+     */
+    void SetMarquee(bool on) { marquee_.store(on, std::memory_order_relaxed); }
+
+    /**
+     * Sets the completed count back to zero & the total to total. Unlike the
+     * other members this must not race with Add().
+     */
+    void Reset(std::uint64_t total = 0);
+
+    std::uint64_t Current() const;
+    std::uint64_t Total() const { return total_.load(std::memory_order_relaxed); }
+    bool Marquee() const { return marquee_.load(std::memory_order_relaxed); }
+
+    /**
+     * Gets Current() scaled to [0, steps], rounded down. Returns 0 if no
+     * total has been set.
+     */
+    int Scaled(int steps) const;
+
+  private:
+    ProgressChannel(const ProgressChannel&) = delete;
+    ProgressChannel& operator= (const ProgressChannel&) = delete;
+
+    enum {
+      STRIPES = 16
+    };
+
+    struct alignas(64) Stripe {
+      std::atomic<std::uint64_t> count;
+    };
+
+    Stripe stripes_[STRIPES];
+    std::atomic<std::uint64_t> total_;
+    std::atomic<bool> marquee_;
+  };
+
+  /**
+   * The UI side of a ProgressChannel: samples it once a frame & works out
+   * which of the bar's marquee state, range & position need to be sent.
+   * ProgressBar::Bind drives one of these; it holds no window, so the
+   * throttling can be measured on its own.
+   */
+  struct ProgressSampler {
+    struct Changes {
+      bool marquee;
+      bool range;
+      bool value;
+    };
+
+    ProgressSampler() : steps_(-1), value_(-1), marquee_(false), updates_(0) {}
+
+    /**
+     * Samples c for a bar steps positions wide & records what changed since
+     * the last sample. The position is only compared while not in marquee
+     * mode.
+     */
+    Changes Sample(const ProgressChannel& c, int steps);
+
+    bool Marquee() const { return marquee_; }
+    int Steps() const { return steps_; }
+    int Value() const { return value_; }
+
+    /**
+     * Total number of changes reported, i.e. messages the bar was sent.
+     */
+    unsigned int Updates() const { return updates_; }
+
+  private:
+    int steps_;
+    int value_;
+    bool marquee_;
+    unsigned int updates_;
+  };
+
+}
\ No newline at end of file
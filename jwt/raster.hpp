@@ -0,0 +1,101 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "box.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file
+ *
+ * raster.hpp contains Raster, a 32-bit pixel buffer with the few drawing
+ * operations SceneGraph needs.
+ *
+ * It has no Windows dependencies. On Windows, SceneWindow wraps the bits of
+ * a DIB section in one, so the scene is rendered straight into the window's
+ * back buffer.
+ */
+
+namespace jwt {
+
+  /**
+   * A 32-bit 0xAARRGGBB image, either owned or wrapping someone else's
+   * memory. Rows are stride pixels apart, top row first; in memory each pixel
+   * is B, G, R, A, which is what a 32bpp top-down DIB expects.
+   *
+   * Every drawing operation is clipped to the image.
+   */
+  struct Raster {
+    Raster();
+    Raster(int width, int height);
+
+    /**
+     * Wraps pixels, which must stay valid while the Raster uses them.
+     * stride is in pixels.
+     */
+    Raster(std::uint32_t* pixels, int width, int height, int stride);
+
+    /**
+     * Reallocates an owned image; the contents are lost.
+     */
+    void Resize(int width, int height);
+    void Wrap(std::uint32_t* pixels, int width, int height, int stride);
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    Box Bounds() const { Box b = { 0, 0, width_, height_ }; return b; }
+
+    std::uint32_t* Row(int y) { return pixels_ + (std::size_t) y * stride_; }
+    const std::uint32_t* Row(int y) const { return pixels_ + (std::size_t) y * stride_; }
+
+    std::uint32_t Pixel(int x, int y) const { return Row(y)[x]; }
+
+    /**
+     * Sets every pixel in b to argb.
+     */
+    void Clear(const Box& b, std::uint32_t argb);
+
+    /**
+     * Draws argb over b, blending by its alpha. Fully transparent colours
+     * draw nothing; opaque ones are a Clear.
+     */
+    void Fill(const Box& b, std::uint32_t argb);
+
+    /**
+     * Number of pixels written since construction; for measuring how much
+     * work a repaint did.
+     */
+    std::uint64_t PixelsWritten() const { return written_; }
+
+  private:
+    Raster(const Raster&) = delete;
+    Raster& operator= (const Raster&) = delete;
+
+    std::vector<std::uint32_t> owned_;
+    std::uint32_t* pixels_;
+    int width_;
+    int height_;
+    int stride_;
+
+    std::uint64_t written_;
+  };
+
+}
\ No newline at end of file
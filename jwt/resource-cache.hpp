@@ -0,0 +1,223 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @file
+ *
+ * resource-cache.hpp contains ResourceCache, a reference-counted cache of
+ * loaded resources with least-recently-used eviction, & ResourceRef, which
+ * holds one reference.
+ *
+ * Both are portable; the loading is done by a ResourceCache::Loader. See
+ * resources.hpp for the one JWT uses for icons, bitmaps, menus & strings.
+ */
+
+namespace jwt {
+
+  /**
+   * Identifies a resource: which module it comes from, what kind it is, its
+   * id &, for images, the size it was loaded at.
+   */
+  struct ResourceKey {
+    std::uintptr_t module;
+    unsigned int kind;
+    unsigned int id;
+    int cx;
+    int cy;
+  };
+
+  inline bool operator== (const ResourceKey& a, const ResourceKey& b) {
+    return a.module == b.module && a.kind == b.kind && a.id == b.id && a.cx == b.cx && a.cy == b.cy;
+  }
+
+  struct ResourceKeyHash {
+    std::size_t operator() (const ResourceKey& k) const {
+      std::size_t h = std::hash<std::uintptr_t>()(k.module);
+      h = h * 31 + k.kind;
+      h = h * 31 + k.id;
+      h = h * 31 + (unsigned int) k.cx;
+      h = h * 31 + (unsigned int) k.cy;
+      return h;
+    }
+  };
+
+  /**
+   * Loads each resource once & hands out counted references to it.
+   *
+   * A resource stays loaded while it has references. When the last one is
+   * released it is kept, in least-recently-used order, for as long as the
+   * total size of everything loaded fits in the budget; past that the oldest
+   * unreferenced resources are freed. Referenced resources are never freed,
+   * so the budget can be exceeded while they are all in use.
+   *
+   * All members are thread-safe.
+   */
+  struct ResourceCache {
+    typedef std::uintptr_t Handle;
+
+    /**
+     * Does the actual loading & freeing.
+     */
+    struct Loader {
+      /**
+       * @param bytes set to the resource's approximate size
+       * @return the handle, or 0 if it could not be loaded. Handles must be
+       *         unique among the resources currently loaded.
+       */
+      virtual Handle Load(const ResourceKey&, std::size_t& bytes) = 0;
+      virtual void Free(const ResourceKey&, Handle) = 0;
+
+    protected:
+      ~Loader() {}
+    };
+
+    struct Stats {
+      std::size_t hits;
+      std::size_t misses;
+      std::size_t evictions;
+      std::size_t entries;
+      std::size_t bytes;
+    };
+
+    ResourceCache(Loader&, std::size_t budget);
+
+    /**
+     * Frees everything, referenced or not.
+     */
+    ~ResourceCache();
+
+    /**
+     * Gets a reference to the resource, loading it if need be.
+     * @return the handle, or 0 if the loader failed
+     */
+    Handle Acquire(const ResourceKey&);
+
+    void AddRef(Handle);
+    void Release(Handle);
+
+    void SetBudget(std::size_t);
+    std::size_t Budget() const;
+
+    /**
+     * Frees every unreferenced resource, whatever the budget.
+     */
+    void Purge();
+
+    Stats GetStats() const;
+
+  private:
+    ResourceCache(const ResourceCache&) = delete;
+    ResourceCache& operator= (const ResourceCache&) = delete;
+
+    typedef std::list<Handle> LruList;
+
+    struct Entry {
+      Handle handle;
+      std::size_t bytes;
+      unsigned int refs;
+      LruList::iterator lru;      // valid while refs == 0
+    };
+
+    typedef std::unordered_map<ResourceKey, Entry, ResourceKeyHash> Entries;
+
+    void Evict(std::size_t budget);
+
+    Loader& loader_;
+    mutable std::mutex lock_;
+
+    // Pointers rather than iterators into entries_: a rehash invalidates
+    // iterators but not pointers to the elements
+    Entries entries_;
+    std::unordered_map<Handle, Entries::value_type*> handles_;
+    LruList lru_;                 // unreferenced, least recently used first
+
+    std::size_t budget_;
+    std::size_t bytes_;
+    std::size_t hits_;
+    std::size_t misses_;
+    std::size_t evictions_;
+  };
+
+  /**
+   * Holds one reference to a cached resource & releases it on destruction.
+   * Copying takes another reference.
+   */
+  struct ResourceRef {
+    ResourceRef() : cache_(nullptr), handle_(0) {}
+
+    /**
+     * Adopts a reference already acquired from cache.
+     */
+    ResourceRef(ResourceCache& cache, ResourceCache::Handle h)
+      : cache_(h ? &cache : nullptr), handle_(h)
+    {}
+
+    ResourceRef(const ResourceRef& r)
+      : cache_(r.cache_), handle_(r.handle_)
+    {
+      if (cache_) {
+        cache_->AddRef(handle_);
+      }
+    }
+
+    ResourceRef(ResourceRef&& r)
+      : cache_(r.cache_), handle_(r.handle_)
+    {
+      r.cache_ = nullptr;
+      r.handle_ = 0;
+    }
+
+    ~ResourceRef() { Reset(); }
+
+    ResourceRef& operator= (ResourceRef r) {
+      std::swap(cache_, r.cache_);
+      std::swap(handle_, r.handle_);
+      return *this;
+    }
+
+    void Reset() {
+      if (cache_) {
+        cache_->Release(handle_);
+        cache_ = nullptr;
+        handle_ = 0;
+      }
+    }
+
+    ResourceCache::Handle Get() const { return handle_; }
+
+    template<typename T>
+    T As() const { return (T) handle_; }
+
+    explicit operator bool() const { return handle_ != 0; }
+
+  private:
+    ResourceCache* cache_;
+    ResourceCache::Handle handle_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "resource-cache.hpp"
+
+namespace jwt {
+
+  /**
+   * Values of ResourceKey::kind used by the loaders below.
+   */
+  enum ResourceKind {
+    RESOURCE_ICON = 1,
+    RESOURCE_CURSOR,
+    RESOURCE_BITMAP,
+    RESOURCE_MENU,
+    RESOURCE_STRING
+  };
+
+  /**
+   * Gets the process-wide cache used by the functions below. It starts with
+   * an 8MB budget; see ResourceCache::SetBudget & ResourceCache::GetStats.
+   */
+  ResourceCache& Resources();
+
+  /**
+   * Loads an icon at the specified size (0, 0 means the system's default
+   * icon size). The icon is destroyed once the last reference has gone &
+   * the cache needs the room, so keep the ResourceRef for as long as
+   * anything displays it.
+   *
+   * @param module the module holding the resource; nullptr for the exe
+   */
+  ResourceRef LoadIconResource(UINT id, int cx = 0, int cy = 0, HINSTANCE module = nullptr);
+
+  ResourceRef LoadCursorResource(UINT id, HINSTANCE module = nullptr);
+
+  ResourceRef LoadBitmapResource(UINT id, HINSTANCE module = nullptr);
+
+  /**
+   * Creates a new menu from a menu resource. The resource is looked up once
+   * & its template cached; the HMENU belongs to the caller, as with
+   * LoadMenu.
+   * @return the menu, or nullptr if there is no such resource
+   */
+  HMENU LoadMenuResource(UINT id, HINSTANCE module = nullptr);
+
+  /**
+   * Gets a string from a string table.
+   * @return the string, or an empty string if there is no such resource
+   */
+  std::wstring LoadStringResource(UINT id, HINSTANCE module = nullptr);
+}
\ No newline at end of file
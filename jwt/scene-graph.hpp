@@ -0,0 +1,250 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "box.hpp"
+#include "raster.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ *
+ * scene-graph.hpp contains SceneGraph, a retained tree of rectangles that
+ * knows which parts of the picture each change affects & repaints only
+ * those.
+ *
+ * It has no Windows dependencies; see SceneWindow for the UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * A tree of nodes, each a box in its parent's coordinates with a
+   * translate & scale transform, a fill colour & optionally a painter of its
+   * own. A node marked CLIP clips its descendants to its box.
+   *
+   * Every node caches its world transform & the part of it that is actually
+   * on screen (its box in world coordinates, clipped by its ancestors). A
+   * change records that area, as it was, for the changed node & its
+   * descendants; the next TakeDirty or Render brings the caches up to date
+   * & records the new areas too. Changes to a node that leave it where it
+   * was (a colour, or Invalidate) record just its own area.
+   *
+   * Render repaints one area of a Raster: it clears it to the background,
+   * finds the nodes that intersect it in a grid index of the cached areas, &
+   * draws them in tree order (parents before children, siblings in order)
+   * clipped to the area. A window keeps the Raster between paints &
+   * renders only what TakeDirty reports, so the cost of a repaint follows
+   * the size of the change rather than the size of the scene.
+   *
+   * Scale applies to the node's box & to its children; translation is in
+   * the parent's coordinates. Boxes are rounded outwards to whole pixels.
+   *
+   * ROOT always exists & is never drawn; it is the parent of top-level
+   * nodes. As in WindowlessModel, an Id kept after Remove is no longer
+   * Valid.
+   */
+  struct SceneGraph {
+    typedef std::uint64_t Id;
+
+    static const Id ROOT = 0;
+    static const Id INVALID_ID = ~0ULL;
+
+    enum Flag {
+      VISIBLE = 0x01,
+      CLIP = 0x02
+    };
+
+    enum {
+      CELL_SIZE = 128,
+
+      /**
+       * TakeDirty reports at most this many boxes; past it, their union
+       * costs less than the bookkeeping.
+       */
+      MAX_DIRTY_BOXES = 16
+    };
+
+    /**
+     * Draws a node in place of its fill. world is the node's box in
+     * raster coordinates; nothing outside clip may be touched.
+     */
+    typedef std::function<void(Raster&, const Box& world, const Box& clip)> Painter;
+
+    SceneGraph();
+
+    /**
+     * Adds a VISIBLE node as the last (topmost) child of parent. A fill of
+     * 0 (fully transparent) draws nothing, which suits groups.
+     */
+    Id Add(Id parent, const Box&, std::uint32_t argb = 0);
+
+    /**
+     * Removes a node & all its descendants. ROOT can't be removed.
+     */
+    void Remove(Id);
+    void Clear();
+
+    bool Valid(Id) const;
+    std::size_t Size() const { return count_; }
+
+    Id Parent(Id) const;
+
+    const Box& Bounds(Id) const;
+    void SetBounds(Id, const Box&);
+
+    void SetTransform(Id, int tx, int ty, double sx = 1.0, double sy = 1.0);
+
+    std::uint32_t Color(Id) const;
+    void SetColor(Id, std::uint32_t argb);
+
+    unsigned int Flags(Id) const;
+    void SetFlags(Id, unsigned int flags, bool on);
+
+    void SetPainter(Id, Painter);
+
+    /**
+     * Marks a node's area for repainting, e.g. when what its painter draws
+     * has changed.
+     */
+    void Invalidate(Id);
+
+    /**
+     * Makes a node the topmost of its siblings.
+     */
+    void Raise(Id);
+
+    /**
+     * The part of a node that is on screen, as of the last TakeDirty or
+     * Render; Empty if it is hidden or clipped away.
+     */
+    const Box& Visible(Id) const;
+
+    std::uint32_t Background() const { return background_; }
+    void SetBackground(std::uint32_t argb);
+
+    /**
+     * Replaces out with the nodes whose area intersects area, in the
+     * order they are drawn.
+     */
+    void Query(const Box& area, std::vector<Id>& out);
+
+    /**
+     * Appends the areas needing repainting since the last call to out, as
+     * a few non-overlapping boxes, & forgets them.
+     */
+    void TakeDirty(std::vector<Box>& out);
+    bool Dirty() const { return !dirty_.empty() || !changed_.empty(); }
+
+    /**
+     * Repaints area (clipped to the raster) from scratch.
+     */
+    void Render(Raster&, const Box& area);
+
+    /**
+     * Number of nodes drawn by Render since construction.
+     */
+    std::uint64_t NodesDrawn() const { return drawn_; }
+
+  private:
+    SceneGraph(const SceneGraph&) = delete;
+    SceneGraph& operator= (const SceneGraph&) = delete;
+
+    typedef std::uint32_t Slot;
+    typedef std::uint64_t CellKey;
+
+    static const Slot NONE = ~0u;
+
+    // Plain constants rather than enumerators, so that combining them with
+    // Flag values isn't arithmetic between two enumeration types
+    static const std::uint32_t ALIVE = 0x80000000u;
+    static const std::uint32_t CHANGED = 0x40000000u;
+
+    struct Node {
+      Box box;
+      int tx, ty;
+      double sx, sy;
+      std::uint32_t color;
+      std::uint32_t flags;
+      std::uint32_t generation;
+
+      Slot parent, first, last, prev, next;
+
+      // Cached by Update
+      double wsx, wsy, wtx, wty;
+      Box world;
+      Box visible;
+      Box clip;       // what descendants are clipped to
+      std::uint32_t order;
+    };
+
+    Slot SlotOf(Id) const;
+    Id IdOf(Slot s) const { return ((Id) nodes_[s].generation << 32) | s; }
+
+    void Link(Slot s, Slot parent);
+    void Unlink(Slot s);
+
+    /**
+     * Records the current area of s & its descendants & queues s for
+     * Update.
+     */
+    void Change(Slot s);
+    void MarkDirty(const Box& b);
+
+    /**
+     * Brings the caches of every changed subtree up to date.
+     */
+    void Update();
+    void Recompute(Slot s);
+    void Renumber();
+
+    /**
+     * Replaces out with the slots whose area intersects area, in drawing
+     * order.
+     */
+    void Gather(const Box& area, std::vector<Slot>& out);
+
+    static int CellOf(int v);
+    static CellKey Key(int cx, int cy);
+    void Index(Slot, bool insert);
+
+    std::vector<Node> nodes_;
+    std::vector<Slot> free_;
+    std::size_t count_;
+
+    std::unordered_map<Slot, Painter> painters_;
+
+    std::vector<Slot> changed_;
+    bool orderDirty_;
+
+    std::unordered_map<CellKey, std::vector<Slot>> cells_;
+    std::vector<std::uint32_t> stamp_;
+    std::uint32_t query_;
+    std::vector<Slot> scratch_;
+
+    std::vector<Box> dirty_;
+    std::uint32_t background_;
+    std::uint64_t drawn_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "custom-window.hpp"
+#include "defer-create.hpp"
+#include "raster.hpp"
+#include "scene-graph.hpp"
+#include <vector>
+
+namespace jwt {
+
+  /**
+   * A window that displays a SceneGraph, keeping the rendered picture in a
+   * back buffer so that a change repaints only the area it affects.
+   *
+   * Usage
+   * -----
+   * ~~~~~~{.cpp}
+   * SceneWindow view(parent);
+   * SceneGraph& g = view.Scene();
+   *
+   * auto panel = g.Add(SceneGraph::ROOT, { 10, 10, 300, 200 }, 0xFFF0F0F0);
+   * g.SetFlags(panel, SceneGraph::CLIP, true);
+   * auto marker = g.Add(panel, { 0, 0, 8, 8 }, 0xFFC00000);
+   * view.Update();
+   *
+   * g.SetTransform(marker, x, y);     // later, e.g. on a timer
+   * view.Update();
+   * ~~~~~~
+   * Change the scene through Scene() & then call Update(), which renders the
+   * dirty areas into the back buffer & invalidates just those. WM_PAINT only
+   * copies from the back buffer; resizing the window renders it all again.
+   *
+   * The back buffer is a 32-bit DIB section the scene is rendered into
+   * directly, so Painters draw with Raster rather than GDI.
+   */
+  struct SceneWindow
+    : CustomWindow<SceneWindow>
+  {
+    friend struct CustomWindow<SceneWindow>;
+    static const wchar_t* CLASS_NAME;
+
+    static void Register();
+
+    explicit SceneWindow(Window& parent);
+    ~SceneWindow();
+
+    SceneGraph& Scene() { return scene_; }
+    const SceneGraph& Scene() const { return scene_; }
+
+    /**
+     * Renders the areas made dirty by changes to the scene & invalidates
+     * them.
+     */
+    void Update();
+
+  protected:
+    explicit SceneWindow(const defer_create_t&);
+
+    void Create(Window& parent);
+    LRESULT WndProc(HWND, UINT, WPARAM, LPARAM);
+
+  private:
+    SceneGraph scene_;
+
+    HDC memDC_;
+    HBITMAP dib_;
+    HGDIOBJ oldBitmap_;
+    Raster back_;
+
+    std::vector<Box> dirty_;
+
+    void Resize(int w, int h);
+    void FreeBuffer();
+    void Paint();
+  };
+
+}
\ No newline at end of file
@@ -20,6 +20,8 @@
 
 #include "custom-window.hpp"
 #include "defer-create.hpp"
+#include "tile-cache.hpp"
+#include <memory>
 
 namespace jwt {
 
@@ -61,6 +63,30 @@ namespace jwt {
       return *this;
     }
 
+    /**
+     * Switches the pane to painting its content itself, from a TileCache
+     * filled by renderer. Content is in extent coordinates, so the pane
+     * only needs an Extent; scrolling keeps using the ScrollPolicy, & the
+     * strip the default policy exposes is painted from cached tiles,
+     * rendering only those not seen before (or invalidated since).
+     *
+     * Child windows still work but are painted over nothing in particular;
+     * use one mode or the other.
+     */
+    ScrollPane& UseTileCache(TileCache::Renderer renderer,
+      std::size_t budgetBytes = TileCache::DEFAULT_BUDGET, int tileSize = TileCache::DEFAULT_TILE_SIZE);
+
+    /**
+     * The pane's TileCache, or nullptr if UseTileCache hasn't been called.
+     */
+    TileCache* Tiles() { return tiles_.get(); }
+
+    /**
+     * Marks an area of the content (in extent coordinates) as changed: its
+     * tiles are rendered again & the part in view is repainted.
+     */
+    ScrollPane& InvalidateContent(const Box& area);
+
   protected:
     explicit ScrollPane(const defer_create_t&);
 
@@ -81,6 +107,8 @@ namespace jwt {
 
     ScrollPolicyT scrollPolicy_;
 
+    std::unique_ptr<TileCache> tiles_;
+
     void ConfigScrollbars();
     void ConfigOptionalScrollbars();
     void ConfigAlwaysOnScrollbars();
@@ -88,6 +116,8 @@ namespace jwt {
 
     void HandleHScroll(int action);
     void HandleVScroll(int action);
+
+    void PaintTiles();
   };
 
   void DefaultScrollPolicy(ScrollPane&, const Point&, const Point&);
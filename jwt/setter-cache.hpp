@@ -0,0 +1,127 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ *
+ * setter-cache.hpp contains SetterCache, which lets setters such as SetText
+ * skip sending a message when the value hasn't changed.
+ *
+ * It has no Windows dependencies; every Window owns one (see
+ * Window::Setters).
+ */
+
+namespace jwt {
+
+  /**
+   * Remembers the last value written through each setter of one window.
+   *
+   * Setters follow the same pattern:
+   * ~~~~~~{.cpp}
+   * std::uint64_t h = SetterCache::Hash(text);
+   * if (w.Setters().Skip(SetterCache::TEXT, h)) {
+   *   return w;
+   * }
+   * SetWindowText(...);
+   * w.Setters().Store(SetterCache::TEXT, h);
+   * ~~~~~~
+   * Strings & arrays are stored as a 64-bit hash rather than a copy. A hash
+   * collision would suppress a genuine change; at 64 bits that is not a
+   * practical concern for UI text.
+   *
+   * The cache only knows about writes made through JWT. If a control is
+   * changed some other way (by the user, or by sending it messages
+   * directly) call Resync(Window&) or Clear(), or switch the cache off for
+   * that window with Enable(false). Wrappers for controls the user can change
+   * do this for you; see Edit & TrackBar.
+   *
+   * A window that never calls a cached setter costs one empty vector.
+   */
+  struct SetterCache {
+    /**
+     * Keys used by the built-in setters. Keys from PART_TEXT on are indexed:
+     * PART_TEXT + n is the text of status bar part n.
+     */
+    enum Key {
+      TEXT = 0,
+      VALUE,
+      RANGE,
+      MARQUEE,
+      PARTS,
+      PART_TEXT = 0x100,
+      PART_TEXT_LAST = PART_TEXT + 255
+    };
+
+    SetterCache() : enabled_(true), skipped_(0), written_(0) {}
+
+    /**
+     * Returns true (& counts a skipped write) if caching is enabled & value
+     * is what was last stored for key.
+     */
+    bool Skip(unsigned int key, std::uint64_t value);
+
+    /**
+     * Records that value has just been written for key.
+     */
+    void Store(unsigned int key, std::uint64_t value);
+
+    void Forget(unsigned int key);
+    void Forget(unsigned int first, unsigned int last);
+    void Clear() { entries_.clear(); }
+
+    /**
+     * Turning the cache off also clears it, so turning it back on starts
+     * from a clean slate.
+     */
+    void Enable(bool on);
+    bool Enabled() const { return enabled_; }
+
+    /**
+     * Counts of writes skipped & made since construction; for measuring how
+     * much the cache is saving.
+     */
+    unsigned int Skipped() const { return skipped_; }
+    unsigned int Written() const { return written_; }
+
+    static std::uint64_t Hash(const std::wstring&);
+    static std::uint64_t Hash(const int* values, std::size_t count);
+
+    static std::uint64_t Pack(int a, int b) {
+      return ((std::uint64_t) (std::uint32_t) a << 32) | (std::uint32_t) b;
+    }
+
+  private:
+    typedef std::pair<unsigned int, std::uint64_t> Entry;
+
+    // Linear search: a window has a handful of cached properties
+    std::vector<Entry> entries_;
+
+    bool enabled_;
+    unsigned int skipped_;
+    unsigned int written_;
+  };
+
+}
\ No newline at end of file
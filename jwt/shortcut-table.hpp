@@ -0,0 +1,124 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file
+ *
+ * shortcut-table.hpp contains ShortcutTable, which maps key strokes to
+ * commands with a single hash lookup.
+ *
+ * It has no Windows dependencies; see AddShortcut (shortcuts.hpp) for the
+ * UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * Keyboard shortcuts keyed by (virtual key, modifiers), each bound to a
+   * command id, a target & a scope.
+   *
+   * Bindings are kept in a list & compiled on demand (on the first Find after
+   * a change) into an open-addressed hash table, so a lookup is one probe
+   * sequence however many shortcuts there are. A key that several scopes
+   * bind is looked up once; its bindings are then scanned for the best
+   * scope.
+   *
+   * Scopes & targets are opaque integers to the table (JWT uses HWNDs).
+   * GLOBAL bindings match in any scope.
+   */
+  struct ShortcutTable {
+    enum Modifiers {
+      NONE = 0x0,
+      SHIFT = 0x1,
+      CONTROL = 0x2,
+      ALT = 0x4
+    };
+
+    typedef std::uintptr_t Scope;
+    typedef unsigned int BindingId;
+
+    static const Scope GLOBAL = 0;
+
+    struct Binding {
+      unsigned int vk;
+      unsigned int modifiers;
+      Scope scope;
+      std::uintptr_t target;
+      int command;
+      BindingId id;
+    };
+
+    ShortcutTable();
+
+    /**
+     * Binds vk (1-255) + modifiers. A later binding for the same key & scope
+     * hides an earlier one until it is removed.
+     */
+    BindingId Add(unsigned int vk, unsigned int modifiers, Scope, std::uintptr_t target, int command);
+
+    void Remove(BindingId);
+
+    /**
+     * Removes every binding that targets target, e.g. when it is destroyed.
+     */
+    void RemoveTarget(std::uintptr_t target);
+
+    /**
+     * Finds the binding for a key stroke. scopes are tried in order (most
+     * specific first) & then GLOBAL.
+     * @return the binding, or nullptr; valid until the table is next changed
+     */
+    const Binding* Find(unsigned int vk, unsigned int modifiers, const Scope* scopes, std::size_t count) const;
+
+    const Binding* Find(unsigned int vk, unsigned int modifiers, Scope scope = GLOBAL) const {
+      return Find(vk, modifiers, &scope, 1);
+    }
+
+    std::size_t Size() const { return bindings_.size(); }
+    bool Empty() const { return bindings_.empty(); }
+
+  private:
+    struct Slot {
+      std::uint32_t key;      // 0 for an empty slot
+      std::uint32_t first;    // range in compiled_
+      std::uint32_t count;
+    };
+
+    static std::uint32_t Key(unsigned int vk, unsigned int modifiers) {
+      return (modifiers << 8) | vk;
+    }
+
+    void Compile() const;
+
+    std::vector<Binding> bindings_;
+    BindingId nextId_;
+
+    // Compiled form: bindings sorted by key (insertion order within a key)
+    // & a power-of-two table of slots pointing into them
+    mutable std::vector<Binding> compiled_;
+    mutable std::vector<Slot> slots_;
+    mutable bool dirty_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "window.hpp"
+#include "shortcut-table.hpp"
+
+namespace jwt {
+
+  /**
+   * Binds a key stroke to a command on target, without an accelerator
+   * resource:
+   * ~~~~~~{.cpp}
+   * AddShortcut(w, 'S', ShortcutTable::CONTROL, IDM_SAVE);
+   * w.On(Command, IDM_SAVE, [&]() { Save(); });
+   * ~~~~~~
+   * The command arrives as a WM_COMMAND from an accelerator, so it goes
+   * through the same On(Command, ...) handlers as the menu. The shortcut
+   * only works while the focus is in target or one of its descendants; a
+   * shortcut bound by a window nearer the focus wins over one bound further
+   * out.
+   *
+   * Shortcuts are held by the pump of target's thread (see
+   * MessagePump::Shortcuts). A CustomWindow or Dialog target's shortcuts
+   * are removed when it is destroyed; for other targets call
+   * RemoveShortcuts first.
+   */
+  ShortcutTable::BindingId AddShortcut(Window& target, unsigned int vk, unsigned int modifiers, int command);
+
+  /**
+   * As AddShortcut, but works whichever of the thread's windows has the
+   * focus, as long as no scoped shortcut claims the same key stroke.
+   */
+  ShortcutTable::BindingId AddGlobalShortcut(Window& target, unsigned int vk, unsigned int modifiers, int command);
+
+  void RemoveShortcut(Window& target, ShortcutTable::BindingId);
+
+  /**
+   * Removes every shortcut that targets target.
+   */
+  void RemoveShortcuts(Window& target);
+}
\ No newline at end of file
@@ -23,15 +23,63 @@
 #include "dialog.hpp"
 #include "defer-create.hpp"
 #include "event-types.hpp"
+#include "status-model.hpp"
+#include "timer-service.hpp"
+#include <array>
+#include <memory>
 
 namespace jwt {
 
   struct StatusBar
     : Window
   {
+    enum {
+      FRAME_INTERVAL = 16
+    };
+
     StatusBar(Window& parent);
     StatusBar(Window& parent, const std::initializer_list<int>&);
     StatusBar(Dialog& parent, int buttonId);
+    ~StatusBar();
+
+    /**
+     * Batched updates: the text (or layout) is stored in the bar's
+     * StatusModel & written to the control by a single flush at most once
+     * every FRAME_INTERVAL milliseconds. Only parts whose text actually
+     * changed are written, so six counters ticking thousands of times a
+     * second cost at most six SB_SETTEXTs a frame.
+     *
+     * Once a bar has been used this way SetText & SetParts also go through
+     * the model (& flush immediately) so the two never disagree.
+     *
+     * Starting batched mode costs one SB_GETPARTS. Text the control already
+     * shows isn't read back; GetText fetches it from the control until the
+     * part is first queued.
+     */
+    void Queue(int part, const std::wstring&);
+    void QueueParts(const int* rightEdges, int count);
+    void QueueParts(const std::initializer_list<int>&);
+
+    /**
+     * Writes queued changes now rather than waiting for the next frame.
+     */
+    void Flush();
+
+    /**
+     * Owner-draw mode: the bar draws the model's text itself rather than
+     * handing it to the control, & a changed part is simply invalidated.
+     * Text is measured once per change rather than on every paint. Implies
+     * batched mode; turning it on reads back the text of any part that
+     * hasn't been queued yet.
+     */
+    void SetOwnerDraw(bool);
+    bool OwnerDraw() const { return ownerDraw_; }
+
+    /**
+     * Gets the model behind batched mode, or nullptr if the bar hasn't been
+     * used that way. Useful for reading back text & the flush counters.
+     */
+    const StatusModel* Model() const { return model_.get(); }
 
   protected:
     StatusBar(const defer_create_t&);
@@ -41,20 +89,38 @@ namespace jwt {
     LRESULT HandleReflectedMessage(HWND, UINT, WPARAM, LPARAM);
 
   private:
+    struct Writer;
+    friend struct Writer;
+
+    StatusModel& TheModel();
+    void ScheduleFlush();
+    void DrawPart(const DRAWITEMSTRUCT&);
+
+    std::unique_ptr<StatusModel> model_;
+    TimerService::TimerId flush_;
+    bool ownerDraw_;
   };
 
   StatusBar& SetParts(StatusBar& s, const std::initializer_list<int>&);
 
+  namespace detail {
+    StatusBar& SendParts(StatusBar&, const int* rightEdges, int count);
+  }
+
+  /**
+   * Sets the right edge of each part. The control can't have more than
+   * StatusModel::MAX_PARTS parts; std::length_error is thrown, & nothing
+   * changed, if given more.
+   */
   template<typename InputIterator>
   StatusBar& SetParts(StatusBar& s, InputIterator first, InputIterator last) {
     assert(s.TheHWND());
 
-    std::vector<int> parts(first, last);
-    assert(parts.size() > 0 && parts.size() <= 256);
-
-    SendMessage(s.TheHWND(), SB_SETPARTS, parts.size(), (LPARAM) &*parts.begin());
+    // No allocation: the control can't have more than 256 parts anyway
+    std::array<int, StatusModel::MAX_PARTS> parts;
+    int count = StatusModel::GatherParts(first, last, parts);
 
-    return s;
+    return detail::SendParts(s, parts.data(), count);
   }
 
   StatusBar& SetText(StatusBar&, int part, const std::wstring&);
@@ -0,0 +1,180 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @file
+ *
+ * status-model.hpp contains StatusModel, the in-memory state behind a
+ * batched StatusBar.
+ *
+ * It has no Windows dependencies; see StatusBar::Queue for the UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * Parts layout & per-part text of a status bar, with a record of what has
+   * changed since it was last written to the control.
+   *
+   * Setting a part to the text it already has doesn't make it dirty. Flush
+   * hands the layout (if it changed) & each dirty part to a Sink, in that
+   * order, & then marks everything clean.
+   *
+   * A part's text is unknown until it has been set: a model attached to a
+   * control that already shows text doesn't read it all back up front. The
+   * first SetText of an unknown part always makes it dirty, & MarkAllDirty
+   * leaves unknown parts alone rather than blanking them.
+   *
+   * Nothing is allocated after construction except by the texts themselves,
+   * & a part's string reuses its buffer when the new text fits.
+   */
+  struct StatusModel {
+    enum {
+      MAX_PARTS = 256
+    };
+
+    /**
+     * Receives the changes during Flush.
+     */
+    struct Sink {
+      virtual void Parts(const int* rightEdges, int count) = 0;
+      virtual void Text(int part, const std::wstring&) = 0;
+
+    protected:
+      ~Sink() {}
+    };
+
+    StatusModel();
+
+    /**
+     * Sets the right edge of each part (-1 extends the last part to the edge
+     * of the bar), as for SB_SETPARTS. 1 <= count; std::length_error is
+     * thrown if count > MAX_PARTS.
+     *
+     * A layout that differs from the current one also marks every part's
+     * text dirty, since the control may have dropped some of it.
+     */
+    void SetParts(const int* rightEdges, int count);
+
+    /**
+     * Copies the right edges in [first, last) into parts & returns how many
+     * there were, without allocating. Throws std::length_error, having
+     * written nothing past the end of parts, if there are more than
+     * MAX_PARTS.
+     */
+    template<typename InputIterator>
+    static int GatherParts(InputIterator first, InputIterator last, std::array<int, MAX_PARTS>& parts) {
+      int count = 0;
+
+      for (; first != last; ++first) {
+        if (count == MAX_PARTS) {
+          throw std::length_error("StatusBar: too many parts");
+        }
+        parts[count++] = *first;
+      }
+      return count;
+    }
+
+    int PartCount() const { return count_; }
+    const int* Parts() const { return parts_.data(); }
+
+    /**
+     * @return true if the text differed & the part is now dirty
+     */
+    bool SetText(int part, const std::wstring&);
+
+    /**
+     * Gets a part's text; empty if it isn't Known.
+     */
+    const std::wstring& Text(int part) const;
+
+    /**
+     * Returns true if the part's text has been set, i.e. Text says what the
+     * control shows (or will once flushed).
+     */
+    bool Known(int part) const;
+
+    bool Dirty() const { return layoutDirty_ || dirty_.any(); }
+    bool Dirty(int part) const;
+
+    /**
+     * Marks every known part (& the layout, if one has been set) dirty, e.g.
+     * after the control has been written to some other way.
+     */
+    void MarkAllDirty();
+
+    /**
+     * Marks everything clean without writing it, e.g. after loading the
+     * model from the control.
+     */
+    void MarkClean();
+
+    /**
+     * Writes the changes to sink & marks the model clean.
+     * @return the number of Sink calls made
+     */
+    unsigned int Flush(Sink&);
+
+    /**
+     * Number of Flush calls that found something to write, & the total
+     * number of Sink calls they made.
+     */
+    unsigned int Flushes() const { return flushes_; }
+    unsigned int Writes() const { return writes_; }
+
+    /**
+     * Cached text extent of a part, for owner-drawn bars: measured once per
+     * text change rather than on every paint. Extent returns false if the
+     * part hasn't been measured since its text last changed.
+     */
+    bool Extent(int part, int& cx, int& cy) const;
+    void SetExtent(int part, int cx, int cy);
+    void ForgetExtents() { measured_.reset(); }
+
+  private:
+    StatusModel(const StatusModel&) = delete;
+    StatusModel& operator= (const StatusModel&) = delete;
+
+    struct Size {
+      int cx;
+      int cy;
+    };
+
+    std::array<int, MAX_PARTS> parts_;
+    int count_;
+    bool layoutDirty_;
+
+    std::array<std::wstring, MAX_PARTS> texts_;
+    std::bitset<MAX_PARTS> known_;
+    std::bitset<MAX_PARTS> dirty_;
+
+    std::array<Size, MAX_PARTS> extents_;
+    std::bitset<MAX_PARTS> measured_;
+
+    unsigned int flushes_;
+    unsigned int writes_;
+  };
+
+}
\ No newline at end of file
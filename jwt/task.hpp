@@ -0,0 +1,471 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "executor.hpp"
+#include <assert.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @file
+ *
+ * task.hpp contains Task<T>, a lazily-started coroutine type, & the ResumeOn
+ * awaitable for hopping between executors.
+ *
+ * Coroutines need compiler support: C++20 coroutines, or the Coroutines TS
+ * (/await on Visual Studio 2015). Without either, JWT_HAS_COROUTINES is 0 &
+ * this header declares nothing beyond executor.hpp.
+ *
+ * Like executor.hpp, nothing here depends on Windows; see async.hpp for the
+ * pieces that tie tasks to windows & the thread pool.
+ */
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define JWT_HAS_COROUTINES 1
+#define JWT_SYMMETRIC_TRANSFER 1
+namespace jwt { namespace coro = std; }
+#elif defined(_RESUMABLE_FUNCTIONS_SUPPORTED)
+#include <experimental/resumable>
+#define JWT_HAS_COROUTINES 1
+#define JWT_SYMMETRIC_TRANSFER 0
+namespace jwt { namespace coro = std::experimental; }
+#elif defined(__cpp_coroutines)
+#include <experimental/coroutine>
+#define JWT_HAS_COROUTINES 1
+#define JWT_SYMMETRIC_TRANSFER 0
+namespace jwt { namespace coro = std::experimental; }
+#else
+#define JWT_HAS_COROUTINES 0
+#endif
+
+#if JWT_HAS_COROUTINES
+
+namespace jwt {
+
+  template<typename T>
+  struct Task;
+
+  namespace detail {
+
+    /**
+     * Coroutine frames are allocated from small per-thread free lists,
+     * bucketed by size, so that starting a task normally reuses the frame of
+     * one that has finished. Oversized frames go straight to the heap.
+     */
+    void* AllocateFrame(std::size_t);
+    void FreeFrame(void*, std::size_t);
+
+    struct FinalAwaiter;
+
+    struct PromiseBase {
+      PromiseBase() : homeOwner_(nullptr) {}
+
+      coro::coroutine_handle<> continuation_;
+      CancellationToken token_;
+      std::exception_ptr exception_;
+
+      // The executor the task was spawned to run on & the object it was
+      // spawned for (see Task::WithHome); inherited like the token
+      std::shared_ptr<Executor> home_;
+      const void* homeOwner_;
+
+      static void* operator new(std::size_t n) { return AllocateFrame(n); }
+      static void operator delete(void* p, std::size_t n) { FreeFrame(p, n); }
+
+      coro::suspend_always initial_suspend() noexcept { return {}; }
+      FinalAwaiter final_suspend() noexcept;
+
+      void unhandled_exception() { exception_ = std::current_exception(); }
+
+      // Coroutines TS spelling of unhandled_exception
+      void set_exception(std::exception_ptr e) { exception_ = std::move(e); }
+    };
+
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+
+#if JWT_SYMMETRIC_TRANSFER
+      template<typename Promise>
+      coro::coroutine_handle<> await_suspend(coro::coroutine_handle<Promise> h) noexcept {
+        coro::coroutine_handle<> c = h.promise().continuation_;
+        return (c) ? c : coro::noop_coroutine();
+      }
+#else
+      template<typename Promise>
+      void await_suspend(coro::coroutine_handle<Promise> h) noexcept {
+        coro::coroutine_handle<> c = h.promise().continuation_;
+        if (c) {
+          c.resume();
+        }
+      }
+#endif
+
+      void await_resume() noexcept {}
+    };
+
+    inline FinalAwaiter PromiseBase::final_suspend() noexcept { return {}; }
+
+    /**
+     * Gets the cancellation token of the coroutine doing the awaiting, or a
+     * never-cancelled one if it isn't a JWT task.
+     */
+    template<typename Promise>
+    typename std::enable_if<std::is_base_of<PromiseBase, Promise>::value, const CancellationToken&>::type
+    TokenOf(Promise& p) {
+      return p.token_;
+    }
+
+    template<typename Promise>
+    typename std::enable_if<!std::is_base_of<PromiseBase, Promise>::value, const CancellationToken&>::type
+    TokenOf(Promise&) {
+      static const CancellationToken never;
+      return never;
+    }
+
+    /**
+     * Gets the promise of the coroutine doing the awaiting as a PromiseBase,
+     * or nullptr if it isn't a JWT task.
+     */
+    template<typename Promise>
+    typename std::enable_if<std::is_base_of<PromiseBase, Promise>::value, PromiseBase*>::type
+    BaseOf(Promise& p) {
+      return &p;
+    }
+
+    template<typename Promise>
+    typename std::enable_if<!std::is_base_of<PromiseBase, Promise>::value, PromiseBase*>::type
+    BaseOf(Promise&) {
+      return nullptr;
+    }
+
+    template<typename T>
+    struct Promise : PromiseBase {
+      Promise() : hasValue_(false) {}
+
+      ~Promise() {
+        if (hasValue_) {
+          reinterpret_cast<T*>(&value_)->~T();
+        }
+      }
+
+      Task<T> get_return_object();
+
+      template<typename U>
+      void return_value(U&& v) {
+        new (&value_) T(std::forward<U>(v));
+        hasValue_ = true;
+      }
+
+      T Result() {
+        if (exception_) {
+          std::rethrow_exception(exception_);
+        }
+        return std::move(*reinterpret_cast<T*>(&value_));
+      }
+
+    private:
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type value_;
+      bool hasValue_;
+    };
+
+    template<>
+    struct Promise<void> : PromiseBase {
+      Task<void> get_return_object();
+
+      void return_void() {}
+
+      void Result() {
+        if (exception_) {
+          std::rethrow_exception(exception_);
+        }
+      }
+    };
+  }
+
+  /**
+   * A coroutine that produces a T (or nothing, for Task<>).
+   *
+   * Tasks are lazy: the body doesn't start until the task is co_awaited or
+   * handed to Spawn. Awaiting a task runs it to completion (however many
+   * times it suspends along the way) & yields its result, rethrowing any
+   * exception that escaped it.
+   * ~~~~~~{.cpp}
+   * Task<std::string> LoadAsync(std::wstring path) {
+   *   co_await ResumeOn(DefaultWorkerPool());
+   *   co_return ReadWholeFile(path);
+   * }
+   * ~~~~~~
+   *
+   * Cancellation
+   * ------------
+   * A task carries a CancellationToken, inherited from whoever awaits it
+   * unless it was given one explicitly (see Spawn). ResumeOn checks the token
+   * when the task resumes & throws TaskCancelled if it has been cancelled, so
+   * a task that outlives the window it was working for unwinds at its next
+   * hop instead of touching a destroyed window.
+   */
+  template<typename T = void>
+  struct Task {
+    typedef detail::Promise<T> promise_type;
+    typedef coro::coroutine_handle<promise_type> Handle;
+
+    Task() : handle_(nullptr) {}
+
+    Task(Task&& t) : handle_(t.handle_) { t.handle_ = nullptr; }
+
+    Task& operator= (Task&& t) {
+      if (this != &t) {
+        Reset();
+        handle_ = t.handle_;
+        t.handle_ = nullptr;
+      }
+      return *this;
+    }
+
+    ~Task() { Reset(); }
+
+    bool Valid() const { return (bool) handle_; }
+    bool Done() const { return !handle_ || handle_.done(); }
+
+    /**
+     * Binds the task to a token. A bound task ignores the token of whoever
+     * awaits it.
+     */
+    Task& WithCancellation(CancellationToken t) {
+      handle_.promise().token_ = std::move(t);
+      return *this;
+    }
+
+    /**
+     * Gives the task a home: the executor it was started for, & the object
+     * (usually a Window) that executor belongs to. Awaiting
+     * ResumeOn(owner, ...) with that object then resumes on home without
+     * touching owner, which may have been destroyed on another thread. Like
+     * the token, the home is inherited by the tasks this one awaits.
+     */
+    Task& WithHome(std::shared_ptr<Executor> home, const void* owner) {
+      handle_.promise().home_ = std::move(home);
+      handle_.promise().homeOwner_ = owner;
+      return *this;
+    }
+
+    struct Awaiter {
+      Handle handle_;
+
+      bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+#if JWT_SYMMETRIC_TRANSFER
+      template<typename Promise>
+      coro::coroutine_handle<> await_suspend(coro::coroutine_handle<Promise> awaiter) noexcept {
+        Inherit(awaiter);
+        return handle_;
+      }
+#else
+      template<typename Promise>
+      void await_suspend(coro::coroutine_handle<Promise> awaiter) noexcept {
+        Inherit(awaiter);
+        handle_.resume();
+      }
+#endif
+
+      T await_resume() { return handle_.promise().Result(); }
+
+    private:
+      template<typename Promise>
+      void Inherit(coro::coroutine_handle<Promise> awaiter) {
+        promise_type& p = handle_.promise();
+
+        p.continuation_ = awaiter;
+        if (!p.token_.CanBeCancelled()) {
+          p.token_ = detail::TokenOf(awaiter.promise());
+        }
+
+        detail::PromiseBase* parent = detail::BaseOf(awaiter.promise());
+        if (!p.home_ && parent) {
+          p.home_ = parent->home_;
+          p.homeOwner_ = parent->homeOwner_;
+        }
+      }
+    };
+
+    Awaiter operator co_await() && {
+      return Awaiter{ handle_ };
+    }
+
+  private:
+    friend struct detail::Promise<T>;
+
+    explicit Task(Handle h) : handle_(h) {}
+
+    void Reset() {
+      if (handle_) {
+        handle_.destroy();
+        handle_ = nullptr;
+      }
+    }
+
+    Handle handle_;
+  };
+
+  namespace detail {
+    template<typename T>
+    Task<T> Promise<T>::get_return_object() {
+      return Task<T>(coro::coroutine_handle<Promise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> Promise<void>::get_return_object() {
+      return Task<void>(coro::coroutine_handle<Promise<void>>::from_promise(*this));
+    }
+  }
+
+  /**
+   * Awaitable that suspends the current coroutine & resumes it on an
+   * executor:
+   * ~~~~~~{.cpp}
+   * co_await ResumeOn(DefaultWorkerPool());   // now on a pool thread
+   * ...
+   * co_await ResumeOn(w.OwningPump());        // back on the UI thread
+   * ~~~~~~
+   * The awaiter is itself the WorkItem posted to the executor; it lives in
+   * the coroutine frame, so a hop costs no allocation.
+   *
+   * Throws TaskCancelled on resumption if the task's token was cancelled in
+   * the meantime (or without suspending at all if it was already cancelled).
+   */
+  struct ResumeOnAwaiter
+    : WorkItem
+  {
+    explicit ResumeOnAwaiter(Executor& e)
+      : WorkItem(&Run), executor_(&e), owner_(nullptr), executorOf_(nullptr), token_(nullptr)
+    {}
+
+    /**
+     * Resumes on the executor belonging to owner. If the task's home owner
+     * is owner (see Task::WithHome), that is the task's home executor &
+     * owner is never touched; otherwise executorOf(owner) is called from the
+     * awaiting thread, so owner must be alive & safe to use there.
+     */
+    ResumeOnAwaiter(const void* owner, Executor& (*executorOf)(const void*))
+      : WorkItem(&Run), executor_(nullptr), owner_(owner), executorOf_(executorOf), token_(nullptr)
+    {}
+
+    bool await_ready() const noexcept { return false; }
+
+    template<typename Promise>
+    bool await_suspend(coro::coroutine_handle<Promise> h) {
+      token_ = &detail::TokenOf(h.promise());
+      if (token_->Cancelled()) {
+        return false;
+      }
+
+      // Held until Post returns: the task may resume, finish & drop its
+      // home on the executor's thread before then
+      std::shared_ptr<Executor> home;
+      Executor* e = executor_;
+
+      if (!e) {
+        detail::PromiseBase* p = detail::BaseOf(h.promise());
+
+        if (p && p->home_ && p->homeOwner_ == owner_) {
+          home = p->home_;
+          e = home.get();
+        }
+        else {
+          e = &executorOf_(owner_);
+        }
+      }
+
+      handle_ = h;
+      e->Post(this);
+      return true;
+    }
+
+    void await_resume() const {
+      if (token_ && token_->Cancelled()) {
+        throw TaskCancelled();
+      }
+    }
+
+  private:
+    static void Run(WorkItem* w) {
+      static_cast<ResumeOnAwaiter*>(w)->handle_.resume();
+    }
+
+    Executor* executor_;
+    const void* owner_;
+    Executor& (*executorOf_)(const void*);
+    const CancellationToken* token_;
+    coro::coroutine_handle<> handle_;
+  };
+
+  inline ResumeOnAwaiter ResumeOn(Executor& e) {
+    return ResumeOnAwaiter(e);
+  }
+
+  namespace detail {
+    struct Detached {
+      struct promise_type {
+        static void* operator new(std::size_t n) { return AllocateFrame(n); }
+        static void operator delete(void* p, std::size_t n) { FreeFrame(p, n); }
+
+        Detached get_return_object() { return Detached(); }
+
+        coro::suspend_never initial_suspend() noexcept { return {}; }
+        coro::suspend_never final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+        void set_exception(std::exception_ptr) { std::terminate(); }
+      };
+    };
+
+    Detached RunDetached(Task<void>, std::function<void(std::exception_ptr)>);
+
+    // A coroutine lambda's captures live in the closure, not the frame; copy
+    // the closure into a frame of our own so that it outlives the call.
+    template<typename Callable>
+    Task<void> InvokeOwned(Callable f) {
+      co_await f();
+    }
+  }
+
+  /**
+   * Starts a task that nobody will await. It runs synchronously up to its
+   * first suspension & cleans itself up when it finishes.
+   *
+   * The task is bound to token. If it fails with TaskCancelled nothing
+   * happens; any other exception is passed to onError, on whatever thread
+   * the task was running when it failed.
+   */
+  inline void Spawn(Task<void> t, CancellationToken token, std::function<void(std::exception_ptr)> onError) {
+    assert(t.Valid());
+
+    t.WithCancellation(std::move(token));
+    detail::RunDetached(std::move(t), std::move(onError));
+  }
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <algorithm>
+#include <assert.h>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ *
+ * thread-registry.hpp contains ThreadRegistry & ThreadOwned, which between
+ * them give each thread at most one of something & let other threads find
+ * it. MessagePump uses them for the per-thread pumps (see DefaultPump).
+ *
+ * Both are portable.
+ */
+
+namespace jwt {
+
+  /**
+   * Objects belonging to one thread each, keyed by that thread's id so that
+   * other threads can find them. Objects are added & removed on their own
+   * thread but may be looked up from any; hence the lock.
+   */
+  template<typename T, typename ThreadId>
+  struct ThreadRegistry {
+    /**
+     * Registers t as the object of thread id, which mustn't have one yet.
+     */
+    void Add(ThreadId id, T* t) {
+      std::lock_guard<std::mutex> lock(lock_);
+
+      assert(!FindLocked(id));
+      entries_.push_back(std::make_pair(id, t));
+    }
+
+    /**
+     * Unregisters t; does nothing if it isn't registered.
+     */
+    void Remove(T* t) {
+      std::lock_guard<std::mutex> lock(lock_);
+
+      entries_.erase(
+        std::remove_if(begin(entries_), end(entries_), [t](const Entry& e) { return e.second == t; }),
+        end(entries_)
+      );
+    }
+
+    /**
+     * @return the object of thread id, or nullptr if it has none
+     */
+    T* Find(ThreadId id) const {
+      std::lock_guard<std::mutex> lock(lock_);
+      return FindLocked(id);
+    }
+
+  private:
+    typedef std::pair<ThreadId, T*> Entry;
+
+    T* FindLocked(ThreadId id) const {
+      for (const Entry& e : entries_) {
+        if (e.first == id) {
+          return e.second;
+        }
+      }
+      return nullptr;
+    }
+
+    mutable std::mutex lock_;
+    std::vector<Entry> entries_;
+  };
+
+  /**
+   * The calling thread's T, when declared thread_local: created by the first
+   * Get on each thread.
+   *
+   * Anything may share ownership of it through the shared_ptr Share gives.
+   * When the thread exits, onThreadExit is called & the thread's own
+   * reference is dropped; the T goes with the last reference, which may be
+   * held by something destroyed after the thread-locals (a static, say).
+   */
+  template<typename T>
+  struct ThreadOwned {
+    explicit ThreadOwned(void (*onThreadExit)(T&) = nullptr)
+      : onThreadExit_(onThreadExit)
+    {}
+
+    ~ThreadOwned() {
+      if (object_ && onThreadExit_) {
+        onThreadExit_(*object_);
+      }
+    }
+
+    T& Get() {
+      if (!object_) {
+        object_ = std::make_shared<T>();
+      }
+      return *object_;
+    }
+
+    std::shared_ptr<T> Share() {
+      Get();
+      return object_;
+    }
+
+    bool Created() const { return !!object_; }
+
+  private:
+    ThreadOwned(const ThreadOwned&) = delete;
+    ThreadOwned& operator= (const ThreadOwned&) = delete;
+
+    std::shared_ptr<T> object_;
+    void (*onThreadExit_)(T&);
+  };
+
+}
\ No newline at end of file
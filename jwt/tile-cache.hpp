@@ -0,0 +1,170 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "box.hpp"
+#include "raster.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * @file
+ *
+ * tile-cache.hpp contains TileCache, which keeps rendered pieces of a large
+ * scrolling canvas so that scrolling only renders what comes into view for
+ * the first time.
+ *
+ * It has no Windows dependencies; see ScrollPane::UseTileCache for the UI
+ * side.
+ */
+
+namespace jwt {
+
+  /**
+   * Square tiles of rendered content, kept in least-recently-used order
+   * under a memory budget.
+   *
+   * The content is a canvas of any size (up to Extent) drawn by a Renderer
+   * on demand, one tile at a time. Visit walks the tiles covering a
+   * viewport, rendering those that are missing or have been invalidated &
+   * reusing the rest, & hands each to the caller to copy to the screen. A
+   * scroll that exposes a strip of the canvas costs a render of the tiles
+   * that strip reaches into, & only the first time.
+   *
+   * When a new tile would take the cache over budget, the least recently
+   * used tile that isn't part of the current Visit gives up its pixels
+   * instead. A viewport needing more tiles than the budget allows still
+   * gets them; the excess goes at the end of the Visit.
+   *
+   * Invalidate marks the tiles an area of the canvas touches as stale: they
+   * are rendered again when next visited, & are the first to be reused
+   * meanwhile.
+   */
+  struct TileCache {
+    enum {
+      DEFAULT_TILE_SIZE = 256,
+      DEFAULT_BUDGET = 32 * 1024 * 1024
+    };
+
+    /**
+     * Renders the area of the canvas a tile covers. The tile's pixel (0, 0)
+     * is (area.x, area.y) on the canvas, & it has been cleared to the
+     * background first.
+     */
+    typedef std::function<void(Raster& tile, const Box& area)> Renderer;
+
+    /**
+     * Receives a visited tile: the part src of it belongs at (x, y) relative
+     * to the viewport's top left.
+     */
+    typedef std::function<void(const Raster& tile, const Box& src, int x, int y)> Visitor;
+
+    explicit TileCache(Renderer, std::size_t budgetBytes = DEFAULT_BUDGET, int tileSize = DEFAULT_TILE_SIZE);
+
+    int TileSize() const { return tileSize_; }
+    std::size_t TileBytes() const { return (std::size_t) tileSize_ * tileSize_ * 4; }
+
+    /**
+     * Size of the canvas; nothing outside (0, 0, w, h) is visited.
+     * Shrinking it drops the tiles that no longer fit. Until it is set the
+     * canvas is 2^30 pixels square.
+     */
+    void SetExtent(int w, int h);
+    int ExtentW() const { return extentW_; }
+    int ExtentH() const { return extentH_; }
+
+    std::uint32_t Background() const { return background_; }
+    void SetBackground(std::uint32_t argb);
+
+    /**
+     * Visits the tiles covering viewport (a box on the canvas), top row
+     * first.
+     */
+    void Visit(const Box& viewport, const Visitor&);
+
+    /**
+     * Copies viewport from the tiles into target, whose pixel (0, 0) is the
+     * viewport's top left.
+     */
+    void Compose(Raster& target, const Box& viewport);
+
+    void Invalidate(const Box& area);
+    void InvalidateAll();
+
+    /**
+     * Frees every tile.
+     */
+    void Clear();
+
+    std::size_t Budget() const { return budget_; }
+    void SetBudget(std::size_t bytes);
+
+    std::size_t Bytes() const { return tiles_.size() * TileBytes(); }
+    std::size_t Tiles() const { return tiles_.size(); }
+
+    /**
+     * Counts since construction of tiles visited from the cache & tiles
+     * rendered; for measuring how well the budget fits the scrolling.
+     */
+    std::uint64_t Hits() const { return hits_; }
+    std::uint64_t Renders() const { return renders_; }
+
+  private:
+    TileCache(const TileCache&) = delete;
+    TileCache& operator= (const TileCache&) = delete;
+
+    typedef std::uint64_t Key;
+
+    struct Tile {
+      std::unique_ptr<Raster> pixels;
+      std::list<Key>::iterator lru;
+      std::uint32_t visit;
+      bool valid;
+    };
+
+    static Key KeyOf(int tx, int ty) {
+      return ((Key) (std::uint32_t) tx << 32) | (std::uint32_t) ty;
+    }
+
+    Tile& Acquire(int tx, int ty);
+    void Render(Tile&, int tx, int ty);
+    void Trim();
+    void Drop(Key);
+
+    Renderer renderer_;
+    int tileSize_;
+    std::size_t budget_;
+
+    int extentW_;
+    int extentH_;
+    std::uint32_t background_;
+
+    std::unordered_map<Key, Tile> tiles_;
+    std::list<Key> lru_;      // most recently used first
+    std::uint32_t visit_;
+
+    std::uint64_t hits_;
+    std::uint64_t renders_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "timer-wheel.hpp"
+
+namespace jwt {
+
+  struct MessagePump;
+
+  /**
+   * TimerService runs any number of timers on a MessagePump's thread using a
+   * single kernel timer.
+   *
+   * Get one from MessagePump::Timers() rather than constructing it yourself:
+   * ~~~~~~{.cpp}
+   * TimerService& timers = DefaultPump().Timers();
+   *
+   * TimerService::TimerId blink = timers.Every(500, [&]() { ToggleCaret(); });
+   * timers.Once(2000, [&]() { HideTooltip(); });
+   * ...
+   * timers.Cancel(blink);
+   * ~~~~~~
+   *
+   * Unlike SetTimer, timers don't need a window, don't consume USER timer ids
+   * and cost nothing while they are not due: the service keeps them in a
+   * TimerWheel & arms one waitable timer for the earliest deadline.
+   *
+   * Coalescing
+   * ----------
+   * Wake-ups are rounded up to a multiple of the slack (see SetSlack), so
+   * timers whose deadlines fall in the same slack window fire together on a
+   * single wake. A timer may therefore fire up to `slack` milliseconds late,
+   * never early. The default slack of 0 fires each timer as close to its
+   * deadline as Windows allows.
+   */
+  struct TimerService {
+    typedef TimerWheel::TimerId TimerId;
+    typedef TimerWheel::Callback Callback;
+
+    static const TimerId INVALID_TIMER = TimerWheel::INVALID_TIMER;
+
+    explicit TimerService(MessagePump&);
+    ~TimerService();
+
+    /**
+     * Calls c once, after delay milliseconds.
+     */
+    TimerId Once(DWORD delay, Callback c);
+
+    /**
+     * Calls c every period milliseconds until cancelled. Periods are measured
+     * from the original deadline so the timer does not drift; if the thread
+     * is too busy to service it, missed periods are skipped.
+     */
+    TimerId Every(DWORD period, Callback c);
+
+    /**
+     * Cancels a timer. Safe to call from inside any timer's callback,
+     * including the timer being cancelled.
+     *
+     * @return false if the timer has already fired or been cancelled
+     */
+    bool Cancel(TimerId);
+
+    void SetSlack(DWORD milliseconds);
+    DWORD Slack() const { return slack_; }
+
+    size_t Count() const { return wheel_.Size(); }
+
+  private:
+    TimerService(const TimerService&) = delete;
+    TimerService& operator= (const TimerService&) = delete;
+
+    void Fire();
+    void Rearm();
+
+    MessagePump& pump_;
+    HANDLE timer_;
+    TimerWheel wheel_;
+
+    DWORD slack_;
+
+    bool armed_;
+    TimerWheel::Time armedFor_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @file
+ *
+ * timer-wheel.hpp contains TimerWheel, the bookkeeping behind TimerService.
+ *
+ * It deliberately has no Windows dependencies: time is whatever the caller
+ * says it is, which makes the wheel easy to drive from a virtual clock.
+ */
+
+namespace jwt {
+
+  /**
+   * A hierarchical timing wheel.
+   *
+   * Timers live in one of four levels of 64 slots each. Level 0 slots are
+   * one tick wide, level 1 slots 64 ticks and so on; timers further out than
+   * 64^4 ticks wait on an overflow list. As time advances, timers cascade
+   * down the levels until they reach level 0 & expire.
+   *
+   * - Schedule and Cancel are O(1): each slot is an intrusive doubly-linked
+   *   list threaded through a single node array.
+   * - Advance only visits ticks at which something can happen (a non-empty
+   *   slot or a cascade), found using a 64-bit occupancy mask per level, so
+   *   long idle periods are skipped cheaply.
+   *
+   * Callbacks may schedule & cancel timers (including themselves). If a
+   * callback throws, the timers that were due alongside it stay due & are
+   * fired by the next call to Advance.
+   */
+  struct TimerWheel {
+    typedef std::uint64_t Time;
+    typedef std::uint64_t TimerId;
+    typedef std::function<void()> Callback;
+
+    /**
+     * Returned by Schedule on failure & never a valid id; safe to Cancel.
+     */
+    static const TimerId INVALID_TIMER = 0;
+
+    explicit TimerWheel(Time now = 0);
+
+    /**
+     * Schedules c to run once time reaches deadline. If period is non-zero
+     * the timer then repeats every period ticks until cancelled. Deadlines
+     * in the past fire on the next call to Advance.
+     */
+    TimerId Schedule(Time deadline, Time period, Callback c);
+
+    /**
+     * Cancels a timer. Returns false if it has already fired (one-shot
+     * timers) or been cancelled.
+     */
+    bool Cancel(TimerId);
+
+    /**
+     * Moves time forward to now, firing every timer whose deadline is <= now.
+     * @return the number of callbacks that were run
+     */
+    size_t Advance(Time now);
+
+    /**
+     * Gets a time at or before the earliest pending deadline; it is exact
+     * when that timer has reached level 0, otherwise it is the time of the
+     * next cascade. Either way it is the right time to call Advance next.
+     *
+     * @return false if there are no timers
+     */
+    bool NextDeadline(Time& deadline) const;
+
+    Time Now() const { return now_; }
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+
+  private:
+    enum {
+      LEVEL_BITS = 6,
+      SLOTS = 1 << LEVEL_BITS,
+      LEVELS = 4,
+
+      // Special lists after the LEVELS * SLOTS wheel slots
+      DUE_LIST = LEVELS * SLOTS,
+      OVERFLOW_LIST,
+      FIRING_LIST,
+      LIST_COUNT,
+
+      FREE = 0xFFFF
+    };
+
+    static const std::uint32_t NIL = 0xFFFFFFFF;
+
+    struct Node {
+      Time deadline;
+      Time period;
+      Callback callback;
+
+      std::uint32_t prev;
+      std::uint32_t next;
+      std::uint32_t generation;
+      std::uint16_t list;
+    };
+
+    struct List {
+      std::uint32_t head;
+      std::uint32_t tail;
+    };
+
+    Time now_;
+    size_t size_;
+
+    std::vector<Node> nodes_;
+    std::uint32_t freeList_;
+
+    List lists_[LIST_COUNT];
+    std::uint64_t occupied_[LEVELS];
+
+    std::uint32_t Allocate();
+    void Release(std::uint32_t);
+
+    void Insert(std::uint32_t);
+    void PushBack(std::uint16_t list, std::uint32_t);
+    void Unlink(std::uint32_t);
+    void Splice(std::uint16_t from, std::uint16_t to);
+
+    void Cascade(std::uint16_t list);
+    bool NextEvent(Time& t) const;
+    size_t FireList(Time target);
+
+    static TimerId MakeId(std::uint32_t index, std::uint32_t generation) {
+      return ((TimerId) generation << 32) | index;
+    }
+  };
+
+}
\ No newline at end of file
@@ -23,9 +23,34 @@
 #include "dialog.hpp"
 #include "defer-create.hpp"
 #include "event-types.hpp"
+#include "resources.hpp"
+#include <initializer_list>
+#include <vector>
 
 namespace jwt {
 
+  /**
+   * Describes one button for Toolbar::AddButtons. Arguments are as for
+   * Toolbar::AddButton; use Separator() for a separator.
+   */
+  struct ToolbarButton {
+    int baseImgIndex;
+    int subImgIndex;
+    int id;
+    std::wstring label;
+    bool separator;
+
+    ToolbarButton(int baseImgIndex, int subImgIndex, int id, const std::wstring& label)
+      : baseImgIndex(baseImgIndex), subImgIndex(subImgIndex), id(id), label(label), separator(false)
+    {}
+
+    static ToolbarButton Separator() {
+      ToolbarButton b(0, 0, 0, L"");
+      b.separator = true;
+      return b;
+    }
+  };
+
   struct Toolbar
     : Window
   {
@@ -34,9 +59,31 @@ namespace jwt {
     int AddStandardBitmap(UINT id);
     int AddBitmapResource(UINT id);
 
+    /**
+     * Gives the toolbar an image list shared with every other toolbar that
+     * uses the same resource & size (see SharedImageList), rather than a
+     * private copy of the bitmap.
+     *
+     * @return the image list index; pass it as baseImgIndex to AddButton
+     */
+    int AddSharedBitmap(UINT id, int imageWidth = 16);
+
     Toolbar& AddButton(int baseImgIndex, int subImgIndex, int id, const std::wstring& label);
     Toolbar& AddSeparator();
 
+    /**
+     * Adds any number of buttons with a single TB_ADDBUTTONS, with redraw
+     * suppressed until they are all in.
+     */
+    Toolbar& AddButtons(const ToolbarButton*, std::size_t count);
+    Toolbar& AddButtons(const std::initializer_list<ToolbarButton>&);
+
+    template<typename InputIterator>
+    Toolbar& AddButtons(InputIterator first, InputIterator last) {
+      std::vector<ToolbarButton> buttons(first, last);
+      return AddButtons(buttons.data(), buttons.size());
+    }
+
     Toolbar& Autosize();
 
   protected:
@@ -45,6 +92,13 @@ namespace jwt {
     void Create(Window& parent);
 
     LRESULT HandleReflectedMessage(HWND, UINT, WPARAM, LPARAM);
+
+  private:
+    // Image list 0 is the one TB_ADDBITMAP adds to; shared lists go after it
+    int nextImageList_;
+
+    // Bitmaps added by AddBitmapResource, kept loaded for the toolbar's life
+    std::vector<ResourceRef> bitmaps_;
   };
 
 }
\ No newline at end of file
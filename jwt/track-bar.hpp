@@ -23,20 +23,59 @@
 #include "dialog.hpp"
 #include "defer-create.hpp"
 #include "event-types.hpp"
+#include "messages.hpp"
+#include "timer-service.hpp"
 
 namespace jwt {
 
+  /**
+   * Passed to LatestChange handlers.
+   *
+   * `tracking` is true while the user is still dragging the thumb (or holding
+   * down a key or the mouse on the channel) & false for the position the
+   * user settled on. Handlers typically do cheap previews while tracking &
+   * the real work once it is false.
+   */
+  struct TrackChange {
+    int value;
+    bool tracking;
+  };
+
   struct TrackBar
     : Window
   {
     TrackBar(Window& parent);
     TrackBar(Dialog& parent, int ctrlId);
+    ~TrackBar();
 
+    /**
+     * Called for every scroll notification.
+     *
+     * A TrackBar only has scroll notifications reflected to it while it has
+     * Change or LatestChange listeners.
+     */
     template<typename Callable>
     auto On(const ChangeTag&, Callable c) -> decltype(onChange_.connect(c)) {
+      Reflect(REFLECT_SCROLL, true);
       return onChange_.connect(c);
     }
 
+    /**
+     * Coalescing version of On(Change): notifications are collected until
+     * the pump has drained its queue & the handler is then called once with
+     * the latest position. A fast drag that generates dozens of WM_HSCROLLs
+     * between frames results in a single call.
+     *
+     * The final position (tracking == false) is always delivered. To move
+     * expensive work off the UI thread as well, hand the value to a
+     * MailboxWorker (see mailbox.hpp).
+     */
+    template<typename Callable>
+    auto On(const LatestChangeTag&, Callable c) -> decltype(onLatestChange_.connect(c)) {
+      Reflect(REFLECT_SCROLL, true);
+      return onLatestChange_.connect(c);
+    }
+
   protected:
     TrackBar(const defer_create_t&);
 
@@ -45,7 +84,18 @@ namespace jwt {
     LRESULT HandleReflectedMessage(HWND, UINT, WPARAM, LPARAM);
 
   private:
+    friend TrackBar& SetValue(TrackBar&, int);
+
+    bool Watched() const { return !onChange_.empty() || !onLatestChange_.empty(); }
+
+    void QueueLatest(const ScrollMsg&);
+    void DeliverLatest();
+
     boost::signals2::signal<void()> onChange_;
+    boost::signals2::signal<void(const TrackChange&)> onLatestChange_;
+
+    TrackChange latest_;
+    TimerService::TimerId latestDelivery_;
   };
 
   int GetValue(const TrackBar&);
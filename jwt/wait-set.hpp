@@ -0,0 +1,174 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <algorithm>
+#include <assert.h>
+#include <exception>
+#include <functional>
+#include <vector>
+
+/**
+ * @file
+ *
+ * wait-set.hpp contains WaitSet, the handles & callbacks behind
+ * MessagePump::AddWait.
+ *
+ * It is portable: the handle type & the call that polls handles are
+ * template parameters, so it can be tested without kernel objects.
+ */
+
+namespace jwt {
+
+  /**
+   * Handles to wait on, each with a callback to run when it is signalled.
+   *
+   * The owner hands Handles() to its blocking wait (MsgWaitForMultipleObjects
+   * & the like) & passes the index that woke it to Dispatch. Those waits
+   * report the lowest signalled index only, so Dispatch polls the handles
+   * after it as well: a handle early in the array that is signalled on every
+   * wake (MessagePump's post event) can't starve the ones behind it.
+   *
+   * Remove may be called from inside a callback; entries are only cleared
+   * then, & dropped by the next Compact.
+   */
+  template<typename Handle>
+  struct WaitSet {
+    typedef std::function<void()> Callback;
+
+    WaitSet() : removed_(false) {}
+
+    /**
+     * h mustn't be a value-initialized Handle; that marks removed entries.
+     */
+    void Add(Handle h, Callback c) {
+      assert(h != Handle());
+      assert(c);
+
+      handles_.push_back(h);
+      callbacks_.push_back(c);
+    }
+
+    /**
+     * @return false if h wasn't registered
+     */
+    bool Remove(Handle h) {
+      auto i = std::find(begin(handles_), end(handles_), h);
+      if (i == end(handles_)) {
+        return false;
+      }
+
+      size_t index = i - begin(handles_);
+      handles_[index] = Handle();
+      callbacks_[index] = nullptr;
+      removed_ = true;
+      return true;
+    }
+
+    /**
+     * Drops removed entries; call before handing Handles() to a wait.
+     */
+    void Compact() {
+      if (!removed_) {
+        return;
+      }
+
+      size_t j = 0;
+      for (size_t i = 0; i < handles_.size(); ++i) {
+        if (handles_[i] != Handle()) {
+          handles_[j] = handles_[i];
+          callbacks_[j] = std::move(callbacks_[i]);
+          ++j;
+        }
+      }
+      handles_.resize(j);
+      callbacks_.resize(j);
+
+      removed_ = false;
+    }
+
+    const Handle* Handles() const { return (handles_.empty()) ? nullptr : &handles_[0]; }
+    size_t Size() const { return handles_.size(); }
+
+    /**
+     * Runs the callback of the handle at index first, which a wait has just
+     * reported as signalled, then those of the handles after it that are
+     * signalled too. Each runs at most once.
+     *
+     * poll(const Handle*, size_t count) must return the index of the first
+     * signalled handle of the count given without blocking, or count if
+     * there are none. Exceptions from callbacks go to report(exception_ptr)
+     * so that the rest still run.
+     *
+     * @return the number of callbacks run
+     */
+    template<typename Poll, typename Report>
+    size_t Dispatch(size_t first, Poll poll, Report report) {
+      assert(first < handles_.size());
+
+      // Callbacks may add & remove entries: added ones wait for the next
+      // wake, removed ones are skipped. Indices stay put until Compact.
+      size_t end = handles_.size();
+      size_t ran = 0;
+      std::vector<Handle> rest;
+      std::vector<size_t> restIndex;
+
+      for (size_t next = first; ; ) {
+        if (handles_[next] != Handle()) {
+          Run(next, report);
+          ++ran;
+        }
+
+        rest.clear();
+        restIndex.clear();
+        for (size_t i = next + 1; i < end; ++i) {
+          if (handles_[i] != Handle()) {
+            rest.push_back(handles_[i]);
+            restIndex.push_back(i);
+          }
+        }
+
+        size_t signalled = (rest.empty()) ? 0 : poll(&rest[0], rest.size());
+        if (signalled >= rest.size()) {
+          return ran;
+        }
+        next = restIndex[signalled];
+      }
+    }
+
+  private:
+    template<typename Report>
+    void Run(size_t index, Report& report) {
+      // Copy: the callback may add waits, moving the vector
+      Callback c = callbacks_[index];
+
+      try {
+        c();
+      }
+      catch (...) {
+        report(std::current_exception());
+      }
+    }
+
+    std::vector<Handle> handles_;
+    std::vector<Callback> callbacks_;
+    bool removed_;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ *
+ * warm-pool.hpp contains WarmPool, which keeps expensive objects built
+ * ahead of time & reuses them rather than destroying them.
+ *
+ * It has no Windows dependencies; see DialogPool for the UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * A pool of ready-made objects, filled a little at a time & capped by a
+   * memory budget.
+   *
+   * The pool never builds anything by itself: whoever owns it calls WarmOne
+   * when there is time to spare (DialogPool does so when its thread is idle)
+   * until NeedsWarming returns false. Acquire hands out a ready object, or
+   * builds one on the spot if none is ready. Release resets an object & keeps
+   * it for next time, unless that would take the pool over its budget.
+   *
+   * Each object is assumed to cost the same number of bytes; the pool holds
+   * at most min(maxReady, budget / itemBytes) ready objects. Objects that are
+   * out on loan don't count against the budget.
+   *
+   * Not thread-safe: a pool belongs to one thread.
+   */
+  template<typename T>
+  struct WarmPool {
+    typedef std::function<std::unique_ptr<T>()> Factory;
+    typedef std::function<void(T&)> Reset;
+
+    /**
+     * @param reset  called on each released object before it is kept; may
+     *               be empty if objects need no resetting
+     */
+    WarmPool(Factory factory, Reset reset, std::size_t maxReady, std::size_t itemBytes, std::size_t budgetBytes)
+      : factory_(std::move(factory)), reset_(std::move(reset)),
+      maxReady_(maxReady), itemBytes_(std::max<std::size_t>(itemBytes, 1)), budget_(budgetBytes),
+      hits_(0), misses_(0), built_(0)
+    {}
+
+    /**
+     * Number of ready objects the pool will hold.
+     */
+    std::size_t Capacity() const {
+      return std::min(maxReady_, budget_ / itemBytes_);
+    }
+
+    std::size_t Ready() const { return ready_.size(); }
+
+    bool NeedsWarming() const { return ready_.size() < Capacity(); }
+
+    /**
+     * Builds one object if the pool is short of capacity; one per call so
+     * that the caller can spread the work over several idle slices.
+     *
+     * @return true if more warming is wanted
+     */
+    bool WarmOne() {
+      if (NeedsWarming()) {
+        ready_.push_back(Build());
+      }
+      return NeedsWarming();
+    }
+
+    std::unique_ptr<T> Acquire() {
+      if (ready_.empty()) {
+        ++misses_;
+        return Build();
+      }
+
+      ++hits_;
+      std::unique_ptr<T> p = std::move(ready_.back());
+      ready_.pop_back();
+      return p;
+    }
+
+    /**
+     * Resets p & keeps it, or destroys it if the pool is full.
+     */
+    void Release(std::unique_ptr<T> p) {
+      if (!p || ready_.size() >= Capacity()) {
+        return;
+      }
+
+      if (reset_) {
+        reset_(*p);
+      }
+      ready_.push_back(std::move(p));
+    }
+
+    /**
+     * Changing the budget destroys ready objects that no longer fit.
+     */
+    void SetBudget(std::size_t budgetBytes) {
+      budget_ = budgetBytes;
+      Trim();
+    }
+
+    std::size_t Budget() const { return budget_; }
+
+    void Trim() {
+      while (ready_.size() > Capacity()) {
+        ready_.pop_back();
+      }
+    }
+
+    void Clear() { ready_.clear(); }
+
+    /**
+     * Acquires served from the pool & built on demand, & the total number
+     * of objects built.
+     */
+    unsigned int Hits() const { return hits_; }
+    unsigned int Misses() const { return misses_; }
+    unsigned int Built() const { return built_; }
+
+  private:
+    WarmPool(const WarmPool&) = delete;
+    WarmPool& operator= (const WarmPool&) = delete;
+
+    std::unique_ptr<T> Build() {
+      std::unique_ptr<T> p = factory_();
+      ++built_;
+      return p;
+    }
+
+    Factory factory_;
+    Reset reset_;
+
+    std::vector<std::unique_ptr<T>> ready_;
+
+    std::size_t maxReady_;
+    std::size_t itemBytes_;
+    std::size_t budget_;
+
+    unsigned int hits_;
+    unsigned int misses_;
+    unsigned int built_;
+  };
+
+}
\ No newline at end of file
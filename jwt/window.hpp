@@ -20,6 +20,12 @@
 
 #include "libraries.hpp"
 #include "measurement.hpp" 
+#include "message-pump.hpp"
+#include "setter-cache.hpp"
+#include <cstdint>
+#include <memory>
+#include <typeinfo>
+#include <assert.h>
 
 /**
  * @file
@@ -33,6 +39,24 @@
 
 namespace jwt {
 
+  /**
+   * What a lazily-created Window will be created with: recorded by its
+   * constructor & by setters called before it has an HWND, then passed to
+   * CreateWindowEx in one go. See Window::CreateLazily.
+   */
+  struct PendingWindow {
+    const wchar_t* className;
+    HWND parent;        // nullptr once the parent has been destroyed
+    HWND gate;          // hidden ancestor whose showing realizes the window
+    std::uint64_t order;  // creation order, kept when realized in a batch
+    bool dead;          // parent destroyed first; it will never be realized
+    int id;             // control id, passed as CreateWindowEx's hMenu
+    DWORD style;
+    DWORD exStyle;
+    std::wstring text;
+    Rect bounds;
+  };
+
   /**
    *  Window is intended for use as a base-class for classes providing wrappers
    *  for specific window types: i.e. buttons, lists dialogs etc.
@@ -88,6 +112,7 @@ namespace jwt {
    *  - WM_COMMAND
    *  - WM_NOTIFY
    *  - WM_HSCROLL/WM_VSCROLL
+   *  - WM_DRAWITEM
    *
    *  When it identifies one if these messages it should call
    *  `Window::ReflectMessage(...)` copying the message parameters directly to
@@ -97,30 +122,203 @@ namespace jwt {
    *  Window, it calls the virtual function `HandleReflectedMessage(...)` for
    *  that Window. A wrapper subclass should override this function and handle
    *  these messages accordingly. 
+   *
+   *  ### Skipping unobserved messages ###
+   *
+   *  Most controls generate a steady stream of notifications that nobody is
+   *  listening to. To avoid the virtual call for these, each Window carries a
+   *  small bitmask saying which kinds of reflected message it currently wants
+   *  (REFLECT_COMMAND, REFLECT_NOTIFY, REFLECT_SCROLL, REFLECT_DRAW), & may
+   *  narrow REFLECT_COMMAND & REFLECT_NOTIFY to a single notification code.
+   *  ReflectMessage tests these before calling `HandleReflectedMessage(...)`.
+   *
+   *  Every Window wants everything to begin with. The built-in wrappers opt
+   *  out of what they have no listeners for: the first time a reflected
+   *  message finds nobody listening they call `Unreflect<T>(...)`, & when a
+   *  listener connects they turn the bit back on with `Reflect(...)`.
+   *
+   *  Unreflect & ReflectOnly only take effect when the object is exactly the
+   *  wrapper type named, so a subclass that overrides
+   *  `HandleReflectedMessage(...)` keeps receiving everything without doing
+   *  anything. It may opt out itself, if it knows it can:
+   *  ~~~~~~~~~~~~{.cpp}
+   *  LRESULT MyButton::HandleReflectedMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
+   *    if (m != WM_NOTIFY) {
+   *      Unreflect<MyButton>(ReflectFlag(m));
+   *    }
+   *    ...
+   *  }
+   *  ~~~~~~~~~~~~
    */
   struct Window {
 
-    virtual ~Window() {}
+    /**
+     * Cancels Lifetime() tokens.
+     */
+    virtual ~Window();
 
     /**
-     * Gets the HWND contained by this Window.
+     * Gets the HWND contained by this Window, creating it first if the
+     * Window was created lazily & hasn't been realized yet.
      * @return HWND
      */
-    HWND TheHWND() { return hWnd_; }
+    HWND TheHWND() {
+      if (pending_) {
+        Realize();
+      }
+      return hWnd_;
+    }
 
     /**
-     * Gets a const version of the HWND contained by this Window.
+     * Gets a const version of the HWND contained by this Window. This is
+     * nullptr while a lazily-created Window is pending: call Realize first
+     * if the HWND must exist.
      * @return const HWND
      */
-    const HWND TheHWND() const { return hWnd_; }
+    const HWND TheHWND() const {
+      return hWnd_;
+    }
+
+    /**
+     * Creates the HWND of a lazily-created Window now, rather than waiting
+     * for it to be shown. Does nothing if the Window already has an HWND, or
+     * if it is dead: its parent was destroyed before it was realized, so it
+     * stays pending (& TheHWND nullptr) for good.
+     */
+    void Realize();
+
+    /**
+     * Gets the recorded state of a lazily-created Window that has no HWND
+     * yet, or nullptr once it has one. Setters that can be recorded (text,
+     * bounds, style, visibility) write here instead of realizing the Window.
+     */
+    PendingWindow* Pending() { return pending_.get(); }
+    const PendingWindow* Pending() const { return pending_.get(); }
+
+    /**
+     * Realizes the lazily-created Windows that were waiting for h to be
+     * shown. SetVisible & CustomWindow call this; call it yourself after
+     * showing any other kind of window with ShowWindow.
+     */
+    static void RealizeWaitingOn(HWND h);
+
+    /**
+     * Drops the lazily-created Windows that were waiting for h to be shown,
+     * as h is being destroyed & took their parents with it. They are left
+     * pending but dead: setters still record, & SetVisible & Realize do
+     * nothing. CustomWindow & Dialog call this on WM_DESTROY; call it
+     * yourself for any other kind of window that hides lazily-created
+     * descendants.
+     */
+    static void ForgetWaitingOn(HWND h);
+
+    /**
+     * Gets the set of REFLECT_* flags for which this Window currently
+     * receives reflected messages.
+     */
+    unsigned int ReflectedMessages() const { return reflect_; }
+
+    /**
+     * Gets the MessagePump of the thread that created this Window. Messages
+     * for the Window are dispatched by this pump, so this is where dialog
+     * registration & exception reporting should go.
+     *
+     * The Window keeps its pump alive, so this is safe to use from a
+     * destructor, even that of a static Window.
+     */
+    MessagePump& OwningPump() const { return *pump_; }
+
+    /**
+     * Gets a token that is cancelled when this Window is destroyed. Work that
+     * refers to the Window but may finish after it has gone (a task started
+     * with Spawn(Window&, ...), for example) should check it first.
+     */
+    CancellationToken Lifetime() const { return lifetime_.Token(); }
+
+    /**
+     * Gets the cache that lets setters such as SetText skip writes that
+     * wouldn't change anything. Call Setters().Enable(false) to make every
+     * setter write through for this Window.
+     */
+    SetterCache& Setters() { return setters_; }
+    const SetterCache& Setters() const { return setters_; }
 
   protected:
+    enum ReflectFlags {
+      REFLECT_NONE = 0x00,
+      REFLECT_COMMAND = 0x01,
+      REFLECT_NOTIFY = 0x02,
+      REFLECT_SCROLL = 0x04,
+      REFLECT_DRAW = 0x08,
+      REFLECT_ALL = REFLECT_COMMAND | REFLECT_NOTIFY | REFLECT_SCROLL | REFLECT_DRAW
+    };
+
     HWND hWnd_;
 
     /**
-     * Default constructor. Sets hWnd_ to nullptr.
+     * Default constructor. Sets hWnd_ to nullptr, requests all reflected
+     * messages & associates the Window with the calling thread's pump.
+     */
+    Window()
+      : hWnd_(nullptr), reflect_(REFLECT_ALL), narrowed_(REFLECT_NONE), commandCode_(0), notifyCode_(0),
+        pump_(DefaultPump().shared_from_this()), redrawLocks_(0)
+    {}
+
+    /**
+     * Records what CreateWindowEx would be given instead of calling it. The
+     * HWND is created by Realize, which the non-const TheHWND calls, or when
+     * the parent, or whichever ancestor is hiding it, is shown; if nothing
+     * is hiding it, that is straight away.
+     *
+     * A pending Window costs a PendingWindow rather than a kernel window, so
+     * controls on pages that are never opened cost almost nothing.
+     */
+    void CreateLazily(Window& parent, const wchar_t* className, DWORD style, DWORD exStyle = 0, int id = 0);
+
+    /**
+     * Turns reflection of the specified REFLECT_* flags on or off. Turning a
+     * flag on also widens it to every notification code again.
+     * See "Skipping unobserved messages" above.
+     */
+    void Reflect(unsigned int flags, bool on) {
+      reflect_ = (on) ? (reflect_ | flags) : (reflect_ & ~flags);
+      if (on) {
+        narrowed_ &= ~flags;
+      }
+    }
+
+    /**
+     * Turns reflection of flags off if this object is exactly a T. Wrappers
+     * call this from their HandleReflectedMessage when nobody is listening;
+     * a subclass of T may have overridden that & still want the messages.
+     */
+    template<typename T>
+    void Unreflect(unsigned int flags) {
+      if (typeid(*this) == typeid(T)) {
+        Reflect(flags, false);
+      }
+    }
+
+    /**
+     * Narrows REFLECT_COMMAND or REFLECT_NOTIFY to the one notification
+     * code (the HIWORD of a WM_COMMAND's wParam or an NMHDR's code) if this
+     * object is exactly a T. See Unreflect.
      */
-    Window() : hWnd_(nullptr) {}
+    template<typename T>
+    void ReflectOnly(unsigned int flag, UINT code) {
+      assert(flag == REFLECT_COMMAND || flag == REFLECT_NOTIFY);
+
+      if (typeid(*this) == typeid(T)) {
+        narrowed_ |= flag;
+        ((flag == REFLECT_COMMAND) ? commandCode_ : notifyCode_) = code;
+      }
+    }
+
+    /**
+     * Gets the REFLECT_* flag that message m is reflected under, or
+     * REFLECT_NONE if it isn't one ReflectMessage handles.
+     */
+    static unsigned int ReflectFlag(UINT m);
 
     /**
      * This method is part of the message reflection mechanism.
@@ -135,6 +333,7 @@ namespace jwt {
      * - WM_NOTIFY
      * - WM_HSCROLL
      * - WM_VSCROLL
+     * - WM_DRAWITEM
      *
      * Messages should be altered unchanged.
      *
@@ -170,17 +369,31 @@ namespace jwt {
     virtual LRESULT HandleReflectedMessage(HWND, UINT, WPARAM, LPARAM);
 
   private:
+    unsigned int reflect_;
+    unsigned int narrowed_;   // flags limited to commandCode_/notifyCode_
+    UINT commandCode_;
+    UINT notifyCode_;
+    std::shared_ptr<MessagePump> pump_;
+    CancellationSource lifetime_;
+    SetterCache setters_;
+    unsigned int redrawLocks_;
+    std::unique_ptr<PendingWindow> pending_;
+
+    friend struct RedrawLock;
+
     Window(const Window&) = delete;
     Window& operator= (const Window&) = delete;
   };
 
   /**
-   *
+   * Sends a message to the Window & then rethrows any exception reported by
+   * a handler while it was being processed on this thread.
    */
   LRESULT SafeSendMessage(Window&, UINT, WPARAM, LPARAM);
 
   /**
-  *
+  * Sends a message to the Window & then rethrows any exception reported by
+  * a handler while it was being processed on this thread.
   */
   LRESULT SafeSendMessage(const Window&, UINT, WPARAM, LPARAM);
 
@@ -191,6 +404,13 @@ namespace jwt {
   */
   std::wstring ClassName(const Window&);
 
+  /**
+   * Returns true if the Window's class is clsName (case-insensitive, as
+   * class names are). Compares class atoms, looked up once per name, rather
+   * than fetching & comparing the name.
+   */
+  bool HasClass(const Window&, const wchar_t* clsName);
+
   /**
    * Gets the outer size of a Window. (i.e. the size measured outside of the
    * non-client area)
@@ -271,6 +491,9 @@ namespace jwt {
    * Equivalent to `GetWindowLong(w.TheHWND(), GWL_STYLE);`
    */
   inline DWORD Style(const Window& w) {
+    if (const PendingWindow* p = w.Pending()) {
+      return p->style;
+    }
     return GetWindowLong(w.TheHWND(), GWL_STYLE);
   }
 
@@ -279,6 +502,10 @@ namespace jwt {
   * Equivalent to `GetWindowLong(w.TheHWND(), GWL_STYLE);`
   */
   inline Window& Style(Window& w, DWORD styleMask) {
+    if (PendingWindow* p = w.Pending()) {
+      p->style = styleMask;
+      return w;
+    }
     SetWindowLong(w.TheHWND(), GWL_STYLE, styleMask);
     return w;
   }
@@ -289,7 +516,7 @@ namespace jwt {
    * @return bool
    */
   inline bool HasStyle(const Window& w, DWORD styleMask) {
-    return (GetWindowLong(w.TheHWND(), GWL_STYLE) & styleMask) == styleMask;
+    return (Style(w) & styleMask) == styleMask;
   }
 
   /**
@@ -304,6 +531,9 @@ namespace jwt {
    * Equivalent to `GetWindowLong(w.TheHWND(), GWL_EXSTYLE);`
    */
   inline DWORD ExStyle(const Window& w) {
+    if (const PendingWindow* p = w.Pending()) {
+      return p->exStyle;
+    }
     return GetWindowLong(w.TheHWND(), GWL_EXSTYLE);
   }
 
@@ -313,7 +543,7 @@ namespace jwt {
    * @return bool
    */
   inline bool HasExStyle(const Window& w, DWORD styleMask) {
-    return (GetWindowLong(w.TheHWND(), GWL_EXSTYLE) & styleMask) == styleMask;
+    return (ExStyle(w) & styleMask) == styleMask;
   }
 
   /**
@@ -328,6 +558,29 @@ namespace jwt {
    */
   Window& SetText(Window&, const std::wstring&);
 
+  /**
+   * Gets the control id of a child Window: the value its WM_COMMAND &
+   * WM_NOTIFY messages carry.
+   * @return int
+   */
+  int ControlId(const Window&);
+
+  /**
+   * Sets the control id of a child Window. A lazily-created Window records
+   * it & is created with it.
+   * @return Window& - the target Window to allowing function chaining.
+   */
+  Window& SetControlId(Window&, int id);
+
+  /**
+   * Forgets every value remembered by the Window's SetterCache, so the next
+   * call to each setter writes through. Call this after changing the
+   * underlying control without going through JWT.
+   *
+   * @return Window& - the target Window to allowing function chaining.
+   */
+  Window& Resync(Window&);
+
   /**
    * Returns whether a window has the WS_VISIBLE style.
    * This is a proxy for whether the window is visible. Clearly this does not
@@ -369,6 +622,34 @@ namespace jwt {
 
 
   Dimension CalculateExtentOfChildren(const Window&);
+
+  /**
+   * Suppresses painting of a Window (& its children) for the lifetime of the
+   * lock & then repaints it once. Wrap bulk changes in one:
+   * ~~~~~~{.cpp}
+   * {
+   *   RedrawLock lock(toolbar);
+   *   toolbar.AddButtons(buttons);
+   *   toolbar.Autosize();
+   * }
+   * ~~~~~~
+   * Locks nest; only the outermost one sends WM_SETREDRAW. A lock on a
+   * hidden window does nothing, since turning redraw back on would show it.
+   *
+   * Note that while a window is locked IsVisible() reports false:
+   * WM_SETREDRAW works by clearing WS_VISIBLE.
+   */
+  struct RedrawLock {
+    explicit RedrawLock(Window&);
+    ~RedrawLock();
+
+  private:
+    RedrawLock(const RedrawLock&) = delete;
+    RedrawLock& operator= (const RedrawLock&) = delete;
+
+    Window& w_;
+    bool active_;
+  };
 }
 
 #include "window-impl.hpp"
\ No newline at end of file
@@ -0,0 +1,141 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "libraries.hpp"
+#include "custom-window.hpp"
+#include "defer-create.hpp"
+#include "event-types.hpp"
+#include "windowless-model.hpp"
+#include <functional>
+
+namespace jwt {
+
+  /**
+   * A window that hosts any number of windowless controls: push buttons,
+   * check boxes & labels that are drawn & hit-tested by the host rather than
+   * being windows of their own. Thousands of them cost one HWND & paint in
+   * one double-buffered WM_PAINT.
+   *
+   * Usage
+   * -----
+   * ~~~~~~{.cpp}
+   * WindowlessHost host(parent);
+   * WindowlessModel& m = host.Model();
+   *
+   * auto ok = m.Add(WindowlessModel::PUSH_BUTTON, { 10, 10, 80, 24 }, L"OK");
+   * auto wrap = m.Add(WindowlessModel::CHECK_BOX, { 10, 40, 120, 20 }, L"Word wrap");
+   * host.Update();
+   *
+   * host.On(Click, ok, []() { Save(); });
+   * host.On(Click, [&](WindowlessModel::Id id) { ... });
+   * ~~~~~~
+   * Change controls through Model() & then call Update(), which repaints
+   * whatever those changes have made dirty. The host updates itself after
+   * handling input.
+   *
+   * Mouse & keyboard
+   * ----------------
+   * Controls track the mouse (HOT) & are PRESSED between button down & up; a
+   * click is a button up over the control that saw the button down. Tab &
+   * Shift+Tab move the focus between the host's controls, & Space or Enter
+   * clicks the focused one. Clicking a check box toggles CHECKED before the
+   * Click event is raised.
+   *
+   * Drawing
+   * -------
+   * The built-in kinds are drawn with the system's button & text styles. Set
+   * a Painter to draw them (or kinds of your own, from USER_KIND) yourself;
+   * it is called for each control that needs painting, bottom first, on an
+   * off-screen DC in client coordinates.
+   */
+  struct WindowlessHost
+    : CustomWindow<WindowlessHost>
+  {
+    typedef std::function<void(HDC, const WindowlessModel&, WindowlessModel::Id, const RECT&, bool focused)> Painter;
+
+    friend struct CustomWindow<WindowlessHost>;
+    static const wchar_t* CLASS_NAME;
+
+    static void Register();
+
+    explicit WindowlessHost(Window& parent);
+
+    WindowlessModel& Model() { return model_; }
+    const WindowlessModel& Model() const { return model_; }
+
+    /**
+     * Invalidates the areas made dirty by changes to the model.
+     */
+    void Update();
+
+    void SetPainter(Painter p);
+
+    /**
+     * Draws a control of one of the built-in kinds; the default Painter.
+     */
+    static void DrawControl(HDC, const WindowlessModel&, WindowlessModel::Id, const RECT&, bool focused);
+
+    template<typename Callable>
+    auto On(const ClickTag&, Callable c) -> decltype(onClick_.connect(c)) {
+      return onClick_.connect(c);
+    }
+
+    template<typename Callable>
+    auto On(const ClickTag&, WindowlessModel::Id id, Callable c) -> decltype(onClick_.connect(c)) {
+      return onClick_.connect([c, id](WindowlessModel::Id clicked) {
+        if (clicked == id) {
+          c();
+        }
+      });
+    }
+
+    using CustomWindow<WindowlessHost>::On;
+
+  protected:
+    explicit WindowlessHost(const defer_create_t&);
+
+    void Create(Window& parent);
+    LRESULT WndProc(HWND, UINT, WPARAM, LPARAM);
+
+  private:
+    WindowlessModel model_;
+    Painter painter_;
+
+    boost::signals2::signal<void(WindowlessModel::Id)> onClick_;
+
+    WindowlessModel::Id hot_;
+    WindowlessModel::Id pressed_;
+    bool trackingLeave_;
+
+    std::vector<WindowlessModel::Id> visible_;
+    std::vector<WindowlessModel::Box> dirty_;
+
+    void Paint();
+    void InvalidateFocus();
+    void MouseMove(int x, int y);
+    void MouseLeave();
+    void ButtonDown(int x, int y);
+    void ButtonUp(int x, int y);
+    void KeyDown(WPARAM vk);
+    void Activate(WindowlessModel::Id);
+    void SetHot(WindowlessModel::Id);
+  };
+
+}
\ No newline at end of file
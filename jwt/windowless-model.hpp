@@ -0,0 +1,210 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include "box.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ *
+ * windowless-model.hpp contains WindowlessModel, the state of a set of
+ * controls that are drawn & hit-tested by their host rather than being
+ * windows of their own.
+ *
+ * It has no Windows dependencies; see WindowlessHost for the UI side.
+ */
+
+namespace jwt {
+
+  /**
+   * Bounds, state & text of any number of windowless controls, with a
+   * spatial index for hit-testing & finding what to paint.
+   *
+   * Controls are stored column-wise (one array per property, indexed by
+   * slot) so that a hit test or a paint query only touches the bounds &
+   * state it needs. Removed slots are reused; an Id carries the slot's
+   * generation, so an Id kept after Remove is simply no longer Valid.
+   *
+   * The index is a uniform grid of CELL_SIZE squares, each listing the
+   * controls that overlap it, kept up to date as bounds change. Hit tests
+   * look at one cell; queries at the cells a rectangle covers. A control
+   * spanning many cells is listed in each, so very large controls (a
+   * background panel, say) are better drawn by the host itself.
+   *
+   * Stacking order is the order controls were added, until BringToFront.
+   * Keyboard focus moves through VISIBLE, ENABLED, FOCUSABLE controls in
+   * stacking order.
+   *
+   * Every change that affects what is drawn records the area that needs
+   * repainting; the host collects them with TakeDirty.
+   */
+  struct WindowlessModel {
+    typedef std::uint64_t Id;
+
+    static const Id INVALID_ID = ~0ULL;
+
+    /**
+     * Kinds the host knows how to draw. Others may be used with a custom
+     * painter.
+     */
+    enum Kind {
+      PUSH_BUTTON = 0,
+      CHECK_BOX,
+      LABEL,
+      USER_KIND = 0x100
+    };
+
+    enum State {
+      VISIBLE = 0x01,
+      ENABLED = 0x02,
+      FOCUSABLE = 0x04,
+      HOT = 0x08,
+      PRESSED = 0x10,
+      CHECKED = 0x20
+    };
+
+    enum {
+      CELL_SIZE = 64
+    };
+
+    typedef jwt::Box Box;
+
+    WindowlessModel();
+
+    /**
+     * Adds a control on top of the others. New controls are VISIBLE &
+     * ENABLED, & FOCUSABLE unless they are LABELs.
+     */
+    Id Add(unsigned int kind, const Box& bounds, const std::wstring& text = std::wstring());
+    void Remove(Id);
+    void Clear();
+
+    bool Valid(Id) const;
+    std::size_t Size() const { return count_; }
+
+    unsigned int Kind(Id) const;
+
+    const Box& Bounds(Id) const;
+    void SetBounds(Id, const Box&);
+
+    unsigned int State(Id) const;
+    bool Has(Id id, unsigned int state) const { return (State(id) & state) == state; }
+    void SetState(Id, unsigned int state, bool on);
+
+    const std::wstring& Text(Id) const;
+    void SetText(Id, const std::wstring&);
+
+    void BringToFront(Id);
+
+    /**
+     * The topmost VISIBLE control containing (x, y), or INVALID_ID.
+     */
+    Id HitTest(int x, int y) const;
+
+    /**
+     * Replaces out with the VISIBLE controls that intersect area, bottom
+     * first (the order to paint them in).
+     */
+    void Query(const Box& area, std::vector<Id>& out) const;
+
+    Id Focus() const { return focus_; }
+
+    /**
+     * Focuses id, or nothing if id is INVALID_ID.
+     * @return false if id can't take the focus
+     */
+    bool SetFocus(Id);
+
+    /**
+     * Moves the focus to the next (or previous) control that can take it,
+     * wrapping around.
+     * @return the newly focused control, or INVALID_ID if none can
+     */
+    Id FocusNext(bool backwards = false);
+
+    /**
+     * The control FocusNext would move to, without moving. Without wrap,
+     * INVALID_ID if the focus is already on the last (or first) control
+     * that can take it.
+     */
+    Id NextFocus(bool backwards, bool wrap) const;
+
+    /**
+     * Appends the areas needing repainting since the last call to out, &
+     * forgets them.
+     */
+    void TakeDirty(std::vector<Box>& out);
+    bool Dirty() const { return !dirty_.empty(); }
+
+  private:
+    WindowlessModel(const WindowlessModel&) = delete;
+    WindowlessModel& operator= (const WindowlessModel&) = delete;
+
+    // A plain constant rather than an enumerator, so that combining it with
+    // State values isn't arithmetic between two enumeration types
+    static const std::uint32_t ALIVE = 0x80000000u;
+
+    typedef std::uint32_t Slot;
+    typedef std::uint64_t CellKey;
+
+    Slot SlotOf(Id) const;
+    Id IdOf(Slot s) const { return ((Id) generation_[s] << 32) | s; }
+
+    bool CanFocus(Slot) const;
+    void MarkDirty(Slot s) { dirty_.push_back(bounds_[s]); }
+
+    static int CellOf(int v);
+    static CellKey Key(int cx, int cy);
+    void Index(Slot, bool insert);
+
+    // One entry per slot in each
+    std::vector<Box> bounds_;
+    std::vector<std::uint32_t> state_;
+    std::vector<std::uint32_t> kind_;
+    std::vector<std::uint32_t> z_;
+    std::vector<std::uint32_t> generation_;
+    std::vector<std::wstring> text_;
+
+    std::vector<Slot> free_;
+    std::size_t count_;
+    std::uint32_t nextZ_;
+
+    std::unordered_map<CellKey, std::vector<Slot>> cells_;
+
+    // Marks slots already seen by the current Query
+    mutable std::vector<std::uint32_t> stamp_;
+    mutable std::uint32_t query_;
+
+    Id focus_;
+    std::vector<Box> dirty_;
+  };
+
+  /**
+   * Lays controls out left to right in rows of columns cells, each cell
+   * cellW x cellH with gap pixels between them, starting at (x, y).
+   */
+  void LayoutGrid(WindowlessModel&, const std::vector<WindowlessModel::Id>&,
+    int x, int y, int columns, int cellW, int cellH, int gap);
+
+}
\ No newline at end of file
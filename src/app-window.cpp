@@ -18,6 +18,7 @@
 */
 #include "libraries.hpp"
 #include "app-window.hpp"
+#include "resources.hpp"
 
 #include <assert.h>
 #include <iostream>
@@ -49,7 +50,7 @@ namespace jwt {
       CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT,
       nullptr, nullptr, GetModuleHandle(nullptr), (void*) this
     );
-    DefaultPump().RaiseReportedException();
+    OwningPump().RaiseReportedException();
     assert(hWnd_ != nullptr);
   }
 
@@ -65,20 +66,22 @@ namespace jwt {
       ReflectMessage(h, m, w, l);
       break;
 
+    case WM_DRAWITEM:
+      if (ReflectMessage(h, m, w, l)) {
+        return TRUE;
+      }
+      break;
+
     case WM_COMMAND: {
-      CommandEvent::Type t = (HIWORD(w) == 0)
-        ? CommandEvent::MENU
-        : (HIWORD(w) == 1)
-        ? CommandEvent::ACCELERATOR
-        : CommandEvent::CONTROL;
+      CommandMsg cmd(w, l);
 
-      onCommand_(CommandEvent(t, LOWORD(w), l));
+      onCommand_(cmd.Event());
 
-      if (t == CommandEvent::CONTROL) {
+      if (cmd.FromControl()) {
         ReflectMessage(h, m, w, l);
       }
     }
-                     break;
+    break;
 
     case WM_SIZE:
       if (layoutPolicy_) {
@@ -88,12 +91,12 @@ namespace jwt {
 
     case WM_SIZING:
       if (sizePolicy_) {
-        RECT* r = (RECT*)l;
-        Rect r2(*r);
+        SizingMsg sizing(w, l);
+        Rect r(*sizing.Bounds());
 
-        sizePolicy_((unsigned int) w, r2);
+        sizePolicy_(sizing.edge, r);
 
-        *r = (RECT)r2;
+        *sizing.Bounds() = (RECT)r;
       }
       break;
     }
@@ -102,7 +105,7 @@ namespace jwt {
   }
 
   AppWindow& AppWindow::Menu(UINT resource) {
-    HMENU m = LoadMenu(GetModuleHandle(nullptr), MAKEINTRESOURCE(resource));
+    HMENU m = LoadMenuResource(resource);
     assert(m);
 
     SetMenu(hWnd_, m);
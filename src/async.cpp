@@ -0,0 +1,85 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "async.hpp"
+#include <assert.h>
+
+namespace jwt {
+
+  namespace {
+    VOID CALLBACK RunWorkItem(PTP_CALLBACK_INSTANCE, PVOID context) {
+      WorkItem* w = static_cast<WorkItem*>(context);
+      w->run(w);
+    }
+
+    // Carries an exception from whichever thread a spawned task failed on to
+    // the pump that owns its window. Only allocated on failure.
+    struct ReportOnPump
+      : WorkItem
+    {
+      ReportOnPump(std::shared_ptr<MessagePump> p, std::exception_ptr e)
+        : WorkItem(&Run), pump(std::move(p)), exception(std::move(e))
+      {}
+
+      static void Run(WorkItem* w) {
+        std::unique_ptr<ReportOnPump> self(static_cast<ReportOnPump*>(w));
+        self->pump->ReportException(self->exception);
+      }
+
+      std::shared_ptr<MessagePump> pump;
+      std::exception_ptr exception;
+    };
+  }
+
+  void WorkerPool::Post(WorkItem* w) {
+    assert(w && w->run);
+
+    if (!TrySubmitThreadpoolCallback(&RunWorkItem, w, nullptr)) {
+      throw "TrySubmitThreadpoolCallback failed.";
+    }
+  }
+
+  WorkerPool& DefaultWorkerPool() {
+    static WorkerPool pool;
+    return pool;
+  }
+
+#if JWT_HAS_COROUTINES
+
+  void Spawn(const Window& w, Task<void> t) {
+    // Shared, so that neither the hops back nor a late error report depend
+    // on w still being alive
+    std::shared_ptr<MessagePump> pump = w.OwningPump().shared_from_this();
+
+    t.WithHome(pump, &w);
+
+    Spawn(std::move(t), w.Lifetime(), [pump](std::exception_ptr e) {
+      if (GetCurrentThreadId() == pump->ThreadId()) {
+        pump->ReportException(e);
+      }
+      else {
+        pump->Post(new ReportOnPump(pump, e));
+      }
+    });
+  }
+
+#endif
+
+} // namespace jwt
\ No newline at end of file
@@ -37,11 +37,16 @@ namespace jwt {
     SetText(*this, txt);
   }
 
+  Button::Button(const lazy_create_t&, Window& parent, const std::wstring& txt, DWORD buttonStyles) {
+    CreateLazily(parent, L"BUTTON", WS_VISIBLE | WS_CHILD | buttonStyles);
+    SetText(*this, txt);
+  }
+
   Button::Button(Dialog& parent, int buttonId) {
     hWnd_ = parent.Item(buttonId);
     
     assert(hWnd_ != nullptr);
-    assert(ClassName(*this) == L"Button");
+    assert(HasClass(*this, L"Button"));
 
     SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) this);
   }
@@ -63,11 +68,18 @@ namespace jwt {
   LRESULT Button::HandleReflectedMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
     switch (m) {
     case WM_COMMAND:
-      if (HIWORD(w) == BN_CLICKED) {
+      if (onClick_.empty()) {
+        Unreflect<Button>(REFLECT_COMMAND);
+      }
+      else if (CommandMsg(w, l).code == BN_CLICKED) {
         onClick_();
         return 0;
       }
       break;
+
+    default:
+      Unreflect<Button>(ReflectFlag(m));
+      break;
     }
 
     return 0;
@@ -105,10 +117,13 @@ namespace jwt {
   }
 
   LRESULT SplitButton::HandleReflectedMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
-    if (m == WM_NOTIFY) {
-      NMBCDROPDOWN* n = (NMBCDROPDOWN*) l;
+    if (NotifyMsg<NMBCDROPDOWN>::Matches(m)) {
+      NotifyMsg<NMBCDROPDOWN> n(w, l);
 
-      if (n->hdr.code == BCN_DROPDOWN) {
+      if (onDropdown_.empty()) {
+        Unreflect<SplitButton>(REFLECT_NOTIFY);
+      }
+      else if (n.Code() == BCN_DROPDOWN) {
         onDropdown_();
       }
     }
@@ -123,8 +138,10 @@ namespace jwt {
   //
 
   Button& SetIcon(Button& b, WORD iconId) {
-    HICON icon = LoadIcon(GetModuleHandle(nullptr), MAKEINTRESOURCE(iconId));
-    SendMessage(b.TheHWND(), BM_SETIMAGE, IMAGE_ICON, (LPARAM) icon);
+    // Swap references only once the button has stopped using the old icon
+    ResourceRef icon = LoadIconResource(iconId);
+    SendMessage(b.TheHWND(), BM_SETIMAGE, IMAGE_ICON, (LPARAM) icon.As<HICON>());
+    b.icon_ = std::move(icon);
     return b;
   }
 
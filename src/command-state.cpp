@@ -0,0 +1,162 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "command-state.hpp"
+#include <assert.h>
+#include <memory>
+
+namespace jwt {
+
+  CommandStateRegistry::CommandStateRegistry()
+    : allStale_(false), evaluations_(0), pushes_(0)
+  {
+  }
+
+  void CommandStateRegistry::Provide(int id, Provider p) {
+    assert(p);
+
+    auto shared = std::make_shared<const Provider>(std::move(p));
+
+    auto i = index_.find(id);
+    if (i != index_.end()) {
+      entries_[i->second].provider = std::move(shared);
+    }
+    else {
+      Entry e = { id, std::move(shared), CommandState(), false, false };
+      index_[id] = entries_.size();
+      entries_.push_back(std::move(e));
+    }
+
+    Invalidate(id);
+  }
+
+  void CommandStateRegistry::Remove(int id) {
+    auto i = index_.find(id);
+    if (i == index_.end()) {
+      return;
+    }
+
+    // Swap with the last entry so removal doesn't shift everything
+    std::size_t slot = i->second;
+    index_.erase(i);
+
+    if (slot != entries_.size() - 1) {
+      entries_[slot] = std::move(entries_.back());
+      index_[entries_[slot].id] = slot;
+    }
+    entries_.pop_back();
+
+    // A stale_ entry for id is skipped by Update once the id is unknown
+  }
+
+  void CommandStateRegistry::Invalidate() {
+    allStale_ = true;
+  }
+
+  void CommandStateRegistry::Invalidate(int id) {
+    auto i = index_.find(id);
+    if (i == index_.end()) {
+      return;
+    }
+
+    Entry& e = entries_[i->second];
+    if (!e.stale) {
+      e.stale = true;
+      stale_.push_back(id);
+    }
+  }
+
+  bool CommandStateRegistry::Refresh(std::size_t slot, Sink& sink) {
+    Entry* e = &entries_[slot];
+    e->stale = false;
+
+    // The provider may Remove or replace itself, or Provide other commands,
+    // which moves entries_ about: hold on to it for the call & find the
+    // entry again afterwards.
+    int id = e->id;
+    std::shared_ptr<const Provider> p = e->provider;
+
+    CommandState s = (*p)();
+    ++evaluations_;
+
+    auto i = index_.find(id);
+    if (i == index_.end()) {
+      return false;
+    }
+
+    e = &entries_[i->second];
+    if (e->pushed && s == e->last) {
+      return false;
+    }
+
+    sink.Push(id, s);
+    e->last = s;
+    e->pushed = true;
+    ++pushes_;
+    return true;
+  }
+
+  std::size_t CommandStateRegistry::Update(Sink& sink) {
+    if (allStale_) {
+      allStale_ = false;
+      stale_.clear();
+
+      for (auto& e : entries_) {
+        e.stale = true;
+        stale_.push_back(e.id);
+      }
+    }
+
+    // Walk ids rather than entries, since providers may change the
+    // registry. Invalidations made during the pass go to the next one
+    // (unless the command hasn't been reached yet); pass_ is kept to reuse
+    // its capacity.
+    pass_.clear();
+    pass_.swap(stale_);
+
+    std::size_t pushed = 0;
+
+    for (int id : pass_) {
+      auto i = index_.find(id);
+      if (i != index_.end() && entries_[i->second].stale) {
+        pushed += Refresh(i->second, sink);
+      }
+    }
+
+    return pushed;
+  }
+
+  void CommandStateRegistry::Repush() {
+    for (auto& e : entries_) {
+      e.pushed = false;
+    }
+    Invalidate();
+  }
+
+  bool CommandStateRegistry::Pushed(int id, CommandState& s) const {
+    auto i = index_.find(id);
+    if (i == index_.end() || !entries_[i->second].pushed) {
+      return false;
+    }
+
+    s = entries_[i->second].last;
+    return true;
+  }
+
+} // namespace jwt
\ No newline at end of file
@@ -0,0 +1,177 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "command-updater.hpp"
+#include "toolbar.hpp"
+#include <algorithm>
+#include <assert.h>
+
+namespace jwt {
+
+  namespace {
+    void PushToMenu(HMENU m, int id, const CommandState& s) {
+      EnableMenuItem(m, id, MF_BYCOMMAND | (s.enabled ? MF_ENABLED : MF_GRAYED));
+      CheckMenuItem(m, id, MF_BYCOMMAND | (s.checked ? MF_CHECKED : MF_UNCHECKED));
+    }
+
+    void PushToToolbar(HWND h, int id, const CommandState& s) {
+      LRESULT old = SendMessage(h, TB_GETSTATE, id, 0);
+      if (old == -1) {
+        return;           // no such button on this toolbar
+      }
+
+      LRESULT state = old & ~(TBSTATE_ENABLED | TBSTATE_CHECKED);
+      if (s.enabled) state |= TBSTATE_ENABLED;
+      if (s.checked) state |= TBSTATE_CHECKED;
+
+      if (state != old) {
+        SendMessage(h, TB_SETSTATE, id, MAKELONG(state, 0));
+      }
+    }
+  }
+
+  struct CommandUpdater::Pusher
+    : CommandStateRegistry::Sink
+  {
+    explicit Pusher(CommandUpdater& u) : u_(u), menuBarChanged_(false) {}
+
+    void Push(int id, const CommandState& s) {
+      for (auto& t : u_.windows_) {
+        HWND h = t.window->TheHWND();
+
+        if (t.menuBar) {
+          if (HMENU m = GetMenu(h)) {
+            PushToMenu(m, id, s);
+            menuBarChanged_ = true;
+          }
+        }
+        else {
+          PushToToolbar(h, id, s);
+        }
+      }
+
+      for (HMENU m : u_.menus_) {
+        PushToMenu(m, id, s);
+      }
+    }
+
+    void Finish() {
+      // Top level items are drawn by the window, not the menu
+      if (menuBarChanged_) {
+        for (auto& t : u_.windows_) {
+          if (t.menuBar) {
+            DrawMenuBar(t.window->TheHWND());
+          }
+        }
+      }
+    }
+
+  private:
+    CommandUpdater& u_;
+    bool menuBarChanged_;
+  };
+
+  CommandUpdater::CommandUpdater(MessagePump& pump)
+    : pump_(pump), pass_(TimerService::INVALID_TIMER)
+  {
+  }
+
+  CommandUpdater::~CommandUpdater() {
+    if (pass_ != TimerService::INVALID_TIMER) {
+      pump_.CancelTimer(pass_);
+    }
+  }
+
+  void CommandUpdater::Invalidate() {
+    registry_.Invalidate();
+    Schedule();
+  }
+
+  void CommandUpdater::Invalidate(int id) {
+    registry_.Invalidate(id);
+    Schedule();
+  }
+
+  void CommandUpdater::Update() {
+    if (pass_ != TimerService::INVALID_TIMER) {
+      pump_.CancelTimer(pass_);
+      pass_ = TimerService::INVALID_TIMER;
+    }
+
+    windows_.erase(
+      std::remove_if(begin(windows_), end(windows_), [](const WindowTarget& t) {
+        return t.alive.Cancelled();
+      }),
+      end(windows_)
+    );
+
+    Pusher p(*this);
+    if (registry_.Update(p)) {
+      p.Finish();
+    }
+  }
+
+  void CommandUpdater::AttachToolbar(Toolbar& t) {
+    WindowTarget target = { &t, t.Lifetime(), false };
+    windows_.push_back(target);
+    Attached();
+  }
+
+  void CommandUpdater::AttachMenu(Window& w) {
+    WindowTarget target = { &w, w.Lifetime(), true };
+    windows_.push_back(target);
+    Attached();
+  }
+
+  void CommandUpdater::AttachMenu(HMENU m) {
+    assert(m);
+
+    menus_.push_back(m);
+    Attached();
+  }
+
+  void CommandUpdater::Detach(const Window& w) {
+    windows_.erase(
+      std::remove_if(begin(windows_), end(windows_), [&w](const WindowTarget& t) {
+        return t.window == &w;
+      }),
+      end(windows_)
+    );
+  }
+
+  void CommandUpdater::Detach(HMENU m) {
+    menus_.erase(std::remove(begin(menus_), end(menus_), m), end(menus_));
+  }
+
+  void CommandUpdater::Attached() {
+    registry_.Repush();
+    Schedule();
+  }
+
+  void CommandUpdater::Schedule() {
+    if (pass_ == TimerService::INVALID_TIMER && registry_.Pending()) {
+      pass_ = pump_.Timers().Once(0, [this]() {
+        pass_ = TimerService::INVALID_TIMER;
+        Update();
+      });
+    }
+  }
+
+} // namespace jwt
\ No newline at end of file
@@ -20,4 +20,5 @@
 
 namespace jwt {
   const defer_create_t defer_create;
+  const lazy_create_t lazy_create;
 }
\ No newline at end of file
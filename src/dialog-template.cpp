@@ -0,0 +1,157 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "dialog-template.hpp"
+#include <assert.h>
+
+namespace jwt {
+
+  DialogTemplateBuilder::DialogTemplateBuilder(const std::wstring& title, short x, short y, short cx, short cy,
+    std::uint32_t style, std::uint32_t exStyle)
+    : count_(0), style_(style)
+  {
+    Word(1);                      // dlgVer
+    Word(0xFFFF);                 // signature: this is a DLGTEMPLATEEX
+    DWord(0);                     // helpID
+    DWord(exStyle);
+    DWord(style);
+    Word(0);                      // cDlgItems, patched as controls are added
+    Word((std::uint16_t) x);
+    Word((std::uint16_t) y);
+    Word((std::uint16_t) cx);
+    Word((std::uint16_t) cy);
+    Word(0);                      // no menu
+    Word(0);                      // default dialog class
+    String(title);
+  }
+
+  DialogTemplateBuilder& DialogTemplateBuilder::Font(const std::wstring& typeface, std::uint16_t points,
+    std::uint16_t weight, bool italic, std::uint8_t charset)
+  {
+    assert(count_ == 0 && !(style_ & DS_SETFONT));
+
+    style_ |= DS_SETFONT;
+    Patch(STYLE_OFFSET, style_, 4);
+
+    Word(points);
+    Word(weight);
+    buffer_.push_back(italic ? 1 : 0);
+    buffer_.push_back(charset);
+    String(typeface);
+
+    return *this;
+  }
+
+  DialogTemplateBuilder& DialogTemplateBuilder::Control(ClassOrdinal cls, const std::wstring& text, std::uint32_t id,
+    short x, short y, short cx, short cy, std::uint32_t style, std::uint32_t exStyle)
+  {
+    Item(id, x, y, cx, cy, style, exStyle);
+    Ordinal((std::uint16_t) cls);
+    Finish(text);
+
+    return *this;
+  }
+
+  DialogTemplateBuilder& DialogTemplateBuilder::Control(const std::wstring& className, const std::wstring& text, std::uint32_t id,
+    short x, short y, short cx, short cy, std::uint32_t style, std::uint32_t exStyle)
+  {
+    assert(!className.empty());
+
+    Item(id, x, y, cx, cy, style, exStyle);
+    String(className);
+    Finish(text);
+
+    return *this;
+  }
+
+  void DialogTemplateBuilder::Reserve(std::size_t controls, std::size_t averageTextLength) {
+    // Fixed part of an item, its alignment, a class ordinal & extra count
+    const std::size_t itemBytes = 24 + 3 + 4 + 2;
+
+    buffer_.reserve(buffer_.size() + controls * (itemBytes + (averageTextLength + 1) * 2));
+  }
+
+  void DialogTemplateBuilder::Item(std::uint32_t id, short x, short y, short cx, short cy,
+    std::uint32_t style, std::uint32_t exStyle)
+  {
+    assert(count_ < MAX_CONTROLS);
+
+    Align();
+    DWord(0);                     // helpID
+    DWord(exStyle);
+    DWord(style);
+    Word((std::uint16_t) x);
+    Word((std::uint16_t) y);
+    Word((std::uint16_t) cx);
+    Word((std::uint16_t) cy);
+    DWord(id);
+  }
+
+  void DialogTemplateBuilder::Finish(const std::wstring& text) {
+    String(text);
+    Word(0);                      // no creation data
+
+    Patch(COUNT_OFFSET, (std::uint32_t) ++count_, 2);
+  }
+
+  void DialogTemplateBuilder::Word(std::uint16_t w) {
+    buffer_.push_back((std::uint8_t) (w & 0xFF));
+    buffer_.push_back((std::uint8_t) (w >> 8));
+  }
+
+  void DialogTemplateBuilder::DWord(std::uint32_t d) {
+    Word((std::uint16_t) (d & 0xFFFF));
+    Word((std::uint16_t) (d >> 16));
+  }
+
+  void DialogTemplateBuilder::String(const std::wstring& s) {
+    // UTF-16 whatever the size of wchar_t
+    for (wchar_t c : s) {
+      std::uint32_t u = (std::uint32_t) c;
+
+      if (u > 0xFFFF) {
+        u -= 0x10000;
+        Word((std::uint16_t) (0xD800 | (u >> 10)));
+        Word((std::uint16_t) (0xDC00 | (u & 0x3FF)));
+      }
+      else {
+        Word((std::uint16_t) u);
+      }
+    }
+    Word(0);
+  }
+
+  void DialogTemplateBuilder::Ordinal(std::uint16_t o) {
+    Word(0xFFFF);
+    Word(o);
+  }
+
+  void DialogTemplateBuilder::Align() {
+    while (buffer_.size() % 4) {
+      buffer_.push_back(0);
+    }
+  }
+
+  void DialogTemplateBuilder::Patch(std::size_t offset, std::uint32_t value, std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; ++i) {
+      buffer_[offset + i] = (std::uint8_t) (value >> (8 * i));
+    }
+  }
+
+} // namespace jwt
\ No newline at end of file
@@ -30,18 +30,70 @@ namespace jwt {
     Create(parent, resourceId);
   }
 
+  Dialog::Dialog(const DialogTemplateBuilder& t) {
+    Create(t);
+  }
+
+  Dialog::Dialog(Window& parent, const DialogTemplateBuilder& t) {
+    Create(parent, t);
+  }
+
   Dialog::Dialog(const defer_create_t&) {
   }
 
   Dialog::~Dialog() {
     if (hWnd_ && GetWindowLongPtr(hWnd_, GWLP_USERDATA)) {
-      DefaultPump().RemoveDialog(hWnd_);
+      OwningPump().RemoveDialog(hWnd_);
       DestroyWindow(hWnd_);
     }
   }
 
   HWND Dialog::Item(int id) {
-    return GetDlgItem(hWnd_, id);
+    auto i = items_.find(id);
+    if (i != items_.end() && IsWindow(i->second)) {
+      return i->second;
+    }
+
+    // Not seen (or destroyed without telling us: template controls have
+    // WS_EX_NOPARENTNOTIFY), so ask Windows & remember the answer
+    HWND h = GetDlgItem(hWnd_, id);
+    if (h) {
+      items_[id] = h;
+    }
+    else if (i != items_.end()) {
+      items_.erase(i);
+    }
+    return h;
+  }
+
+  void Dialog::IndexItems() {
+    items_.clear();
+
+    // Children in z-order, so where ids repeat the first wins, as it does
+    // for GetDlgItem
+    for (HWND h = GetWindow(hWnd_, GW_CHILD); h; h = GetWindow(h, GW_HWNDNEXT)) {
+      items_.emplace(GetDlgCtrlID(h), h);
+    }
+  }
+
+  void Dialog::TrackItem(WPARAM w, LPARAM l) {
+    // HIWORD(w) is the id truncated to 16 bits; ask the child instead,
+    // which still exists in both cases
+    HWND h = (HWND) l;
+
+    switch (LOWORD(w)) {
+    case WM_CREATE:
+      items_.emplace(GetDlgCtrlID(h), h);
+      break;
+
+    case WM_DESTROY: {
+      auto i = items_.find(GetDlgCtrlID(h));
+      if (i != items_.end() && i->second == h) {
+        items_.erase(i);
+      }
+    }
+    break;
+    }
   }
 
   void Dialog::Create(int resourceId) {
@@ -52,7 +104,7 @@ namespace jwt {
       DlgProcAdapter,
       (LPARAM) this
     );
-    DefaultPump().AddDialog(hWnd_);
+    OwningPump().AddDialog(hWnd_);
   }
 
   void Dialog::Create(Window& parent, int resourceId) {
@@ -63,22 +115,42 @@ namespace jwt {
       DlgProcAdapter,
       (LPARAM) this
     );
-    DefaultPump().RaiseReportedException();
-    DefaultPump().AddDialog(hWnd_);
+    OwningPump().RaiseReportedException();
+    OwningPump().AddDialog(hWnd_);
+  }
+
+  void Dialog::Create(const DialogTemplateBuilder& t) {
+    CreateDialogIndirectParam(
+      GetModuleHandle(nullptr),
+      reinterpret_cast<LPCDLGTEMPLATE>(t.Data()),
+      nullptr,
+      DlgProcAdapter,
+      (LPARAM) this
+    );
+    OwningPump().RaiseReportedException();
+    OwningPump().AddDialog(hWnd_);
+  }
+
+  void Dialog::Create(Window& parent, const DialogTemplateBuilder& t) {
+    CreateDialogIndirectParam(
+      GetModuleHandle(nullptr),
+      reinterpret_cast<LPCDLGTEMPLATE>(t.Data()),
+      parent.TheHWND(),
+      DlgProcAdapter,
+      (LPARAM) this
+    );
+    OwningPump().RaiseReportedException();
+    OwningPump().AddDialog(hWnd_);
   }
 
   INT_PTR Dialog::DlgProc(HWND h, UINT m, WPARAM w, LPARAM l) {
     switch (m) {
     case WM_COMMAND: {
-      CommandEvent::Type t = (HIWORD(w) == 0)
-        ? CommandEvent::MENU
-        : (HIWORD(w) == 1)
-        ? CommandEvent::ACCELERATOR
-        : CommandEvent::CONTROL;
+      CommandMsg cmd(w, l);
 
-      onCommand_(CommandEvent(t, LOWORD(w), l));
+      onCommand_(cmd.Event());
 
-      if (l) {
+      if (cmd.FromControl()) {
         ReflectMessage(h, m, w, l);
       }
     }
@@ -90,6 +162,12 @@ namespace jwt {
       ReflectMessage(h, m, w, l);
       return TRUE;
 
+    case WM_DRAWITEM:
+      if (ReflectMessage(h, m, w, l)) {
+        return TRUE;
+      }
+      break;
+
     case WM_CLOSE:
       onClose_();
       return TRUE;
@@ -101,13 +179,25 @@ namespace jwt {
   INT_PTR Dialog::PrivateDlgProc(HWND h, UINT m, WPARAM w, LPARAM l) {
     if (m == WM_INITDIALOG) {
       hWnd_ = h;
+      IndexItems();
+    }
+    else if (m == WM_PARENTNOTIFY) {
+      TrackItem(w, l);
+    }
+    else if (m == WM_SHOWWINDOW && w) {
+      RealizeWaitingOn(h);
+    }
+    else if (m == WM_DESTROY) {
+      ForgetWaitingOn(h);
+      OwningPump().Shortcuts().RemoveTarget((std::uintptr_t) h);
     }
 
     try {
+      messages_.Dispatch(m, w, l);
       return DlgProc(h, m, w, l);
     }
     catch (...) {
-      DefaultPump().ReportException(std::current_exception());
+      OwningPump().ReportException(std::current_exception());
       return FALSE;
     }
   }
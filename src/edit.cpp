@@ -33,13 +33,24 @@ namespace jwt {
     SetText(*this, txt);
   }
 
+  Edit::Edit(const lazy_create_t&, Window& parent, const std::wstring& txt, DWORD flags) {
+    Setters().Enable(false);
+
+    CreateLazily(parent, L"EDIT", WS_VISIBLE | WS_CHILD | flags);
+    SetText(*this, txt);
+  }
+
   Edit::Edit(Dialog& parent, int editId) {
     hWnd_ = parent.Item(editId);
     
     assert(hWnd_ != nullptr);
-    assert(ClassName(*this) == L"Edit");
+    assert(HasClass(*this, L"Edit"));
 
     SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) this);
+
+    // The user types into edits, so the last text we wrote says nothing
+    // about what the control holds now
+    Setters().Enable(false);
   }
 
   Edit::Edit(const defer_create_t&) {
@@ -54,14 +65,15 @@ namespace jwt {
     assert(hWnd_ != nullptr);
 
     SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) this);
+
+    // The user types into edits, so the last text we wrote says nothing
+    // about what the control holds now
+    Setters().Enable(false);
   }
 
   LRESULT Edit::HandleReflectedMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
-    switch (m) {
-    case WM_COMMAND:
-      break;
-    }
-
+    // Nothing is listened for
+    Unreflect<Edit>(ReflectFlag(m));
     return 0;
   }
 
@@ -72,6 +84,11 @@ namespace jwt {
   //
 
   std::wstring GetSelectedText(const Edit& e) {
+    // Nothing can be selected before the control exists
+    if (e.Pending()) {
+      return std::wstring();
+    }
+
     auto s = GetText(e);
     DWORD start = 0;
     DWORD end = 0;
@@ -87,6 +104,11 @@ namespace jwt {
   }
 
   std::wstring GetCueBanner(const Edit& e) {
+    // SetCueBanner realizes the control, so a pending one has none
+    if (e.Pending()) {
+      return std::wstring();
+    }
+
     wchar_t buffer[200] = {};
     SendMessage(e.TheHWND(), EM_GETCUEBANNER, (WPARAM) buffer, sizeof(buffer) / sizeof(wchar_t));
     return buffer;
@@ -25,5 +25,6 @@ namespace jwt {
   const ClickTag Click;
   const SecondaryActionTag SecondaryAction;
   const ChangeTag Change;
+  const LatestChangeTag LatestChange;
 
 } // namespace jwt
\ No newline at end of file
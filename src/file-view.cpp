@@ -0,0 +1,389 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "file-view.hpp"
+#include "async.hpp"
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+
+namespace jwt {
+
+  namespace {
+    const int WHEEL_LINES = 3;
+
+    // Without an index to go by
+    const std::uint64_t TYPICAL_LINE = 80;
+
+    // Keeps scroll bar positions well inside an int
+    const std::uint64_t MAX_SCROLL_UNITS = 1 << 30;
+  }
+
+  const wchar_t* FileView::CLASS_NAME = L"FileView::CLASS_NAME";
+
+  void FileView::Register() {
+    CustomWindow<FileView>::Register(CLASS_NAME);
+  }
+
+  FileView::FileView(Window& parent)
+    : poll_(TimerService::INVALID_TIMER), top_(0), unit_(1), lineHeight_(0)
+  {
+    Create(parent);
+  }
+
+  FileView::FileView(const defer_create_t&)
+    : poll_(TimerService::INVALID_TIMER), top_(0), unit_(1), lineHeight_(0)
+  {
+  }
+
+  FileView::~FileView() {
+    // The indexer is destroyed (& waited for) before the index & the file
+    // by member order; only the timer needs stopping
+    if (poll_ != TimerService::INVALID_TIMER) {
+      OwningPump().CancelTimer(poll_);
+    }
+  }
+
+  void FileView::Create(Window& parent) {
+    Register();
+    CreateWindow(CLASS_NAME, L"",
+      WS_VISIBLE | WS_CHILD | WS_VSCROLL | WS_TABSTOP,
+      0, 0, 0, 0,
+      parent.TheHWND(), nullptr, GetModuleHandle(nullptr), (LPVOID) this
+    );
+    OwningPump().RaiseReportedException();
+
+    assert(hWnd_);
+  }
+
+  bool FileView::Open(const MappedFile::Path& path) {
+    Close();
+
+    if (!file_.Open(path)) {
+      return false;
+    }
+
+    index_.reset(new LineIndex(file_.Data(), file_.Size()));
+    indexer_.reset(new LineIndexer(DefaultWorkerPool(), *index_));
+    indexer_->Start();
+
+    // The scroll bar's page size follows the average line length, which
+    // settles as more of the file is indexed
+    poll_ = OwningPump().Timers().Every(POLL_INTERVAL, [this]() {
+      ConfigScrollbar();
+
+      if (index_->Done()) {
+        OwningPump().CancelTimer(poll_);
+        poll_ = TimerService::INVALID_TIMER;
+      }
+    });
+
+    ConfigScrollbar();
+    InvalidateRect(hWnd_, nullptr, TRUE);
+    return true;
+  }
+
+  void FileView::Close() {
+    if (poll_ != TimerService::INVALID_TIMER) {
+      OwningPump().CancelTimer(poll_);
+      poll_ = TimerService::INVALID_TIMER;
+    }
+
+    indexer_.reset();
+    index_.reset();
+    file_.Close();
+    top_ = 0;
+
+    ConfigScrollbar();
+    InvalidateRect(hWnd_, nullptr, TRUE);
+  }
+
+  bool FileView::TopLine(std::uint64_t& line) const {
+    return index_ && index_->LineAt(top_, line);
+  }
+
+  bool FileView::GoToLine(std::uint64_t line) {
+    std::uint64_t offset;
+
+    if (!index_ || !index_->LineStart(line, offset)) {
+      return false;
+    }
+
+    SetTop(offset);
+    return true;
+  }
+
+  void FileView::GoToOffset(std::uint64_t offset) {
+    if (file_.Size() == 0) {
+      return;
+    }
+
+    offset = (std::min)(offset, file_.Size() - 1);
+    SetTop(LineIndex::StartOfLine(file_.Data(), offset));
+  }
+
+  LRESULT FileView::WndProc(HWND h, UINT m, WPARAM w, LPARAM l) {
+    switch (m) {
+    case WM_SIZE:
+      ConfigScrollbar();
+      break;
+
+    case WM_PAINT:
+      Paint();
+      return 0;
+
+    case WM_ERASEBKGND:
+      // Every line is drawn opaque, blank ones included
+      return 1;
+
+    case WM_VSCROLL: {
+      ScrollMsg scroll(m, w, l);
+      HandleScroll(scroll.action);
+      return 0;
+    }
+
+    case WM_MOUSEWHEEL:
+      ScrollLines(-(std::int64_t) GET_WHEEL_DELTA_WPARAM(w) * WHEEL_LINES / WHEEL_DELTA);
+      UpdateWindow(h);
+      return 0;
+
+    case WM_GETDLGCODE:
+      return DLGC_WANTARROWS;
+
+    case WM_KEYDOWN:
+      HandleKey(w);
+      return 0;
+
+    case WM_LBUTTONDOWN:
+      SetFocus(h);
+      return 0;
+    }
+
+    return CustomWindow<FileView>::WndProc(h, m, w, l);
+  }
+
+  void FileView::Measure() {
+    if (lineHeight_ > 0) {
+      return;
+    }
+
+    HDC dc = GetDC(hWnd_);
+    HGDIOBJ oldFont = SelectObject(dc, GetStockObject(ANSI_FIXED_FONT));
+
+    TEXTMETRIC tm = {};
+    GetTextMetrics(dc, &tm);
+    lineHeight_ = (tm.tmHeight > 0) ? tm.tmHeight : 16;
+
+    SelectObject(dc, oldFont);
+    ReleaseDC(hWnd_, dc);
+  }
+
+  int FileView::VisibleLines() {
+    Measure();
+    return (std::max)(GetClientSize(*this).h / lineHeight_, 1);
+  }
+
+  std::uint64_t FileView::LastLineStart() const {
+    return (file_.Size() > 0) ? LineIndex::StartOfLine(file_.Data(), file_.Size() - 1) : 0;
+  }
+
+  void FileView::SetTop(std::uint64_t offset) {
+    if (offset == top_) {
+      return;
+    }
+
+    top_ = offset;
+    ConfigScrollbar();
+    InvalidateRect(hWnd_, nullptr, FALSE);
+  }
+
+  void FileView::ScrollLines(std::int64_t n) {
+    if (file_.Size() == 0) {
+      return;
+    }
+
+    const char* data = file_.Data();
+    const char* end = data + file_.Size();
+    std::uint64_t top = top_;
+    std::uint64_t last = LastLineStart();
+    std::int64_t moved = 0;
+
+    // Walk the newlines either way; n is at most a page
+    while (moved < n && top < last) {
+      std::uint64_t one = 1;
+      top = LineIndex::SkipNewlines(data + top, end, one) - data;
+      ++moved;
+    }
+    while (moved > n && top > 0) {
+      top = LineIndex::StartOfLine(data, top - 1);
+      --moved;
+    }
+
+    if (moved == 0) {
+      return;
+    }
+
+    top_ = top;
+    ConfigScrollbar();
+
+    if (moved > -VisibleLines() && moved < VisibleLines()) {
+      ScrollWindow(hWnd_, 0, (int) -moved * lineHeight_, nullptr, nullptr);
+    }
+    else {
+      InvalidateRect(hWnd_, nullptr, FALSE);
+    }
+  }
+
+  void FileView::ConfigScrollbar() {
+    std::uint64_t size = file_.Size();
+
+    unit_ = 1;
+    while (size / unit_ > MAX_SCROLL_UNITS) {
+      unit_ *= 2;
+    }
+
+    std::uint64_t lineBytes = TYPICAL_LINE;
+    if (index_ && index_->Lines() > 1) {
+      lineBytes = (std::max)(index_->Indexed() / index_->Lines(), (std::uint64_t) 1);
+    }
+
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(SCROLLINFO);
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+    si.nMin = 0;
+    si.nMax = (int) (size / unit_);
+    si.nPage = (UINT) (std::min)(VisibleLines() * lineBytes / unit_, (std::uint64_t) MAX_SCROLL_UNITS);
+    si.nPos = (int) (top_ / unit_);
+
+    SetScrollInfo(hWnd_, SB_VERT, &si, TRUE);
+  }
+
+  void FileView::HandleScroll(int action) {
+    switch (action) {
+    case SB_LINEUP:
+      ScrollLines(-1);
+      break;
+
+    case SB_LINEDOWN:
+      ScrollLines(1);
+      break;
+
+    case SB_PAGEUP:
+      ScrollLines(-VisibleLines());
+      break;
+
+    case SB_PAGEDOWN:
+      ScrollLines(VisibleLines());
+      break;
+
+    case SB_THUMBTRACK:
+    case SB_THUMBPOSITION: {
+      SCROLLINFO si = {};
+      si.cbSize = sizeof(SCROLLINFO);
+      si.fMask = SIF_TRACKPOS;
+      GetScrollInfo(hWnd_, SB_VERT, &si);
+
+      GoToOffset((std::uint64_t) si.nTrackPos * unit_);
+      break;
+    }
+
+    case SB_TOP:
+      GoToOffset(0);
+      break;
+
+    case SB_BOTTOM:
+      GoToOffset(file_.Size());
+      break;
+
+    default:
+      return;
+    }
+
+    UpdateWindow(hWnd_);
+  }
+
+  void FileView::HandleKey(WPARAM vk) {
+    switch (vk) {
+    case VK_UP:     HandleScroll(SB_LINEUP); break;
+    case VK_DOWN:   HandleScroll(SB_LINEDOWN); break;
+    case VK_PRIOR:  HandleScroll(SB_PAGEUP); break;
+    case VK_NEXT:   HandleScroll(SB_PAGEDOWN); break;
+    case VK_HOME:   HandleScroll(SB_TOP); break;
+    case VK_END:    HandleScroll(SB_BOTTOM); break;
+    }
+  }
+
+  void FileView::Paint() {
+    PAINTSTRUCT ps;
+    HDC dc = BeginPaint(hWnd_, &ps);
+
+    Measure();
+
+    Dimension c = GetClientSize(*this);
+    HGDIOBJ oldFont = SelectObject(dc, GetStockObject(ANSI_FIXED_FONT));
+    SetBkColor(dc, GetSysColor(COLOR_WINDOW));
+    SetTextColor(dc, GetSysColor(COLOR_WINDOWTEXT));
+
+    const char* data = file_.Data();
+    const char* end = data + file_.Size();
+    const char* p = data + top_;
+
+    // Lines above the update region are only skipped over
+    int first = ps.rcPaint.top / lineHeight_;
+    if (data && first > 0) {
+      std::uint64_t skip = first;
+      p = LineIndex::SkipNewlines(p, end, skip);
+    }
+
+    // A UTF-8 byte never makes more than one UTF-16 unit, so this holds
+    // any MAX_COLUMNS characters' worth of bytes
+    text_.resize(MAX_COLUMNS * 4);
+
+    for (int y = first * lineHeight_; y < ps.rcPaint.bottom; y += lineHeight_) {
+      RECT r = { 0, y, c.w, y + lineHeight_ };
+      int n = 0;
+
+      if (data && p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* stop = (nl) ? nl : end;
+        const char* next = (nl) ? nl + 1 : end;
+
+        if (stop > p && stop[-1] == '\r') {
+          --stop;
+        }
+
+        int bytes = (int) (std::min)(stop - p, (std::ptrdiff_t) text_.size());
+        n = MultiByteToWideChar(CP_UTF8, 0, p, bytes, text_.data(), (int) text_.size());
+        n = (std::min)(n, (int) MAX_COLUMNS);
+
+        // No tab stops in ExtTextOut
+        std::replace(text_.begin(), text_.begin() + n, L'\t', L' ');
+
+        p = next;
+      }
+
+      ExtTextOut(dc, 0, y, ETO_OPAQUE | ETO_CLIPPED, &r, text_.data(), (UINT) n, nullptr);
+    }
+
+    SelectObject(dc, oldFont);
+    EndPaint(hWnd_, &ps);
+  }
+
+} // namespace jwt
\ No newline at end of file
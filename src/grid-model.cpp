@@ -0,0 +1,340 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "grid-model.hpp"
+#include <algorithm>
+#include <assert.h>
+
+namespace jwt {
+
+  namespace {
+    bool ByRow(const std::pair<std::uint32_t, int>& a, std::uint32_t row) {
+      return a.first < row;
+    }
+  }
+
+  //
+  // RowIndex
+  //
+  RowIndex::RowIndex(int defaultHeight, std::uint64_t count)
+    : defaultHeight_(defaultHeight), count_(0)
+  {
+    assert(defaultHeight >= 0);
+
+    SetCount(count);
+  }
+
+  void RowIndex::SetCount(std::uint64_t count) {
+    std::uint64_t blocks = (count + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    std::uint32_t lastRows = (std::uint32_t) (count - (blocks - 1) * BLOCK_ROWS);
+
+    for (auto i = heights_.begin(); i != heights_.end(); ) {
+      if (i->first >= blocks) {
+        i = heights_.erase(i);
+        continue;
+      }
+
+      if (i->first == blocks - 1) {
+        Overrides& o = i->second;
+        o.erase(std::lower_bound(o.begin(), o.end(), lastRows, ByRow), o.end());
+
+        if (o.empty()) {
+          i = heights_.erase(i);
+          continue;
+        }
+      }
+      ++i;
+    }
+
+    count_ = count;
+    Rebuild();
+  }
+
+  int RowIndex::Height(std::uint64_t row) const {
+    assert(row < count_);
+
+    auto i = heights_.find(row / BLOCK_ROWS);
+    if (i == heights_.end()) {
+      return defaultHeight_;
+    }
+
+    std::uint32_t r = (std::uint32_t) (row % BLOCK_ROWS);
+    auto h = std::lower_bound(i->second.begin(), i->second.end(), r, ByRow);
+
+    return (h != i->second.end() && h->first == r) ? h->second : defaultHeight_;
+  }
+
+  void RowIndex::SetHeight(std::uint64_t row, int height) {
+    assert(row < count_);
+    assert(height >= 0);
+
+    std::uint64_t block = row / BLOCK_ROWS;
+    std::uint32_t r = (std::uint32_t) (row % BLOCK_ROWS);
+
+    Overrides& o = heights_[block];
+    auto h = std::lower_bound(o.begin(), o.end(), r, ByRow);
+    bool found = (h != o.end() && h->first == r);
+    int old = (found) ? h->second : defaultHeight_;
+
+    if (height == defaultHeight_) {
+      if (found) {
+        o.erase(h);
+      }
+    }
+    else if (found) {
+      h->second = height;
+    }
+    else {
+      o.insert(h, std::make_pair(r, height));
+    }
+
+    if (o.empty()) {
+      heights_.erase(block);
+    }
+
+    AddDelta(block, (std::int64_t) height - old);
+  }
+
+  void RowIndex::ResetHeights() {
+    heights_.clear();
+    Rebuild();
+  }
+
+  std::int64_t RowIndex::Offset(std::uint64_t row) const {
+    assert(row <= count_);
+
+    std::uint64_t block = row / BLOCK_ROWS;
+    std::uint32_t r = (std::uint32_t) (row % BLOCK_ROWS);
+    std::int64_t y = (std::int64_t) row * defaultHeight_;
+
+    for (std::uint64_t k = block; k > 0; k -= k & (~k + 1)) {
+      y += tree_[k];
+    }
+
+    auto i = heights_.find(block);
+    if (i != heights_.end()) {
+      for (const auto& h : i->second) {
+        if (h.first >= r) {
+          break;
+        }
+        y += h.second - defaultHeight_;
+      }
+    }
+    return y;
+  }
+
+  std::uint64_t RowIndex::RowAt(std::int64_t y) const {
+    assert(count_ > 0);
+
+    if (y < 0) {
+      y = 0;
+    }
+    if (y >= Total()) {
+      return count_ - 1;
+    }
+
+    // Descend the tree for the last block starting at or before y. Each
+    // node covers step whole blocks, hence the default heights added back.
+    std::uint64_t blocks = tree_.size() - 1;
+    std::uint64_t step = 1;
+    while (step * 2 <= blocks) {
+      step *= 2;
+    }
+
+    std::uint64_t block = 0;
+    std::int64_t rest = y;
+
+    for (; step > 0; step /= 2) {
+      if (block + step <= blocks) {
+        std::int64_t h = tree_[block + step] + (std::int64_t) step * BLOCK_ROWS * defaultHeight_;
+
+        if (h <= rest) {
+          block += step;
+          rest -= h;
+        }
+      }
+    }
+
+    // Then along the block's rows
+    std::uint64_t first = block * BLOCK_ROWS;
+    std::uint64_t last = (std::min)(first + BLOCK_ROWS, count_);
+
+    auto i = heights_.find(block);
+    const Overrides* o = (i != heights_.end()) ? &i->second : nullptr;
+    std::size_t next = 0;
+
+    for (std::uint64_t row = first; row < last; ++row) {
+      int h = defaultHeight_;
+
+      if (o && next < o->size() && (*o)[next].first == row - first) {
+        h = (*o)[next++].second;
+      }
+      if (rest < h) {
+        return row;
+      }
+      rest -= h;
+    }
+    return last - 1;
+  }
+
+  std::int64_t RowIndex::BlockDelta(std::uint64_t block) const {
+    std::int64_t delta = 0;
+
+    auto i = heights_.find(block);
+    if (i != heights_.end()) {
+      for (const auto& h : i->second) {
+        delta += h.second - defaultHeight_;
+      }
+    }
+    return delta;
+  }
+
+  void RowIndex::AddDelta(std::uint64_t block, std::int64_t delta) {
+    if (delta == 0) {
+      return;
+    }
+
+    for (std::uint64_t k = block + 1; k < tree_.size(); k += k & (~k + 1)) {
+      tree_[k] += delta;
+    }
+  }
+
+  void RowIndex::Rebuild() {
+    std::uint64_t blocks = (count_ + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    tree_.assign(blocks + 1, 0);
+
+    for (const auto& i : heights_) {
+      tree_[i.first + 1] = BlockDelta(i.first);
+    }
+
+    // O(n) construction: push each node's total up to its parent
+    for (std::uint64_t k = 1; k <= blocks; ++k) {
+      std::uint64_t parent = k + (k & (~k + 1));
+      if (parent <= blocks) {
+        tree_[parent] += tree_[k];
+      }
+    }
+  }
+
+  //
+  // CellCache
+  //
+  CellCache::CellCache(GridProvider& p, std::size_t maxBlocks)
+    : provider_(&p), maxBlocks_(maxBlocks), hits_(0), fetches_(0)
+  {
+    assert(maxBlocks > 0);
+  }
+
+  const std::wstring& CellCache::Cell(std::uint64_t row, int column) {
+    std::uint64_t block = row / BLOCK_ROWS;
+    auto i = blocks_.find(block);
+
+    Block* b;
+    if (i != blocks_.end()) {
+      b = &i->second;
+      lru_.splice(lru_.begin(), lru_, b->lru);
+      ++hits_;
+    }
+    else {
+      b = &Fetch(block);
+    }
+
+    std::size_t cell = (std::size_t) (row - block * BLOCK_ROWS) * b->columns + column;
+
+    if (column < 0 || column >= b->columns || cell >= b->cells.size()) {
+      return empty_;
+    }
+    return b->cells[cell];
+  }
+
+  void CellCache::Invalidate() {
+    blocks_.clear();
+    lru_.clear();
+  }
+
+  void CellCache::Invalidate(std::uint64_t first, std::uint64_t count) {
+    if (count == 0) {
+      return;
+    }
+
+    std::uint64_t b0 = first / BLOCK_ROWS;
+    std::uint64_t b1 = (first + count - 1) / BLOCK_ROWS;
+
+    for (auto i = blocks_.begin(); i != blocks_.end(); ) {
+      if (i->first >= b0 && i->first <= b1) {
+        lru_.erase(i->second.lru);
+        i = blocks_.erase(i);
+      }
+      else {
+        ++i;
+      }
+    }
+  }
+
+  void CellCache::SetProvider(GridProvider& p) {
+    provider_ = &p;
+    Invalidate();
+  }
+
+  void CellCache::SetMaxBlocks(std::size_t maxBlocks) {
+    assert(maxBlocks > 0);
+
+    maxBlocks_ = maxBlocks;
+    Trim();
+  }
+
+  CellCache::Block& CellCache::Fetch(std::uint64_t block) {
+    std::uint64_t first = block * BLOCK_ROWS;
+    std::uint64_t rows = provider_->Rows();
+    std::uint32_t count = (first < rows) ? (std::uint32_t) (std::min)((std::uint64_t) BLOCK_ROWS, rows - first) : 0;
+
+    // Fetch before touching the cache, so a provider that throws leaves it
+    // as it was rather than holding a block that isn't in the LRU list
+    std::vector<std::wstring> cells;
+    int columns = provider_->Columns();
+
+    if (count > 0) {
+      provider_->Fetch(first, count, cells);
+    }
+
+    // Make room first, so the new block can't be the one dropped
+    while (blocks_.size() >= maxBlocks_) {
+      blocks_.erase(lru_.back());
+      lru_.pop_back();
+    }
+
+    lru_.push_front(block);
+
+    Block& b = blocks_[block];
+    b.cells = std::move(cells);
+    b.columns = columns;
+    b.lru = lru_.begin();
+
+    ++fetches_;
+    return b;
+  }
+
+  void CellCache::Trim() {
+    while (blocks_.size() > maxBlocks_) {
+      blocks_.erase(lru_.back());
+      lru_.pop_back();
+    }
+  }
+
+} // namespace jwt
\ No newline at end of file
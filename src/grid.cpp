@@ -0,0 +1,487 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "grid.hpp"
+#include <algorithm>
+#include <assert.h>
+
+namespace jwt {
+
+  namespace {
+    const int TEXT_PAD_X = 4;
+    const int TEXT_PAD_Y = 2;
+    const int EDGE_SLOP = 3;
+    const int LINE_WIDTH = 16;
+    const int WHEEL_ROWS = 3;
+
+    // Keeps scroll bar positions well inside an int
+    const std::int64_t MAX_SCROLL_UNITS = 1 << 30;
+
+    struct NoRows : GridProvider {
+      std::uint64_t Rows() const { return 0; }
+      int Columns() const { return 0; }
+      std::wstring Header(int) const { return std::wstring(); }
+      void Fetch(std::uint64_t, std::uint32_t, std::vector<std::wstring>&) {}
+    };
+
+    NoRows noRows;
+  }
+
+  const wchar_t* Grid::CLASS_NAME = L"Grid::CLASS_NAME";
+
+  void Grid::Register() {
+    CustomWindow<Grid>::Register(CLASS_NAME);
+  }
+
+  Grid::Grid(Window& parent, GridProvider& p)
+    : provider_(&p), rows_(RowIndex::DEFAULT_HEIGHT, p.Rows()), cells_(p),
+      widths_(p.Columns(), DEFAULT_COLUMN_WIDTH), y_(0), x_(0), yUnit_(1),
+      resizing_(-1), dragFrom_(0), dragWidth_(0), overEdge_(false)
+  {
+    Create(parent);
+  }
+
+  Grid::Grid(const defer_create_t&)
+    : provider_(&noRows), rows_(), cells_(noRows), y_(0), x_(0), yUnit_(1),
+      resizing_(-1), dragFrom_(0), dragWidth_(0), overEdge_(false)
+  {
+  }
+
+  void Grid::Create(Window& parent) {
+    Register();
+    CreateWindow(CLASS_NAME, L"",
+      WS_VISIBLE | WS_CHILD | WS_HSCROLL | WS_VSCROLL | WS_TABSTOP,
+      0, 0, 0, 0,
+      parent.TheHWND(), nullptr, GetModuleHandle(nullptr), (LPVOID) this
+    );
+    OwningPump().RaiseReportedException();
+
+    assert(hWnd_);
+  }
+
+  Grid& Grid::Provider(GridProvider& p) {
+    provider_ = &p;
+    cells_.SetProvider(p);
+
+    Refresh();
+    return *this;
+  }
+
+  int Grid::ColumnWidth(int column) const {
+    assert(column >= 0 && column < (int) widths_.size());
+    return widths_[column];
+  }
+
+  Grid& Grid::ColumnWidth(int column, int width) {
+    assert(column >= 0 && column < (int) widths_.size());
+
+    width = (std::max)(width, (int) MIN_COLUMN_WIDTH);
+    if (widths_[column] == width) {
+      return *this;
+    }
+
+    widths_[column] = width;
+    ConfigScrollbars();
+
+    // Everything from the column's left edge moves
+    Dimension c = GetClientSize(*this);
+    RECT r = { ColumnLeft(column) - x_, 0, c.w, c.h };
+    InvalidateRect(hWnd_, &r, FALSE);
+    return *this;
+  }
+
+  std::uint64_t Grid::TopRow() const {
+    return (rows_.Count() > 0) ? rows_.RowAt(y_) : 0;
+  }
+
+  Grid& Grid::TopRow(std::uint64_t row) {
+    ScrollTo(x_, rows_.Offset((std::min)(row, rows_.Count())));
+    return *this;
+  }
+
+  void Grid::Refresh() {
+    rows_.SetCount(provider_->Rows());
+    widths_.resize(provider_->Columns(), DEFAULT_COLUMN_WIDTH);
+    cells_.Invalidate();
+
+    Relayout();
+  }
+
+  void Grid::Relayout() {
+    ConfigScrollbars();
+    InvalidateRect(hWnd_, nullptr, FALSE);
+  }
+
+  LRESULT Grid::WndProc(HWND h, UINT m, WPARAM w, LPARAM l) {
+    switch (m) {
+    case WM_SIZE:
+      ConfigScrollbars();
+      break;
+
+    case WM_PAINT:
+      Paint();
+      return 0;
+
+    case WM_ERASEBKGND:
+      // Paint() covers every pixel
+      return 1;
+
+    case WM_HSCROLL:
+    case WM_VSCROLL: {
+      ScrollMsg scroll(m, w, l);
+      HandleScroll(scroll.vertical, scroll.action);
+      return 0;
+    }
+
+    case WM_MOUSEWHEEL: {
+      std::int64_t step = (std::int64_t) GET_WHEEL_DELTA_WPARAM(w) * WHEEL_ROWS * rows_.DefaultHeight() / WHEEL_DELTA;
+      ScrollTo(x_, y_ - step);
+      UpdateWindow(h);
+      return 0;
+    }
+
+    case WM_GETDLGCODE:
+      return DLGC_WANTARROWS;
+
+    case WM_KEYDOWN:
+      HandleKey(w);
+      return 0;
+
+    case WM_LBUTTONDOWN: {
+      SetFocus(h);
+
+      int edge = EdgeAt(GET_X_LPARAM(l), GET_Y_LPARAM(l));
+      if (edge >= 0) {
+        resizing_ = edge;
+        dragFrom_ = GET_X_LPARAM(l);
+        dragWidth_ = widths_[edge];
+        SetCapture(h);
+      }
+      return 0;
+    }
+
+    case WM_MOUSEMOVE:
+      if (resizing_ >= 0) {
+        ColumnWidth(resizing_, dragWidth_ + GET_X_LPARAM(l) - dragFrom_);
+        UpdateWindow(h);
+      }
+      else {
+        overEdge_ = EdgeAt(GET_X_LPARAM(l), GET_Y_LPARAM(l)) >= 0;
+      }
+      return 0;
+
+    case WM_LBUTTONUP:
+      if (resizing_ >= 0) {
+        ReleaseCapture();
+      }
+      return 0;
+
+    case WM_CAPTURECHANGED:
+      resizing_ = -1;
+      return 0;
+
+    case WM_SETCURSOR:
+      if (LOWORD(l) == HTCLIENT && (resizing_ >= 0 || overEdge_)) {
+        SetCursor(LoadCursor(nullptr, IDC_SIZEWE));
+        return TRUE;
+      }
+      break;
+    }
+
+    return CustomWindow<Grid>::WndProc(h, m, w, l);
+  }
+
+  int Grid::TotalWidth() const {
+    int w = 0;
+    for (int cw : widths_) {
+      w += cw;
+    }
+    return w;
+  }
+
+  int Grid::ColumnLeft(int column) const {
+    int left = 0;
+    for (int c = 0; c < column; ++c) {
+      left += widths_[c];
+    }
+    return left;
+  }
+
+  int Grid::EdgeAt(int x, int y) const {
+    if (y < 0 || y >= HeaderHeight()) {
+      return -1;
+    }
+
+    // The last edge within reach wins, so that a column shrunk to nothing
+    // can still be widened
+    int found = -1;
+    int right = -x_;
+
+    for (int c = 0; c < (int) widths_.size(); ++c) {
+      right += widths_[c];
+
+      if (x >= right - EDGE_SLOP && x <= right + EDGE_SLOP) {
+        found = c;
+      }
+      else if (right > x + EDGE_SLOP) {
+        break;
+      }
+    }
+    return found;
+  }
+
+  void Grid::ConfigScrollbars() {
+    Dimension c = GetClientSize(*this);
+    int viewH = (std::max)(c.h - HeaderHeight(), 0);
+    std::int64_t total = rows_.Total();
+
+    yUnit_ = 1;
+    while (total / yUnit_ > MAX_SCROLL_UNITS) {
+      yUnit_ *= 2;
+    }
+
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(SCROLLINFO);
+    si.fMask = SIF_RANGE | SIF_PAGE;
+    si.nMin = 0;
+
+    si.nMax = (int) (total / yUnit_);
+    si.nPage = viewH / yUnit_;
+    SetScrollInfo(hWnd_, SB_VERT, &si, TRUE);
+
+    si.nMax = TotalWidth();
+    si.nPage = c.w;
+    SetScrollInfo(hWnd_, SB_HORZ, &si, TRUE);
+
+    // Re-clamps the position & puts it on the bars
+    ScrollTo(x_, y_);
+  }
+
+  void Grid::ScrollTo(int x, std::int64_t y) {
+    Dimension c = GetClientSize(*this);
+    int header = HeaderHeight();
+    int viewH = (std::max)(c.h - header, 0);
+
+    y = (std::min)(y, rows_.Total() - viewH);
+    y = (std::max)(y, (std::int64_t) 0);
+
+    x = (std::min)(x, TotalWidth() - c.w);
+    x = (std::max)(x, 0);
+
+    std::int64_t dy = y_ - y;
+    int dx = x_ - x;
+
+    y_ = y;
+    x_ = x;
+
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(SCROLLINFO);
+    si.fMask = SIF_POS;
+
+    si.nPos = (int) (y_ / yUnit_);
+    SetScrollInfo(hWnd_, SB_VERT, &si, TRUE);
+
+    si.nPos = x_;
+    SetScrollInfo(hWnd_, SB_HORZ, &si, TRUE);
+
+    // Move what is already drawn & leave the rest to WM_PAINT; the header
+    // only moves sideways
+    if (dy != 0) {
+      RECT body = { 0, header, c.w, c.h };
+
+      if (dy > -viewH && dy < viewH) {
+        ScrollWindow(hWnd_, 0, (int) dy, &body, &body);
+      }
+      else {
+        InvalidateRect(hWnd_, &body, FALSE);
+      }
+    }
+
+    if (dx != 0) {
+      if (dx > -c.w && dx < c.w) {
+        ScrollWindow(hWnd_, dx, 0, nullptr, nullptr);
+      }
+      else {
+        InvalidateRect(hWnd_, nullptr, FALSE);
+      }
+    }
+  }
+
+  void Grid::HandleScroll(bool vertical, int action) {
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(SCROLLINFO);
+    si.fMask = SIF_ALL;
+
+    GetScrollInfo(hWnd_, (vertical) ? SB_VERT : SB_HORZ, &si);
+
+    Dimension c = GetClientSize(*this);
+    std::int64_t pos = (vertical) ? y_ : x_;
+    std::int64_t line = (vertical) ? rows_.DefaultHeight() : LINE_WIDTH;
+    std::int64_t page = (vertical) ? (std::max)(c.h - HeaderHeight(), 0) : c.w;
+    std::int64_t unit = (vertical) ? yUnit_ : 1;
+
+    switch (action) {
+    case SB_LINEUP:
+      pos -= line;
+      break;
+
+    case SB_LINEDOWN:
+      pos += line;
+      break;
+
+    case SB_PAGEUP:
+      pos -= page;
+      break;
+
+    case SB_PAGEDOWN:
+      pos += page;
+      break;
+
+    case SB_THUMBTRACK:
+    case SB_THUMBPOSITION:
+      pos = (std::int64_t) si.nTrackPos * unit;
+      break;
+
+    case SB_TOP:
+      pos = 0;
+      break;
+
+    case SB_BOTTOM:
+      pos = (vertical) ? rows_.Total() : TotalWidth();
+      break;
+
+    default:
+      return;
+    }
+
+    if (vertical) {
+      ScrollTo(x_, pos);
+    }
+    else {
+      ScrollTo((int) (std::min)(pos, (std::int64_t) TotalWidth()), y_);
+    }
+    UpdateWindow(hWnd_);
+  }
+
+  void Grid::HandleKey(WPARAM vk) {
+    switch (vk) {
+    case VK_UP:     HandleScroll(true, SB_LINEUP); break;
+    case VK_DOWN:   HandleScroll(true, SB_LINEDOWN); break;
+    case VK_PRIOR:  HandleScroll(true, SB_PAGEUP); break;
+    case VK_NEXT:   HandleScroll(true, SB_PAGEDOWN); break;
+    case VK_HOME:   HandleScroll(true, SB_TOP); break;
+    case VK_END:    HandleScroll(true, SB_BOTTOM); break;
+    case VK_LEFT:   HandleScroll(false, SB_LINELEFT); break;
+    case VK_RIGHT:  HandleScroll(false, SB_LINERIGHT); break;
+    }
+  }
+
+  void Grid::Paint() {
+    PAINTSTRUCT ps;
+    HDC dc = BeginPaint(hWnd_, &ps);
+    const RECT& clip = ps.rcPaint;
+
+    Dimension c = GetClientSize(*this);
+    int header = HeaderHeight();
+    int columns = (int) widths_.size();
+
+    HGDIOBJ oldFont = SelectObject(dc, GetStockObject(DEFAULT_GUI_FONT));
+    HBRUSH lines = GetSysColorBrush(COLOR_BTNSHADOW);
+
+    // The first column reaching into the update region
+    int first = 0;
+    int firstLeft = -x_;
+    while (first < columns && firstLeft + widths_[first] <= clip.left) {
+      firstLeft += widths_[first++];
+    }
+
+    int right = firstLeft;
+    for (int col = first; col < columns && right < clip.right; ++col) {
+      right += widths_[col];
+    }
+
+    // Text is drawn opaque, so the grid lines are all that's left to fill
+    auto drawCell = [&](const RECT& r, const std::wstring& text) {
+      RECT inner = { r.left, r.top, r.right - 1, r.bottom - 1 };
+      ExtTextOut(dc, inner.left + TEXT_PAD_X, inner.top + TEXT_PAD_Y, ETO_CLIPPED | ETO_OPAQUE,
+        &inner, text.c_str(), (UINT) text.size(), nullptr);
+
+      RECT v = { r.right - 1, r.top, r.right, r.bottom };
+      RECT h = { r.left, r.bottom - 1, r.right - 1, r.bottom };
+      FillRect(dc, &v, lines);
+      FillRect(dc, &h, lines);
+    };
+
+    // Body first: a row partly scrolled under the header is then covered
+    int bottom = header;
+
+    if (rows_.Count() > 0 && clip.bottom > header) {
+      SetBkColor(dc, GetSysColor(COLOR_WINDOW));
+      SetTextColor(dc, GetSysColor(COLOR_WINDOWTEXT));
+
+      std::uint64_t row = rows_.RowAt(y_ + (std::max)((int) clip.top, header) - header);
+      std::int64_t top = rows_.Offset(row) - y_ + header;
+
+      for (; row < rows_.Count() && top < clip.bottom; ++row) {
+        int h = rows_.Height(row);
+
+        if (h > 0) {
+          int left = firstLeft;
+
+          for (int col = first; col < columns && left < clip.right; ++col) {
+            RECT r = { left, (int) top, left + widths_[col], (int) top + h };
+            drawCell(r, cells_.Cell(row, col));
+            left += widths_[col];
+          }
+        }
+        top += h;
+      }
+      bottom = (int) (std::min)(top, (std::int64_t) c.h);
+    }
+
+    if (clip.top < header) {
+      SetBkColor(dc, GetSysColor(COLOR_BTNFACE));
+      SetTextColor(dc, GetSysColor(COLOR_BTNTEXT));
+
+      int left = firstLeft;
+      for (int col = first; col < columns && left < clip.right; ++col) {
+        RECT r = { left, 0, left + widths_[col], header };
+        drawCell(r, provider_->Header(col));
+        left += widths_[col];
+      }
+    }
+
+    // Beyond the last column & below the last row
+    HBRUSH bg = GetSysColorBrush(COLOR_WINDOW);
+    RECT beside = { right, 0, c.w, c.h };
+    RECT below = { 0, bottom, right, c.h };
+
+    if (right < clip.right) {
+      FillRect(dc, &beside, bg);
+    }
+    if (bottom < clip.bottom) {
+      FillRect(dc, &below, bg);
+    }
+
+    SelectObject(dc, oldFont);
+    EndPaint(hWnd_, &ps);
+  }
+
+} // namespace jwt
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "image-list-cache.hpp"
+#include <assert.h>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace jwt {
+
+  namespace {
+    typedef std::tuple<HINSTANCE, UINT, int> Key;
+
+    struct Cache {
+      std::mutex lock;
+      std::map<Key, HIMAGELIST> lists;
+
+      ~Cache() {
+        for (auto& i : lists) {
+          ImageList_Destroy(i.second);
+        }
+      }
+    };
+
+    Cache& TheCache() {
+      static Cache cache;
+      return cache;
+    }
+  }
+
+  HIMAGELIST SharedImageList(UINT resourceId, int imageWidth, HINSTANCE module) {
+    assert(imageWidth > 0);
+
+    if (!module) {
+      module = GetModuleHandle(nullptr);
+    }
+
+    Cache& c = TheCache();
+    std::lock_guard<std::mutex> lock(c.lock);
+
+    HIMAGELIST& list = c.lists[Key(module, resourceId, imageWidth)];
+    if (!list) {
+      list = ImageList_LoadImage(module, MAKEINTRESOURCE(resourceId), imageWidth, 0,
+        CLR_DEFAULT, IMAGE_BITMAP, LR_CREATEDIBSECTION);
+
+      if (!list) {
+        c.lists.erase(Key(module, resourceId, imageWidth));
+        throw "ImageList_LoadImage failed.";
+      }
+    }
+
+    return list;
+  }
+
+  std::size_t SharedImageListCount() {
+    Cache& c = TheCache();
+    std::lock_guard<std::mutex> lock(c.lock);
+
+    return c.lists.size();
+  }
+
+} // namespace jwt
\ No newline at end of file
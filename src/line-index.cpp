@@ -0,0 +1,284 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "line-index.hpp"
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JWT_LINE_INDEX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace jwt {
+
+#ifdef JWT_LINE_INDEX_SSE2
+  namespace {
+    unsigned int PopCount(std::uint32_t v) {
+      // POPCNT isn't guaranteed alongside SSE2
+      v = v - ((v >> 1) & 0x55555555u);
+      v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+      return (((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+    }
+
+    unsigned int LowestBit(std::uint32_t v) {
+      assert(v != 0);
+#ifdef _MSC_VER
+      unsigned long i;
+      _BitScanForward(&i, v);
+      return i;
+#else
+      return __builtin_ctz(v);
+#endif
+    }
+  }
+#endif
+
+  //
+  // LineIndex
+  //
+  LineIndex::LineIndex(const char* data, std::uint64_t size)
+    : data_(data), size_(size), starts_(1, 0), newlines_(0), indexed_(0)
+  {
+    assert(data || size == 0);
+  }
+
+  std::uint64_t LineIndex::Scan(std::uint64_t bytes) {
+    // Only this thread writes newlines_ & indexed_, so they can be read
+    // without the lock here
+    std::uint64_t from = indexed_.load(std::memory_order_relaxed);
+    std::uint64_t to = from + (std::min)(bytes, size_ - from);
+
+    if (from == to) {
+      return 0;
+    }
+
+    std::vector<std::uint64_t> found;
+    std::uint64_t lines = newlines_;
+
+    const char* p = data_ + from;
+    const char* end = data_ + to;
+
+    while (p < end) {
+      std::uint64_t need = STRIDE - lines % STRIDE;
+      std::uint64_t missing = need;
+
+      p = SkipNewlines(p, end, missing);
+      lines += need - missing;
+
+      if (missing == 0) {
+        found.push_back(p - data_);
+      }
+    }
+
+    std::lock_guard<std::mutex> guard(lock_);
+    starts_.insert(starts_.end(), found.begin(), found.end());
+    newlines_ = lines;
+    indexed_.store(to, std::memory_order_release);
+
+    return to - from;
+  }
+
+  std::uint64_t LineIndex::Lines() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return LinesLocked();
+  }
+
+  std::uint64_t LineIndex::LinesLocked() const {
+    if (size_ == 0) {
+      return 0;
+    }
+
+    // A '\n' at the very end doesn't start another line
+    std::uint64_t lines = 1 + newlines_;
+    if (newlines_ > 0 && indexed_.load(std::memory_order_relaxed) == size_ && data_[size_ - 1] == '\n') {
+      --lines;
+    }
+    return lines;
+  }
+
+  bool LineIndex::LineStart(std::uint64_t line, std::uint64_t& offset) const {
+    std::uint64_t start;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+
+      if (line >= LinesLocked()) {
+        return false;
+      }
+      start = starts_[line / STRIDE];
+    }
+
+    std::uint64_t skip = line % STRIDE;
+    if (skip > 0) {
+      start = SkipNewlines(data_ + start, data_ + size_, skip) - data_;
+    }
+
+    offset = start;
+    return true;
+  }
+
+  bool LineIndex::LineAt(std::uint64_t offset, std::uint64_t& line) const {
+    std::size_t i;
+    std::uint64_t start;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+
+      if (offset >= indexed_.load(std::memory_order_relaxed)) {
+        return false;
+      }
+
+      i = (std::upper_bound(starts_.begin(), starts_.end(), offset) - starts_.begin()) - 1;
+      start = starts_[i];
+    }
+
+    line = (std::uint64_t) i * STRIDE + CountNewlines(data_ + start, data_ + offset);
+    return true;
+  }
+
+  bool LineIndex::Line(std::uint64_t line, const char*& text, std::size_t& length) const {
+    std::uint64_t start;
+    if (!LineStart(line, start)) {
+      return false;
+    }
+
+    const char* begin = data_ + start;
+    const char* end = static_cast<const char*>(std::memchr(begin, '\n', (std::size_t) (size_ - start)));
+
+    if (!end) {
+      end = data_ + size_;
+    }
+    if (end > begin && end[-1] == '\r') {
+      --end;
+    }
+
+    text = begin;
+    length = end - begin;
+    return true;
+  }
+
+  std::uint64_t LineIndex::StartOfLine(const char* data, std::uint64_t offset) {
+    const char* p = data + offset;
+
+    while (p > data && p[-1] != '\n') {
+      --p;
+    }
+    return p - data;
+  }
+
+  const char* LineIndex::SkipNewlines(const char* p, const char* end, std::uint64_t& n) {
+    if (n == 0) {
+      return p;
+    }
+
+#ifdef JWT_LINE_INDEX_SSE2
+    // 32 bytes at a time: most blocks hold fewer newlines than are still
+    // wanted, & are skipped on a population count alone
+    const __m128i nl = _mm_set1_epi8('\n');
+
+    while (end - p >= 32) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+
+      std::uint32_t mask = (std::uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(a, nl)) |
+        ((std::uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(b, nl)) << 16);
+
+      unsigned int count = PopCount(mask);
+      if (count < n) {
+        n -= count;
+        p += 32;
+        continue;
+      }
+
+      // The one wanted is in this block: drop the n - 1 before it
+      for (std::uint64_t i = 1; i < n; ++i) {
+        mask &= mask - 1;
+      }
+      n = 0;
+      return p + LowestBit(mask) + 1;
+    }
+#endif
+
+    while (p < end) {
+      const char* q = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      if (!q) {
+        return end;
+      }
+
+      p = q + 1;
+      if (--n == 0) {
+        return p;
+      }
+    }
+    return end;
+  }
+
+  std::uint64_t LineIndex::CountNewlines(const char* begin, const char* end) {
+    const std::uint64_t all = ~0ULL;
+    std::uint64_t n = all;
+
+    SkipNewlines(begin, end, n);
+    return all - n;
+  }
+
+  //
+  // LineIndexer
+  //
+  LineIndexer::LineIndexer(Executor& e, LineIndex& index, std::size_t chunkBytes)
+    : WorkItem(&Run), executor_(e), index_(index), chunk_(chunkBytes), running_(false), stop_(false)
+  {
+    assert(chunkBytes > 0);
+  }
+
+  LineIndexer::~LineIndexer() {
+    Stop();
+
+    while (running_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void LineIndexer::Start() {
+    stop_.store(false, std::memory_order_release);
+
+    if (!index_.Done() && !running_.exchange(true, std::memory_order_acq_rel)) {
+      executor_.Post(this);
+    }
+  }
+
+  void LineIndexer::Run(WorkItem* w) {
+    LineIndexer* self = static_cast<LineIndexer*>(w);
+
+    self->index_.Scan(self->chunk_);
+
+    if (!self->index_.Done() && !self->stop_.load(std::memory_order_acquire)) {
+      self->executor_.Post(self);
+      return;
+    }
+
+    // Last touch: the destructor may proceed once this is clear
+    self->running_.store(false, std::memory_order_release);
+  }
+
+} // namespace jwt
\ No newline at end of file
@@ -33,11 +33,15 @@ namespace jwt {
     Create(parent);
   }
 
+  ListBox::ListBox(const lazy_create_t&, Window& parent) {
+    CreateLazily(parent, L"ListBox", WS_VISIBLE | WS_CHILD);
+  }
+
   ListBox::ListBox(Dialog& parent, int listId) {
     hWnd_ = parent.Item(listId);
 
     assert(hWnd_ != nullptr);
-    assert(ClassName(*this) == L"ListBox");
+    assert(HasClass(*this, L"ListBox"));
 
 
     SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) this);
@@ -58,11 +62,8 @@ namespace jwt {
   }
 
   LRESULT ListBox::HandleReflectedMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
-    switch (m) {
-    case WM_COMMAND:
-      break;
-    }
-
+    // Nothing is listened for
+    Unreflect<ListBox>(ReflectFlag(m));
     return 0;
   }
 
@@ -118,6 +119,11 @@ namespace jwt {
   }
 
   int SelectedIndex(const ListBox& l) {
+    // Adding strings realizes the control, so a pending one is empty
+    if (l.Pending()) {
+      return LB_ERR;
+    }
+
     assert(l.TheHWND() != nullptr);
     assert(!HasStyle(l, LBS_MULTIPLESEL));
 
@@ -125,6 +131,10 @@ namespace jwt {
   }
 
   std::vector<int> SelectedIndices(const ListBox& l) {
+    if (l.Pending()) {
+      return std::vector<int>();
+    }
+
     assert(l.TheHWND() != nullptr);
     assert(HasStyle(l, LBS_MULTIPLESEL));
 
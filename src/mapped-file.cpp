@@ -0,0 +1,155 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mapped-file.hpp"
+
+#ifdef _WIN32
+#include "libraries.hpp"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jwt {
+
+#ifdef _WIN32
+
+  MappedFile::MappedFile()
+    : data_(nullptr), size_(0), open_(false), file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+  {}
+
+  bool MappedFile::Open(const Path& path) {
+    Close();
+
+    // Share writes & deletes: the file is usually a log something else is
+    // still appending to
+    HANDLE f = CreateFile(path.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (f == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size) || (std::uint64_t) size.QuadPart > (std::uint64_t) SIZE_MAX) {
+      CloseHandle(f);
+      return false;
+    }
+
+    file_ = f;
+    size_ = (std::uint64_t) size.QuadPart;
+    open_ = true;
+
+    // An empty file can't be mapped, & needn't be
+    if (size_ == 0) {
+      return true;
+    }
+
+    mapping_ = CreateFileMapping(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_) {
+      data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    if (!data_) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  void MappedFile::Close() {
+    if (data_) {
+      UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+      CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(file_);
+    }
+
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+  }
+
+#else
+
+  MappedFile::MappedFile()
+    : data_(nullptr), size_(0), open_(false), fd_(-1)
+  {}
+
+  bool MappedFile::Open(const Path& path) {
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (std::uint64_t) st.st_size > (std::uint64_t) SIZE_MAX) {
+      close(fd);
+      return false;
+    }
+
+    fd_ = fd;
+    size_ = (std::uint64_t) st.st_size;
+    open_ = true;
+
+    if (size_ == 0) {
+      return true;
+    }
+
+    void* p = mmap(nullptr, (std::size_t) size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      Close();
+      return false;
+    }
+
+    data_ = static_cast<const char*>(p);
+    return true;
+  }
+
+  void MappedFile::Close() {
+    if (data_) {
+      munmap(const_cast<char*>(data_), (std::size_t) size_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    fd_ = -1;
+  }
+
+#endif
+
+  MappedFile::~MappedFile() {
+    Close();
+  }
+
+} // namespace jwt
\ No newline at end of file
@@ -19,66 +19,457 @@
 
 #include "libraries.hpp"
 #include "message-pump.hpp"
+#include "thread-registry.hpp"
+#include "timer-service.hpp"
+#include "window.hpp"
 #include <memory>
+#include <unordered_set>
 #include <algorithm>
+#include <stdexcept>
+#include <system_error>
+#include <assert.h>
 
 namespace jwt {
 
-  std::unique_ptr<MessagePump> defaultPump_ = nullptr;
+  namespace {
+    // Every live pump, so that other threads can find the pump belonging to
+    // a window's thread (see MessagePump::ForThread).
+    //
+    // Note: a function-local static because windows (and therefore pumps)
+    // are routinely created from static constructors in other translation
+    // units.
+    //
+    ThreadRegistry<MessagePump, DWORD>& Registry() {
+      static ThreadRegistry<MessagePump, DWORD> registry;
+      return registry;
+    }
+
+    void ThreadExiting(MessagePump& pump) {
+      // Queued wrappers hold references too; let them go
+      pump.FlushDestroyQueue();
+
+      // The thread can no longer run the pump, & a later thread may be
+      // given the same id
+      Registry().Remove(&pump);
+    }
+
+    // The calling thread's pump. Windows created on the thread share
+    // ownership of it (see Window::OwningPump): thread-locals are destroyed
+    // before statics, so static windows would otherwise reach a deleted pump
+    // from their destructors. The pump goes with the last of them.
+    thread_local ThreadOwned<MessagePump> threadPump_(&ThreadExiting);
+
+    // For WaitSet::Dispatch: which of h is signalled, without waiting
+    size_t PollHandles(const HANDLE* h, size_t count) {
+      DWORD r = WaitForMultipleObjects((DWORD) count, h, FALSE, 0);
+
+      if (r >= WAIT_OBJECT_0 && r < WAIT_OBJECT_0 + count) {
+        return r - WAIT_OBJECT_0;
+      }
+      if (r >= WAIT_ABANDONED_0 && r < WAIT_ABANDONED_0 + count) {
+        return r - WAIT_ABANDONED_0;
+      }
+
+      // WAIT_TIMEOUT; or WAIT_FAILED, which the next blocking wait reports
+      return count;
+    }
+  }
 
   MessagePump::MessagePump()
-    : dlgOrAccelChanged_(false)
+    : threadId_(GetCurrentThreadId()), dlgOrAccelChanged_(false),
+      userWaits_(0), completionPort_(nullptr), nextCompletionKey_(1),
+      flushingDestroys_(false), posted_(nullptr), postEvent_(nullptr), pendingCount_(0)
   {
+    postEvent_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    assert(postEvent_ != nullptr);
+
+    AddInternalWait(postEvent_, [this]() {
+      RunPosted();
+    });
+
+    Registry().Add(threadId_, this);
+  }
+
+  MessagePump::~MessagePump() {
+    // Wrappers' destructors may still need the timers
+    FlushDestroyQueue();
+
+    // Before the wait list goes: the service unregisters its timer handle
+    timers_.reset();
+
+    if (completionPort_) {
+      CloseHandle(completionPort_);
+    }
+    CloseHandle(postEvent_);
+
+    Registry().Remove(this);
+  }
+
+  MessagePump* MessagePump::ForThread(DWORD threadId) {
+    return Registry().Find(threadId);
   }
 
   int MessagePump::Pump() {
     MSG m;
 
-    while (GetMessage(&m, nullptr, 0, 0)) {
-      bool msgHandled = false;
+    for (;;) {
+      // Drain everything that is already queued before blocking; Wait()
+      // returns as soon as there is input *or* a registered handle fires.
+      while (PeekMessage(&m, nullptr, 0, 0, PM_REMOVE)) {
+        if (m.message == WM_QUIT) {
+          return (int) m.wParam;
+        }
+
+        Dispatch(m);
+      }
+
+      Wait();
+    }
+  }
+
+  void MessagePump::Dispatch(MSG& m) {
+    bool msgHandled = false;
+    bool keyMsg = (m.message >= WM_KEYFIRST && m.message <= WM_KEYLAST);
 
-      size_t l = dialogs_.size();
+    if ((m.message == WM_KEYDOWN || m.message == WM_SYSKEYDOWN) && !shortcuts_.Empty()) {
+      msgHandled = DispatchShortcut(m);
+    }
+
+    size_t l = (msgHandled) ? 0 : dialogs_.size();
+    for (size_t i = 0; i < l; ++i) {
+      HWND d = dialogs_[i];
+      if (d && IsDialogMessage(d, &m)) {
+        msgHandled = true;
+        RaiseReportedException();
+        break;
+      }
+    }
+
+    // TranslateAccelerator only acts on keyboard messages
+    if (!msgHandled && keyMsg) {
+      l = accelerators_.size();
       for (size_t i = 0; i < l; ++i) {
-        HWND d = dialogs_[i];
-        if (d && IsDialogMessage(d, &m)) {
+        HACCEL a = accelerators_[i];
+        if (a && TranslateAccelerator(m.hwnd, a, &m)) {
           msgHandled = true;
-          RaiseReportedException();
           break;
         }
       }
+    }
+
+    if (!msgHandled) {
+      TranslateMessage(&m);
+      DispatchMessage(&m);
+      RaiseReportedException();
+    }
+
+    if (PendingDestroys()) {
+      FlushDestroyQueue();
+      RaiseReportedException();
+    }
+
+    if (dlgOrAccelChanged_) {
+      dialogs_.erase(
+        remove(begin(dialogs_), end(dialogs_), nullptr),
+        end(dialogs_)
+      );
+
+      accelerators_.erase(
+        remove(begin(accelerators_), end(accelerators_), nullptr),
+        end(accelerators_)
+      );
+
+      dlgOrAccelChanged_ = false;
+    }
+  }
+
+  bool MessagePump::DispatchShortcut(const MSG& m) {
+    unsigned int modifiers = ShortcutTable::NONE;
+    if (GetKeyState(VK_SHIFT) < 0)   modifiers |= ShortcutTable::SHIFT;
+    if (GetKeyState(VK_CONTROL) < 0) modifiers |= ShortcutTable::CONTROL;
+    if (GetKeyState(VK_MENU) < 0)    modifiers |= ShortcutTable::ALT;
+
+    // Scopes: the window with the focus & its ancestors, innermost first
+    ShortcutTable::Scope scopes[MAX_SHORTCUT_SCOPES];
+    size_t count = 0;
+
+    HWND root = GetAncestor(m.hwnd, GA_ROOT);
+    for (HWND h = m.hwnd; h && count < MAX_SHORTCUT_SCOPES; h = GetAncestor(h, GA_PARENT)) {
+      scopes[count++] = (ShortcutTable::Scope) h;
+      if (h == root) {
+        break;
+      }
+    }
+
+    const ShortcutTable::Binding* b = shortcuts_.Find((unsigned int) m.wParam, modifiers, scopes, count);
+    if (!b) {
+      return false;
+    }
+
+    HWND target = (HWND) b->target;
+    if (!IsWindow(target) || !IsWindowEnabled(target)) {
+      return false;
+    }
+
+    SendMessage(target, WM_COMMAND, MAKEWPARAM(b->command, 1), 0);
+    RaiseReportedException();
+    return true;
+  }
+
+  void MessagePump::Wait() {
+    // RemoveWait only clears entries, so that it is safe to call from inside
+    // a callback; drop them before handing the array to Windows
+    waits_.Compact();
+
+    // MWMO_INPUTAVAILABLE: return immediately if there is input in the queue
+    // even if an earlier PeekMessage has already seen it.
+    DWORD count = (DWORD) waits_.Size();
+    DWORD r = MsgWaitForMultipleObjectsEx(
+      count, waits_.Handles(),
+      INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE
+    );
+
+    size_t index = count;
+    if (r >= WAIT_OBJECT_0 && r < WAIT_OBJECT_0 + count) {
+      index = r - WAIT_OBJECT_0;
+    }
+    else if (r >= WAIT_ABANDONED_0 && r < WAIT_ABANDONED_0 + count) {
+      index = r - WAIT_ABANDONED_0;
+    }
+    else if (r == WAIT_FAILED) {
+      // Usually a handle closed while still registered. Every later wait
+      // would fail the same way, so carrying on would just spin.
+      throw std::system_error((int) GetLastError(), std::system_category(), "MessagePump: waiting on the registered handles failed");
+    }
+
+    if (index < count) {
+      // Only the lowest signalled index is reported; Dispatch polls the
+      // rest, so that a busy post event can't starve the handles after it
+      waits_.Dispatch(index, PollHandles, [this](std::exception_ptr e) {
+        ReportException(e);
+      });
+
+      FlushDestroyQueue();
+      RaiseReportedException();
+    }
+    else {
+      assert(r == WAIT_OBJECT_0 + count);
+    }
+  }
+
+  void MessagePump::AddWait(HANDLE h, WaitCallback c) {
+    // MsgWaitForMultipleObjectsEx takes at most MAXIMUM_WAIT_OBJECTS - 1
+    // handles, & two of those are kept for the post event & completion port
+    // whether or not the port has been created yet. Thrown rather than
+    // asserted: a release build would hand Windows an over-long array.
+    if (userWaits_ + RESERVED_WAITS + 1 >= MAXIMUM_WAIT_OBJECTS) {
+      throw std::length_error("MessagePump::AddWait: too many handles registered");
+    }
+
+    AddInternalWait(h, c);
+    ++userWaits_;
+  }
+
+  void MessagePump::AddInternalWait(HANDLE h, WaitCallback c) {
+    assert(h != nullptr && h != INVALID_HANDLE_VALUE);
+    waits_.Add(h, c);
+  }
+
+  void MessagePump::RemoveWait(HANDLE h) {
+    assert(h != postEvent_ && h != completionPort_);
+
+    if (waits_.Remove(h)) {
+      --userWaits_;
+    }
+  }
+
+  ULONG_PTR MessagePump::AddCompletionHandler(HANDLE file, CompletionCallback c) {
+    assert(c);
+
+    if (!completionPort_) {
+      completionPort_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+      assert(completionPort_ != nullptr);
+
+      // A completion port is signalled while it has packets queued, so it
+      // can sit in the same wait as everything else.
+      AddInternalWait(completionPort_, [this]() {
+        DrainCompletionPort();
+      });
+    }
+
+    ULONG_PTR key = nextCompletionKey_++;
+
+    HANDLE port = CreateIoCompletionPort(file, completionPort_, key, 0);
+    assert(port == completionPort_);
+
+    completionHandlers_[key] = c;
+    return key;
+  }
+
+  void MessagePump::RemoveCompletionHandler(ULONG_PTR key) {
+    // Packets already queued for this key are dropped when they are drained
+    completionHandlers_.erase(key);
+  }
+
+  void MessagePump::DrainCompletionPort() {
+    OVERLAPPED_ENTRY entries[COMPLETION_BATCH_SIZE];
+    ULONG count = 0;
+
+    if (!GetQueuedCompletionStatusEx(completionPort_, entries, COMPLETION_BATCH_SIZE, &count, 0, FALSE)) {
+      return;
+    }
+
+    // Every packet in the batch must be delivered, even if a handler throws;
+    // otherwise the I/O it represents is silently lost.
+    for (ULONG i = 0; i < count; ++i) {
+      auto h = completionHandlers_.find(entries[i].lpCompletionKey);
+
+      if (h != completionHandlers_.end()) {
+        CompletionCallback c = h->second;
+
+        try {
+          c(entries[i]);
+        }
+        catch (...) {
+          ReportException(std::current_exception());
+        }
+      }
+    }
+  }
+
+  void MessagePump::Post(WorkItem* w) {
+    assert(w && w->run);
+
+    WorkItem* head = posted_.load(std::memory_order_relaxed);
+    do {
+      w->next = head;
+    } while (!posted_.compare_exchange_weak(head, w, std::memory_order_release, std::memory_order_relaxed));
+
+    // Only the post that makes the list non-empty needs to wake the pump;
+    // RunPosted takes the whole list at once.
+    if (!head) {
+      SetEvent(postEvent_);
+    }
+  }
+
+  void MessagePump::RunPosted() {
+    WorkItem* w = posted_.exchange(nullptr, std::memory_order_acquire);
+
+    // The list was pushed LIFO; reverse it so that items run in post order
+    WorkItem* fifo = nullptr;
+    while (w) {
+      WorkItem* next = w->next;
+      w->next = fifo;
+      fifo = w;
+      w = next;
+    }
+
+    while (fifo) {
+      // Read next first: running the item may destroy it
+      w = fifo;
+      fifo = w->next;
+
+      try {
+        w->run(w);
+      }
+      catch (...) {
+        ReportException(std::current_exception());
+      }
+    }
+  }
+
+  void MessagePump::DestroyLater(HWND h) {
+    assert(h != nullptr);
+    destroyQueue_.push_back(h);
+  }
+
+  void MessagePump::DeleteLater(Window* w) {
+    assert(w != nullptr);
+    deleteQueue_.push_back(w);
+  }
+
+  void MessagePump::FlushDestroyQueue() {
+    if (flushingDestroys_) {
+      return;
+    }
+    flushingDestroys_ = true;
+
+    while (PendingDestroys()) {
+      // Wrappers first: their destructors queue more windows
+      while (!deleteQueue_.empty()) {
+        std::vector<Window*> wrappers;
+        wrappers.swap(deleteQueue_);
+
+        for (Window* w : wrappers) {
+          delete w;
+        }
+      }
+
+      std::vector<HWND> windows;
+      windows.swap(destroyQueue_);
+
+      std::unordered_set<HWND> queued(begin(windows), end(windows));
+      HWND desktop = GetDesktopWindow();
+
+      // A window goes with its ancestor, so only the topmost queued windows
+      // need destroying. Suspend drawing of their parents meanwhile.
+      std::vector<HWND> roots;
+      std::vector<HWND> parents;
+
+      for (HWND h : windows) {
+        if (!IsWindow(h)) {
+          continue;
+        }
+
+        HWND parent = GetAncestor(h, GA_PARENT);
+        bool covered = false;
 
-      if (!msgHandled) {
-        l = accelerators_.size();
-        for (size_t i = 0; i < l; ++i) {
-          HACCEL a = accelerators_[i];
-          if (a && TranslateAccelerator(m.hwnd, a, &m)) {
-            msgHandled = true;
+        for (HWND a = parent; a && a != desktop; a = GetAncestor(a, GA_PARENT)) {
+          if (queued.count(a)) {
+            covered = true;
             break;
           }
         }
+
+        if (!covered) {
+          roots.push_back(h);
+
+          // Hidden parents are left alone: WM_SETREDRAW TRUE would show them
+          if (parent && parent != desktop && IsWindowVisible(parent) &&
+              std::find(begin(parents), end(parents), parent) == end(parents)) {
+            SendMessage(parent, WM_SETREDRAW, FALSE, 0);
+            parents.push_back(parent);
+          }
+        }
       }
 
-      if (!msgHandled) {
-        TranslateMessage(&m);
-        DispatchMessage(&m);
-        RaiseReportedException();
+      for (HWND h : roots) {
+        // Queued twice, or already taken by an earlier root's WM_DESTROY
+        if (IsWindow(h)) {
+          DestroyWindow(h);
+        }
       }
 
-      if (dlgOrAccelChanged_) {
-        dialogs_.erase(
-          remove(begin(dialogs_), end(dialogs_), nullptr),
-          end(dialogs_)
-        );
+      for (HWND p : parents) {
+        if (IsWindow(p)) {
+          SendMessage(p, WM_SETREDRAW, TRUE, 0);
+          RedrawWindow(p, nullptr, nullptr, RDW_ERASE | RDW_FRAME | RDW_INVALIDATE | RDW_ALLCHILDREN);
+        }
+      }
+    }
 
-        accelerators_.erase(
-          remove(begin(accelerators_), end(accelerators_), nullptr),
-          end(accelerators_)
-        );
+    flushingDestroys_ = false;
+  }
 
-        dlgOrAccelChanged_ = false;
-      }
+  TimerService& MessagePump::Timers() {
+    if (!timers_) {
+      timers_ = std::unique_ptr<TimerService>(new TimerService(*this));
     }
-    return (int) m.wParam;
+    return *timers_;
+  }
+
+  bool MessagePump::CancelTimer(TimerWheel::TimerId id) {
+    return (timers_) ? timers_->Cancel(id) : false;
   }
 
   void MessagePump::AddDialog(HWND h) {
@@ -110,24 +501,29 @@ namespace jwt {
   }
 
   void MessagePump::ReportException(std::exception_ptr e) {
-    assert(!currentException_);
+    assert(e);
 
-    currentException_ = e;
+    pendingExceptions_.push_back(e);
+    pendingCount_.store((unsigned int) pendingExceptions_.size(), std::memory_order_relaxed);
   }
 
-  void MessagePump::RaiseReportedException() {
-    if (currentException_) {
-      std::exception_ptr e = currentException_;
-      currentException_ = nullptr;
-      std::rethrow_exception(e);
+  void MessagePump::RaisePendingExceptions() {
+    // Swap the queue out before throwing so that the pump is left in a clean
+    // state whatever the caller does with the exception.
+    std::vector<std::exception_ptr> pending;
+    pending.swap(pendingExceptions_);
+    pendingCount_.store(0, std::memory_order_relaxed);
+
+    if (pending.size() == 1) {
+      std::rethrow_exception(pending.front());
+    }
+    else if (pending.size() > 1) {
+      throw AggregateException(std::move(pending));
     }
   }
 
   MessagePump& DefaultPump() {
-    if (!defaultPump_) {
-      defaultPump_ = std::unique_ptr<MessagePump>(new MessagePump);
-    }
-    return *defaultPump_;
+    return threadPump_.Get();
   }
 
 } // namespace jwt
\ No newline at end of file
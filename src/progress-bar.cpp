@@ -31,7 +31,7 @@ namespace jwt {
     hWnd_ = parent.Item(ctrlId);
 
     assert(hWnd_ != nullptr);
-    assert(ClassName(*this) == PROGRESS_CLASS);
+    assert(HasClass(*this, PROGRESS_CLASS));
 
     SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) this);
   }
@@ -39,6 +39,10 @@ namespace jwt {
   ProgressBar::ProgressBar(const defer_create_t&) {
   }
 
+  ProgressBar::~ProgressBar() {
+    Unbind();
+  }
+
   void ProgressBar::Create(Window& parent) {
     hWnd_ = CreateWindow(
       PROGRESS_CLASS, nullptr, WS_VISIBLE | WS_CHILD,
@@ -51,12 +55,56 @@ namespace jwt {
   }
 
   LRESULT ProgressBar::HandleReflectedMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
-    switch (m) {
-    case WM_COMMAND:
-      break;
+    // Nothing is listened for
+    Unreflect<ProgressBar>(ReflectFlag(m));
+    return 0;
+  }
+
+  void ProgressBar::Bind(ProgressChannel& c, DWORD interval) {
+    assert(hWnd_);
+
+    Unbind();
+
+    binding_ = Binding();
+    binding_.channel = &c;
+    binding_.timer = OwningPump().Timers().Every(interval, [this]() {
+      Sample();
+    });
+
+    Sample();
+  }
+
+  void ProgressBar::Unbind() {
+    if (binding_.channel) {
+      OwningPump().CancelTimer(binding_.timer);
+      binding_.channel = nullptr;
+      binding_.timer = TimerService::INVALID_TIMER;
     }
+  }
 
-    return 0;
+  void ProgressBar::Sample() {
+    if (!IsWindowVisible(hWnd_)) {
+      return;
+    }
+
+    // One step per pixel: finer positions can't be seen, so there's no
+    // point sending them.
+    RECT r;
+    GetClientRect(hWnd_, &r);
+    int steps = std::max(1, (int) (r.right - r.left));
+
+    ProgressSampler& s = binding_.sampler;
+    ProgressSampler::Changes changes = s.Sample(*binding_.channel, steps);
+
+    if (changes.marquee) {
+      SetMarquee(*this, s.Marquee());
+    }
+    if (changes.range) {
+      SetRange(*this, 0, s.Steps());
+    }
+    if (changes.value) {
+      SetValue(*this, s.Value());
+    }
   }
 
   //
@@ -66,21 +114,40 @@ namespace jwt {
   ProgressBar& SetMarquee(ProgressBar& b, bool on) {
     assert(b.TheHWND());
 
+    if (b.Setters().Skip(SetterCache::MARQUEE, on)) {
+      return b;
+    }
+
     SendMessage(b.TheHWND(), PBM_SETMARQUEE, on, 0);
+    b.Setters().Store(SetterCache::MARQUEE, on);
     return b;
   }
 
   ProgressBar& SetValue(ProgressBar& b, int v) {
     assert(b.TheHWND());
 
+    if (b.Setters().Skip(SetterCache::VALUE, (std::uint32_t) v)) {
+      return b;
+    }
+
     SendMessage(b.TheHWND(), PBM_SETPOS, v, 0);
+    b.Setters().Store(SetterCache::VALUE, (std::uint32_t) v);
     return b;
   }
 
   ProgressBar& SetRange(ProgressBar& b, int min, int max) {
     assert(b.TheHWND());
-    
+
+    std::uint64_t range = SetterCache::Pack(min, max);
+    if (b.Setters().Skip(SetterCache::RANGE, range)) {
+      return b;
+    }
+
     SendMessage(b.TheHWND(), PBM_SETRANGE32, min, max);
+    b.Setters().Store(SetterCache::RANGE, range);
+
+    // The control clamps its position to the new range
+    b.Setters().Forget(SetterCache::VALUE);
     return b;
   }
 
@@ -0,0 +1,109 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "progress-channel.hpp"
+
+namespace jwt {
+
+  namespace {
+    // Threads are dealt stripes round-robin the first time they write to any
+    // channel; the same index is used for every channel.
+    std::atomic<unsigned int> nextStripe_(0);
+
+    unsigned int ThreadStripe() {
+      thread_local unsigned int stripe = nextStripe_.fetch_add(1, std::memory_order_relaxed);
+      return stripe;
+    }
+  }
+
+  ProgressChannel::ProgressChannel()
+    : total_(0), marquee_(false)
+  {
+    for (auto& s : stripes_) {
+      s.count.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void ProgressChannel::Add(std::uint64_t n) {
+    stripes_[ThreadStripe() % STRIPES].count.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  void ProgressChannel::Reset(std::uint64_t total) {
+    for (auto& s : stripes_) {
+      s.count.store(0, std::memory_order_relaxed);
+    }
+    total_.store(total, std::memory_order_relaxed);
+  }
+
+  std::uint64_t ProgressChannel::Current() const {
+    std::uint64_t sum = 0;
+
+    for (const auto& s : stripes_) {
+      sum += s.count.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  int ProgressChannel::Scaled(int steps) const {
+    std::uint64_t total = Total();
+    if (!total || steps <= 0) {
+      return 0;
+    }
+
+    std::uint64_t current = Current();
+    if (current >= total) {
+      return steps;
+    }
+
+    // Floating point: current * steps can overflow 64 bits for large totals
+    return (int) ((double) current / (double) total * steps);
+  }
+
+  ProgressSampler::Changes ProgressSampler::Sample(const ProgressChannel& c, int steps) {
+    Changes changes = { false, false, false };
+
+    bool marquee = c.Marquee();
+    if (marquee != marquee_) {
+      marquee_ = marquee;
+      changes.marquee = true;
+      ++updates_;
+    }
+
+    if (marquee) {
+      return changes;
+    }
+
+    if (steps != steps_) {
+      steps_ = steps;
+      value_ = -1;
+      changes.range = true;
+      ++updates_;
+    }
+
+    int value = c.Scaled(steps);
+    if (value != value_) {
+      value_ = value;
+      changes.value = true;
+      ++updates_;
+    }
+
+    return changes;
+  }
+
+} // namespace jwt
\ No newline at end of file
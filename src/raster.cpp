@@ -0,0 +1,116 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "raster.hpp"
+#include <algorithm>
+#include <assert.h>
+
+namespace jwt {
+
+  Raster::Raster()
+    : pixels_(nullptr), width_(0), height_(0), stride_(0), written_(0)
+  {}
+
+  Raster::Raster(int width, int height)
+    : pixels_(nullptr), width_(0), height_(0), stride_(0), written_(0)
+  {
+    Resize(width, height);
+  }
+
+  Raster::Raster(std::uint32_t* pixels, int width, int height, int stride)
+    : pixels_(nullptr), width_(0), height_(0), stride_(0), written_(0)
+  {
+    Wrap(pixels, width, height, stride);
+  }
+
+  void Raster::Resize(int width, int height) {
+    assert(width >= 0 && height >= 0);
+
+    owned_.assign((std::size_t) width * height, 0);
+    pixels_ = (owned_.empty()) ? nullptr : owned_.data();
+    width_ = width;
+    height_ = height;
+    stride_ = width;
+  }
+
+  void Raster::Wrap(std::uint32_t* pixels, int width, int height, int stride) {
+    assert(width >= 0 && height >= 0 && stride >= width);
+    assert(pixels || width == 0 || height == 0);
+
+    owned_.clear();
+    owned_.shrink_to_fit();
+
+    pixels_ = pixels;
+    width_ = width;
+    height_ = height;
+    stride_ = stride;
+  }
+
+  void Raster::Clear(const Box& b, std::uint32_t argb) {
+    Box c = b.Intersect(Bounds());
+    if (c.Empty()) {
+      return;
+    }
+
+    for (int y = c.y; y < c.y + c.h; ++y) {
+      std::uint32_t* row = Row(y) + c.x;
+      std::fill(row, row + c.w, argb);
+    }
+    written_ += (std::uint64_t) c.w * c.h;
+  }
+
+  void Raster::Fill(const Box& b, std::uint32_t argb) {
+    std::uint32_t a = argb >> 24;
+
+    if (a == 0) {
+      return;
+    }
+    if (a == 255) {
+      Clear(b, argb);
+      return;
+    }
+
+    Box c = b.Intersect(Bounds());
+    if (c.Empty()) {
+      return;
+    }
+
+    // Source over, per channel: d + (s - d) * a / 255, with the result
+    // alpha likewise
+    std::uint32_t sr = (argb >> 16) & 0xFF, sg = (argb >> 8) & 0xFF, sb = argb & 0xFF;
+
+    for (int y = c.y; y < c.y + c.h; ++y) {
+      std::uint32_t* p = Row(y) + c.x;
+
+      for (int x = 0; x < c.w; ++x) {
+        std::uint32_t d = p[x];
+        std::uint32_t da = d >> 24, dr = (d >> 16) & 0xFF, dg = (d >> 8) & 0xFF, db = d & 0xFF;
+
+        dr += (int) ((int) sr - (int) dr) * (int) a / 255;
+        dg += (int) ((int) sg - (int) dg) * (int) a / 255;
+        db += (int) ((int) sb - (int) db) * (int) a / 255;
+        da += (255 - da) * a / 255;
+
+        p[x] = (da << 24) | (dr << 16) | (dg << 8) | db;
+      }
+    }
+    written_ += (std::uint64_t) c.w * c.h;
+  }
+
+} // namespace jwt
\ No newline at end of file
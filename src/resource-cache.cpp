@@ -0,0 +1,139 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "resource-cache.hpp"
+#include <assert.h>
+
+namespace jwt {
+
+  ResourceCache::ResourceCache(Loader& loader, std::size_t budget)
+    : loader_(loader), budget_(budget), bytes_(0), hits_(0), misses_(0), evictions_(0)
+  {
+  }
+
+  ResourceCache::~ResourceCache() {
+    for (auto& e : entries_) {
+      loader_.Free(e.first, e.second.handle);
+    }
+  }
+
+  ResourceCache::Handle ResourceCache::Acquire(const ResourceKey& key) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    auto i = entries_.find(key);
+    if (i != entries_.end()) {
+      Entry& e = i->second;
+      if (e.refs++ == 0) {
+        lru_.erase(e.lru);
+      }
+      ++hits_;
+      return e.handle;
+    }
+
+    ++misses_;
+
+    std::size_t bytes = 0;
+    Handle h = loader_.Load(key, bytes);
+    if (!h) {
+      return 0;
+    }
+
+    Entry e = { h, bytes, 1, lru_.end() };
+    i = entries_.insert(std::make_pair(key, e)).first;
+    handles_[h] = &*i;
+    bytes_ += bytes;
+
+    // The new resource is referenced, so only older ones can go
+    Evict(budget_);
+    return h;
+  }
+
+  void ResourceCache::AddRef(Handle h) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    auto i = handles_.find(h);
+    assert(i != handles_.end());
+
+    Entry& e = i->second->second;
+    if (e.refs++ == 0) {
+      lru_.erase(e.lru);
+    }
+  }
+
+  void ResourceCache::Release(Handle h) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    auto i = handles_.find(h);
+    assert(i != handles_.end());
+
+    Entry& e = i->second->second;
+    assert(e.refs > 0);
+
+    if (--e.refs == 0) {
+      e.lru = lru_.insert(lru_.end(), h);
+      Evict(budget_);
+    }
+  }
+
+  void ResourceCache::SetBudget(std::size_t budget) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    budget_ = budget;
+    Evict(budget_);
+  }
+
+  std::size_t ResourceCache::Budget() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return budget_;
+  }
+
+  void ResourceCache::Purge() {
+    std::lock_guard<std::mutex> lock(lock_);
+    Evict(0);
+  }
+
+  ResourceCache::Stats ResourceCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    Stats s = { hits_, misses_, evictions_, entries_.size(), bytes_ };
+    return s;
+  }
+
+  void ResourceCache::Evict(std::size_t budget) {
+    while (bytes_ > budget && !lru_.empty()) {
+      Handle h = lru_.front();
+      lru_.pop_front();
+
+      auto j = handles_.find(h);
+      Entries::value_type* i = j->second;
+      handles_.erase(j);
+
+      loader_.Free(i->first, h);
+
+      bytes_ -= i->second.bytes;
+
+      // Copied: erasing by a reference to the element's own key is asking
+      // for trouble
+      ResourceKey key = i->first;
+      entries_.erase(key);
+      ++evictions_;
+    }
+  }
+
+} // namespace jwt
\ No newline at end of file
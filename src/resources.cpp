@@ -0,0 +1,163 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "resources.hpp"
+#include <assert.h>
+
+namespace jwt {
+
+  namespace {
+    const std::size_t DEFAULT_BUDGET = 8 * 1024 * 1024;
+
+    // Used when an icon or cursor is loaded at the system default size
+    const int DEFAULT_IMAGE_SIZE = 32;
+
+    std::size_t ImageBytes(int cx, int cy) {
+      if (cx <= 0) cx = DEFAULT_IMAGE_SIZE;
+      if (cy <= 0) cy = DEFAULT_IMAGE_SIZE;
+
+      // 32bpp colour plus a 1bpp mask
+      return (std::size_t) cx * cy * 4 + (std::size_t) cx * cy / 8;
+    }
+
+    struct WindowsLoader
+      : ResourceCache::Loader
+    {
+      ResourceCache::Handle Load(const ResourceKey& k, std::size_t& bytes) {
+        HINSTANCE module = (HINSTANCE) k.module;
+        LPCWSTR name = MAKEINTRESOURCE(k.id);
+
+        switch (k.kind) {
+        case RESOURCE_ICON:
+        case RESOURCE_CURSOR: {
+          UINT type = (k.kind == RESOURCE_ICON) ? IMAGE_ICON : IMAGE_CURSOR;
+          UINT flags = (k.cx || k.cy) ? 0 : LR_DEFAULTSIZE;
+
+          bytes = ImageBytes(k.cx, k.cy);
+          return (ResourceCache::Handle) LoadImage(module, name, type, k.cx, k.cy, flags);
+        }
+
+        case RESOURCE_BITMAP: {
+          HANDLE h = LoadImage(module, name, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION);
+
+          BITMAP bm;
+          if (h && GetObject(h, sizeof(bm), &bm)) {
+            bytes = (std::size_t) bm.bmWidthBytes * bm.bmHeight;
+          }
+          return (ResourceCache::Handle) h;
+        }
+
+        case RESOURCE_MENU: {
+          // The template lives in the module's image: there is nothing to
+          // free, so it costs nothing against the budget
+          HRSRC r = FindResource(module, name, RT_MENU);
+          HGLOBAL g = (r) ? LoadResource(module, r) : nullptr;
+
+          bytes = 0;
+          return (ResourceCache::Handle) ((g) ? LockResource(g) : nullptr);
+        }
+
+        case RESOURCE_STRING: {
+          // With a zero buffer size LoadString returns a read-only pointer
+          // to the (unterminated) string in the resource
+          const wchar_t* p = nullptr;
+          int length = LoadString(module, k.id, (LPWSTR) &p, 0);
+
+          if (length <= 0 || !p) {
+            return 0;
+          }
+
+          bytes = sizeof(std::wstring) + length * sizeof(wchar_t);
+          return (ResourceCache::Handle) new std::wstring(p, length);
+        }
+        }
+
+        assert(false);
+        return 0;
+      }
+
+      void Free(const ResourceKey& k, ResourceCache::Handle h) {
+        switch (k.kind) {
+        case RESOURCE_ICON:
+          DestroyIcon((HICON) h);
+          break;
+
+        case RESOURCE_CURSOR:
+          DestroyCursor((HCURSOR) h);
+          break;
+
+        case RESOURCE_BITMAP:
+          DeleteObject((HGDIOBJ) h);
+          break;
+
+        case RESOURCE_MENU:
+          break;
+
+        case RESOURCE_STRING:
+          delete (std::wstring*) h;
+          break;
+        }
+      }
+    };
+
+    ResourceRef Acquire(HINSTANCE module, ResourceKind kind, UINT id, int cx, int cy) {
+      if (!module) {
+        module = GetModuleHandle(nullptr);
+      }
+
+      ResourceKey k = { (std::uintptr_t) module, (unsigned int) kind, id, cx, cy };
+
+      ResourceCache& c = Resources();
+      return ResourceRef(c, c.Acquire(k));
+    }
+  }
+
+  ResourceCache& Resources() {
+    // Deliberately never destroyed: windows held in statics may still
+    // release references during static destruction, & Windows frees the
+    // handles when the process exits anyway.
+    static WindowsLoader* loader = new WindowsLoader;
+    static ResourceCache* cache = new ResourceCache(*loader, DEFAULT_BUDGET);
+    return *cache;
+  }
+
+  ResourceRef LoadIconResource(UINT id, int cx, int cy, HINSTANCE module) {
+    return Acquire(module, RESOURCE_ICON, id, cx, cy);
+  }
+
+  ResourceRef LoadCursorResource(UINT id, HINSTANCE module) {
+    return Acquire(module, RESOURCE_CURSOR, id, 0, 0);
+  }
+
+  ResourceRef LoadBitmapResource(UINT id, HINSTANCE module) {
+    return Acquire(module, RESOURCE_BITMAP, id, 0, 0);
+  }
+
+  HMENU LoadMenuResource(UINT id, HINSTANCE module) {
+    ResourceRef t = Acquire(module, RESOURCE_MENU, id, 0, 0);
+    return (t) ? LoadMenuIndirect(t.As<const void*>()) : nullptr;
+  }
+
+  std::wstring LoadStringResource(UINT id, HINSTANCE module) {
+    ResourceRef s = Acquire(module, RESOURCE_STRING, id, 0, 0);
+    return (s) ? *s.As<const std::wstring*>() : std::wstring();
+  }
+
+} // namespace jwt
\ No newline at end of file
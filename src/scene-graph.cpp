@@ -0,0 +1,585 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "scene-graph.hpp"
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+namespace jwt {
+
+  const SceneGraph::Id SceneGraph::ROOT;
+  const SceneGraph::Id SceneGraph::INVALID_ID;
+  const SceneGraph::Slot SceneGraph::NONE;
+
+  namespace {
+    // Big enough for any window, small enough that sums of two don't
+    // overflow
+    const int FAR_EDGE = 1 << 29;
+  }
+
+  SceneGraph::SceneGraph()
+    : count_(0), orderDirty_(false), query_(0), background_(0xFFFFFFFFu), drawn_(0)
+  {
+    Node root = {};
+    root.sx = root.sy = 1.0;
+    root.wsx = root.wsy = 1.0;
+    root.flags = ALIVE | VISIBLE;
+    root.parent = root.first = root.last = root.prev = root.next = NONE;
+    root.clip.x = root.clip.y = -FAR_EDGE;
+    root.clip.w = root.clip.h = 2 * FAR_EDGE;
+
+    nodes_.push_back(root);
+    stamp_.push_back(0);
+  }
+
+  SceneGraph::Id SceneGraph::Add(Id parent, const Box& b, std::uint32_t argb) {
+    Slot p = SlotOf(parent);
+    Slot s;
+
+    if (!free_.empty()) {
+      s = free_.back();
+      free_.pop_back();
+    }
+    else {
+      s = (Slot) nodes_.size();
+      nodes_.push_back(Node());
+      stamp_.push_back(0);
+    }
+
+    Node& n = nodes_[s];
+    std::uint32_t generation = n.generation;
+
+    n = Node();
+    n.generation = generation;
+    n.box = b;
+    n.sx = n.sy = 1.0;
+    n.color = argb;
+    n.flags = ALIVE | VISIBLE;
+    n.first = n.last = NONE;
+
+    Link(s, p);
+    ++count_;
+
+    // Nothing to record yet: Update adds the new area
+    n.flags |= CHANGED;
+    changed_.push_back(s);
+    orderDirty_ = true;
+
+    return IdOf(s);
+  }
+
+  void SceneGraph::Remove(Id id) {
+    if (!Valid(id)) {
+      return;
+    }
+
+    Slot top = SlotOf(id);
+    assert(top != 0 && "ROOT can't be removed");
+
+    Unlink(top);
+
+    std::vector<Slot> stack(1, top);
+    while (!stack.empty()) {
+      Slot s = stack.back();
+      stack.pop_back();
+
+      Node& n = nodes_[s];
+      for (Slot c = n.first; c != NONE; c = nodes_[c].next) {
+        stack.push_back(c);
+      }
+
+      MarkDirty(n.visible);
+      Index(s, false);
+      painters_.erase(s);
+
+      n.flags = 0;
+      n.visible = Box();
+      ++n.generation;
+      free_.push_back(s);
+      --count_;
+    }
+
+    orderDirty_ = true;
+  }
+
+  void SceneGraph::Clear() {
+    while (nodes_[0].first != NONE) {
+      Remove(IdOf(nodes_[0].first));
+    }
+  }
+
+  bool SceneGraph::Valid(Id id) const {
+    Slot s = (Slot) (id & 0xFFFFFFFFu);
+
+    return id != INVALID_ID && s < nodes_.size() &&
+      nodes_[s].generation == (std::uint32_t) (id >> 32) && (nodes_[s].flags & ALIVE);
+  }
+
+  SceneGraph::Slot SceneGraph::SlotOf(Id id) const {
+    assert(Valid(id));
+    return (Slot) (id & 0xFFFFFFFFu);
+  }
+
+  SceneGraph::Id SceneGraph::Parent(Id id) const {
+    Slot p = nodes_[SlotOf(id)].parent;
+    return (p == NONE) ? INVALID_ID : IdOf(p);
+  }
+
+  const Box& SceneGraph::Bounds(Id id) const {
+    return nodes_[SlotOf(id)].box;
+  }
+
+  void SceneGraph::SetBounds(Id id, const Box& b) {
+    Slot s = SlotOf(id);
+    assert(s != 0);
+
+    if (nodes_[s].box == b) {
+      return;
+    }
+
+    Change(s);
+    nodes_[s].box = b;
+  }
+
+  void SceneGraph::SetTransform(Id id, int tx, int ty, double sx, double sy) {
+    Slot s = SlotOf(id);
+    assert(s != 0);
+    assert(sx > 0 && sy > 0);
+
+    Node& n = nodes_[s];
+    if (n.tx == tx && n.ty == ty && n.sx == sx && n.sy == sy) {
+      return;
+    }
+
+    Change(s);
+    n.tx = tx;
+    n.ty = ty;
+    n.sx = sx;
+    n.sy = sy;
+  }
+
+  std::uint32_t SceneGraph::Color(Id id) const {
+    return nodes_[SlotOf(id)].color;
+  }
+
+  void SceneGraph::SetColor(Id id, std::uint32_t argb) {
+    Slot s = SlotOf(id);
+    assert(s != 0);
+
+    if (nodes_[s].color != argb) {
+      nodes_[s].color = argb;
+      MarkDirty(nodes_[s].visible);
+    }
+  }
+
+  unsigned int SceneGraph::Flags(Id id) const {
+    return nodes_[SlotOf(id)].flags & (VISIBLE | CLIP);
+  }
+
+  void SceneGraph::SetFlags(Id id, unsigned int flags, bool on) {
+    Slot s = SlotOf(id);
+    assert(s != 0);
+    assert((flags & ~(VISIBLE | CLIP)) == 0);
+
+    std::uint32_t f = (on) ? (nodes_[s].flags | flags) : (nodes_[s].flags & ~flags);
+    if (f == nodes_[s].flags) {
+      return;
+    }
+
+    Change(s);
+    nodes_[s].flags = f;
+  }
+
+  void SceneGraph::SetPainter(Id id, Painter p) {
+    Slot s = SlotOf(id);
+    assert(s != 0);
+
+    if (p) {
+      painters_[s] = std::move(p);
+    }
+    else {
+      painters_.erase(s);
+    }
+    MarkDirty(nodes_[s].visible);
+  }
+
+  void SceneGraph::Invalidate(Id id) {
+    MarkDirty(nodes_[SlotOf(id)].visible);
+  }
+
+  void SceneGraph::Raise(Id id) {
+    Slot s = SlotOf(id);
+    assert(s != 0);
+
+    Slot p = nodes_[s].parent;
+    if (nodes_[p].last == s) {
+      return;
+    }
+
+    Unlink(s);
+    Link(s, p);
+
+    // Only where it overlaps its siblings changes, but they aren't cheap
+    // to find; the subtree's area is a safe bound
+    std::vector<Slot> stack(1, s);
+    while (!stack.empty()) {
+      Slot c = stack.back();
+      stack.pop_back();
+
+      MarkDirty(nodes_[c].visible);
+      for (Slot d = nodes_[c].first; d != NONE; d = nodes_[d].next) {
+        stack.push_back(d);
+      }
+    }
+
+    orderDirty_ = true;
+  }
+
+  const Box& SceneGraph::Visible(Id id) const {
+    return nodes_[SlotOf(id)].visible;
+  }
+
+  void SceneGraph::SetBackground(std::uint32_t argb) {
+    if (background_ != argb) {
+      background_ = argb;
+      MarkDirty(nodes_[0].clip);
+    }
+  }
+
+  void SceneGraph::Link(Slot s, Slot p) {
+    Node& n = nodes_[s];
+    Node& parent = nodes_[p];
+
+    n.parent = p;
+    n.prev = parent.last;
+    n.next = NONE;
+
+    if (parent.last != NONE) {
+      nodes_[parent.last].next = s;
+    }
+    else {
+      parent.first = s;
+    }
+    parent.last = s;
+  }
+
+  void SceneGraph::Unlink(Slot s) {
+    Node& n = nodes_[s];
+    Node& parent = nodes_[n.parent];
+
+    if (n.prev != NONE) {
+      nodes_[n.prev].next = n.next;
+    }
+    else {
+      parent.first = n.next;
+    }
+
+    if (n.next != NONE) {
+      nodes_[n.next].prev = n.prev;
+    }
+    else {
+      parent.last = n.prev;
+    }
+
+    n.prev = n.next = NONE;
+  }
+
+  void SceneGraph::Change(Slot s) {
+    // Already queued: its old area (& its subtree's) is recorded & the
+    // caches won't move until Update
+    if (nodes_[s].flags & CHANGED) {
+      return;
+    }
+
+    std::vector<Slot> stack(1, s);
+    while (!stack.empty()) {
+      Slot c = stack.back();
+      stack.pop_back();
+
+      MarkDirty(nodes_[c].visible);
+      for (Slot d = nodes_[c].first; d != NONE; d = nodes_[d].next) {
+        stack.push_back(d);
+      }
+    }
+
+    nodes_[s].flags |= CHANGED;
+    changed_.push_back(s);
+  }
+
+  void SceneGraph::MarkDirty(const Box& b) {
+    if (!b.Empty()) {
+      dirty_.push_back(b);
+    }
+  }
+
+  void SceneGraph::Update() {
+    // A node can be queued after one of its ancestors; recomputing it again
+    // is harmless, & cheaper than sorting the queue
+    for (std::size_t i = 0; i < changed_.size(); ++i) {
+      Slot s = changed_[i];
+
+      if (nodes_[s].flags & ALIVE) {
+        nodes_[s].flags &= ~CHANGED;
+        Recompute(s);
+      }
+    }
+    changed_.clear();
+
+    if (orderDirty_) {
+      Renumber();
+    }
+  }
+
+  void SceneGraph::Recompute(Slot top) {
+    std::vector<Slot> stack(1, top);
+
+    while (!stack.empty()) {
+      Slot s = stack.back();
+      stack.pop_back();
+
+      Node& n = nodes_[s];
+      const Node& p = nodes_[n.parent];
+
+      n.wsx = p.wsx * n.sx;
+      n.wsy = p.wsy * n.sy;
+      n.wtx = p.wtx + p.wsx * n.tx;
+      n.wty = p.wty + p.wsy * n.ty;
+
+      int l = (int) std::floor(n.wsx * n.box.x + n.wtx);
+      int t = (int) std::floor(n.wsy * n.box.y + n.wty);
+      int r = (int) std::ceil(n.wsx * (n.box.x + n.box.w) + n.wtx);
+      int b = (int) std::ceil(n.wsy * (n.box.y + n.box.h) + n.wty);
+
+      Box world = { l, t, r - l, b - t };
+      Box visible = Box();
+      Box clip = Box();
+
+      // A hidden parent leaves its children an empty clip
+      if ((n.flags & VISIBLE) && !p.clip.Empty() && !n.box.Empty()) {
+        visible = world.Intersect(p.clip);
+      }
+      if ((n.flags & VISIBLE) && !p.clip.Empty()) {
+        clip = (n.flags & CLIP) ? world.Intersect(p.clip) : p.clip;
+      }
+
+      n.world = world;
+      n.clip = clip;
+
+      if (n.visible != visible) {
+        Index(s, false);
+        n.visible = visible;
+        Index(s, true);
+      }
+      MarkDirty(visible);
+
+      for (Slot c = n.first; c != NONE; c = nodes_[c].next) {
+        stack.push_back(c);
+      }
+    }
+  }
+
+  void SceneGraph::Renumber() {
+    std::uint32_t order = 0;
+    Slot s = nodes_[0].first;
+
+    // Pre-order walk without a stack: down to the first child, else along
+    // to the next sibling, else back up until one has a next sibling
+    while (s != NONE) {
+      nodes_[s].order = order++;
+
+      if (nodes_[s].first != NONE) {
+        s = nodes_[s].first;
+        continue;
+      }
+      while (s != 0 && nodes_[s].next == NONE) {
+        s = nodes_[s].parent;
+      }
+      s = (s == 0) ? NONE : nodes_[s].next;
+    }
+
+    orderDirty_ = false;
+  }
+
+  void SceneGraph::Query(const Box& area, std::vector<Id>& out) {
+    Gather(area, scratch_);
+
+    out.clear();
+    for (Slot s : scratch_) {
+      out.push_back(IdOf(s));
+    }
+  }
+
+  void SceneGraph::Gather(const Box& area, std::vector<Slot>& out) {
+    Update();
+    out.clear();
+
+    if (area.Empty()) {
+      return;
+    }
+
+    if (++query_ == 0) {
+      std::fill(stamp_.begin(), stamp_.end(), 0);
+      query_ = 1;
+    }
+
+    auto visit = [&](const std::vector<Slot>& cell) {
+      for (Slot s : cell) {
+        if (stamp_[s] != query_) {
+          stamp_[s] = query_;
+
+          if (nodes_[s].visible.Intersects(area)) {
+            out.push_back(s);
+          }
+        }
+      }
+    };
+
+    int cx0 = CellOf(area.x), cx1 = CellOf(area.x + area.w - 1);
+    int cy0 = CellOf(area.y), cy1 = CellOf(area.y + area.h - 1);
+
+    if ((std::uint64_t) (cx1 - cx0 + 1) * (std::uint64_t) (cy1 - cy0 + 1) > cells_.size()) {
+      for (const auto& c : cells_) {
+        visit(c.second);
+      }
+    }
+    else {
+      for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+          auto c = cells_.find(Key(cx, cy));
+          if (c != cells_.end()) {
+            visit(c->second);
+          }
+        }
+      }
+    }
+
+    std::sort(out.begin(), out.end(), [this](Slot a, Slot b) {
+      return nodes_[a].order < nodes_[b].order;
+    });
+  }
+
+  void SceneGraph::TakeDirty(std::vector<Box>& out) {
+    Update();
+
+    // Merge until no two overlap; a box grown by a merge may now reach
+    // boxes it missed, so start again after each. Once there are more than
+    // MAX_DIRTY_BOXES the union is the answer, & merging the rest (which is
+    // quadratic) would be wasted
+    std::vector<Box> merged;
+    Box all = Box();
+
+    for (Box b : dirty_) {
+      all = all.Union(b);
+      if (merged.size() > MAX_DIRTY_BOXES) {
+        continue;
+      }
+
+      for (std::size_t i = 0; i < merged.size(); ) {
+        if (merged[i].Intersects(b)) {
+          b = b.Union(merged[i]);
+          merged[i] = merged.back();
+          merged.pop_back();
+          i = 0;
+        }
+        else {
+          ++i;
+        }
+      }
+      merged.push_back(b);
+    }
+    dirty_.clear();
+
+    if (merged.size() > MAX_DIRTY_BOXES) {
+      out.push_back(all);
+      return;
+    }
+
+    out.insert(out.end(), merged.begin(), merged.end());
+  }
+
+  void SceneGraph::Render(Raster& r, const Box& area) {
+    Box a = area.Intersect(r.Bounds());
+    if (a.Empty()) {
+      return;
+    }
+
+    r.Clear(a, background_);
+    Gather(a, scratch_);
+
+    for (Slot s : scratch_) {
+      const Node& n = nodes_[s];
+      Box clip = n.visible.Intersect(a);
+
+      auto p = painters_.find(s);
+      if (p != painters_.end()) {
+        p->second(r, n.world, clip);
+      }
+      else {
+        r.Fill(clip, n.color);
+      }
+    }
+
+    drawn_ += scratch_.size();
+  }
+
+  int SceneGraph::CellOf(int v) {
+    return (v >= 0) ? v / CELL_SIZE : -((-v - 1) / CELL_SIZE) - 1;
+  }
+
+  SceneGraph::CellKey SceneGraph::Key(int cx, int cy) {
+    return ((CellKey) (std::uint32_t) cx << 32) | (std::uint32_t) cy;
+  }
+
+  void SceneGraph::Index(Slot s, bool insert) {
+    const Box& b = nodes_[s].visible;
+    if (b.Empty()) {
+      return;
+    }
+
+    int cx0 = CellOf(b.x), cx1 = CellOf(b.x + b.w - 1);
+    int cy0 = CellOf(b.y), cy1 = CellOf(b.y + b.h - 1);
+
+    for (int cy = cy0; cy <= cy1; ++cy) {
+      for (int cx = cx0; cx <= cx1; ++cx) {
+        CellKey k = Key(cx, cy);
+
+        if (insert) {
+          cells_[k].push_back(s);
+          continue;
+        }
+
+        auto c = cells_.find(k);
+        assert(c != cells_.end());
+
+        std::vector<Slot>& v = c->second;
+        auto i = std::find(v.begin(), v.end(), s);
+        assert(i != v.end());
+
+        *i = v.back();
+        v.pop_back();
+
+        if (v.empty()) {
+          cells_.erase(c);
+        }
+      }
+    }
+  }
+
+} // namespace jwt
\ No newline at end of file
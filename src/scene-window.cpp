@@ -0,0 +1,167 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "scene-window.hpp"
+#include <assert.h>
+#include <cstdint>
+
+namespace jwt {
+
+  const wchar_t* SceneWindow::CLASS_NAME = L"SceneWindow::CLASS_NAME";
+
+  void SceneWindow::Register() {
+    CustomWindow<SceneWindow>::Register(CLASS_NAME);
+  }
+
+  SceneWindow::SceneWindow(Window& parent)
+    : memDC_(nullptr), dib_(nullptr), oldBitmap_(nullptr)
+  {
+    Create(parent);
+  }
+
+  SceneWindow::SceneWindow(const defer_create_t&)
+    : memDC_(nullptr), dib_(nullptr), oldBitmap_(nullptr)
+  {
+  }
+
+  SceneWindow::~SceneWindow() {
+    FreeBuffer();
+
+    if (memDC_) {
+      DeleteDC(memDC_);
+    }
+  }
+
+  void SceneWindow::Create(Window& parent) {
+    Register();
+    CreateWindow(CLASS_NAME, L"",
+      WS_VISIBLE | WS_CHILD,
+      0, 0, 0, 0,
+      parent.TheHWND(), nullptr, GetModuleHandle(nullptr), (LPVOID) this
+    );
+    OwningPump().RaiseReportedException();
+
+    assert(hWnd_);
+  }
+
+  void SceneWindow::Update() {
+    if (!scene_.Dirty()) {
+      return;
+    }
+
+    dirty_.clear();
+    scene_.TakeDirty(dirty_);
+
+    for (const auto& d : dirty_) {
+      // Dirty areas may lie partly (or wholly) outside the window
+      Box b = d.Intersect(back_.Bounds());
+      if (b.Empty()) {
+        continue;
+      }
+
+      scene_.Render(back_, b);
+
+      RECT r = { b.x, b.y, b.x + b.w, b.y + b.h };
+      InvalidateRect(hWnd_, &r, FALSE);
+    }
+  }
+
+  LRESULT SceneWindow::WndProc(HWND h, UINT m, WPARAM w, LPARAM l) {
+    switch (m) {
+    case WM_SIZE:
+      Resize(LOWORD(l), HIWORD(l));
+      return 0;
+
+    case WM_PAINT:
+      Paint();
+      return 0;
+
+    case WM_ERASEBKGND:
+      // Everything is copied from the back buffer
+      return 1;
+    }
+
+    return CustomWindow<SceneWindow>::WndProc(h, m, w, l);
+  }
+
+  void SceneWindow::Resize(int w, int h) {
+    if (w == back_.Width() && h == back_.Height()) {
+      return;
+    }
+
+    FreeBuffer();
+
+    if (w > 0 && h > 0) {
+      if (!memDC_) {
+        HDC screen = GetDC(hWnd_);
+        memDC_ = CreateCompatibleDC(screen);
+        ReleaseDC(hWnd_, screen);
+      }
+
+      // Top-down (negative height), so rows are in Raster's order
+      BITMAPINFO bi = {};
+      bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+      bi.bmiHeader.biWidth = w;
+      bi.bmiHeader.biHeight = -h;
+      bi.bmiHeader.biPlanes = 1;
+      bi.bmiHeader.biBitCount = 32;
+      bi.bmiHeader.biCompression = BI_RGB;
+
+      void* bits = nullptr;
+      dib_ = CreateDIBSection(memDC_, &bi, DIB_RGB_COLORS, &bits, nullptr, 0);
+
+      if (dib_) {
+        oldBitmap_ = SelectObject(memDC_, dib_);
+        back_.Wrap(static_cast<std::uint32_t*>(bits), w, h, w);
+      }
+    }
+
+    // Everything has to be rendered again; what was dirty is included
+    dirty_.clear();
+    scene_.TakeDirty(dirty_);
+    scene_.Render(back_, back_.Bounds());
+
+    InvalidateRect(hWnd_, nullptr, FALSE);
+  }
+
+  void SceneWindow::FreeBuffer() {
+    back_.Wrap(nullptr, 0, 0, 0);
+
+    if (dib_) {
+      SelectObject(memDC_, oldBitmap_);
+      DeleteObject(dib_);
+      dib_ = nullptr;
+      oldBitmap_ = nullptr;
+    }
+  }
+
+  void SceneWindow::Paint() {
+    PAINTSTRUCT ps;
+    HDC dc = BeginPaint(hWnd_, &ps);
+
+    if (dib_) {
+      const RECT& r = ps.rcPaint;
+      BitBlt(dc, r.left, r.top, r.right - r.left, r.bottom - r.top, memDC_, r.left, r.top, SRCCOPY);
+    }
+
+    EndPaint(hWnd_, &ps);
+  }
+
+} // namespace jwt
\ No newline at end of file
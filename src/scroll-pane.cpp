@@ -48,24 +48,43 @@ namespace jwt {
       0, 0, 0, 0,
       parent.TheHWND(), nullptr, GetModuleHandle(nullptr), (LPVOID) this
     );
-    DefaultPump().RaiseReportedException();
+    OwningPump().RaiseReportedException();
 
     assert(hWnd_);
   }
 
   LRESULT ScrollPane::WndProc(HWND h, UINT m, WPARAM w, LPARAM l) {
     switch (m) {
-    case WM_SIZE:
-      ConfigScrollbars();
+    case WM_PAINT:
+      if (tiles_) {
+        PaintTiles();
+        return 0;
+      }
       break;
 
-    case WM_HSCROLL:
-      HandleHScroll(LOWORD(w));
+    case WM_ERASEBKGND:
+      if (tiles_) {
+        // PaintTiles covers the whole update region
+        return 1;
+      }
       break;
 
-    case WM_VSCROLL:
-      HandleVScroll(LOWORD(w));
+    case WM_SIZE:
+      ConfigScrollbars();
       break;
+
+    case WM_HSCROLL:
+    case WM_VSCROLL: {
+      ScrollMsg scroll(m, w, l);
+
+      if (scroll.vertical) {
+        HandleVScroll(scroll.action);
+      }
+      else {
+        HandleHScroll(scroll.action);
+      }
+    }
+    break;
     }
 
     return CustomWindow<ScrollPane>::WndProc(h, m, w, l);
@@ -100,6 +119,9 @@ namespace jwt {
 
   ScrollPane& ScrollPane::Extent(const Dimension& extent) {
     extent_ = extent;
+    if (tiles_) {
+      tiles_->SetExtent(extent.w, extent.h);
+    }
     ConfigScrollbars();
     return *this;
   }
@@ -125,6 +147,29 @@ namespace jwt {
     return *this;
   }
 
+  ScrollPane& ScrollPane::UseTileCache(TileCache::Renderer renderer, std::size_t budgetBytes, int tileSize) {
+    tiles_.reset(new TileCache(std::move(renderer), budgetBytes, tileSize));
+    tiles_->SetExtent(extent_.w, extent_.h);
+
+    InvalidateRect(hWnd_, nullptr, TRUE);
+    return *this;
+  }
+
+  ScrollPane& ScrollPane::InvalidateContent(const Box& area) {
+    if (!tiles_) {
+      return *this;
+    }
+
+    tiles_->Invalidate(area);
+
+    RECT r = {
+      area.x - position_.x, area.y - position_.y,
+      area.x + area.w - position_.x, area.y + area.h - position_.y
+    };
+    InvalidateRect(hWnd_, &r, FALSE);
+    return *this;
+  }
+
   void ScrollPane::ConfigScrollbars() {
     if (AlwaysOn()) {
       ConfigAlwaysOnScrollbars();
@@ -324,6 +369,49 @@ namespace jwt {
     }
   }
 
+  void ScrollPane::PaintTiles() {
+    PAINTSTRUCT ps;
+    HDC dc = BeginPaint(hWnd_, &ps);
+    const RECT& r = ps.rcPaint;
+
+    Box view = {
+      r.left + position_.x, r.top + position_.y, r.right - r.left, r.bottom - r.top
+    };
+
+    // Each tile is handed to GDI as a DIB of just the rows needed, so that
+    // the source always starts at row 0 of a top-down bitmap
+    BITMAPINFO bi = {};
+    bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bi.bmiHeader.biWidth = tiles_->TileSize();
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+
+    tiles_->Visit(view, [&](const Raster& tile, const Box& src, int x, int y) {
+      bi.bmiHeader.biHeight = -src.h;
+
+      SetDIBitsToDevice(dc,
+        r.left + x, r.top + y, src.w, src.h,
+        src.x, 0, 0, src.h,
+        tile.Row(src.y), &bi, DIB_RGB_COLORS
+      );
+    });
+
+    // Whatever lies beyond the extent
+    HBRUSH bg = GetSysColorBrush(COLOR_WINDOW);
+    RECT right = { extent_.w - position_.x, r.top, r.right, r.bottom };
+    RECT below = { r.left, extent_.h - position_.y, r.right, r.bottom };
+
+    if (right.left < right.right) {
+      FillRect(dc, &right, bg);
+    }
+    if (below.top < below.bottom) {
+      FillRect(dc, &below, bg);
+    }
+
+    EndPaint(hWnd_, &ps);
+  }
+
   //
   // Non-member ScrollPane functions
   //
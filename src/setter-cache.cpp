@@ -0,0 +1,106 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "setter-cache.hpp"
+#include <algorithm>
+
+namespace jwt {
+
+  namespace {
+    // 64-bit FNV-1a
+    const std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    const std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+    std::uint64_t HashBytes(std::uint64_t h, const void* data, std::size_t n) {
+      const unsigned char* p = static_cast<const unsigned char*>(data);
+
+      for (std::size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+      }
+      return h;
+    }
+  }
+
+  bool SetterCache::Skip(unsigned int key, std::uint64_t value) {
+    if (!enabled_) {
+      return false;
+    }
+
+    for (const auto& e : entries_) {
+      if (e.first == key) {
+        if (e.second == value) {
+          ++skipped_;
+          return true;
+        }
+        return false;
+      }
+    }
+    return false;
+  }
+
+  void SetterCache::Store(unsigned int key, std::uint64_t value) {
+    ++written_;
+
+    if (!enabled_) {
+      return;
+    }
+
+    for (auto& e : entries_) {
+      if (e.first == key) {
+        e.second = value;
+        return;
+      }
+    }
+    entries_.push_back(Entry(key, value));
+  }
+
+  void SetterCache::Forget(unsigned int key) {
+    Forget(key, key);
+  }
+
+  void SetterCache::Forget(unsigned int first, unsigned int last) {
+    entries_.erase(
+      std::remove_if(begin(entries_), end(entries_), [first, last](const Entry& e) {
+        return e.first >= first && e.first <= last;
+      }),
+      end(entries_)
+    );
+  }
+
+  void SetterCache::Enable(bool on) {
+    enabled_ = on;
+    if (!on) {
+      Clear();
+    }
+  }
+
+  std::uint64_t SetterCache::Hash(const std::wstring& s) {
+    // Include the length so that embedded nulls can't make two strings alike
+    std::size_t n = s.size();
+    std::uint64_t h = HashBytes(FNV_OFFSET, &n, sizeof(n));
+    return HashBytes(h, s.data(), s.size() * sizeof(wchar_t));
+  }
+
+  std::uint64_t SetterCache::Hash(const int* values, std::size_t count) {
+    std::uint64_t h = HashBytes(FNV_OFFSET, &count, sizeof(count));
+    return HashBytes(h, values, count * sizeof(int));
+  }
+
+} // namespace jwt
\ No newline at end of file
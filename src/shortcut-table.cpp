@@ -0,0 +1,148 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "shortcut-table.hpp"
+#include <algorithm>
+#include <assert.h>
+
+namespace jwt {
+
+  namespace {
+    std::uint32_t Hash(std::uint32_t key) {
+      // Fibonacci hashing; the caller masks off the low bits it needs
+      return (key * 2654435769u) >> 16;
+    }
+  }
+
+  ShortcutTable::ShortcutTable()
+    : nextId_(1), dirty_(false)
+  {
+  }
+
+  ShortcutTable::BindingId ShortcutTable::Add(unsigned int vk, unsigned int modifiers, Scope scope, std::uintptr_t target, int command) {
+    assert(vk > 0 && vk <= 0xFF);
+    assert((modifiers & ~(SHIFT | CONTROL | ALT)) == 0);
+
+    Binding b = { vk, modifiers, scope, target, command, nextId_++ };
+    bindings_.push_back(b);
+    dirty_ = true;
+
+    return b.id;
+  }
+
+  void ShortcutTable::Remove(BindingId id) {
+    auto i = std::find_if(begin(bindings_), end(bindings_), [id](const Binding& b) {
+      return b.id == id;
+    });
+
+    if (i != end(bindings_)) {
+      bindings_.erase(i);
+      dirty_ = true;
+    }
+  }
+
+  void ShortcutTable::RemoveTarget(std::uintptr_t target) {
+    auto i = std::remove_if(begin(bindings_), end(bindings_), [target](const Binding& b) {
+      return b.target == target;
+    });
+
+    if (i != end(bindings_)) {
+      bindings_.erase(i, end(bindings_));
+      dirty_ = true;
+    }
+  }
+
+  void ShortcutTable::Compile() const {
+    compiled_ = bindings_;
+    std::stable_sort(begin(compiled_), end(compiled_), [](const Binding& a, const Binding& b) {
+      return Key(a.vk, a.modifiers) < Key(b.vk, b.modifiers);
+    });
+
+    // At most half full keeps probe sequences short
+    std::size_t size = 8;
+    while (size < compiled_.size() * 2) {
+      size *= 2;
+    }
+
+    Slot empty = { 0, 0, 0 };
+    slots_.assign(size, empty);
+    std::size_t mask = size - 1;
+
+    for (std::size_t i = 0; i < compiled_.size(); ) {
+      std::uint32_t key = Key(compiled_[i].vk, compiled_[i].modifiers);
+
+      std::size_t j = i + 1;
+      while (j < compiled_.size() && Key(compiled_[j].vk, compiled_[j].modifiers) == key) {
+        ++j;
+      }
+
+      std::size_t s = Hash(key) & mask;
+      while (slots_[s].key != 0) {
+        s = (s + 1) & mask;
+      }
+
+      slots_[s].key = key;
+      slots_[s].first = (std::uint32_t) i;
+      slots_[s].count = (std::uint32_t) (j - i);
+
+      i = j;
+    }
+
+    dirty_ = false;
+  }
+
+  const ShortcutTable::Binding* ShortcutTable::Find(unsigned int vk, unsigned int modifiers, const Scope* scopes, std::size_t count) const {
+    if (dirty_) {
+      Compile();
+    }
+
+    if (compiled_.empty() || vk == 0 || vk > 0xFF) {
+      return nullptr;
+    }
+
+    std::uint32_t key = Key(vk, modifiers);
+    std::size_t mask = slots_.size() - 1;
+    std::size_t s = Hash(key) & mask;
+
+    while (slots_[s].key != key) {
+      if (slots_[s].key == 0) {
+        return nullptr;
+      }
+      s = (s + 1) & mask;
+    }
+
+    const Binding* first = &compiled_[slots_[s].first];
+    const Binding* last = first + slots_[s].count;
+
+    // Latest binding first, most specific scope first
+    for (std::size_t i = 0; i <= count; ++i) {
+      Scope scope = (i < count) ? scopes[i] : GLOBAL;
+
+      for (const Binding* b = last; b != first; ) {
+        --b;
+        if (b->scope == scope) {
+          return b;
+        }
+      }
+    }
+
+    return nullptr;
+  }
+
+} // namespace jwt
\ No newline at end of file
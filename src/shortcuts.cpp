@@ -0,0 +1,48 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "shortcuts.hpp"
+#include <assert.h>
+
+namespace jwt {
+
+  ShortcutTable::BindingId AddShortcut(Window& target, unsigned int vk, unsigned int modifiers, int command) {
+    assert(target.TheHWND());
+
+    std::uintptr_t h = (std::uintptr_t) target.TheHWND();
+    return target.OwningPump().Shortcuts().Add(vk, modifiers, h, h, command);
+  }
+
+  ShortcutTable::BindingId AddGlobalShortcut(Window& target, unsigned int vk, unsigned int modifiers, int command) {
+    assert(target.TheHWND());
+
+    std::uintptr_t h = (std::uintptr_t) target.TheHWND();
+    return target.OwningPump().Shortcuts().Add(vk, modifiers, ShortcutTable::GLOBAL, h, command);
+  }
+
+  void RemoveShortcut(Window& target, ShortcutTable::BindingId id) {
+    target.OwningPump().Shortcuts().Remove(id);
+  }
+
+  void RemoveShortcuts(Window& target) {
+    target.OwningPump().Shortcuts().RemoveTarget((std::uintptr_t) target.TheHWND());
+  }
+
+} // namespace jwt
\ No newline at end of file
@@ -20,28 +20,115 @@
 #include "libraries.hpp"
 #include "status-bar.hpp"
 #include <assert.h>
+#include <stdexcept>
 
 namespace jwt {
 
-  StatusBar::StatusBar(Window& parent) {
+  namespace {
+    void WriteParts(StatusBar& s, const int* rightEdges, int count) {
+      std::uint64_t h = SetterCache::Hash(rightEdges, count);
+      if (s.Setters().Skip(SetterCache::PARTS, h)) {
+        return;
+      }
+
+      SendMessage(s.TheHWND(), SB_SETPARTS, count, (LPARAM) rightEdges);
+      s.Setters().Store(SetterCache::PARTS, h);
+
+      // Parts that went away take their text with them
+      s.Setters().Forget(SetterCache::PART_TEXT, SetterCache::PART_TEXT_LAST);
+    }
+
+    std::wstring ReadText(HWND h, int part) {
+      int length = LOWORD(SendMessage(h, SB_GETTEXTLENGTH, part, 0));
+      if (length < 1) {
+        return L"";
+      }
+
+      // length excludes the terminator, which SB_GETTEXT writes into the
+      // string's own null slot
+      std::wstring txt(length, ' ');
+      SendMessage(h, SB_GETTEXT, part, (LPARAM) &*txt.begin());
+
+      return txt;
+    }
+
+    void WriteText(StatusBar& s, int part, const std::wstring& txt) {
+      std::uint64_t h = SetterCache::Hash(txt);
+      if (s.Setters().Skip(SetterCache::PART_TEXT + part, h)) {
+        return;
+      }
+
+      SendMessage(s.TheHWND(), SB_SETTEXT, MAKEWORD(part, 0), (LPARAM) txt.c_str());
+      s.Setters().Store(SetterCache::PART_TEXT + part, h);
+    }
+  }
+
+  //
+  // Writes a StatusModel's changes to the control
+  //
+  struct StatusBar::Writer
+    : StatusModel::Sink
+  {
+    explicit Writer(StatusBar& s) : bar_(s) {}
+
+    void Parts(const int* rightEdges, int count) {
+      WriteParts(bar_, rightEdges, count);
+    }
+
+    void Text(int part, const std::wstring& txt) {
+      if (!bar_.ownerDraw_) {
+        WriteText(bar_, part, txt);
+        return;
+      }
+
+      // The control only holds the part number; we draw the text from the
+      // model. Invalidate as well, in case the control sees nothing new.
+      HWND h = bar_.TheHWND();
+      SendMessage(h, SB_SETTEXT, part | SBT_OWNERDRAW, (LPARAM) part);
+
+      RECT r;
+      if (SendMessage(h, SB_GETRECT, part, (LPARAM) &r)) {
+        InvalidateRect(h, &r, TRUE);
+      }
+    }
+
+  private:
+    StatusBar& bar_;
+  };
+
+  StatusBar::StatusBar(Window& parent)
+    : flush_(TimerService::INVALID_TIMER), ownerDraw_(false)
+  {
     Create(parent);
   }
 
-  StatusBar::StatusBar(Window& parent, const std::initializer_list<int>& parts) {
+  StatusBar::StatusBar(Window& parent, const std::initializer_list<int>& parts)
+    : flush_(TimerService::INVALID_TIMER), ownerDraw_(false)
+  {
     Create(parent);
     SetParts(*this, parts);
   }
 
-  StatusBar::StatusBar(Dialog& parent, int statusbarId) {
+  StatusBar::StatusBar(Dialog& parent, int statusbarId)
+    : flush_(TimerService::INVALID_TIMER), ownerDraw_(false)
+  {
     hWnd_ = parent.Item(statusbarId);
     
     assert(hWnd_ != nullptr);
-    assert(ClassName(*this) == STATUSCLASSNAME);
+    assert(HasClass(*this, STATUSCLASSNAME));
 
     SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) this);
   }
 
-  StatusBar::StatusBar(const defer_create_t&) {
+  StatusBar::StatusBar(const defer_create_t&)
+    : flush_(TimerService::INVALID_TIMER), ownerDraw_(false)
+  {
+  }
+
+  StatusBar::~StatusBar() {
+    if (flush_ != TimerService::INVALID_TIMER) {
+      OwningPump().CancelTimer(flush_);
+    }
   }
 
   void StatusBar::Create(Window& parent) {
@@ -56,33 +143,179 @@ namespace jwt {
   }
 
   LRESULT StatusBar::HandleReflectedMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
-    switch (m) {
-    case WM_COMMAND:
-      break;
+    if (m == WM_DRAWITEM && ownerDraw_) {
+      DrawPart(*(const DRAWITEMSTRUCT*) l);
+      return TRUE;
     }
 
+    // Only owner-drawn parts are listened for
+    Unreflect<StatusBar>(ReflectFlag(m));
     return 0;
   }
 
+  void StatusBar::Queue(int part, const std::wstring& txt) {
+    assert(hWnd_);
+
+    if (TheModel().SetText(part, txt)) {
+      ScheduleFlush();
+    }
+  }
+
+  void StatusBar::QueueParts(const int* rightEdges, int count) {
+    assert(hWnd_);
+
+    TheModel().SetParts(rightEdges, count);
+    if (model_->Dirty()) {
+      ScheduleFlush();
+    }
+  }
+
+  void StatusBar::QueueParts(const std::initializer_list<int>& l) {
+    QueueParts(l.begin(), (int) l.size());
+  }
+
+  void StatusBar::Flush() {
+    if (flush_ != TimerService::INVALID_TIMER) {
+      OwningPump().Timers().Cancel(flush_);
+      flush_ = TimerService::INVALID_TIMER;
+    }
+
+    if (model_) {
+      Writer w(*this);
+      model_->Flush(w);
+    }
+  }
+
+  void StatusBar::SetOwnerDraw(bool on) {
+    assert(hWnd_);
+
+    StatusModel& m = TheModel();
+    if (on == ownerDraw_) {
+      return;
+    }
+
+    // From now on the model's text is all there is, so fetch whatever the
+    // control is showing that the model hasn't been told
+    if (on) {
+      for (int i = 0; i < m.PartCount(); ++i) {
+        if (!m.Known(i)) {
+          m.SetText(i, ReadText(hWnd_, i));
+        }
+      }
+    }
+
+    ownerDraw_ = on;
+    if (on) {
+      Reflect(REFLECT_DRAW, true);
+    }
+
+    // Every part has to be rewritten in the new form
+    Setters().Forget(SetterCache::PART_TEXT, SetterCache::PART_TEXT_LAST);
+    m.ForgetExtents();
+    m.MarkAllDirty();
+    Flush();
+  }
+
+  StatusModel& StatusBar::TheModel() {
+    if (!model_) {
+      // Start from the control's layout (one message) but not its text: that
+      // would be a round trip per part. Parts start out unknown, & queueing
+      // the text a part already has is still caught by the SetterCache when
+      // it is flushed.
+      std::unique_ptr<StatusModel> m(new StatusModel);
+
+      std::array<int, StatusModel::MAX_PARTS> parts;
+      int count = (int) SendMessage(hWnd_, SB_GETPARTS, parts.size(), (LPARAM) parts.data());
+
+      if (count > 0) {
+        m->SetParts(parts.data(), count);
+      }
+      m->MarkClean();
+
+      model_ = std::move(m);
+    }
+    return *model_;
+  }
+
+  void StatusBar::ScheduleFlush() {
+    if (flush_ == TimerService::INVALID_TIMER) {
+      flush_ = OwningPump().Timers().Once(FRAME_INTERVAL, [this]() {
+        flush_ = TimerService::INVALID_TIMER;
+        Flush();
+      });
+    }
+  }
+
+  void StatusBar::DrawPart(const DRAWITEMSTRUCT& d) {
+    if (!model_ || d.itemID >= StatusModel::MAX_PARTS) {
+      return;
+    }
+
+    int part = (int) d.itemID;
+    const std::wstring& txt = model_->Text(part);
+
+    int cx, cy;
+    if (!model_->Extent(part, cx, cy)) {
+      SIZE size;
+      GetTextExtentPoint32(d.hDC, txt.c_str(), (int) txt.size(), &size);
+
+      cx = size.cx;
+      cy = size.cy;
+      model_->SetExtent(part, cx, cy);
+    }
+
+    RECT r = d.rcItem;
+    SetBkMode(d.hDC, TRANSPARENT);
+
+    if (cx <= r.right - r.left) {
+      // Fits: place it directly using the cached extent
+      ExtTextOut(d.hDC, r.left, r.top + ((r.bottom - r.top) - cy) / 2,
+        ETO_CLIPPED, &r, txt.c_str(), (UINT) txt.size(), nullptr);
+    }
+    else {
+      DrawText(d.hDC, txt.c_str(), (int) txt.size(), &r,
+        DT_SINGLELINE | DT_VCENTER | DT_NOPREFIX | DT_END_ELLIPSIS);
+    }
+  }
+
   //
   // Non-member statusbar functions
   //
 
   StatusBar& SetParts(StatusBar& s, const std::initializer_list<int>& l) {
-    assert(s.TheHWND());
-    assert(l.size() > 0 && l.size() <= 256);
+    return detail::SendParts(s, l.begin(), (int) l.size());
+  }
 
-    std::vector<int> parts(l);
-    SendMessage(s.TheHWND(), SB_SETPARTS, parts.size(), (LPARAM) &*parts.begin());
+  namespace detail {
+    StatusBar& SendParts(StatusBar& s, const int* rightEdges, int count) {
+      assert(s.TheHWND());
+      assert(count > 0);
+      if (count > StatusModel::MAX_PARTS) {
+        throw std::length_error("StatusBar: too many parts");
+      }
 
-    return s;
+      if (s.Model()) {
+        s.QueueParts(rightEdges, count);
+        s.Flush();
+      }
+      else {
+        WriteParts(s, rightEdges, count);
+      }
+      return s;
+    }
   }
 
   StatusBar& SetText(StatusBar& s, int part, const std::wstring& txt) {
     assert(s.TheHWND());
     assert(part >= 0 && part <= 255);
 
-    SendMessage(s.TheHWND(), SB_SETTEXT, MAKEWORD(part, 0), (LPARAM) txt.c_str());
+    if (s.Model()) {
+      s.Queue(part, txt);
+      s.Flush();
+    }
+    else {
+      WriteText(s, part, txt);
+    }
 
     return s;
   }
@@ -91,17 +324,14 @@ namespace jwt {
     assert(s.TheHWND());
     assert(part >= 0 && part <= 255);
 
-    int length = LOWORD(SendMessage(s.TheHWND(), SB_GETTEXTLENGTH, part, 0));
-    if (length < 1) {
-      return L"";
+    // Once there's a model it holds the latest text, including anything
+    // queued, & it's the only place owner-drawn text lives
+    const StatusModel* m = s.Model();
+    if (m && m->Known(part)) {
+      return m->Text(part);
     }
 
-    std::wstring txt(length, ' ');
-    SendMessage(s.TheHWND(), SB_GETTEXT, part, (LPARAM) &*txt.begin());
-
-    txt.resize(txt.size() - 1);
-
-    return txt;
+    return ReadText(s.TheHWND(), part);
   }
 
 
@@ -0,0 +1,145 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "status-model.hpp"
+#include <algorithm>
+#include <assert.h>
+#include <stdexcept>
+
+namespace jwt {
+
+  StatusModel::StatusModel()
+    : count_(0), layoutDirty_(false), flushes_(0), writes_(0)
+  {
+    parts_.fill(0);
+  }
+
+  void StatusModel::SetParts(const int* rightEdges, int count) {
+    assert(count > 0);
+    if (count > MAX_PARTS) {
+      throw std::length_error("StatusBar: too many parts");
+    }
+
+    if (count == count_ && std::equal(rightEdges, rightEdges + count, parts_.begin())) {
+      return;
+    }
+
+    std::copy(rightEdges, rightEdges + count, parts_.begin());
+    count_ = count;
+    layoutDirty_ = true;
+
+    MarkAllDirty();
+  }
+
+  bool StatusModel::SetText(int part, const std::wstring& txt) {
+    assert(part >= 0 && part < MAX_PARTS);
+
+    if (known_.test(part) && texts_[part] == txt) {
+      return false;
+    }
+
+    texts_[part] = txt;
+    known_.set(part);
+    dirty_.set(part);
+    measured_.reset(part);
+    return true;
+  }
+
+  const std::wstring& StatusModel::Text(int part) const {
+    assert(part >= 0 && part < MAX_PARTS);
+
+    return texts_[part];
+  }
+
+  bool StatusModel::Known(int part) const {
+    assert(part >= 0 && part < MAX_PARTS);
+
+    return known_.test(part);
+  }
+
+  bool StatusModel::Dirty(int part) const {
+    assert(part >= 0 && part < MAX_PARTS);
+
+    return dirty_.test(part);
+  }
+
+  void StatusModel::MarkAllDirty() {
+    if (count_ > 0) {
+      layoutDirty_ = true;
+    }
+
+    // Parts beyond the layout may have been given text too; SB_SETTEXT
+    // accepts any index up to 255. Unknown parts would be written blank.
+    dirty_ |= known_;
+  }
+
+  void StatusModel::MarkClean() {
+    layoutDirty_ = false;
+    dirty_.reset();
+  }
+
+  unsigned int StatusModel::Flush(Sink& sink) {
+    if (!Dirty()) {
+      return 0;
+    }
+
+    unsigned int writes = 0;
+
+    if (layoutDirty_) {
+      // Clear first: if the sink throws, the model is left clean rather than
+      // retrying the same write forever
+      layoutDirty_ = false;
+      sink.Parts(parts_.data(), count_);
+      ++writes;
+    }
+
+    for (int i = 0; i < MAX_PARTS && dirty_.any(); ++i) {
+      if (dirty_.test(i)) {
+        dirty_.reset(i);
+        sink.Text(i, texts_[i]);
+        ++writes;
+      }
+    }
+
+    ++flushes_;
+    writes_ += writes;
+    return writes;
+  }
+
+  bool StatusModel::Extent(int part, int& cx, int& cy) const {
+    assert(part >= 0 && part < MAX_PARTS);
+
+    if (!measured_.test(part)) {
+      return false;
+    }
+
+    cx = extents_[part].cx;
+    cy = extents_[part].cy;
+    return true;
+  }
+
+  void StatusModel::SetExtent(int part, int cx, int cy) {
+    assert(part >= 0 && part < MAX_PARTS);
+
+    extents_[part].cx = cx;
+    extents_[part].cy = cy;
+    measured_.set(part);
+  }
+
+} // namespace jwt
\ No newline at end of file
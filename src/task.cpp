@@ -0,0 +1,125 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "task.hpp"
+
+#if JWT_HAS_COROUTINES
+
+namespace jwt {
+  namespace detail {
+
+    namespace {
+      // Frames of up to 128 << (SIZE_CLASSES - 1) bytes are cached; a few
+      // hundred bytes is typical.
+      enum {
+        SMALLEST_CLASS = 128,
+        SIZE_CLASSES = 6,
+        CACHED_PER_CLASS = 16
+      };
+
+      struct FreeBlock {
+        FreeBlock* next;
+      };
+
+      struct FrameCache {
+        FreeBlock* blocks[SIZE_CLASSES];
+        unsigned int counts[SIZE_CLASSES];
+
+        FrameCache() {
+          for (int i = 0; i < SIZE_CLASSES; ++i) {
+            blocks[i] = nullptr;
+            counts[i] = 0;
+          }
+        }
+
+        ~FrameCache() {
+          for (int i = 0; i < SIZE_CLASSES; ++i) {
+            while (blocks[i]) {
+              FreeBlock* b = blocks[i];
+              blocks[i] = b->next;
+              ::operator delete(b);
+            }
+          }
+        }
+      };
+
+      // Per-thread, so no locking. A frame freed on a different thread from
+      // the one that allocated it simply joins that thread's cache.
+      thread_local FrameCache frameCache_;
+
+      int SizeClass(std::size_t n) {
+        std::size_t size = SMALLEST_CLASS;
+
+        for (int i = 0; i < SIZE_CLASSES; ++i, size <<= 1) {
+          if (n <= size) {
+            return i;
+          }
+        }
+        return -1;
+      }
+    }
+
+    void* AllocateFrame(std::size_t n) {
+      int c = SizeClass(n);
+      if (c < 0) {
+        return ::operator new(n);
+      }
+
+      FrameCache& cache = frameCache_;
+      if (FreeBlock* b = cache.blocks[c]) {
+        cache.blocks[c] = b->next;
+        --cache.counts[c];
+        return b;
+      }
+
+      return ::operator new(std::size_t(SMALLEST_CLASS) << c);
+    }
+
+    void FreeFrame(void* p, std::size_t n) {
+      int c = SizeClass(n);
+      FrameCache& cache = frameCache_;
+
+      if (c < 0 || cache.counts[c] >= CACHED_PER_CLASS) {
+        ::operator delete(p);
+        return;
+      }
+
+      FreeBlock* b = static_cast<FreeBlock*>(p);
+      b->next = cache.blocks[c];
+      cache.blocks[c] = b;
+      ++cache.counts[c];
+    }
+
+    Detached RunDetached(Task<void> t, std::function<void(std::exception_ptr)> onError) {
+      try {
+        co_await std::move(t);
+      }
+      catch (const TaskCancelled&) {
+      }
+      catch (...) {
+        if (onError) {
+          onError(std::current_exception());
+        }
+      }
+    }
+
+  }
+} // namespace jwt
+
+#endif
\ No newline at end of file
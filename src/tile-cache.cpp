@@ -0,0 +1,243 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "tile-cache.hpp"
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+
+namespace jwt {
+
+  namespace {
+    const int UNBOUNDED = 1 << 30;
+  }
+
+  TileCache::TileCache(Renderer r, std::size_t budgetBytes, int tileSize)
+    : renderer_(std::move(r)), tileSize_(tileSize), budget_(budgetBytes),
+      extentW_(UNBOUNDED), extentH_(UNBOUNDED), background_(0xFFFFFFFFu),
+      visit_(0), hits_(0), renders_(0)
+  {
+    assert(renderer_);
+    assert(tileSize > 0);
+  }
+
+  void TileCache::SetExtent(int w, int h) {
+    assert(w >= 0 && h >= 0);
+
+    extentW_ = w;
+    extentH_ = h;
+
+    for (auto i = tiles_.begin(); i != tiles_.end(); ) {
+      int tx = (int) (std::uint32_t) (i->first >> 32);
+      int ty = (int) (std::uint32_t) i->first;
+
+      if (tx * tileSize_ >= w || ty * tileSize_ >= h) {
+        lru_.erase(i->second.lru);
+        i = tiles_.erase(i);
+      }
+      else {
+        ++i;
+      }
+    }
+  }
+
+  void TileCache::SetBackground(std::uint32_t argb) {
+    if (background_ != argb) {
+      background_ = argb;
+      InvalidateAll();
+    }
+  }
+
+  void TileCache::Visit(const Box& viewport, const Visitor& f) {
+    Box extent = { 0, 0, extentW_, extentH_ };
+    Box v = viewport.Intersect(extent);
+
+    if (v.Empty()) {
+      return;
+    }
+
+    if (++visit_ == 0) {
+      for (auto& t : tiles_) {
+        t.second.visit = 0;
+      }
+      visit_ = 1;
+    }
+
+    int tx0 = v.x / tileSize_, tx1 = (v.x + v.w - 1) / tileSize_;
+    int ty0 = v.y / tileSize_, ty1 = (v.y + v.h - 1) / tileSize_;
+
+    for (int ty = ty0; ty <= ty1; ++ty) {
+      for (int tx = tx0; tx <= tx1; ++tx) {
+        Tile& t = Acquire(tx, ty);
+
+        Box tile = { tx * tileSize_, ty * tileSize_, tileSize_, tileSize_ };
+        Box part = tile.Intersect(v);
+        Box src = { part.x - tile.x, part.y - tile.y, part.w, part.h };
+
+        f(*t.pixels, src, part.x - viewport.x, part.y - viewport.y);
+      }
+    }
+
+    Trim();
+  }
+
+  void TileCache::Compose(Raster& target, const Box& viewport) {
+    Visit(viewport, [&target](const Raster& tile, const Box& src, int x, int y) {
+      Box at = { x, y, src.w, src.h };
+      Box dst = at.Intersect(target.Bounds());
+
+      for (int row = 0; row < dst.h; ++row) {
+        const std::uint32_t* from = tile.Row(src.y + dst.y - y + row) + src.x + dst.x - x;
+        std::memcpy(target.Row(dst.y + row) + dst.x, from, dst.w * sizeof(std::uint32_t));
+      }
+    });
+  }
+
+  void TileCache::Invalidate(const Box& area) {
+    Box extent = { 0, 0, extentW_, extentH_ };
+    Box a = area.Intersect(extent);
+
+    if (a.Empty() || tiles_.empty()) {
+      return;
+    }
+
+    auto stale = [this](Tile& t) {
+      t.valid = false;
+
+      // First in line for reuse
+      lru_.splice(lru_.end(), lru_, t.lru);
+    };
+
+    int tx0 = a.x / tileSize_, tx1 = (a.x + a.w - 1) / tileSize_;
+    int ty0 = a.y / tileSize_, ty1 = (a.y + a.h - 1) / tileSize_;
+
+    // A large area covers more tiles than are cached
+    if ((std::uint64_t) (tx1 - tx0 + 1) * (std::uint64_t) (ty1 - ty0 + 1) > tiles_.size()) {
+      for (auto& i : tiles_) {
+        int tx = (int) (std::uint32_t) (i.first >> 32);
+        int ty = (int) (std::uint32_t) i.first;
+
+        if (tx >= tx0 && tx <= tx1 && ty >= ty0 && ty <= ty1) {
+          stale(i.second);
+        }
+      }
+      return;
+    }
+
+    for (int ty = ty0; ty <= ty1; ++ty) {
+      for (int tx = tx0; tx <= tx1; ++tx) {
+        auto i = tiles_.find(KeyOf(tx, ty));
+        if (i != tiles_.end()) {
+          stale(i->second);
+        }
+      }
+    }
+  }
+
+  void TileCache::InvalidateAll() {
+    for (auto& t : tiles_) {
+      t.second.valid = false;
+    }
+  }
+
+  void TileCache::Clear() {
+    tiles_.clear();
+    lru_.clear();
+  }
+
+  void TileCache::SetBudget(std::size_t bytes) {
+    budget_ = bytes;
+    Trim();
+  }
+
+  TileCache::Tile& TileCache::Acquire(int tx, int ty) {
+    Key k = KeyOf(tx, ty);
+    auto i = tiles_.find(k);
+
+    if (i != tiles_.end()) {
+      Tile& t = i->second;
+
+      lru_.splice(lru_.begin(), lru_, t.lru);
+      t.visit = visit_;
+
+      if (t.valid) {
+        ++hits_;
+      }
+      else {
+        Render(t, tx, ty);
+      }
+      return t;
+    }
+
+    std::unique_ptr<Raster> pixels;
+
+    // At the budget: take over the pixels of the least recently used tile,
+    // unless the current Visit needs it
+    if (Bytes() + TileBytes() > budget_ && !lru_.empty()) {
+      auto victim = tiles_.find(lru_.back());
+
+      if (victim->second.visit != visit_) {
+        pixels = std::move(victim->second.pixels);
+        Drop(victim->first);
+      }
+    }
+    if (!pixels) {
+      pixels.reset(new Raster(tileSize_, tileSize_));
+    }
+
+    lru_.push_front(k);
+
+    Tile& t = tiles_[k];
+    t.pixels = std::move(pixels);
+    t.lru = lru_.begin();
+    t.visit = visit_;
+
+    Render(t, tx, ty);
+    return t;
+  }
+
+  void TileCache::Render(Tile& t, int tx, int ty) {
+    Box area = { tx * tileSize_, ty * tileSize_, tileSize_, tileSize_ };
+
+    // Set before calling out, so a throwing renderer leaves a stale tile
+    // rather than a half-drawn one marked valid
+    t.valid = false;
+    t.pixels->Clear(t.pixels->Bounds(), background_);
+    renderer_(*t.pixels, area);
+    t.valid = true;
+
+    ++renders_;
+  }
+
+  void TileCache::Trim() {
+    // Only called between Visits, so every tile is fair game
+    while (Bytes() > budget_ && !lru_.empty()) {
+      Drop(lru_.back());
+    }
+  }
+
+  void TileCache::Drop(Key k) {
+    auto i = tiles_.find(k);
+    assert(i != tiles_.end());
+
+    lru_.erase(i->second.lru);
+    tiles_.erase(i);
+  }
+
+} // namespace jwt
\ No newline at end of file
@@ -0,0 +1,125 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "timer-service.hpp"
+#include "message-pump.hpp"
+#include <assert.h>
+
+namespace jwt {
+
+  TimerService::TimerService(MessagePump& pump)
+    : pump_(pump), timer_(nullptr), wheel_(GetTickCount64()), slack_(0),
+      armed_(false), armedFor_(0)
+  {
+    // Synchronization (auto-reset) timer: the wait is satisfied once per
+    // expiry, so the pump doesn't spin if Fire() has nothing to do.
+    timer_ = CreateWaitableTimer(nullptr, FALSE, nullptr);
+    assert(timer_ != nullptr);
+
+    pump_.AddWait(timer_, [this]() {
+      Fire();
+    });
+  }
+
+  TimerService::~TimerService() {
+    pump_.RemoveWait(timer_);
+    CloseHandle(timer_);
+  }
+
+  TimerService::TimerId TimerService::Once(DWORD delay, Callback c) {
+    TimerId id = wheel_.Schedule(GetTickCount64() + delay, 0, std::move(c));
+    Rearm();
+    return id;
+  }
+
+  TimerService::TimerId TimerService::Every(DWORD period, Callback c) {
+    assert(period > 0);
+
+    TimerId id = wheel_.Schedule(GetTickCount64() + period, period, std::move(c));
+    Rearm();
+    return id;
+  }
+
+  bool TimerService::Cancel(TimerId id) {
+    bool cancelled = wheel_.Cancel(id);
+
+    // An armed timer with nothing left to do only costs a wasted wake, but
+    // there's no reason to pay it when the wheel has emptied.
+    if (cancelled && wheel_.Empty()) {
+      Rearm();
+    }
+
+    return cancelled;
+  }
+
+  void TimerService::SetSlack(DWORD milliseconds) {
+    slack_ = milliseconds;
+    Rearm();
+  }
+
+  void TimerService::Fire() {
+    armed_ = false;
+
+    try {
+      wheel_.Advance(GetTickCount64());
+    }
+    catch (...) {
+      Rearm();
+      throw;
+    }
+
+    Rearm();
+  }
+
+  void TimerService::Rearm() {
+    TimerWheel::Time next;
+
+    if (!wheel_.NextDeadline(next)) {
+      if (armed_) {
+        CancelWaitableTimer(timer_);
+        armed_ = false;
+      }
+      return;
+    }
+
+    // Round up to the slack grid: every timer due in the same window shares
+    // one wake-up.
+    if (slack_) {
+      next = ((next + slack_ - 1) / slack_) * slack_;
+    }
+
+    if (armed_ && next == armedFor_) {
+      return;
+    }
+
+    // Relative due time (negative, in 100ns units) so that changes to the
+    // system clock don't move the deadline.
+    TimerWheel::Time now = GetTickCount64();
+    LARGE_INTEGER due;
+    due.QuadPart = (next > now) ? -(LONGLONG) ((next - now) * 10000) : -1;
+
+    BOOL set = SetWaitableTimer(timer_, &due, 0, nullptr, nullptr, FALSE);
+    assert(set);
+
+    armed_ = true;
+    armedFor_ = next;
+  }
+
+} // namespace jwt
\ No newline at end of file
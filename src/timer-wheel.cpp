@@ -0,0 +1,365 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "timer-wheel.hpp"
+#include <assert.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace jwt {
+
+  namespace {
+    unsigned LowestSetBit(std::uint64_t mask) {
+      assert(mask != 0);
+
+#if defined(_MSC_VER) && defined(_M_X64)
+      unsigned long i;
+      _BitScanForward64(&i, mask);
+      return (unsigned) i;
+#elif defined(__GNUC__)
+      return (unsigned) __builtin_ctzll(mask);
+#else
+      unsigned i = 0;
+      while (!(mask & 1)) {
+        mask >>= 1;
+        ++i;
+      }
+      return i;
+#endif
+    }
+
+    // Width (in ticks) of one slot at the given level
+    TimerWheel::Time SlotWidth(unsigned level) {
+      return TimerWheel::Time(1) << (6 * level);
+    }
+  }
+
+  TimerWheel::TimerWheel(Time now)
+    : now_(now), size_(0), freeList_(NIL)
+  {
+    for (auto& l : lists_) {
+      l.head = l.tail = NIL;
+    }
+
+    for (auto& o : occupied_) {
+      o = 0;
+    }
+  }
+
+  TimerWheel::TimerId TimerWheel::Schedule(Time deadline, Time period, Callback c) {
+    assert(c);
+
+    std::uint32_t i = Allocate();
+    Node& n = nodes_[i];
+
+    n.deadline = deadline;
+    n.period = period;
+    n.callback = std::move(c);
+
+    Insert(i);
+    return MakeId(i, n.generation);
+  }
+
+  bool TimerWheel::Cancel(TimerId id) {
+    std::uint32_t i = (std::uint32_t) id;
+    std::uint32_t generation = (std::uint32_t) (id >> 32);
+
+    if (i >= nodes_.size() || nodes_[i].generation != generation || nodes_[i].list == FREE) {
+      return false;
+    }
+
+    Unlink(i);
+    Release(i);
+    return true;
+  }
+
+  size_t TimerWheel::Advance(Time now) {
+    // Time never runs backwards; a late caller simply fires nothing new.
+    if (now < now_) {
+      now = now_;
+    }
+
+    // Anything left over from a callback that threw, or scheduled in the past
+    Splice(DUE_LIST, FIRING_LIST);
+    size_t fired = FireList(now);
+
+    Time t;
+    while (NextEvent(t) && t <= now) {
+      now_ = t;
+
+      // Cascade before expiring: a timer due exactly at t may be sitting in a
+      // higher level until this moment.
+      for (unsigned level = 1; level < LEVELS; ++level) {
+        if (t & (SlotWidth(level) - 1)) {
+          break;
+        }
+
+        unsigned slot = (unsigned) (t >> (LEVEL_BITS * level)) & (SLOTS - 1);
+        Cascade((std::uint16_t) (level * SLOTS + slot));
+      }
+
+      if (lists_[OVERFLOW_LIST].head != NIL && !(t & (SlotWidth(LEVELS - 1) - 1))) {
+        Cascade(OVERFLOW_LIST);
+      }
+
+      // Timers cascaded down with a deadline of exactly t land on the due
+      // list, as do any scheduled in the past by earlier callbacks.
+      Splice(DUE_LIST, FIRING_LIST);
+      Splice((std::uint16_t) (t & (SLOTS - 1)), FIRING_LIST);
+      fired += FireList(now);
+    }
+
+    now_ = now;
+    return fired;
+  }
+
+  bool TimerWheel::NextDeadline(Time& deadline) const {
+    if (lists_[DUE_LIST].head != NIL || lists_[FIRING_LIST].head != NIL) {
+      deadline = now_;
+      return true;
+    }
+
+    return NextEvent(deadline);
+  }
+
+  // ****************************************************************************
+  // Private implementation
+
+  bool TimerWheel::NextEvent(Time& t) const {
+    bool found = false;
+
+    for (unsigned level = 0; level < LEVELS; ++level) {
+      std::uint64_t mask = occupied_[level];
+      if (!mask) {
+        continue;
+      }
+
+      Time width = SlotWidth(level);
+      Time span = width << LEVEL_BITS;
+      Time base = now_ & ~(span - 1);
+      unsigned current = (unsigned) (now_ >> (LEVEL_BITS * level)) & (SLOTS - 1);
+
+      // Slots after the current one come round in this rotation; the current
+      // slot & those before it have already been visited & wait for the next.
+      std::uint64_t later = (current == SLOTS - 1) ? 0 : mask & (~std::uint64_t(0) << (current + 1));
+
+      Time candidate = (later)
+        ? base + LowestSetBit(later) * width
+        : base + span + LowestSetBit(mask) * width;
+
+      if (!found || candidate < t) {
+        t = candidate;
+        found = true;
+      }
+    }
+
+    if (lists_[OVERFLOW_LIST].head != NIL) {
+      Time width = SlotWidth(LEVELS - 1);
+      Time candidate = (now_ | (width - 1)) + 1;
+
+      if (!found || candidate < t) {
+        t = candidate;
+        found = true;
+      }
+    }
+
+    return found;
+  }
+
+  size_t TimerWheel::FireList(Time target) {
+    size_t fired = 0;
+
+    try {
+      while (lists_[FIRING_LIST].head != NIL) {
+        std::uint32_t i = lists_[FIRING_LIST].head;
+        Node& n = nodes_[i];
+
+        Unlink(i);
+
+        // Reschedule (or release) before calling back so that the callback
+        // sees a consistent wheel and may cancel or reschedule itself.
+        Callback c;
+        if (n.period) {
+          c = n.callback;
+
+          // Step from the deadline, not from now, so periodic timers don't
+          // drift; periods missed entirely are skipped rather than replayed.
+          // Missed means up to the time Advance is heading for: now_ is only
+          // the event being handled, & would bring the timer back round
+          // again before Advance returns.
+          Time next = n.deadline + n.period;
+          if (next <= target) {
+            next = target + n.period - (target - n.deadline) % n.period;
+          }
+          n.deadline = next;
+
+          Insert(i);
+        }
+        else {
+          c = std::move(n.callback);
+          Release(i);
+        }
+
+        ++fired;
+        c();
+      }
+    }
+    catch (...) {
+      Splice(FIRING_LIST, DUE_LIST);
+      throw;
+    }
+
+    return fired;
+  }
+
+  void TimerWheel::Insert(std::uint32_t i) {
+    Time deadline = nodes_[i].deadline;
+
+    if (deadline <= now_) {
+      PushBack(DUE_LIST, i);
+      return;
+    }
+
+    Time delta = deadline - now_;
+
+    for (unsigned level = 0; level < LEVELS; ++level) {
+      if (!(delta >> (LEVEL_BITS * (level + 1)))) {
+        unsigned slot = (unsigned) (deadline >> (LEVEL_BITS * level)) & (SLOTS - 1);
+        PushBack((std::uint16_t) (level * SLOTS + slot), i);
+        return;
+      }
+    }
+
+    PushBack(OVERFLOW_LIST, i);
+  }
+
+  void TimerWheel::Cascade(std::uint16_t list) {
+    std::uint32_t i = lists_[list].head;
+
+    lists_[list].head = lists_[list].tail = NIL;
+    if (list < DUE_LIST) {
+      occupied_[list / SLOTS] &= ~(std::uint64_t(1) << (list % SLOTS));
+    }
+
+    while (i != NIL) {
+      std::uint32_t next = nodes_[i].next;
+      Insert(i);
+      i = next;
+    }
+  }
+
+  void TimerWheel::PushBack(std::uint16_t list, std::uint32_t i) {
+    Node& n = nodes_[i];
+    List& l = lists_[list];
+
+    n.list = list;
+    n.next = NIL;
+    n.prev = l.tail;
+
+    if (l.tail != NIL) {
+      nodes_[l.tail].next = i;
+    }
+    else {
+      l.head = i;
+    }
+    l.tail = i;
+
+    if (list < DUE_LIST) {
+      occupied_[list / SLOTS] |= std::uint64_t(1) << (list % SLOTS);
+    }
+  }
+
+  void TimerWheel::Unlink(std::uint32_t i) {
+    Node& n = nodes_[i];
+    List& l = lists_[n.list];
+
+    if (n.prev != NIL) {
+      nodes_[n.prev].next = n.next;
+    }
+    else {
+      l.head = n.next;
+    }
+
+    if (n.next != NIL) {
+      nodes_[n.next].prev = n.prev;
+    }
+    else {
+      l.tail = n.prev;
+    }
+
+    if (l.head == NIL && n.list < DUE_LIST) {
+      occupied_[n.list / SLOTS] &= ~(std::uint64_t(1) << (n.list % SLOTS));
+    }
+
+    n.prev = n.next = NIL;
+  }
+
+  void TimerWheel::Splice(std::uint16_t from, std::uint16_t to) {
+    std::uint32_t i = lists_[from].head;
+
+    while (i != NIL) {
+      std::uint32_t next = nodes_[i].next;
+      Unlink(i);
+      PushBack(to, i);
+      i = next;
+    }
+  }
+
+  std::uint32_t TimerWheel::Allocate() {
+    std::uint32_t i;
+
+    if (freeList_ != NIL) {
+      i = freeList_;
+      freeList_ = nodes_[i].next;
+    }
+    else {
+      assert(nodes_.size() < NIL);
+
+      i = (std::uint32_t) nodes_.size();
+      nodes_.push_back(Node());
+      nodes_[i].generation = 1;
+    }
+
+    nodes_[i].prev = nodes_[i].next = NIL;
+    nodes_[i].list = FREE;
+    ++size_;
+
+    return i;
+  }
+
+  void TimerWheel::Release(std::uint32_t i) {
+    Node& n = nodes_[i];
+
+    n.callback = nullptr;
+    n.list = FREE;
+
+    // Invalidate outstanding ids. Generation 0 is skipped so that no valid id
+    // is ever equal to INVALID_TIMER.
+    if (++n.generation == 0) {
+      n.generation = 1;
+    }
+
+    n.next = freeList_;
+    freeList_ = i;
+    --size_;
+  }
+
+} // namespace jwt
\ No newline at end of file
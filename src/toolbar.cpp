@@ -19,14 +19,47 @@
 
 #include "libraries.hpp"
 #include "toolbar.hpp"
+#include "image-list-cache.hpp"
+#include <assert.h>
 
 namespace jwt {
 
-  Toolbar::Toolbar(Window& parent) {
+  namespace {
+    TBBUTTON ToTBButton(const ToolbarButton& b) {
+      if (b.separator) {
+        TBBUTTON sep = {
+          MAKELONG(0, 0),
+          NULL,
+          0,
+          TBSTYLE_SEP,
+          {},
+          0,
+          (INT_PTR)L""
+        };
+        return sep;
+      }
+
+      TBBUTTON tb = {
+        MAKELONG(b.subImgIndex, b.baseImgIndex),
+        b.id,
+        TBSTATE_ENABLED,
+        BTNS_AUTOSIZE,
+        { 0 }, 0,
+        (INT_PTR)b.label.c_str()
+      };
+      return tb;
+    }
+  }
+
+  Toolbar::Toolbar(Window& parent)
+    : nextImageList_(1)
+  {
     Create(parent);
   }
 
-  Toolbar::Toolbar(const defer_create_t&) {
+  Toolbar::Toolbar(const defer_create_t&)
+    : nextImageList_(1)
+  {
   }
 
   int Toolbar::AddStandardBitmap(UINT id) {
@@ -42,48 +75,69 @@ namespace jwt {
   }
 
   int Toolbar::AddBitmapResource(UINT id) {
+    // A null hInst makes nID a bitmap handle: the cached bitmap is shared
+    // with every other toolbar that adds it
+    ResourceRef bitmap = LoadBitmapResource(id);
+    assert(bitmap);
+
     TBADDBITMAP addBmp = {
-      GetModuleHandle(nullptr),
-      id
+      nullptr,
+      bitmap.Get()
     };
 
     int index = (int) SendMessage(hWnd_, TB_ADDBITMAP, 0, (WPARAM)&addBmp);
     assert(index != -1);
 
+    bitmaps_.push_back(std::move(bitmap));
     return index;
   }
 
 
-  Toolbar& Toolbar::AddButton(int baseImgIndex, int subImgIndex, int id, const std::wstring& label) {
-    TBBUTTON b = {
-      MAKELONG(subImgIndex, baseImgIndex),
-      id,
-      TBSTATE_ENABLED,
-      BTNS_AUTOSIZE,
-      { 0 }, 0,
-      (INT_PTR)label.c_str()
-    };
+  int Toolbar::AddSharedBitmap(UINT id, int imageWidth) {
+    HIMAGELIST list = SharedImageList(id, imageWidth);
 
+    int index = nextImageList_++;
+    SendMessage(hWnd_, TB_SETIMAGELIST, index, (LPARAM)list);
+
+    return index;
+  }
+
+  Toolbar& Toolbar::AddButton(int baseImgIndex, int subImgIndex, int id, const std::wstring& label) {
+    TBBUTTON b = ToTBButton(ToolbarButton(baseImgIndex, subImgIndex, id, label));
     SendMessage(hWnd_, TB_ADDBUTTONS, 1, (LPARAM)&b);
 
     return *this;
   }
 
   Toolbar& Toolbar::AddSeparator() {
-    TBBUTTON b = {
-      MAKELONG(0, 0),
-      NULL,
-      0,
-      TBSTYLE_SEP,
-      {},
-      0,
-      (INT_PTR)L""
-    };
+    TBBUTTON b = ToTBButton(ToolbarButton::Separator());
     SendMessage(hWnd_, TB_ADDBUTTONS, 1, (LPARAM)&b);
 
     return *this;
   }
 
+  Toolbar& Toolbar::AddButtons(const ToolbarButton* buttons, std::size_t count) {
+    if (count == 0) {
+      return *this;
+    }
+
+    std::vector<TBBUTTON> tb;
+    tb.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      tb.push_back(ToTBButton(buttons[i]));
+    }
+
+    RedrawLock lock(*this);
+    SendMessage(hWnd_, TB_ADDBUTTONS, tb.size(), (LPARAM)tb.data());
+
+    return *this;
+  }
+
+  Toolbar& Toolbar::AddButtons(const std::initializer_list<ToolbarButton>& l) {
+    return AddButtons(l.begin(), l.size());
+  }
+
   Toolbar& Toolbar::Autosize() {
     SendMessage(hWnd_, TB_AUTOSIZE, 0, 0);
     return *this;
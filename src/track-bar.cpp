@@ -23,20 +23,32 @@
 
 namespace jwt {
 
-  TrackBar::TrackBar(Window& parent) {
+  TrackBar::TrackBar(Window& parent)
+    : latest_(), latestDelivery_(TimerService::INVALID_TIMER)
+  {
     Create(parent);
   }
 
-  TrackBar::TrackBar(Dialog& parent, int ctrlId) {
+  TrackBar::TrackBar(Dialog& parent, int ctrlId)
+    : latest_(), latestDelivery_(TimerService::INVALID_TIMER)
+  {
     hWnd_ = parent.Item(ctrlId);
     
     assert(hWnd_ != nullptr);
-    assert(ClassName(*this) == TRACKBAR_CLASS);
+    assert(HasClass(*this, TRACKBAR_CLASS));
 
     SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) this);
   }
 
-  TrackBar::TrackBar(const defer_create_t&) {
+  TrackBar::TrackBar(const defer_create_t&)
+    : latest_(), latestDelivery_(TimerService::INVALID_TIMER)
+  {
+  }
+
+  TrackBar::~TrackBar() {
+    if (latestDelivery_ != TimerService::INVALID_TIMER) {
+      OwningPump().CancelTimer(latestDelivery_);
+    }
   }
 
   void TrackBar::Create(Window& parent) {
@@ -54,13 +66,54 @@ namespace jwt {
     switch (m) {
     case WM_HSCROLL:
     case WM_VSCROLL:
-      onChange_();
+      Setters().Forget(SetterCache::VALUE);
+
+      // Nobody is listening; SetValue stops caching until somebody is
+      if (!Watched()) {
+        Unreflect<TrackBar>(REFLECT_SCROLL);
+        break;
+      }
+
+      if (!onChange_.empty()) {
+        onChange_();
+      }
+
+      if (!onLatestChange_.empty()) {
+        QueueLatest(ScrollMsg(m, w, l));
+      }
+      break;
+
+    default:
+      Unreflect<TrackBar>(ReflectFlag(m));
       break;
     }
 
     return 0;
   }
 
+  void TrackBar::QueueLatest(const ScrollMsg& s) {
+    // TB_THUMBPOSITION & TB_ENDTRACK mark the end of a drag or key press;
+    // everything else is an intermediate position. The position in the
+    // message is only 16 bits, so ask the control.
+    latest_.value = GetValue(*this);
+    latest_.tracking = (s.action != TB_THUMBPOSITION && s.action != TB_ENDTRACK);
+
+    // A zero-delay timer only fires once Pump() has run out of messages, by
+    // which time every queued notification has been folded into latest_.
+    if (latestDelivery_ == TimerService::INVALID_TIMER) {
+      latestDelivery_ = OwningPump().Timers().Once(0, [this]() {
+        DeliverLatest();
+      });
+    }
+  }
+
+  void TrackBar::DeliverLatest() {
+    latestDelivery_ = TimerService::INVALID_TIMER;
+
+    TrackChange c = latest_;
+    onLatestChange_(c);
+  }
+
   //
   // Non-member trackbar functions
   //
@@ -73,15 +126,36 @@ namespace jwt {
   TrackBar& SetValue(TrackBar& b, int value) {
     assert(b.TheHWND());
 
+    // The cached position is only good while scroll notifications tell us
+    // when the user moves the thumb, which is while somebody is listening
+    if (!b.Watched()) {
+      SendMessage(b.TheHWND(), TBM_SETPOS, true, value);
+      return b;
+    }
+
+    if (b.Setters().Skip(SetterCache::VALUE, (std::uint32_t) value)) {
+      return b;
+    }
+
     SendMessage(b.TheHWND(), TBM_SETPOS, true, value);
+    b.Setters().Store(SetterCache::VALUE, (std::uint32_t) value);
     return b;
   }
 
   TrackBar& SetRange(TrackBar& b, int min, int max) {
     assert(b.TheHWND());
 
+    std::uint64_t range = SetterCache::Pack(min, max);
+    if (b.Setters().Skip(SetterCache::RANGE, range)) {
+      return b;
+    }
+
     SendMessage(b.TheHWND(), TBM_SETRANGEMIN, false, min);
     SendMessage(b.TheHWND(), TBM_SETRANGEMAX, true, max);
+    b.Setters().Store(SetterCache::RANGE, range);
+
+    // The control clamps its position to the new range
+    b.Setters().Forget(SetterCache::VALUE);
     return b;
   }
 
@@ -20,20 +20,242 @@
 #include "libraries.hpp"
 #include "window.hpp"
 #include "message-pump.hpp"
+#include "messages.hpp"
+#include <algorithm>
+#include <unordered_map>
 #include <assert.h>
 
 namespace jwt {
+
+  namespace {
+    // Pending windows, keyed by the hidden ancestor they are waiting on.
+    // Leaked, so that static windows can still unregister themselves after
+    // thread-local destruction has begun.
+    typedef std::unordered_map<HWND, std::vector<Window*>> WaitingMap;
+
+    WaitingMap& Waiting() {
+      thread_local WaitingMap* waiting = new WaitingMap();
+      return *waiting;
+    }
+
+    // The nearest of h & its ancestors without WS_VISIBLE, or nullptr if
+    // they are all visible. shown is taken to be visible already; it is
+    // being shown, but may not have its style updated yet.
+    HWND HiddenAncestor(HWND h, HWND shown) {
+      for (; h; h = GetAncestor(h, GA_PARENT)) {
+        if (h != shown && !(GetWindowLong(h, GWL_STYLE) & WS_VISIBLE)) {
+          return h;
+        }
+      }
+      return nullptr;
+    }
+
+    // Numbers pending windows in creation order (see RealizeWaitingOn)
+    std::uint64_t NextPendingOrder() {
+      thread_local std::uint64_t next = 0;
+      return next++;
+    }
+
+    void StopWaiting(HWND gate, Window* w) {
+      auto i = Waiting().find(gate);
+      if (i == Waiting().end()) {
+        return;
+      }
+
+      // Search from the back: windows are usually destroyed in the reverse
+      // of the order they were created in
+      std::vector<Window*>& v = i->second;
+      auto j = std::find(v.rbegin(), v.rend(), w);
+      if (j != v.rend()) {
+        v.erase(std::next(j).base());
+      }
+
+      if (v.empty()) {
+        Waiting().erase(i);
+      }
+    }
+  }
+
   //
   // **************************************************
   // Window member function definitions
   // **************************************************
   //
 
+  Window::~Window() {
+    lifetime_.Cancel();
+
+    // Controls point their GWLP_USERDATA at their wrapper so that parents
+    // can reflect notifications to it; don't leave that dangling if the
+    // control outlives the wrapper
+    if (hWnd_ && GetWindowLongPtr(hWnd_, GWLP_USERDATA) == (LONG_PTR) this) {
+      SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) nullptr);
+    }
+
+    if (pending_) {
+      StopWaiting(pending_->gate, this);
+    }
+  }
+
+  void Window::CreateLazily(Window& parent, const wchar_t* className, DWORD style, DWORD exStyle, int id) {
+    assert(hWnd_ == nullptr && !pending_);
+
+    pending_.reset(new PendingWindow());
+    pending_->className = className;
+    pending_->order = NextPendingOrder();
+    pending_->dead = false;
+    pending_->id = id;
+    pending_->style = style;
+    pending_->exStyle = exStyle;
+
+    // A child of a dead window is born dead
+    const PendingWindow* pp = parent.Pending();
+    if (pp && pp->dead) {
+      pending_->parent = nullptr;
+      pending_->gate = nullptr;
+      pending_->dead = true;
+      return;
+    }
+
+    HWND p = parent.TheHWND();
+    assert(p != nullptr);
+
+    pending_->parent = p;
+    pending_->gate = HiddenAncestor(p, nullptr);
+
+    if (pending_->gate) {
+      Waiting()[pending_->gate].push_back(this);
+    }
+    else {
+      Realize();
+    }
+  }
+
+  void Window::Realize() {
+    // A dead window's parent was destroyed while it waited; there is
+    // nothing left to create the HWND in
+    if (!pending_ || pending_->dead) {
+      return;
+    }
+
+    // Clear pending_ first, so that TheHWND() called from inside
+    // CreateWindowEx doesn't come back here
+    std::unique_ptr<PendingWindow> p = std::move(pending_);
+
+    if (p->gate) {
+      StopWaiting(p->gate, this);
+    }
+
+    const Rect& r = p->bounds;
+    hWnd_ = CreateWindowEx(
+      p->exStyle, p->className, p->text.c_str(), p->style,
+      r.position.x, r.position.y, r.size.w, r.size.h,
+      p->parent, (HMENU) (INT_PTR) p->id, nullptr, nullptr
+    );
+    assert(hWnd_ != nullptr);
+
+    SetWindowLongPtr(hWnd_, GWLP_USERDATA, (LONG_PTR) this);
+  }
+
+  void Window::RealizeWaitingOn(HWND h) {
+    auto i = Waiting().find(h);
+    if (i == Waiting().end()) {
+      return;
+    }
+
+    std::vector<Window*> windows;
+    windows.swap(i->second);
+    Waiting().erase(i);
+
+    // Lists are kept in creation order, which is the order siblings are
+    // realized in & so their z-order. Windows moved to another gate's list
+    // are appended for now & the lists they went to re-sorted after.
+    std::vector<HWND> regated;
+
+    for (Window* w : windows) {
+      // Creating an earlier one may have realized this one already (its
+      // WM_CREATE handler asked for TheHWND)
+      if (!w->pending_ || w->pending_->dead) {
+        continue;
+      }
+
+      // A window further up may still be hiding it; wait on that instead
+      HWND gate = HiddenAncestor(w->pending_->parent, h);
+
+      if (gate) {
+        w->pending_->gate = gate;
+        Waiting()[gate].push_back(w);
+        regated.push_back(gate);
+      }
+      else {
+        w->pending_->gate = nullptr;
+        w->Realize();
+      }
+    }
+
+    std::sort(begin(regated), end(regated));
+    regated.erase(std::unique(begin(regated), end(regated)), end(regated));
+
+    for (HWND gate : regated) {
+      auto j = Waiting().find(gate);
+      if (j != Waiting().end()) {
+        std::stable_sort(begin(j->second), end(j->second), [](const Window* a, const Window* b) {
+          return a->pending_->order < b->pending_->order;
+        });
+      }
+    }
+  }
+
+  void Window::ForgetWaitingOn(HWND h) {
+    auto i = Waiting().find(h);
+    if (i == Waiting().end()) {
+      return;
+    }
+
+    // Left pending, so their getters & setters still work on the record;
+    // they just can't be realized any more
+    for (Window* w : i->second) {
+      w->pending_->gate = nullptr;
+      w->pending_->parent = nullptr;
+      w->pending_->dead = true;
+    }
+
+    Waiting().erase(i);
+  }
+
+  unsigned int Window::ReflectFlag(UINT m) {
+    switch (m) {
+    case WM_COMMAND:
+      return REFLECT_COMMAND;
+
+    case WM_VSCROLL:
+    case WM_HSCROLL:
+      return REFLECT_SCROLL;
+
+    case WM_NOTIFY:
+      return REFLECT_NOTIFY;
+
+    case WM_DRAWITEM:
+      return REFLECT_DRAW;
+
+    default:
+      return REFLECT_NONE;
+    }
+  }
+
   LRESULT Window::ReflectMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
     Window* wnd = nullptr;
+    UINT code = 0;
 
     switch (m) {
     case WM_COMMAND:
+      // Menus & accelerators have no control to reflect to
+      if (l) {
+        wnd = (Window*)GetWindowLongPtr((HWND)l, GWLP_USERDATA);
+        code = CommandMsg(w, l).code;
+      }
+      break;
+
     case WM_VSCROLL:
     case WM_HSCROLL:
       if (l) {
@@ -42,8 +264,18 @@ namespace jwt {
       break;
 
     case WM_NOTIFY: {
-      NMHDR* hdr = (NMHDR*)l;
-      wnd = (Window*)GetWindowLongPtr(hdr->hwndFrom, GWLP_USERDATA);
+      NotifyMsg<> n(w, l);
+      wnd = (Window*)GetWindowLongPtr(n.From(), GWLP_USERDATA);
+      code = n.Code();
+    }
+    break;
+
+    case WM_DRAWITEM: {
+      // For menus hwndItem is an HMENU, not a window
+      const DRAWITEMSTRUCT* d = (const DRAWITEMSTRUCT*)l;
+      if (d->CtlType != ODT_MENU) {
+        wnd = (Window*)GetWindowLongPtr(d->hwndItem, GWLP_USERDATA);
+      }
     }
     break;
 
@@ -51,12 +283,24 @@ namespace jwt {
       assert(false);
     }
 
-    if (wnd) {
-      return wnd->HandleReflectedMessage(h, m, w, l);
+    if (!wnd) {
+      return 0;
     }
-    else {
+
+    // Checked here rather than in the wrapper to save the virtual call
+    unsigned int flag = ReflectFlag(m);
+    if (!(wnd->reflect_ & flag)) {
       return 0;
     }
+
+    if (wnd->narrowed_ & flag) {
+      UINT wanted = (flag == REFLECT_COMMAND) ? wnd->commandCode_ : wnd->notifyCode_;
+      if (code != wanted) {
+        return 0;
+      }
+    }
+
+    return wnd->HandleReflectedMessage(h, m, w, l);
   }
 
   LRESULT Window::HandleReflectedMessage(HWND h, UINT m, WPARAM w, LPARAM l) {
@@ -72,18 +316,28 @@ namespace jwt {
   //
 
   LRESULT SafeSendMessage(Window& wnd, UINT m, WPARAM w, LPARAM l) {
+    // Note: we raise on the *calling* thread's pump, not wnd.OwningPump().
+    // If wnd belongs to another thread its handlers ran there & any
+    // exception was reported to (and will be raised by) that thread's pump.
+    //
     LRESULT lr = SendMessage(wnd.TheHWND(), m, w, l);
     DefaultPump().RaiseReportedException();
     return lr;
   }
 
   LRESULT SafeSendMessage(const Window& wnd, UINT m, WPARAM w, LPARAM l) {
+    assert(wnd.TheHWND() != nullptr);
+
     LRESULT lr = SendMessage(wnd.TheHWND(), m, w, l);
     DefaultPump().RaiseReportedException();
     return lr;
   }
 
   std::wstring ClassName(const Window& w) {
+    if (const PendingWindow* p = w.Pending()) {
+      return p->className;
+    }
+
     assert(w.TheHWND() != nullptr);
 
     // FIXME: currently implemented using a fixed-size buffer.
@@ -94,7 +348,49 @@ namespace jwt {
     return buffer;
   }
 
+  namespace {
+    // Class names are a handful of literals, so a linear search by pointer
+    // is enough; the same name at two addresses just gets two entries.
+    ATOM ClassAtom(const wchar_t* clsName) {
+      thread_local std::vector<std::pair<const wchar_t*, ATOM>> atoms;
+
+      for (const auto& a : atoms) {
+        if (a.first == clsName) {
+          return a.second;
+        }
+      }
+
+      WNDCLASSEX wc = {};
+      wc.cbSize = sizeof(wc);
+      ATOM atom = (ATOM) GetClassInfoEx(nullptr, clsName, &wc);
+
+      atoms.push_back(std::make_pair(clsName, atom));
+      return atom;
+    }
+  }
+
+  bool HasClass(const Window& w, const wchar_t* clsName) {
+    if (const PendingWindow* p = w.Pending()) {
+      return lstrcmpi(p->className, clsName) == 0;
+    }
+
+    assert(w.TheHWND() != nullptr);
+
+    ATOM atom = ClassAtom(clsName);
+    if (atom != 0 && atom == GetClassWord(w.TheHWND(), GCW_ATOM)) {
+      return true;
+    }
+
+    // Not registered by the system (atom 0), or registered under a versioned
+    // name by a side-by-side comctl32: fall back to comparing names.
+    return lstrcmpi(ClassName(w).c_str(), clsName) == 0;
+  }
+
   Dimension GetSize(const Window& w) {
+    if (const PendingWindow* p = w.Pending()) {
+      return p->bounds.size;
+    }
+
     assert(w.TheHWND() != nullptr);
 
     RECT r;
@@ -103,6 +399,11 @@ namespace jwt {
   }
 
   Window& SetSize(Window& w, const Dimension& d) {
+    if (PendingWindow* p = w.Pending()) {
+      p->bounds.size = d;
+      return w;
+    }
+
     assert(w.TheHWND() != nullptr);
 
     SetWindowPos(
@@ -158,6 +459,10 @@ namespace jwt {
   }
 
   Point GetPosition(const Window& w) {
+    if (const PendingWindow* p = w.Pending()) {
+      return p->bounds.position;
+    }
+
     assert(w.TheHWND() != nullptr);
 
     RECT r = {};
@@ -178,6 +483,11 @@ namespace jwt {
   }
 
   Window& SetPosition(Window& w, const Point& p) {
+    if (PendingWindow* pw = w.Pending()) {
+      pw->bounds.position = p;
+      return w;
+    }
+
     assert(w.TheHWND() != nullptr);
 
     SetWindowPos(
@@ -189,6 +499,10 @@ namespace jwt {
   }
 
   Rect GetBounds(const Window& w) {
+    if (const PendingWindow* p = w.Pending()) {
+      return p->bounds;
+    }
+
     assert(w.TheHWND() != nullptr);
 
     // GetWindowRect always returns screen coordinates, however we try
@@ -217,6 +531,11 @@ namespace jwt {
   }
 
   Window& SetBounds(Window& w, const Rect& r) {
+    if (PendingWindow* p = w.Pending()) {
+      p->bounds = r;
+      return w;
+    }
+
     assert(w.TheHWND() != nullptr);
 
     SetWindowPos(
@@ -242,6 +561,10 @@ namespace jwt {
     // (b) If a non-empty string was returned, the string is resized to lose the
     //     final character.
 
+    if (const PendingWindow* p = w.Pending()) {
+      return p->text;
+    }
+
     assert(w.TheHWND() != nullptr);
 
     std::wstring txt(GetWindowTextLength(w.TheHWND()) + 1, ' ');
@@ -255,22 +578,96 @@ namespace jwt {
   }
 
   Window& SetText(Window& w, const std::wstring& s) {
+    if (PendingWindow* p = w.Pending()) {
+      p->text = s;
+      return w;
+    }
+
     assert(w.TheHWND() != nullptr);
 
+    std::uint64_t h = SetterCache::Hash(s);
+    if (w.Setters().Skip(SetterCache::TEXT, h)) {
+      return w;
+    }
+
     SetWindowText(w.TheHWND(), s.c_str());
+    w.Setters().Store(SetterCache::TEXT, h);
     return w;
   }
 
-  bool IsVisible(const Window& w) {
+  int ControlId(const Window& w) {
+    if (const PendingWindow* p = w.Pending()) {
+      return p->id;
+    }
+
+    assert(w.TheHWND() != nullptr);
+    return (int) GetWindowLongPtr(w.TheHWND(), GWLP_ID);
+  }
+
+  Window& SetControlId(Window& w, int id) {
+    if (PendingWindow* p = w.Pending()) {
+      p->id = id;
+      return w;
+    }
+
     assert(w.TheHWND() != nullptr);
 
+    SetWindowLongPtr(w.TheHWND(), GWLP_ID, (LONG_PTR) id);
+    return w;
+  }
+
+  Window& Resync(Window& w) {
+    w.Setters().Clear();
+    return w;
+  }
+
+  RedrawLock::RedrawLock(Window& w)
+    : w_(w), active_(false)
+  {
+    assert(w.TheHWND() != nullptr);
+
+    if (w.redrawLocks_ > 0) {
+      ++w.redrawLocks_;
+      active_ = true;
+    }
+    else if (IsWindowVisible(w.TheHWND())) {
+      SendMessage(w.TheHWND(), WM_SETREDRAW, FALSE, 0);
+      w.redrawLocks_ = 1;
+      active_ = true;
+    }
+  }
+
+  RedrawLock::~RedrawLock() {
+    if (active_ && --w_.redrawLocks_ == 0) {
+      SendMessage(w_.TheHWND(), WM_SETREDRAW, TRUE, 0);
+      RedrawWindow(w_.TheHWND(), nullptr, nullptr,
+        RDW_ERASE | RDW_FRAME | RDW_INVALIDATE | RDW_ALLCHILDREN);
+    }
+  }
+
+  bool IsVisible(const Window& w) {
     return !!(Style(w) & WS_VISIBLE);
   }
 
   Window& SetVisible(Window& w, bool visible) {
+    if (PendingWindow* p = w.Pending()) {
+      p->style = (visible) ? (p->style | WS_VISIBLE) : (p->style & ~WS_VISIBLE);
+
+      // Still pending means an ancestor is hidden, & its showing will
+      // realize w; unless it has been shown by other means since. A dead
+      // window can't be shown at all.
+      if (!visible || p->dead || HiddenAncestor(p->parent, nullptr)) {
+        return w;
+      }
+    }
+
     assert(w.TheHWND() != nullptr);
 
     ShowWindow(w.TheHWND(), (visible) ? SW_SHOWNORMAL : SW_HIDE);
+
+    if (visible) {
+      Window::RealizeWaitingOn(w.TheHWND());
+    }
     return w;
   }
 
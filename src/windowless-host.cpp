@@ -0,0 +1,364 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "libraries.hpp"
+#include "windowless-host.hpp"
+#include <assert.h>
+
+namespace jwt {
+
+  namespace {
+    RECT ToRECT(const WindowlessModel::Box& b) {
+      RECT r = {
+        b.x, b.y, b.x + b.w, b.y + b.h
+      };
+      return r;
+    }
+  }
+
+  const wchar_t* WindowlessHost::CLASS_NAME = L"WindowlessHost::CLASS_NAME";
+
+  void WindowlessHost::Register() {
+    CustomWindow<WindowlessHost>::Register(CLASS_NAME);
+  }
+
+  WindowlessHost::WindowlessHost(Window& parent)
+    : painter_(DrawControl), hot_(WindowlessModel::INVALID_ID), pressed_(WindowlessModel::INVALID_ID),
+      trackingLeave_(false)
+  {
+    Create(parent);
+  }
+
+  WindowlessHost::WindowlessHost(const defer_create_t&)
+    : painter_(DrawControl), hot_(WindowlessModel::INVALID_ID), pressed_(WindowlessModel::INVALID_ID),
+      trackingLeave_(false)
+  {
+  }
+
+  void WindowlessHost::Create(Window& parent) {
+    Register();
+    CreateWindow(CLASS_NAME, L"",
+      WS_VISIBLE | WS_CHILD | WS_TABSTOP,
+      0, 0, 0, 0,
+      parent.TheHWND(), nullptr, GetModuleHandle(nullptr), (LPVOID) this
+    );
+    OwningPump().RaiseReportedException();
+
+    assert(hWnd_);
+  }
+
+  void WindowlessHost::Update() {
+    if (!model_.Dirty()) {
+      return;
+    }
+
+    dirty_.clear();
+    model_.TakeDirty(dirty_);
+
+    for (const auto& b : dirty_) {
+      // Take in the focus rectangle, which is drawn just outside the bounds
+      RECT r = ToRECT(b);
+      InflateRect(&r, 2, 2);
+      InvalidateRect(hWnd_, &r, FALSE);
+    }
+  }
+
+  void WindowlessHost::SetPainter(Painter p) {
+    painter_ = (p) ? p : Painter(DrawControl);
+    InvalidateRect(hWnd_, nullptr, FALSE);
+  }
+
+  LRESULT WindowlessHost::WndProc(HWND h, UINT m, WPARAM w, LPARAM l) {
+    switch (m) {
+    case WM_PAINT:
+      Paint();
+      return 0;
+
+    case WM_ERASEBKGND:
+      // Paint() fills the background as part of the buffered frame
+      return 1;
+
+    case WM_MOUSEMOVE:
+      MouseMove(GET_X_LPARAM(l), GET_Y_LPARAM(l));
+      return 0;
+
+    case WM_MOUSELEAVE:
+      trackingLeave_ = false;
+      MouseLeave();
+      return 0;
+
+    case WM_LBUTTONDOWN:
+      ButtonDown(GET_X_LPARAM(l), GET_Y_LPARAM(l));
+      return 0;
+
+    case WM_LBUTTONUP:
+      ButtonUp(GET_X_LPARAM(l), GET_Y_LPARAM(l));
+      return 0;
+
+    case WM_CAPTURECHANGED:
+      if ((HWND) l != h && model_.Valid(pressed_)) {
+        model_.SetState(pressed_, WindowlessModel::PRESSED, false);
+        pressed_ = WindowlessModel::INVALID_ID;
+        Update();
+      }
+      return 0;
+
+    case WM_GETDLGCODE: {
+      // Keep Tab while there is another control to move to in that
+      // direction; at either end let the dialog move on to the next window
+      // rather than wrapping round inside the host
+      LRESULT code = DLGC_WANTARROWS | DLGC_WANTCHARS;
+      const MSG* msg = (const MSG*) l;
+
+      if (msg && msg->message == WM_KEYDOWN && msg->wParam == VK_TAB) {
+        bool backwards = GetKeyState(VK_SHIFT) < 0;
+        if (model_.NextFocus(backwards, false) != WindowlessModel::INVALID_ID) {
+          code |= DLGC_WANTTAB;
+        }
+      }
+      return code;
+    }
+
+    case WM_KEYDOWN:
+      KeyDown(w);
+      return 0;
+
+    case WM_SETFOCUS:
+      // Tabbed into: start from the first control (or the last, for
+      // Shift+Tab), as if each were a window in the tab order
+      if (GetKeyState(VK_TAB) < 0) {
+        model_.SetFocus(WindowlessModel::INVALID_ID);
+        model_.FocusNext(GetKeyState(VK_SHIFT) < 0);
+        Update();
+      }
+      InvalidateFocus();
+      return 0;
+
+    case WM_KILLFOCUS:
+      InvalidateFocus();
+      return 0;
+    }
+
+    return CustomWindow<WindowlessHost>::WndProc(h, m, w, l);
+  }
+
+  void WindowlessHost::InvalidateFocus() {
+    // The focus rectangle is only drawn while the host has the focus
+    if (model_.Valid(model_.Focus())) {
+      RECT r = ToRECT(model_.Bounds(model_.Focus()));
+      InflateRect(&r, 2, 2);
+      InvalidateRect(hWnd_, &r, FALSE);
+    }
+  }
+
+  void WindowlessHost::Paint() {
+    PAINTSTRUCT ps;
+    HDC dc = BeginPaint(hWnd_, &ps);
+
+    const RECT& rc = ps.rcPaint;
+    int w = rc.right - rc.left;
+    int h = rc.bottom - rc.top;
+
+    if (w > 0 && h > 0) {
+      // Draw the whole update region off-screen in client coordinates &
+      // copy it in one go, so overlapping controls never flicker
+      HDC mem = CreateCompatibleDC(dc);
+      HBITMAP bmp = CreateCompatibleBitmap(dc, w, h);
+      HGDIOBJ oldBmp = SelectObject(mem, bmp);
+      HGDIOBJ oldFont = SelectObject(mem, GetStockObject(DEFAULT_GUI_FONT));
+
+      SetViewportOrgEx(mem, -rc.left, -rc.top, nullptr);
+      FillRect(mem, &rc, GetSysColorBrush(COLOR_BTNFACE));
+      SetBkMode(mem, TRANSPARENT);
+
+      WindowlessModel::Box area = {
+        rc.left, rc.top, w, h
+      };
+      model_.Query(area, visible_);
+
+      WindowlessModel::Id focus = (GetFocus() == hWnd_) ? model_.Focus() : WindowlessModel::INVALID_ID;
+
+      for (WindowlessModel::Id id : visible_) {
+        painter_(mem, model_, id, ToRECT(model_.Bounds(id)), id == focus);
+      }
+
+      BitBlt(dc, rc.left, rc.top, w, h, mem, rc.left, rc.top, SRCCOPY);
+
+      SelectObject(mem, oldFont);
+      SelectObject(mem, oldBmp);
+      DeleteObject(bmp);
+      DeleteDC(mem);
+    }
+
+    EndPaint(hWnd_, &ps);
+  }
+
+  void WindowlessHost::DrawControl(HDC dc, const WindowlessModel& m, WindowlessModel::Id id, const RECT& bounds, bool focused) {
+    RECT r = bounds;
+    unsigned int state = m.State(id);
+    bool enabled = !!(state & WindowlessModel::ENABLED);
+
+    UINT frame = (enabled) ? 0 : DFCS_INACTIVE;
+    if (state & WindowlessModel::HOT) {
+      frame |= DFCS_HOT;
+    }
+
+    UINT format = DT_SINGLELINE | DT_VCENTER | DT_NOPREFIX | DT_END_ELLIPSIS;
+    SetTextColor(dc, GetSysColor((enabled) ? COLOR_BTNTEXT : COLOR_GRAYTEXT));
+
+    const std::wstring& text = m.Text(id);
+
+    switch (m.Kind(id)) {
+    case WindowlessModel::PUSH_BUTTON:
+      DrawFrameControl(dc, &r, DFC_BUTTON,
+        DFCS_BUTTONPUSH | frame | ((state & WindowlessModel::PRESSED) ? DFCS_PUSHED : 0));
+      DrawText(dc, text.c_str(), (int) text.size(), &r, format | DT_CENTER);
+      break;
+
+    case WindowlessModel::CHECK_BOX: {
+      int side = (std::min)((int) (r.bottom - r.top), 13);
+      RECT box = {
+        r.left, r.top + (r.bottom - r.top - side) / 2, r.left + side, 0
+      };
+      box.bottom = box.top + side;
+
+      DrawFrameControl(dc, &box, DFC_BUTTON,
+        DFCS_BUTTONCHECK | frame | ((state & WindowlessModel::CHECKED) ? DFCS_CHECKED : 0));
+
+      r.left += side + 4;
+      DrawText(dc, text.c_str(), (int) text.size(), &r, format | DT_LEFT);
+    }
+    break;
+
+    case WindowlessModel::LABEL:
+      DrawText(dc, text.c_str(), (int) text.size(), &r, format | DT_LEFT);
+      break;
+    }
+
+    if (focused) {
+      RECT f = bounds;
+      InflateRect(&f, 1, 1);
+      DrawFocusRect(dc, &f);
+    }
+  }
+
+  void WindowlessHost::MouseMove(int x, int y) {
+    if (!trackingLeave_) {
+      TRACKMOUSEEVENT t = {};
+      t.cbSize = sizeof(t);
+      t.dwFlags = TME_LEAVE;
+      t.hwndTrack = hWnd_;
+
+      trackingLeave_ = !!TrackMouseEvent(&t);
+    }
+
+    WindowlessModel::Id id = model_.HitTest(x, y);
+
+    // While a control is pressed, only it can be hot
+    if (model_.Valid(pressed_) && id != pressed_) {
+      id = WindowlessModel::INVALID_ID;
+    }
+
+    SetHot(id);
+    Update();
+  }
+
+  void WindowlessHost::MouseLeave() {
+    SetHot(WindowlessModel::INVALID_ID);
+    Update();
+  }
+
+  void WindowlessHost::ButtonDown(int x, int y) {
+    if (GetFocus() != hWnd_) {
+      ::SetFocus(hWnd_);
+    }
+
+    WindowlessModel::Id id = model_.HitTest(x, y);
+
+    if (id != WindowlessModel::INVALID_ID && model_.Has(id, WindowlessModel::ENABLED)) {
+      pressed_ = id;
+      model_.SetState(id, WindowlessModel::PRESSED, true);
+      model_.SetFocus(id);
+      SetCapture(hWnd_);
+    }
+
+    Update();
+  }
+
+  void WindowlessHost::ButtonUp(int x, int y) {
+    WindowlessModel::Id id = pressed_;
+
+    if (!model_.Valid(id)) {
+      return;
+    }
+
+    // Clear first: ReleaseCapture sends WM_CAPTURECHANGED
+    pressed_ = WindowlessModel::INVALID_ID;
+    model_.SetState(id, WindowlessModel::PRESSED, false);
+    ReleaseCapture();
+
+    if (model_.HitTest(x, y) == id) {
+      Activate(id);
+    }
+
+    Update();
+  }
+
+  void WindowlessHost::KeyDown(WPARAM vk) {
+    switch (vk) {
+    case VK_TAB:
+      model_.FocusNext(GetKeyState(VK_SHIFT) < 0);
+      break;
+
+    case VK_SPACE:
+    case VK_RETURN:
+      if (model_.Valid(model_.Focus())) {
+        Activate(model_.Focus());
+      }
+      break;
+    }
+
+    Update();
+  }
+
+  void WindowlessHost::Activate(WindowlessModel::Id id) {
+    if (model_.Kind(id) == WindowlessModel::CHECK_BOX) {
+      model_.SetState(id, WindowlessModel::CHECKED, !model_.Has(id, WindowlessModel::CHECKED));
+    }
+
+    onClick_(id);
+  }
+
+  void WindowlessHost::SetHot(WindowlessModel::Id id) {
+    if (id == hot_) {
+      return;
+    }
+
+    if (model_.Valid(hot_)) {
+      model_.SetState(hot_, WindowlessModel::HOT, false);
+    }
+
+    hot_ = id;
+
+    if (model_.Valid(id) && model_.Has(id, WindowlessModel::ENABLED)) {
+      model_.SetState(id, WindowlessModel::HOT, true);
+    }
+  }
+
+} // namespace jwt
\ No newline at end of file
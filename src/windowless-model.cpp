@@ -0,0 +1,372 @@
+/*
+  James' Windows Toolkit (JWT)
+  Copyright (C) 2017 James Heggie
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "windowless-model.hpp"
+#include <algorithm>
+#include <assert.h>
+
+namespace jwt {
+
+  const WindowlessModel::Id WindowlessModel::INVALID_ID;
+
+  WindowlessModel::WindowlessModel()
+    : count_(0), nextZ_(0), query_(0), focus_(INVALID_ID)
+  {}
+
+  WindowlessModel::Id WindowlessModel::Add(unsigned int kind, const Box& bounds, const std::wstring& text) {
+    Slot s;
+
+    if (!free_.empty()) {
+      s = free_.back();
+      free_.pop_back();
+    }
+    else {
+      s = (Slot) bounds_.size();
+      bounds_.push_back(Box());
+      state_.push_back(0);
+      kind_.push_back(0);
+      z_.push_back(0);
+      generation_.push_back(0);
+      text_.push_back(std::wstring());
+      stamp_.push_back(0);
+    }
+
+    bounds_[s] = bounds;
+    kind_[s] = kind;
+    z_[s] = nextZ_++;
+    text_[s] = text;
+    state_[s] = ALIVE | VISIBLE | ENABLED | ((kind != LABEL) ? FOCUSABLE : 0);
+
+    ++count_;
+    Index(s, true);
+    MarkDirty(s);
+
+    return IdOf(s);
+  }
+
+  void WindowlessModel::Remove(Id id) {
+    if (!Valid(id)) {
+      return;
+    }
+
+    Slot s = SlotOf(id);
+
+    Index(s, false);
+    MarkDirty(s);
+
+    if (focus_ == id) {
+      focus_ = INVALID_ID;
+    }
+
+    state_[s] = 0;
+    text_[s].clear();
+    ++generation_[s];
+    free_.push_back(s);
+    --count_;
+  }
+
+  void WindowlessModel::Clear() {
+    for (Slot s = 0; s < bounds_.size(); ++s) {
+      if (state_[s] & ALIVE) {
+        Remove(IdOf(s));
+      }
+    }
+  }
+
+  bool WindowlessModel::Valid(Id id) const {
+    Slot s = (Slot) (id & 0xFFFFFFFFu);
+
+    return id != INVALID_ID && s < bounds_.size() &&
+      generation_[s] == (std::uint32_t) (id >> 32) && (state_[s] & ALIVE);
+  }
+
+  WindowlessModel::Slot WindowlessModel::SlotOf(Id id) const {
+    assert(Valid(id));
+    return (Slot) (id & 0xFFFFFFFFu);
+  }
+
+  unsigned int WindowlessModel::Kind(Id id) const {
+    return kind_[SlotOf(id)];
+  }
+
+  const WindowlessModel::Box& WindowlessModel::Bounds(Id id) const {
+    return bounds_[SlotOf(id)];
+  }
+
+  void WindowlessModel::SetBounds(Id id, const Box& b) {
+    Slot s = SlotOf(id);
+
+    if (bounds_[s] == b) {
+      return;
+    }
+
+    Index(s, false);
+    MarkDirty(s);
+
+    bounds_[s] = b;
+
+    Index(s, true);
+    MarkDirty(s);
+  }
+
+  unsigned int WindowlessModel::State(Id id) const {
+    return state_[SlotOf(id)] & ~ALIVE;
+  }
+
+  void WindowlessModel::SetState(Id id, unsigned int state, bool on) {
+    Slot s = SlotOf(id);
+    state &= ~ALIVE;
+
+    std::uint32_t next = (on) ? (state_[s] | state) : (state_[s] & ~state);
+    if (next == state_[s]) {
+      return;
+    }
+
+    state_[s] = next;
+    MarkDirty(s);
+
+    if (focus_ == id && !CanFocus(s)) {
+      focus_ = INVALID_ID;
+    }
+  }
+
+  const std::wstring& WindowlessModel::Text(Id id) const {
+    return text_[SlotOf(id)];
+  }
+
+  void WindowlessModel::SetText(Id id, const std::wstring& text) {
+    Slot s = SlotOf(id);
+
+    if (text_[s] != text) {
+      text_[s] = text;
+      MarkDirty(s);
+    }
+  }
+
+  void WindowlessModel::BringToFront(Id id) {
+    Slot s = SlotOf(id);
+
+    if (z_[s] + 1 != nextZ_) {
+      z_[s] = nextZ_++;
+      MarkDirty(s);
+    }
+  }
+
+  WindowlessModel::Id WindowlessModel::HitTest(int x, int y) const {
+    auto c = cells_.find(Key(CellOf(x), CellOf(y)));
+    if (c == cells_.end()) {
+      return INVALID_ID;
+    }
+
+    Slot best = 0;
+    bool found = false;
+
+    for (Slot s : c->second) {
+      if ((state_[s] & VISIBLE) && bounds_[s].Contains(x, y) && (!found || z_[s] > z_[best])) {
+        best = s;
+        found = true;
+      }
+    }
+
+    return (found) ? IdOf(best) : INVALID_ID;
+  }
+
+  void WindowlessModel::Query(const Box& area, std::vector<Id>& out) const {
+    out.clear();
+
+    if (area.w <= 0 || area.h <= 0) {
+      return;
+    }
+
+    if (++query_ == 0) {
+      std::fill(stamp_.begin(), stamp_.end(), 0);
+      query_ = 1;
+    }
+
+    std::vector<Slot> found;
+
+    auto visit = [&](const std::vector<Slot>& cell) {
+      for (Slot s : cell) {
+        if (stamp_[s] != query_) {
+          stamp_[s] = query_;
+          if ((state_[s] & VISIBLE) && bounds_[s].Intersects(area)) {
+            found.push_back(s);
+          }
+        }
+      }
+    };
+
+    int cx0 = CellOf(area.x), cx1 = CellOf(area.x + area.w - 1);
+    int cy0 = CellOf(area.y), cy1 = CellOf(area.y + area.h - 1);
+
+    // A huge area covers more (mostly empty) cells than there are in use
+    if ((std::uint64_t) (cx1 - cx0 + 1) * (std::uint64_t) (cy1 - cy0 + 1) > cells_.size()) {
+      for (const auto& c : cells_) {
+        visit(c.second);
+      }
+    }
+    else {
+      for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+          auto c = cells_.find(Key(cx, cy));
+          if (c != cells_.end()) {
+            visit(c->second);
+          }
+        }
+      }
+    }
+
+    std::sort(found.begin(), found.end(), [this](Slot a, Slot b) {
+      return z_[a] < z_[b];
+    });
+
+    out.reserve(found.size());
+    for (Slot s : found) {
+      out.push_back(IdOf(s));
+    }
+  }
+
+  bool WindowlessModel::SetFocus(Id id) {
+    if (id == INVALID_ID || (Valid(id) && CanFocus(SlotOf(id)))) {
+      if (focus_ != id) {
+        if (Valid(focus_)) {
+          MarkDirty(SlotOf(focus_));
+        }
+        focus_ = id;
+        if (id != INVALID_ID) {
+          MarkDirty(SlotOf(id));
+        }
+      }
+      return true;
+    }
+    return false;
+  }
+
+  WindowlessModel::Id WindowlessModel::NextFocus(bool backwards, bool wrap) const {
+    // With nothing focused every candidate is "past": forwards finds the
+    // first, backwards the last
+    bool haveFocus = Valid(focus_);
+    std::uint32_t current = (haveFocus) ? z_[SlotOf(focus_)] : 0;
+
+    // Nearest candidate past the current one, & the extreme one to wrap to
+    bool haveNext = false, haveWrap = false;
+    Slot next = 0, extreme = 0;
+
+    for (Slot s = 0; s < bounds_.size(); ++s) {
+      if (!CanFocus(s)) {
+        continue;
+      }
+
+      std::uint32_t z = z_[s];
+      bool past = !haveFocus || ((backwards) ? z < current : z > current);
+
+      if (past && (!haveNext || ((backwards) ? z > z_[next] : z < z_[next]))) {
+        next = s;
+        haveNext = true;
+      }
+
+      if (!haveWrap || ((backwards) ? z > z_[extreme] : z < z_[extreme])) {
+        extreme = s;
+        haveWrap = true;
+      }
+    }
+
+    if (haveNext) {
+      return IdOf(next);
+    }
+    return (wrap && haveWrap) ? IdOf(extreme) : INVALID_ID;
+  }
+
+  WindowlessModel::Id WindowlessModel::FocusNext(bool backwards) {
+    Id id = NextFocus(backwards, true);
+    SetFocus(id);
+    return id;
+  }
+
+  void WindowlessModel::TakeDirty(std::vector<Box>& out) {
+    out.insert(out.end(), dirty_.begin(), dirty_.end());
+    dirty_.clear();
+  }
+
+  bool WindowlessModel::CanFocus(Slot s) const {
+    const std::uint32_t needed = ALIVE | VISIBLE | ENABLED | FOCUSABLE;
+    return (state_[s] & needed) == needed;
+  }
+
+  int WindowlessModel::CellOf(int v) {
+    // Floor, so that negative coordinates get cells of their own
+    return (v >= 0) ? v / CELL_SIZE : -((-v - 1) / CELL_SIZE) - 1;
+  }
+
+  WindowlessModel::CellKey WindowlessModel::Key(int cx, int cy) {
+    return ((CellKey) (std::uint32_t) cx << 32) | (std::uint32_t) cy;
+  }
+
+  void WindowlessModel::Index(Slot s, bool insert) {
+    const Box& b = bounds_[s];
+    if (b.w <= 0 || b.h <= 0) {
+      return;
+    }
+
+    int cx0 = CellOf(b.x), cx1 = CellOf(b.x + b.w - 1);
+    int cy0 = CellOf(b.y), cy1 = CellOf(b.y + b.h - 1);
+
+    for (int cy = cy0; cy <= cy1; ++cy) {
+      for (int cx = cx0; cx <= cx1; ++cx) {
+        CellKey k = Key(cx, cy);
+
+        if (insert) {
+          cells_[k].push_back(s);
+          continue;
+        }
+
+        auto c = cells_.find(k);
+        assert(c != cells_.end());
+
+        std::vector<Slot>& v = c->second;
+        auto i = std::find(v.begin(), v.end(), s);
+        assert(i != v.end());
+
+        *i = v.back();
+        v.pop_back();
+
+        if (v.empty()) {
+          cells_.erase(c);
+        }
+      }
+    }
+  }
+
+  void LayoutGrid(WindowlessModel& m, const std::vector<WindowlessModel::Id>& ids,
+    int x, int y, int columns, int cellW, int cellH, int gap)
+  {
+    assert(columns > 0);
+
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      int col = (int) (i % columns);
+      int row = (int) (i / columns);
+
+      WindowlessModel::Box b = {
+        x + col * (cellW + gap), y + row * (cellH + gap), cellW, cellH
+      };
+      m.SetBounds(ids[i], b);
+    }
+  }
+
+} // namespace jwt
\ No newline at end of file
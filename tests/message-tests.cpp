@@ -0,0 +1,51 @@
+#include "jwt.hpp"
+
+using namespace jwt;
+
+//
+// Compile-time checks for the message crackers in messages.hpp.
+// Nothing here runs: if this file compiles then the tests have passed.
+//
+
+namespace {
+
+  // WM_SIZE: wParam is the sizing type, lParam packs the client width & height
+  constexpr SizeMsg size(SIZE_MAXIMIZED, MAKELPARAM(640, 480));
+
+  static_assert(SizeMsg::Matches(WM_SIZE), "SizeMsg should match WM_SIZE");
+  static_assert(!SizeMsg::Matches(WM_SIZING), "SizeMsg should not match WM_SIZING");
+  static_assert(size.type == SIZE_MAXIMIZED, "SizeMsg::type");
+  static_assert(size.width == 640 && size.height == 480, "SizeMsg::width/height");
+
+  // WM_SIZING: the edge is passed in wParam
+  constexpr SizingMsg sizing(WMSZ_BOTTOMRIGHT, 0);
+
+  static_assert(SizingMsg::Matches(WM_SIZING), "SizingMsg should match WM_SIZING");
+  static_assert(sizing.edge == WMSZ_BOTTOMRIGHT, "SizingMsg::edge");
+
+  // WM_COMMAND: the source is decided by lParam, not the notification code.
+  // BN_CLICKED == 0 so a click looks like a menu command if you only check
+  // the HIWORD - this was a real bug in AppWindow.
+  constexpr CommandMsg menu(MAKEWPARAM(42, 0), 0);
+  constexpr CommandMsg accel(MAKEWPARAM(42, 1), 0);
+  constexpr CommandMsg click(MAKEWPARAM(42, BN_CLICKED), 0x1234);
+
+  static_assert(menu.id == 42 && menu.code == 0, "CommandMsg::id/code");
+  static_assert(menu.Source() == CommandEvent::MENU, "menu command source");
+  static_assert(accel.Source() == CommandEvent::ACCELERATOR, "accelerator command source");
+  static_assert(click.Source() == CommandEvent::CONTROL, "control command source");
+  static_assert(click.FromControl() && !menu.FromControl(), "CommandMsg::FromControl");
+
+  // WM_HSCROLL/WM_VSCROLL: one cracker covers both orientations
+  constexpr ScrollMsg hScroll(WM_HSCROLL, MAKEWPARAM(SB_THUMBTRACK, 300), 0);
+  constexpr ScrollMsg vScroll(WM_VSCROLL, MAKEWPARAM(SB_LINEDOWN, 0), 0x1234);
+
+  static_assert(ScrollMsg::Matches(WM_HSCROLL) && ScrollMsg::Matches(WM_VSCROLL), "ScrollMsg::Matches");
+  static_assert(!hScroll.vertical && vScroll.vertical, "ScrollMsg::vertical");
+  static_assert(hScroll.action == SB_THUMBTRACK && hScroll.position == 300, "ScrollMsg::action/position");
+  static_assert(!hScroll.FromControl() && vScroll.FromControl(), "ScrollMsg::FromControl");
+
+  // WM_NOTIFY: decoding is deferred until the header is accessed
+  static_assert(NotifyMsg<>::Matches(WM_NOTIFY), "NotifyMsg should match WM_NOTIFY");
+  static_assert(NotifyMsg<NMBCDROPDOWN>::Matches(WM_NOTIFY), "NotifyMsg<T> should match WM_NOTIFY");
+}
\ No newline at end of file
@@ -9,7 +9,7 @@ namespace {
 
   struct ScrollPaneTest {
     ScrollPaneTest()
-      : scrollPane_(w_), d_(scrollPane_, IDD_SCROLLPANETESTS)
+      : scrollPane_(w_), d_(scrollPane_, IDD_SCROLLPANETESTS), commands_(w_.OwningPump())
     {
 
       //
@@ -48,6 +48,18 @@ namespace {
 
       w_.On(Command, ID_TOGGLESCROLLBARSALWAYSON, [this]() {
         scrollPane_.AlwaysOn(!scrollPane_.AlwaysOn());
+        commands_.Invalidate(ID_TOGGLESCROLLBARSALWAYSON);
+      });
+
+      //
+      // Menu item state is pushed once the pump is idle...
+      //
+
+      AddShortcut(w_, 'T', ShortcutTable::CONTROL, ID_TOGGLESCROLLBARSALWAYSON);
+
+      commands_.AttachMenu(w_);
+      commands_.Provide(ID_TOGGLESCROLLBARSALWAYSON, [this]() {
+        return CommandState(true, scrollPane_.AlwaysOn());
       });
       
       w_.On(Command, ID_CLOSE, [this]() {
@@ -72,6 +84,7 @@ namespace {
     AppWindow w_;
     ScrollPane scrollPane_;
     Dialog d_;
+    CommandUpdater commands_;
 
   } scrollPaneTest;
 
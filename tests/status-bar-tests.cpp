@@ -28,6 +28,16 @@ namespace {
       SetText(sb_, 0, L"Part 0");
       SetText(sb_, 1, L"Part 1");
       SetText(sb_, 2, L"Part 2");
+
+      //
+      // Batched updates: part 1 is changed far faster than once a frame
+      //
+
+      ticks_ = 0;
+      w_.OwningPump().Timers().Every(1, [this]() {
+        sb_.Queue(1, std::to_wstring(++ticks_) + L" ticks");
+        sb_.Queue(2, std::to_wstring(sb_.Model()->Flushes()) + L" flushes");
+      });
     }
 
     void Show() {
@@ -37,6 +47,7 @@ namespace {
   private:
     AppWindow w_;
     StatusBar sb_;
+    unsigned int ticks_;
 
   } statusBarTest;
 
@@ -19,6 +19,12 @@ namespace {
         SetValue(b1_, GetValue(t1_));
       });
 
+      // Drag t2_ quickly: the title should lag by at most a frame & end on
+      // the final position, however many notifications were folded together.
+      t2_.On(LatestChange, [this](const TrackChange& c) {
+        SetText(d_, L"Track bar: " + std::to_wstring(c.value) + (c.tracking ? L" (tracking)" : L""));
+      });
+
       AddStyle(b3_, PBS_MARQUEE);
       SetMarquee(b3_, true);
     }
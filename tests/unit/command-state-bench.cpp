@@ -0,0 +1,104 @@
+#include "unit.hpp"
+#include "command-state.hpp"
+#include <vector>
+
+using namespace jwt;
+
+//
+// Update passes over 5k commands. Build with -DJWT_BENCHMARKS=ON
+// -DCMAKE_BUILD_TYPE=Release.
+//
+
+namespace {
+  const int COMMANDS = 5000;
+  const int PASSES = 1000;
+
+  struct CountingSink
+    : CommandStateRegistry::Sink
+  {
+    std::size_t pushes;
+
+    CountingSink() : pushes(0) {}
+
+    void Push(int, const CommandState&) { ++pushes; }
+  };
+
+  // Every tenth command flips when the model's generation changes
+  struct Model {
+    std::vector<bool> enabled;
+    int generation;
+
+    Model() : enabled(COMMANDS, true), generation(0) {}
+
+    void Change() {
+      ++generation;
+      for (int i = 0; i < COMMANDS; i += 10) {
+        enabled[i] = !enabled[i];
+      }
+    }
+  };
+
+  void Fill(CommandStateRegistry& r, Model& m) {
+    for (int id = 0; id < COMMANDS; ++id) {
+      r.Provide(id, [&m, id]() { return CommandState(m.enabled[id]); });
+    }
+
+    CountingSink sink;
+    r.Update(sink);
+  }
+}
+
+TEST(EverythingInvalidatedNothingChanged) {
+  CommandStateRegistry r;
+  Model m;
+  Fill(r, m);
+
+  CountingSink sink;
+  unit::Time("pass over 5k commands, no pushes", PASSES, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      r.Invalidate();
+      r.Update(sink);
+    }
+  });
+
+  CHECK_EQUAL(0u, sink.pushes);
+}
+
+TEST(EverythingInvalidatedATenthChanged) {
+  CommandStateRegistry r;
+  Model m;
+  Fill(r, m);
+
+  CountingSink sink;
+  unit::Time("pass over 5k commands, 500 pushes", PASSES, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      m.Change();
+      r.Invalidate();
+      r.Update(sink);
+    }
+  });
+
+  CHECK_EQUAL((std::size_t) PASSES * COMMANDS / 10, sink.pushes);
+}
+
+TEST(BurstOfSingleInvalidations) {
+  CommandStateRegistry r;
+  Model m;
+  Fill(r, m);
+
+  // A model change touches 50 commands 100 times over before the UI idles
+  CountingSink sink;
+  unit::Time("100 x 50 invalidations & a pass", PASSES, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      for (int burst = 0; burst < 100; ++burst) {
+        for (int id = 0; id < 500; id += 10) {
+          r.Invalidate(id);
+        }
+      }
+      m.Change();
+      r.Update(sink);
+    }
+  });
+
+  CHECK_EQUAL((std::size_t) PASSES * 50, sink.pushes);
+}
@@ -0,0 +1,291 @@
+#include "unit.hpp"
+#include "command-state.hpp"
+#include <string>
+#include <vector>
+
+using namespace jwt;
+
+namespace {
+  // Records pushes as "id:ec" (enabled & checked as 0/1)
+  struct RecordingSink
+    : CommandStateRegistry::Sink
+  {
+    std::vector<std::string> pushes;
+
+    void Push(int id, const CommandState& s) {
+      pushes.push_back(std::to_string(id) + ":" + (s.enabled ? "1" : "0") + (s.checked ? "1" : "0"));
+    }
+
+    std::string Take() {
+      std::string all;
+      for (auto& p : pushes) {
+        all += (all.empty() ? "" : " ") + p;
+      }
+      pushes.clear();
+      return all;
+    }
+  };
+
+  // A command whose state the test flips, counting provider calls
+  struct Command {
+    CommandState state;
+    int calls;
+
+    Command() : calls(0) {}
+
+    CommandStateRegistry::Provider Provider() {
+      return [this]() {
+        ++calls;
+        return state;
+      };
+    }
+  };
+}
+
+TEST(ProvideInvalidatesAndTheFirstUpdatePushes) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command a, b;
+  b.state = CommandState(false, true);
+
+  r.Provide(1, a.Provider());
+  r.Provide(2, b.Provider());
+  CHECK(r.Pending());
+
+  CHECK_EQUAL(2u, r.Update(sink));
+  CHECK_EQUAL(std::string("1:10 2:01"), sink.Take());
+  CHECK(!r.Pending());
+
+  CommandState s;
+  CHECK(r.Pushed(2, s) && s == b.state);
+  CHECK(!r.Pushed(3, s));
+}
+
+TEST(InvalidationsCoalesceUntilUpdate) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command a, b;
+
+  r.Provide(1, a.Provider());
+  r.Provide(2, b.Provider());
+  r.Update(sink);
+  sink.Take();
+
+  // A burst of model changes: one evaluation each, nothing until Update
+  for (int i = 0; i < 1000; ++i) {
+    r.Invalidate(1);
+    r.Invalidate(2);
+    r.Invalidate();
+  }
+  CHECK_EQUAL(1, a.calls);
+  CHECK_EQUAL(1, b.calls);
+
+  a.state.enabled = false;
+  r.Update(sink);
+
+  CHECK_EQUAL(2, a.calls);
+  CHECK_EQUAL(2, b.calls);
+  CHECK_EQUAL(std::string("1:00"), sink.Take());
+  CHECK_EQUAL(4u, r.Evaluations());
+}
+
+TEST(OnlyInvalidatedCommandsAreEvaluated) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command a, b;
+
+  r.Provide(1, a.Provider());
+  r.Provide(2, b.Provider());
+  r.Update(sink);
+
+  r.Invalidate(2);
+  r.Invalidate(99);     // unknown ids are ignored
+  r.Update(sink);
+
+  CHECK_EQUAL(1, a.calls);
+  CHECK_EQUAL(2, b.calls);
+}
+
+TEST(OnlyChangedStatesArePushed) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command a, b, c;
+
+  r.Provide(1, a.Provider());
+  r.Provide(2, b.Provider());
+  r.Provide(3, c.Provider());
+  r.Update(sink);
+  sink.Take();
+
+  b.state.checked = true;
+  r.Invalidate();
+  CHECK_EQUAL(1u, r.Update(sink));
+  CHECK_EQUAL(std::string("2:11"), sink.Take());
+
+  // Changing & changing back between passes pushes nothing
+  b.state.checked = false;
+  b.state.checked = true;
+  r.Invalidate();
+  CHECK_EQUAL(0u, r.Update(sink));
+  CHECK_EQUAL(std::string(""), sink.Take());
+
+  CHECK_EQUAL(4u, r.Pushes());
+}
+
+TEST(RemoveWhileStaleIsSkipped) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command a, b, c;
+
+  r.Provide(1, a.Provider());
+  r.Provide(2, b.Provider());
+  r.Provide(3, c.Provider());
+  r.Update(sink);
+  sink.Take();
+
+  a.state.enabled = b.state.enabled = c.state.enabled = false;
+  r.Invalidate(1);
+  r.Invalidate(3);
+
+  // 1 is removed with its invalidation pending; 3 is moved into its slot
+  r.Remove(1);
+  CHECK_EQUAL(2u, r.Size());
+
+  r.Update(sink);
+  CHECK_EQUAL(1, a.calls);
+  CHECK_EQUAL(2, c.calls);
+  CHECK_EQUAL(std::string("3:00"), sink.Take());
+
+  CommandState s;
+  CHECK(!r.Pushed(1, s));
+  CHECK(r.Pushed(3, s) && !s.enabled);
+}
+
+TEST(RemoveAndProvideAgainStartsFresh) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command a;
+
+  r.Provide(1, a.Provider());
+  r.Invalidate(1);
+  r.Remove(1);
+  r.Provide(1, a.Provider());
+  r.Invalidate(1);
+
+  // The stale id queued before the removal doesn't cause a second call
+  CHECK_EQUAL(1u, r.Update(sink));
+  CHECK_EQUAL(1, a.calls);
+  CHECK_EQUAL(std::string("1:10"), sink.Take());
+}
+
+TEST(ProvidersMayRemoveDuringAPass) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command b, c, d;
+
+  // 1's provider removes itself & 2; the others are moved about underneath
+  // the pass
+  r.Provide(1, [&]() {
+    r.Remove(1);
+    r.Remove(2);
+    return CommandState(false);
+  });
+  r.Provide(2, b.Provider());
+  r.Provide(3, c.Provider());
+  r.Provide(4, d.Provider());
+
+  r.Update(sink);
+
+  CHECK_EQUAL(0, b.calls);
+  CHECK_EQUAL(1, c.calls);
+  CHECK_EQUAL(1, d.calls);
+  CHECK_EQUAL(std::string("3:10 4:10"), sink.Take());
+  CHECK_EQUAL(2u, r.Size());
+
+  CommandState s;
+  CHECK(!r.Pushed(1, s));
+}
+
+TEST(ProvidersMayProvideDuringAPass) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command later;
+
+  // Enough new entries to move the vector the pass is walking
+  r.Provide(1, [&]() {
+    for (int id = 100; id < 200; ++id) {
+      r.Provide(id, later.Provider());
+    }
+    return CommandState();
+  });
+
+  r.Update(sink);
+  CHECK_EQUAL(std::string("1:10"), sink.Take());
+  CHECK_EQUAL(0, later.calls);
+
+  // The new commands were invalidated for the next pass
+  CHECK(r.Pending());
+  CHECK_EQUAL(100u, r.Update(sink));
+  CHECK_EQUAL(100, later.calls);
+}
+
+TEST(InvalidatingDuringAPassIsNotLost) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command a, b;
+
+  // Evaluated in the order provided: 1 asks for 2, which is still to come
+  // in this pass, so 2 is evaluated once
+  r.Provide(1, [&]() {
+    r.Invalidate(2);
+    return CommandState();
+  });
+  r.Provide(2, b.Provider());
+  r.Update(sink);
+
+  CHECK_EQUAL(1, b.calls);
+  CHECK(!r.Pending());
+
+  // 3 asks for 1, which has been evaluated already: the next pass has it
+  r.Provide(3, [&]() {
+    r.Invalidate(1);
+    return CommandState();
+  });
+  r.Provide(4, a.Provider());
+  r.Update(sink);
+
+  CHECK(r.Pending());
+  CHECK_EQUAL(1, a.calls);
+
+  // That pass only has 1, so the 2 it asks for waits for another
+  r.Update(sink);
+  CHECK_EQUAL(1, b.calls);
+  CHECK(r.Pending());
+
+  r.Update(sink);
+  CHECK_EQUAL(2, b.calls);
+  CHECK(!r.Pending());
+}
+
+TEST(RepushSendsEverythingAgain) {
+  CommandStateRegistry r;
+  RecordingSink sink;
+  Command a, b;
+
+  r.Provide(1, a.Provider());
+  r.Provide(2, b.Provider());
+  r.Update(sink);
+  sink.Take();
+
+  // A new toolbar was attached: it has seen nothing, so unchanged states
+  // must be sent too
+  r.Repush();
+  CHECK(r.Pending());
+  CHECK_EQUAL(2u, r.Update(sink));
+  CHECK_EQUAL(std::string("1:10 2:10"), sink.Take());
+
+  CommandState s;
+  CHECK(r.Pushed(1, s));
+
+  CHECK_EQUAL(0u, r.Update(sink));
+}
@@ -0,0 +1,202 @@
+#include "unit.hpp"
+#include "dialog-template.hpp"
+#include <algorithm>
+
+using namespace jwt;
+
+namespace {
+  typedef std::vector<std::uint8_t> Bytes;
+
+  const std::uint32_t POPUP_CAPTION_SYSMENU = 0x80C80000;   // WS_POPUP | WS_CAPTION | WS_SYSMENU
+  const std::uint32_t CHILD_VISIBLE = 0x50000000;           // WS_CHILD | WS_VISIBLE
+
+  Bytes Of(const DialogTemplateBuilder& t) {
+    return Bytes(t.Data(), t.Data() + t.Size());
+  }
+
+  // Compares byte for byte, reporting the first difference
+  void CheckBytes(const Bytes& expected, const Bytes& actual, const char* file, int line) {
+    size_t n = std::min(expected.size(), actual.size());
+
+    for (size_t i = 0; i < n; ++i) {
+      if (expected[i] != actual[i]) {
+        unit::Fail(file, line, "bytes differ at offset " + std::to_string(i) + ": expected " +
+          std::to_string(expected[i]) + ", got " + std::to_string(actual[i]));
+        return;
+      }
+    }
+
+    if (expected.size() != actual.size()) {
+      unit::Fail(file, line, "expected " + std::to_string(expected.size()) + " bytes, got " +
+        std::to_string(actual.size()));
+    }
+  }
+}
+
+#define CHECK_BYTES(expected, actual) CheckBytes(expected, actual, __FILE__, __LINE__)
+
+TEST(HeaderOnly) {
+  DialogTemplateBuilder t(L"Hi", 1, 2, 100, 50, POPUP_CAPTION_SYSMENU);
+
+  Bytes expected = {
+    0x01, 0x00,                   // dlgVer
+    0xFF, 0xFF,                   // signature
+    0x00, 0x00, 0x00, 0x00,       // helpID
+    0x00, 0x00, 0x00, 0x00,       // exStyle
+    0x00, 0x00, 0xC8, 0x80,       // style
+    0x00, 0x00,                   // cDlgItems
+    0x01, 0x00, 0x02, 0x00,       // x, y
+    0x64, 0x00, 0x32, 0x00,       // cx, cy
+    0x00, 0x00,                   // menu
+    0x00, 0x00,                   // windowClass
+    'H', 0x00, 'i', 0x00, 0x00, 0x00
+  };
+
+  CHECK_BYTES(expected, Of(t));
+  CHECK_EQUAL(0u, t.Count());
+}
+
+TEST(FontAndOneButton) {
+  DialogTemplateBuilder t(L"T", 0, 0, 80, 40, POPUP_CAPTION_SYSMENU, 0x00000080);
+  t.Font(L"MS Shell Dlg", 8);
+  t.Control(DialogTemplateBuilder::BUTTON, L"OK", 1, 10, 20, 50, 14, CHILD_VISIBLE | 0x00010001);
+
+  Bytes expected = {
+    // Header; style has DS_SETFONT patched in & the count is 1
+    0x01, 0x00, 0xFF, 0xFF,
+    0x00, 0x00, 0x00, 0x00,
+    0x80, 0x00, 0x00, 0x00,
+    0x40, 0x00, 0xC8, 0x80,
+    0x01, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x50, 0x00, 0x28, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    'T', 0x00, 0x00, 0x00,
+
+    // Font: points, weight, italic, charset, typeface
+    0x08, 0x00, 0x00, 0x00, 0x00, 0x01,
+    'M', 0x00, 'S', 0x00, ' ', 0x00, 'S', 0x00, 'h', 0x00, 'e', 0x00, 'l', 0x00, 'l', 0x00,
+    ' ', 0x00, 'D', 0x00, 'l', 0x00, 'g', 0x00, 0x00, 0x00,
+
+    // Padding to a DWORD boundary (offset 64)
+    0x00, 0x00,
+
+    // Item
+    0x00, 0x00, 0x00, 0x00,       // helpID
+    0x00, 0x00, 0x00, 0x00,       // exStyle
+    0x01, 0x00, 0x01, 0x50,       // style
+    0x0A, 0x00, 0x14, 0x00,       // x, y
+    0x32, 0x00, 0x0E, 0x00,       // cx, cy
+    0x01, 0x00, 0x00, 0x00,       // id
+    0xFF, 0xFF, 0x80, 0x00,       // class: BUTTON ordinal
+    'O', 0x00, 'K', 0x00, 0x00, 0x00,
+    0x00, 0x00                    // extraCount
+  };
+
+  CHECK_BYTES(expected, Of(t));
+  CHECK_EQUAL(1u, t.Count());
+}
+
+TEST(ItemsAreDwordAlignedAndCounted) {
+  DialogTemplateBuilder t(L"", 0, 0, 10, 10, 0);
+
+  // An untitled header is 32 bytes, so the first item needs no padding
+  t.Control(DialogTemplateBuilder::STATIC, L"A", 0xFFFFFFFF, -5, 0, 1, 1, CHILD_VISIBLE);
+  t.Control(DialogTemplateBuilder::EDIT, L"", 7, 0, 0, 1, 1, CHILD_VISIBLE);
+
+  Bytes expected = {
+    0x01, 0x00, 0xFF, 0xFF,
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    0x02, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x0A, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00,
+
+    // First item: 34 bytes
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x50,
+    0xFB, 0xFF, 0x00, 0x00,       // x = -5
+    0x01, 0x00, 0x01, 0x00,
+    0xFF, 0xFF, 0xFF, 0xFF,       // id = -1
+    0xFF, 0xFF, 0x82, 0x00,       // STATIC
+    'A', 0x00, 0x00, 0x00,
+    0x00, 0x00,
+
+    // Padding (offset 66)
+    0x00, 0x00,
+
+    // Second item
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x50,
+    0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0x00,
+    0x07, 0x00, 0x00, 0x00,
+    0xFF, 0xFF, 0x81, 0x00,       // EDIT
+    0x00, 0x00,                   // no text
+    0x00, 0x00
+  };
+
+  CHECK_BYTES(expected, Of(t));
+  CHECK_EQUAL(2u, t.Count());
+}
+
+TEST(NamedClassesAreWrittenAsStrings) {
+  DialogTemplateBuilder t(L"", 0, 0, 0, 0, 0);
+  t.Control(L"msctls_trackbar32", L"", 3, 0, 0, 0, 0, CHILD_VISIBLE);
+
+  Bytes actual = Of(t);
+
+  // Untitled header (32) + fixed item part (24)
+  const size_t classOffset = 32 + 24;
+  const std::string name = "msctls_trackbar32";
+
+  CHECK_EQUAL(classOffset + (name.size() + 1) * 2 + 2 + 2, actual.size());
+
+  Bytes expected;
+  for (char c : name) {
+    expected.push_back((std::uint8_t) c);
+    expected.push_back(0);
+  }
+  expected.insert(expected.end(), { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+
+  if (actual.size() >= classOffset) {
+    CHECK_BYTES(expected, Bytes(actual.begin() + classOffset, actual.end()));
+  }
+}
+
+TEST(TextIsWrittenAsUtf16) {
+  // U+00E9 is one unit; U+1F600 is a surrogate pair whatever wchar_t's size
+  DialogTemplateBuilder t(std::wstring(L"\u00E9") + std::wstring(L"\U0001F600"), 0, 0, 0, 0, 0);
+
+  Bytes actual = Of(t);
+  Bytes title(actual.begin() + 30, actual.end());
+
+  Bytes expected = {
+    0xE9, 0x00,
+    0x3D, 0xD8, 0x00, 0xDE,
+    0x00, 0x00
+  };
+
+  CHECK_BYTES(expected, title);
+}
+
+TEST(ReserveDoesNotChangeTheTemplate) {
+  DialogTemplateBuilder a(L"Same", 0, 0, 10, 10, POPUP_CAPTION_SYSMENU);
+  DialogTemplateBuilder b(L"Same", 0, 0, 10, 10, POPUP_CAPTION_SYSMENU);
+
+  b.Reserve(1000);
+
+  for (int i = 0; i < 100; ++i) {
+    a.Control(DialogTemplateBuilder::BUTTON, L"Button " + std::to_wstring(i), 100 + i, 0, (short) (i * 12), 50, 10, CHILD_VISIBLE);
+    b.Control(DialogTemplateBuilder::BUTTON, L"Button " + std::to_wstring(i), 100 + i, 0, (short) (i * 12), 50, 10, CHILD_VISIBLE);
+  }
+
+  CHECK(Of(a) == Of(b));
+  CHECK_EQUAL(100u, b.Count());
+
+  // cDlgItems
+  CHECK_EQUAL(100, b.Data()[16] | (b.Data()[17] << 8));
+}
@@ -0,0 +1,305 @@
+#include "unit.hpp"
+#include "grid-model.hpp"
+#include <stdexcept>
+#include <string>
+
+using namespace jwt;
+
+namespace {
+  // Plain prefix sums, to check RowIndex against
+  struct NaiveRows {
+    std::vector<int> heights;
+
+    std::vector<std::int64_t> Offsets() const {
+      std::vector<std::int64_t> offsets(1, 0);
+      for (int h : heights) {
+        offsets.push_back(offsets.back() + h);
+      }
+      return offsets;
+    }
+  };
+
+  // Small & deterministic, so a failure reproduces
+  struct Lcg {
+    std::uint32_t state;
+
+    explicit Lcg(std::uint32_t seed) : state(seed) {}
+
+    std::uint32_t Next(std::uint32_t bound) {
+      state = state * 1664525u + 1013904223u;
+      return (state >> 8) % bound;
+    }
+  };
+
+  void CheckAgainstNaive(const RowIndex& index, const NaiveRows& naive) {
+    std::vector<std::int64_t> offsets = naive.Offsets();
+    std::uint64_t count = naive.heights.size();
+
+    CHECK_EQUAL(count, index.Count());
+
+    for (std::uint64_t row = 0; row <= count; ++row) {
+      CHECK_EQUAL(offsets[row], index.Offset(row));
+    }
+
+    // The row y falls in is the first whose bottom is below y
+    std::uint64_t row = 0;
+    for (std::int64_t y = 0; y < offsets.back() + 5; ++y) {
+      while (row < count - 1 && offsets[row + 1] <= y) {
+        ++row;
+      }
+      CHECK_EQUAL(row, index.RowAt(y));
+    }
+    CHECK_EQUAL(0u, index.RowAt(-5));
+  }
+
+  // Row r, column c is "r:c"; counts what it is asked for
+  struct CountingProvider
+    : GridProvider
+  {
+    std::uint64_t rows;
+    int columns;
+    std::vector<std::uint64_t> fetched;
+    bool fail;
+
+    CountingProvider(std::uint64_t rows, int columns) : rows(rows), columns(columns), fail(false) {}
+
+    std::uint64_t Rows() const { return rows; }
+    int Columns() const { return columns; }
+    std::wstring Header(int column) const { return std::to_wstring(column); }
+
+    void Fetch(std::uint64_t first, std::uint32_t count, std::vector<std::wstring>& cells) {
+      fetched.push_back(first);
+
+      for (std::uint64_t r = first; r < first + count; ++r) {
+        for (int c = 0; c < columns; ++c) {
+          cells.push_back(std::to_wstring(r) + L":" + std::to_wstring(c));
+        }
+      }
+
+      // Part way through, as a provider reading a file might
+      if (fail) {
+        throw std::runtime_error("fetch failed");
+      }
+    }
+  };
+}
+
+TEST(DefaultHeightsNeedNoOverrides) {
+  RowIndex index(20, 1000);
+
+  CHECK_EQUAL(1000u * 20, (std::uint64_t) index.Total());
+  CHECK_EQUAL(0, index.Offset(0));
+  CHECK_EQUAL(130 * 20, index.Offset(130));
+  CHECK_EQUAL(0u, index.RowAt(19));
+  CHECK_EQUAL(1u, index.RowAt(20));
+  CHECK_EQUAL(999u, index.RowAt(1000000));
+  CHECK_EQUAL(0u, index.RowAt(-1));
+}
+
+TEST(OffsetsAndRowAtMatchPrefixSums) {
+  // 1000 rows is 16 blocks, the last one short
+  Lcg rng(1);
+  RowIndex index(20, 1000);
+  NaiveRows naive;
+  naive.heights.assign(1000, 20);
+
+  for (int i = 0; i < 300; ++i) {
+    std::uint64_t row = rng.Next(1000);
+    int height = (int) rng.Next(4) * 15;       // 0, 15, 30 or 45: some hidden
+
+    index.SetHeight(row, height);
+    naive.heights[row] = height;
+  }
+
+  CheckAgainstNaive(index, naive);
+}
+
+TEST(HeightChangesUpdateLaterBlocks) {
+  // 3000 rows is 47 blocks: not a power of two, so RowAt's descent
+  // can't take every step
+  RowIndex index(10, 3000);
+  NaiveRows naive;
+  naive.heights.assign(3000, 10);
+
+  const std::uint64_t rows[] = { 0, 63, 64, 1023, 1024, 2999 };
+  for (std::uint64_t row : rows) {
+    index.SetHeight(row, 37);
+    naive.heights[row] = 37;
+    CheckAgainstNaive(index, naive);
+  }
+
+  // Back to the default forgets the override
+  for (std::uint64_t row : rows) {
+    index.SetHeight(row, 10);
+    naive.heights[row] = 10;
+  }
+  CHECK_EQUAL(3000 * 10, index.Total());
+  CheckAgainstNaive(index, naive);
+}
+
+TEST(RowAtSkipsHiddenRows) {
+  RowIndex index(20, 10);
+
+  index.SetHeight(3, 0);
+  index.SetHeight(4, 0);
+
+  // Rows 3 & 4 occupy no pixels; y = 60 is the top of row 5
+  CHECK_EQUAL(60, index.Offset(3));
+  CHECK_EQUAL(60, index.Offset(5));
+  CHECK_EQUAL(2u, index.RowAt(59));
+  CHECK_EQUAL(5u, index.RowAt(60));
+  CHECK_EQUAL(0, index.Height(3));
+}
+
+TEST(HiddenTrailingRowsClampToTheLastRow) {
+  RowIndex index(20, 4);
+
+  index.SetHeight(2, 0);
+  index.SetHeight(3, 0);
+
+  CHECK_EQUAL(40, index.Total());
+  CHECK_EQUAL(3u, index.RowAt(40));
+  CHECK_EQUAL(1u, index.RowAt(39));
+}
+
+TEST(ShrinkingForgetsRemovedHeights) {
+  RowIndex index(20, 200);
+
+  index.SetHeight(10, 5);
+  index.SetHeight(130, 5);
+  index.SetHeight(190, 5);
+
+  index.SetCount(140);
+  CHECK_EQUAL(140 * 20 - 2 * 15, index.Total());
+
+  // Growing again brings back the default, not the old height
+  index.SetCount(200);
+  CHECK_EQUAL(20, index.Height(190));
+  CHECK_EQUAL(200 * 20 - 2 * 15, index.Total());
+
+  index.ResetHeights();
+  CHECK_EQUAL(200 * 20, index.Total());
+}
+
+TEST(OffsetsBeyond32Bits) {
+  const std::uint64_t count = 50000000;
+  RowIndex index(100, count);
+
+  CHECK_EQUAL((std::int64_t) count * 100, index.Total());
+
+  index.SetHeight(count - 1, 1);
+  CHECK_EQUAL((std::int64_t) (count - 1) * 100 + 1, index.Total());
+  CHECK_EQUAL(count - 1, index.RowAt(index.Total() - 1));
+  CHECK_EQUAL(count - 2, index.RowAt(index.Total() - 2));
+  CHECK_EQUAL(25000000u, index.RowAt(2500000000LL));
+}
+
+TEST(CellCacheFetchesWholeBlocks) {
+  CountingProvider p(1000, 3);
+  CellCache cache(p);
+
+  CHECK(cache.Cell(70, 2) == L"70:2");
+  CHECK(cache.Cell(64, 0) == L"64:0");
+  CHECK(cache.Cell(127, 1) == L"127:1");
+
+  CHECK_EQUAL(1u, p.fetched.size());
+  CHECK_EQUAL(64u, p.fetched[0]);
+  CHECK_EQUAL(1u, cache.Fetches());
+  CHECK_EQUAL(2u, cache.Hits());
+}
+
+TEST(CellCacheReturnsEmptyOutsideTheData) {
+  CountingProvider p(100, 2);
+  CellCache cache(p);
+
+  CHECK(cache.Cell(99, 1) == L"99:1");
+  CHECK(cache.Cell(99, 2).empty());
+  CHECK(cache.Cell(99, -1).empty());
+  CHECK(cache.Cell(100, 0).empty());
+  CHECK(cache.Cell(5000, 0).empty());
+}
+
+TEST(CellCacheDropsLeastRecentlyUsedBlocks) {
+  CountingProvider p(1000, 1);
+  CellCache cache(p, 2);
+
+  cache.Cell(0, 0);
+  cache.Cell(64, 0);
+  cache.Cell(0, 0);         // block 0 is now the most recent
+  cache.Cell(128, 0);       // drops block 1
+
+  CHECK_EQUAL(2u, cache.Blocks());
+  CHECK_EQUAL(3u, cache.Fetches());
+
+  cache.Cell(0, 0);
+  CHECK_EQUAL(3u, cache.Fetches());
+
+  cache.Cell(64, 0);
+  CHECK_EQUAL(4u, cache.Fetches());
+
+  cache.SetMaxBlocks(1);
+  CHECK_EQUAL(1u, cache.Blocks());
+  cache.Cell(64, 0);
+  CHECK_EQUAL(4u, cache.Fetches());
+}
+
+TEST(CellCacheInvalidatesOnlyTheRowsGiven) {
+  CountingProvider p(1000, 1);
+  CellCache cache(p);
+
+  cache.Cell(0, 0);
+  cache.Cell(64, 0);
+  cache.Cell(128, 0);
+
+  // Rows 100..140 touch blocks 1 & 2
+  cache.Invalidate(100, 41);
+  CHECK_EQUAL(1u, cache.Blocks());
+
+  cache.Cell(0, 0);
+  CHECK_EQUAL(3u, cache.Fetches());
+
+  cache.Cell(128, 0);
+  CHECK_EQUAL(4u, cache.Fetches());
+
+  cache.Invalidate(0, 0);
+  CHECK_EQUAL(2u, cache.Blocks());
+
+  CountingProvider other(10, 1);
+  cache.SetProvider(other);
+  CHECK_EQUAL(0u, cache.Blocks());
+  CHECK(cache.Cell(3, 0) == L"3:0");
+}
+
+TEST(CellCacheSurvivesAProviderThatThrows) {
+  CountingProvider p(1000, 1);
+  CellCache cache(p, 2);
+
+  cache.Cell(0, 0);
+  cache.Cell(64, 0);
+
+  p.fail = true;
+  bool threw = false;
+  try {
+    cache.Cell(128, 0);
+  }
+  catch (const std::runtime_error&) {
+    threw = true;
+  }
+  CHECK(threw);
+
+  // Nothing was dropped or half added
+  CHECK_EQUAL(2u, cache.Blocks());
+  CHECK_EQUAL(2u, cache.Fetches());
+  CHECK(cache.Cell(64, 0) == L"64:0");
+
+  // & the failed block is fetched again next time, evicting as usual
+  p.fail = false;
+  CHECK(cache.Cell(130, 0) == L"130:0");
+  CHECK_EQUAL(2u, cache.Blocks());
+  CHECK_EQUAL(3u, cache.Fetches());
+
+  cache.Cell(192, 0);
+  cache.Invalidate();
+  CHECK_EQUAL(0u, cache.Blocks());
+  CHECK(cache.Cell(5, 0) == L"5:0");
+}
@@ -0,0 +1,282 @@
+#include "unit.hpp"
+#include "test-executors.hpp"
+#include "line-index.hpp"
+#include <algorithm>
+#include <string>
+
+using namespace jwt;
+using unit::ManualExecutor;
+using unit::ThreadExecutor;
+
+namespace {
+  // Small & deterministic, so a failure reproduces
+  struct Lcg {
+    std::uint32_t state;
+
+    explicit Lcg(std::uint32_t seed) : state(seed) {}
+
+    std::uint32_t Next(std::uint32_t bound) {
+      state = state * 1664525u + 1013904223u;
+      return (state >> 8) % bound;
+    }
+  };
+
+  // size bytes of text with a '\n' about one byte in every gap
+  std::string Text(Lcg& rng, std::size_t size, std::uint32_t gap) {
+    std::string s(size, 'x');
+    for (char& c : s) {
+      if (rng.Next(gap) == 0) {
+        c = '\n';
+      }
+    }
+    return s;
+  }
+
+  std::vector<std::uint64_t> NaiveStarts(const std::string& s) {
+    std::vector<std::uint64_t> starts;
+    if (s.empty()) {
+      return starts;
+    }
+
+    starts.push_back(0);
+    for (std::size_t i = 0; i + 1 < s.size(); ++i) {
+      if (s[i] == '\n') {
+        starts.push_back(i + 1);
+      }
+    }
+    return starts;
+  }
+
+  void CheckAgainstNaive(const LineIndex& index, const std::string& s) {
+    std::vector<std::uint64_t> starts = NaiveStarts(s);
+
+    CHECK(index.Done());
+    CHECK_EQUAL((std::uint64_t) starts.size(), index.Lines());
+
+    for (std::uint64_t line = 0; line < starts.size(); ++line) {
+      std::uint64_t offset = ~0ULL;
+      CHECK(index.LineStart(line, offset));
+      CHECK_EQUAL(starts[line], offset);
+    }
+
+    std::uint64_t unused;
+    CHECK(!index.LineStart(starts.size(), unused));
+
+    std::uint64_t line = 0;
+    for (std::uint64_t offset = 0; offset < s.size(); ++offset) {
+      while (line + 1 < starts.size() && starts[line + 1] <= offset) {
+        ++line;
+      }
+
+      std::uint64_t found = ~0ULL;
+      CHECK(index.LineAt(offset, found));
+      CHECK_EQUAL(line, found);
+      CHECK_EQUAL(starts[line], LineIndex::StartOfLine(s.data(), offset));
+    }
+  }
+
+  std::string LineText(const LineIndex& index, std::uint64_t line) {
+    const char* text = nullptr;
+    std::size_t length = 0;
+
+    if (!index.Line(line, text, length)) {
+      return "<none>";
+    }
+    return std::string(text, length);
+  }
+}
+
+TEST(EmptyBufferHasNoLines) {
+  LineIndex index(nullptr, 0);
+  std::uint64_t unused;
+
+  CHECK(index.Done());
+  CHECK_EQUAL(0u, index.Scan(100));
+  CHECK_EQUAL(0u, index.Lines());
+  CHECK(!index.LineStart(0, unused));
+  CHECK(!index.LineAt(0, unused));
+}
+
+TEST(FinalLineNeedsNoNewline) {
+  std::string a = "one\ntwo";
+  std::string b = "one\ntwo\n";
+  LineIndex ia(a.data(), a.size());
+  LineIndex ib(b.data(), b.size());
+
+  ia.Scan(~0ULL);
+  ib.Scan(~0ULL);
+
+  CHECK_EQUAL(2u, ia.Lines());
+  CHECK_EQUAL(2u, ib.Lines());
+  CHECK_EQUAL(std::string("two"), LineText(ia, 1));
+  CHECK_EQUAL(std::string("two"), LineText(ib, 1));
+  CHECK_EQUAL(std::string("<none>"), LineText(ib, 2));
+}
+
+TEST(LineDropsCarriageReturns) {
+  std::string s = "crlf\r\nlf\n\r\n\rlone\r";
+  LineIndex index(s.data(), s.size());
+  index.Scan(~0ULL);
+
+  CHECK_EQUAL(4u, index.Lines());
+  CHECK_EQUAL(std::string("crlf"), LineText(index, 0));
+  CHECK_EQUAL(std::string("lf"), LineText(index, 1));
+  CHECK_EQUAL(std::string(""), LineText(index, 2));
+
+  // Only a '\r' right before the end of the line is dropped
+  CHECK_EQUAL(std::string("\rlone"), LineText(index, 3));
+}
+
+TEST(OffsetsMatchANaiveScan) {
+  // Dense & sparse newlines, across many strides & 32 byte blocks
+  const std::uint32_t gaps[] = { 1, 2, 7, 40, 300 };
+
+  for (std::uint32_t gap : gaps) {
+    Lcg rng(gap);
+    std::string s = Text(rng, 20000, gap);
+    LineIndex index(s.data(), s.size());
+
+    index.Scan(~0ULL);
+    CheckAgainstNaive(index, s);
+  }
+}
+
+TEST(SizesAroundBlockBoundaries) {
+  // The vector loop takes 32 bytes at a time; the rest go to memchr
+  for (std::size_t size = 1; size <= 100; ++size) {
+    Lcg rng((std::uint32_t) size);
+    std::string s = Text(rng, size, 3);
+    LineIndex index(s.data(), s.size());
+
+    index.Scan(~0ULL);
+    CheckAgainstNaive(index, s);
+  }
+}
+
+TEST(SkipNewlinesFindsTheNthNewline) {
+  // Newlines at either end of each 32 byte block
+  std::string s(128, 'x');
+  const std::size_t at[] = { 0, 31, 32, 63, 64, 95, 96, 127 };
+  for (std::size_t i : at) {
+    s[i] = '\n';
+  }
+
+  const char* begin = s.data();
+  const char* end = begin + s.size();
+
+  for (std::uint64_t n = 1; n <= 8; ++n) {
+    std::uint64_t left = n;
+    CHECK_EQUAL((std::ptrdiff_t) at[n - 1] + 1, LineIndex::SkipNewlines(begin, end, left) - begin);
+    CHECK_EQUAL(0u, left);
+  }
+
+  // From an unaligned start, which shifts every block
+  std::uint64_t left = 3;
+  CHECK_EQUAL(64, LineIndex::SkipNewlines(begin + 1, end, left) - begin);
+
+  // Fewer than asked for
+  left = 10;
+  CHECK(LineIndex::SkipNewlines(begin, end, left) == end);
+  CHECK_EQUAL(2u, left);
+
+  left = 0;
+  CHECK(LineIndex::SkipNewlines(begin + 5, end, left) == begin + 5);
+
+  CHECK_EQUAL(8u, LineIndex::CountNewlines(begin, end));
+  CHECK_EQUAL(6u, LineIndex::CountNewlines(begin + 1, end - 1));
+  CHECK_EQUAL(0u, LineIndex::CountNewlines(begin + 1, begin + 31));
+}
+
+TEST(ScanningInPiecesMatchesOneScan) {
+  Lcg rng(5);
+  std::string s = Text(rng, 10000, 9);
+  LineIndex index(s.data(), s.size());
+
+  // Pieces that split lines, strides & blocks at arbitrary points
+  std::uint64_t total = 0;
+  while (!index.Done()) {
+    std::uint64_t before = index.Indexed();
+    std::uint64_t scanned = index.Scan(1 + rng.Next(97));
+
+    total += scanned;
+    CHECK_EQUAL(before + scanned, index.Indexed());
+
+    // Queries answer from what has been indexed so far
+    std::uint64_t unused;
+    CHECK(!index.LineAt(index.Indexed(), unused));
+  }
+
+  CHECK_EQUAL((std::uint64_t) s.size(), total);
+  CheckAgainstNaive(index, s);
+}
+
+TEST(IndexerRunsAChunkPerWorkItem) {
+  Lcg rng(7);
+  std::string s = Text(rng, 1000, 11);
+  LineIndex index(s.data(), s.size());
+  ManualExecutor e;
+
+  {
+    LineIndexer indexer(e, index, 300);
+
+    indexer.Start();
+    indexer.Start();
+    CHECK(indexer.Running());
+    CHECK_EQUAL(1u, e.Queued());
+
+    // 1000 bytes in 300 byte chunks
+    CHECK_EQUAL(4u, e.RunAll());
+    CHECK(!indexer.Running());
+  }
+
+  CheckAgainstNaive(index, s);
+}
+
+TEST(StoppedIndexerResumes) {
+  Lcg rng(8);
+  std::string s = Text(rng, 1000, 11);
+  LineIndex index(s.data(), s.size());
+  ManualExecutor e;
+  LineIndexer indexer(e, index, 100);
+
+  indexer.Start();
+  indexer.Stop();
+  CHECK_EQUAL(1u, e.RunAll());
+  CHECK(!indexer.Running());
+  CHECK_EQUAL(100u, index.Indexed());
+
+  indexer.Start();
+  CHECK_EQUAL(9u, e.RunAll());
+  CHECK(index.Done());
+
+  // Nothing left to do
+  indexer.Start();
+  CHECK_EQUAL(0u, e.Queued());
+}
+
+TEST(QueriesWhileIndexingOnAnotherThread) {
+  Lcg rng(9);
+  std::string s = Text(rng, 1 << 20, 50);
+  std::vector<std::uint64_t> starts = NaiveStarts(s);
+  LineIndex index(s.data(), s.size());
+
+  {
+    ThreadExecutor e;
+    LineIndexer indexer(e, index, 4096);
+    indexer.Start();
+
+    // Whatever has been reached so far must already be right
+    for (std::uint64_t line = 0; line < starts.size(); line += 97) {
+      std::uint64_t offset;
+      if (index.LineStart(line, offset)) {
+        CHECK_EQUAL(starts[line], offset);
+      }
+    }
+
+    while (indexer.Running()) {
+      std::this_thread::yield();
+    }
+  }
+
+  CheckAgainstNaive(index, s);
+}
@@ -0,0 +1,216 @@
+#include "unit.hpp"
+#include "progress-channel.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace jwt;
+
+TEST(AddsFromManyThreadsAreAllCounted) {
+  const int threads = 32;
+  const int items = 50000;
+  const int steps = 200;
+
+  ProgressChannel c;
+  c.SetTotal((std::uint64_t) threads * items);
+
+  std::atomic<int> running(threads);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&c, &running]() {
+      for (int j = 0; j < items; ++j) {
+        c.Add();
+      }
+      --running;
+    });
+  }
+
+  // Sample once a "frame" while the writers run: the count never goes
+  // backwards or past the total, & each frame sends at most the position
+  // (plus the range, the first time) however many Adds happened in between
+  ProgressSampler sampler;
+  std::uint64_t last = 0;
+  unsigned int frames = 0;
+
+  for (;;) {
+    bool finished = (running == 0);
+
+    std::uint64_t now = c.Current();
+    CHECK(now >= last && now <= c.Total());
+    last = now;
+
+    unsigned int before = sampler.Updates();
+    int value = sampler.Value();
+    ProgressSampler::Changes changes = sampler.Sample(c, steps);
+    ++frames;
+
+    CHECK(!changes.marquee);
+    CHECK_EQUAL(frames == 1, changes.range);
+    CHECK(sampler.Updates() - before <= (frames == 1 ? 2u : 1u));
+    CHECK(sampler.Value() >= value);
+
+    if (finished) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+
+  for (auto& t : workers) {
+    t.join();
+  }
+
+  CHECK_EQUAL(c.Total(), c.Current());
+  CHECK_EQUAL(100, c.Scaled(100));
+
+  // One message per visible step at most, against 1.6 million Adds
+  CHECK_EQUAL(steps, sampler.Value());
+  CHECK(sampler.Updates() <= 1u + steps + 1u);
+  CHECK(sampler.Updates() <= frames + 1);
+}
+
+TEST(AddTakesACount) {
+  ProgressChannel c;
+  c.Add(5);
+  c.Add();
+  c.AddTotal(10);
+  c.AddTotal(10);
+
+  CHECK_EQUAL(6u, c.Current());
+  CHECK_EQUAL(20u, c.Total());
+}
+
+TEST(ScaledRoundsDown) {
+  ProgressChannel c;
+  c.SetTotal(3);
+
+  CHECK_EQUAL(0, c.Scaled(100));
+  c.Add();
+  CHECK_EQUAL(33, c.Scaled(100));
+  c.Add();
+  CHECK_EQUAL(66, c.Scaled(100));
+  c.Add();
+  CHECK_EQUAL(100, c.Scaled(100));
+}
+
+TEST(ScaledIsZeroWithoutATotal) {
+  ProgressChannel c;
+  c.Add(10);
+
+  CHECK_EQUAL(0, c.Scaled(100));
+
+  c.SetTotal(20);
+  CHECK_EQUAL(0, c.Scaled(0));
+  CHECK_EQUAL(0, c.Scaled(-5));
+}
+
+TEST(ScaledClampsOvershoot) {
+  ProgressChannel c;
+  c.SetTotal(10);
+  c.Add(15);
+
+  CHECK_EQUAL(400, c.Scaled(400));
+}
+
+TEST(ScaledHandlesTotalsTooLargeToMultiply) {
+  ProgressChannel c;
+  std::uint64_t total = std::uint64_t(1) << 62;
+
+  c.SetTotal(total);
+  c.Add(total / 4);
+
+  CHECK_EQUAL(250, c.Scaled(1000));
+}
+
+TEST(ResetClearsCountAndSetsTotal) {
+  ProgressChannel c;
+  c.SetTotal(10);
+  c.Add(7);
+
+  c.Reset(50);
+  CHECK_EQUAL(0u, c.Current());
+  CHECK_EQUAL(50u, c.Total());
+
+  c.Reset();
+  CHECK_EQUAL(0u, c.Total());
+}
+
+TEST(MarqueeIsIndependentOfCounts) {
+  ProgressChannel c;
+  CHECK(!c.Marquee());
+
+  c.SetMarquee(true);
+  c.Add(3);
+  CHECK(c.Marquee());
+  CHECK_EQUAL(3u, c.Current());
+
+  c.SetMarquee(false);
+  CHECK(!c.Marquee());
+}
+
+TEST(SamplerOnlyReportsChanges) {
+  ProgressChannel c;
+  ProgressSampler s;
+  c.SetTotal(100);
+
+  ProgressSampler::Changes first = s.Sample(c, 10);
+  CHECK(!first.marquee && first.range && first.value);
+  CHECK_EQUAL(0, s.Value());
+  CHECK_EQUAL(2u, s.Updates());
+
+  // Less than a step's worth of progress isn't sent
+  c.Add(9);
+  ProgressSampler::Changes none = s.Sample(c, 10);
+  CHECK(!none.marquee && !none.range && !none.value);
+  CHECK_EQUAL(2u, s.Updates());
+
+  c.Add(1);
+  CHECK(s.Sample(c, 10).value);
+  CHECK_EQUAL(1, s.Value());
+  CHECK_EQUAL(3u, s.Updates());
+}
+
+TEST(SamplerResendsThePositionWithANewRange) {
+  ProgressChannel c;
+  ProgressSampler s;
+  c.SetTotal(4);
+  c.Add(2);
+
+  s.Sample(c, 10);
+  CHECK_EQUAL(5, s.Value());
+
+  // The bar was resized: the range changes, & the position with it even
+  // though it scales to the same value
+  ProgressSampler::Changes resized = s.Sample(c, 20);
+  CHECK(resized.range && resized.value);
+  CHECK_EQUAL(20, s.Steps());
+  CHECK_EQUAL(10, s.Value());
+
+  c.Add(2);
+  s.Sample(c, 20);
+  ProgressSampler::Changes again = s.Sample(c, 20);
+  CHECK(!again.range && !again.value);
+  CHECK_EQUAL(5u, s.Updates());
+}
+
+TEST(SamplerIgnoresThePositionInMarquee) {
+  ProgressChannel c;
+  ProgressSampler s;
+  c.SetTotal(10);
+
+  s.Sample(c, 10);
+  c.SetMarquee(true);
+  c.Add(5);
+
+  ProgressSampler::Changes on = s.Sample(c, 10);
+  CHECK(on.marquee && !on.range && !on.value);
+  CHECK(s.Marquee());
+  CHECK_EQUAL(0, s.Value());
+
+  ProgressSampler::Changes still = s.Sample(c, 10);
+  CHECK(!still.marquee && !still.value);
+
+  c.SetMarquee(false);
+  ProgressSampler::Changes off = s.Sample(c, 10);
+  CHECK(off.marquee && off.value);
+  CHECK_EQUAL(5, s.Value());
+}
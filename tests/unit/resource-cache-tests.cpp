@@ -0,0 +1,230 @@
+#include "unit.hpp"
+#include "resource-cache.hpp"
+#include <map>
+#include <thread>
+
+using namespace jwt;
+
+namespace {
+  // Hands out sequential handles & records what is loaded
+  struct FakeLoader
+    : ResourceCache::Loader
+  {
+    FakeLoader() : next(1), loads(0), frees(0), fail(false) {}
+
+    ResourceCache::Handle Load(const ResourceKey& k, std::size_t& bytes) {
+      if (fail) {
+        return 0;
+      }
+
+      ++loads;
+      bytes = (std::size_t) k.cx;
+      ResourceCache::Handle h = next++;
+      loaded[h] = k.id;
+      return h;
+    }
+
+    void Free(const ResourceKey& k, ResourceCache::Handle h) {
+      ++frees;
+      CHECK(loaded.count(h) == 1 && loaded[h] == k.id);
+      loaded.erase(h);
+    }
+
+    ResourceCache::Handle next;
+    int loads;
+    int frees;
+    bool fail;
+    std::map<ResourceCache::Handle, unsigned int> loaded;
+  };
+
+  // A resource with the given id taking `bytes` of the budget
+  ResourceKey Key(unsigned int id, int bytes = 10) {
+    ResourceKey k = { 0x400000, 1, id, bytes, 0 };
+    return k;
+  }
+}
+
+TEST(SecondAcquireIsAHit) {
+  FakeLoader l;
+  ResourceCache c(l, 100);
+
+  ResourceCache::Handle a = c.Acquire(Key(1));
+  ResourceCache::Handle b = c.Acquire(Key(1));
+
+  CHECK(a != 0);
+  CHECK_EQUAL(a, b);
+  CHECK_EQUAL(1, l.loads);
+
+  ResourceCache::Stats s = c.GetStats();
+  CHECK_EQUAL(1u, s.hits);
+  CHECK_EQUAL(1u, s.misses);
+  CHECK_EQUAL(1u, s.entries);
+  CHECK_EQUAL(10u, s.bytes);
+
+  c.Release(a);
+  c.Release(b);
+}
+
+TEST(KeysDifferingOnlyInSizeAreDistinct) {
+  FakeLoader l;
+  ResourceCache c(l, 1000);
+
+  ResourceKey small = Key(1, 16);
+  ResourceKey large = Key(1, 32);
+
+  ResourceRef a(c, c.Acquire(small));
+  ResourceRef b(c, c.Acquire(large));
+
+  CHECK(a.Get() != b.Get());
+  CHECK_EQUAL(2, l.loads);
+}
+
+TEST(UnreferencedResourcesStayWithinTheBudget) {
+  FakeLoader l;
+  ResourceCache c(l, 25);
+
+  c.Release(c.Acquire(Key(1)));
+  c.Release(c.Acquire(Key(2)));
+  CHECK_EQUAL(0, l.frees);
+
+  // 30 bytes: the least recently used goes
+  c.Release(c.Acquire(Key(3)));
+  CHECK_EQUAL(1, l.frees);
+  CHECK(l.loaded.size() == 2);
+  CHECK_EQUAL(1u, c.GetStats().evictions);
+
+  // Key 1 was the one evicted
+  c.Release(c.Acquire(Key(1)));
+  CHECK_EQUAL(4, l.loads);
+}
+
+TEST(UseRefreshesRecency) {
+  FakeLoader l;
+  ResourceCache c(l, 20);
+
+  c.Release(c.Acquire(Key(1)));
+  c.Release(c.Acquire(Key(2)));
+
+  // Touch 1, so 2 is now the oldest
+  c.Release(c.Acquire(Key(1)));
+  c.Release(c.Acquire(Key(3)));
+
+  int loads = l.loads;
+  c.Release(c.Acquire(Key(1)));
+  CHECK_EQUAL(loads, l.loads);
+}
+
+TEST(ReferencedResourcesAreNeverEvicted) {
+  FakeLoader l;
+  ResourceCache c(l, 10);
+
+  ResourceRef a(c, c.Acquire(Key(1)));
+  ResourceRef b(c, c.Acquire(Key(2)));
+  ResourceRef d(c, c.Acquire(Key(3)));
+
+  // Over budget, but everything is in use
+  CHECK_EQUAL(0, l.frees);
+  CHECK_EQUAL(30u, c.GetStats().bytes);
+
+  b.Reset();
+  d.Reset();
+  CHECK_EQUAL(2, l.frees);
+  CHECK_EQUAL(10u, c.GetStats().bytes);
+}
+
+TEST(ResourceRefCopiesCountAsReferences) {
+  FakeLoader l;
+  ResourceCache c(l, 0);
+
+  ResourceRef a(c, c.Acquire(Key(1)));
+  {
+    ResourceRef copy = a;
+    ResourceRef moved = std::move(copy);
+    CHECK(!copy);
+    CHECK(moved);
+  }
+  CHECK_EQUAL(0, l.frees);
+
+  a = ResourceRef();
+  CHECK_EQUAL(1, l.frees);
+}
+
+TEST(LoaderFailureIsNotCached) {
+  FakeLoader l;
+  ResourceCache c(l, 100);
+
+  l.fail = true;
+  CHECK_EQUAL(ResourceCache::Handle(0), c.Acquire(Key(1)));
+  CHECK(!ResourceRef(c, 0));
+
+  l.fail = false;
+  ResourceRef r(c, c.Acquire(Key(1)));
+  CHECK(r);
+  CHECK_EQUAL(2u, c.GetStats().misses);
+}
+
+TEST(SetBudgetAndPurgeEvictImmediately) {
+  FakeLoader l;
+  ResourceCache c(l, 100);
+
+  for (unsigned int i = 1; i <= 5; ++i) {
+    c.Release(c.Acquire(Key(i)));
+  }
+  ResourceRef kept(c, c.Acquire(Key(6)));
+
+  c.SetBudget(30);
+  CHECK_EQUAL(30u, c.GetStats().bytes);
+
+  c.Purge();
+  CHECK_EQUAL(1u, c.GetStats().entries);
+  CHECK(kept);
+}
+
+TEST(DestructorFreesEverything) {
+  FakeLoader l;
+  {
+    ResourceCache c(l, 100);
+    c.Release(c.Acquire(Key(1)));
+    c.Acquire(Key(2));
+  }
+  CHECK(l.loaded.empty());
+}
+
+TEST(SurvivesRehashingWithManyEntries) {
+  FakeLoader l;
+  ResourceCache c(l, 1000000);
+
+  // Enough entries to rehash several times while earlier ones are held
+  std::vector<ResourceRef> refs;
+  for (unsigned int i = 0; i < 5000; ++i) {
+    refs.push_back(ResourceRef(c, c.Acquire(Key(i, 1))));
+  }
+
+  refs.clear();
+  c.Purge();
+
+  CHECK(l.loaded.empty());
+  CHECK_EQUAL(0u, c.GetStats().entries);
+}
+
+TEST(ConcurrentAcquireAndRelease) {
+  FakeLoader l;
+  ResourceCache c(l, 50);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&c, t]() {
+      for (unsigned int i = 0; i < 20000; ++i) {
+        ResourceRef r(c, c.Acquire(Key((i * 7 + t) % 16)));
+      }
+    });
+  }
+
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  ResourceCache::Stats s = c.GetStats();
+  CHECK_EQUAL(80000u, s.hits + s.misses);
+  CHECK(s.bytes <= 50);
+}
@@ -0,0 +1,91 @@
+#include "unit.hpp"
+#include "scene-graph.hpp"
+#include <iostream>
+
+using namespace jwt;
+
+//
+// Repaints of a 100k-node scene after changes of different sizes. Build with
+// -DJWT_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release.
+//
+
+namespace {
+  typedef SceneGraph G;
+
+  // 250 rows of 400 4x4 squares, 5px apart, each row a group
+  const int ROWS = 250, COLUMNS = 400, PITCH = 5, SIDE = 4;
+
+  struct Scene {
+    G graph;
+    Raster raster;
+    std::vector<G::Id> squares;
+    std::vector<Box> dirty;
+
+    Scene() : raster(COLUMNS * PITCH, ROWS * PITCH) {
+      for (int row = 0; row < ROWS; ++row) {
+        G::Id group = graph.Add(G::ROOT, Box{ 0, 0, COLUMNS * PITCH, SIDE });
+        graph.SetTransform(group, 0, row * PITCH);
+
+        for (int column = 0; column < COLUMNS; ++column) {
+          squares.push_back(graph.Add(group, Box{ column * PITCH, 0, SIDE, SIDE }, 0xFF0000FFu));
+        }
+      }
+      Repaint();
+    }
+
+    void Repaint() {
+      dirty.clear();
+      graph.TakeDirty(dirty);
+
+      for (const Box& b : dirty) {
+        graph.Render(raster, b);
+      }
+    }
+
+    // Recolours a side x side block of squares & repaints, n times
+    void Change(int side, std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i) {
+        std::uint32_t color = (i & 1) ? 0xFF0000FFu : 0xFFFF0000u;
+
+        for (int row = 0; row < side; ++row) {
+          for (int column = 0; column < side; ++column) {
+            graph.SetColor(squares[(std::size_t) (100 + row) * COLUMNS + 100 + column], color);
+          }
+        }
+        Repaint();
+      }
+    }
+  };
+
+  // Times n repaints of a side x side change & reports the work per repaint
+  double Measure(Scene& s, const char* what, int side, std::uint64_t n) {
+    std::uint64_t drawn = s.graph.NodesDrawn(), written = s.raster.PixelsWritten();
+
+    double ns = unit::Time(what, n, [&](std::uint64_t n) {
+      s.Change(side, n);
+    });
+
+    std::cout << "    " << (s.graph.NodesDrawn() - drawn) / n << " nodes, "
+      << (s.raster.PixelsWritten() - written) / n << " pixels per repaint\n";
+    return ns;
+  }
+}
+
+TEST(RepaintCostFollowsTheChange) {
+  Scene s;
+  CHECK_EQUAL((std::size_t) (ROWS + ROWS * COLUMNS), s.graph.Size());
+
+  double one = Measure(s, "Repaint of 1 changed square", 1, 100000);
+  double hundred = Measure(s, "Repaint of 100 changed squares", 10, 10000);
+  double block = Measure(s, "Repaint of 2500 changed squares", 50, 200);
+
+  std::uint64_t drawn = s.graph.NodesDrawn();
+  double full = unit::Time("Full repaint", 50, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      s.graph.Render(s.raster, s.raster.Bounds());
+    }
+  });
+  CHECK_EQUAL(s.graph.Size() * 50, s.graph.NodesDrawn() - drawn);
+
+  CHECK(one < hundred && hundred < block && block < full);
+}
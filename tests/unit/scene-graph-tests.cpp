@@ -0,0 +1,322 @@
+#include "unit.hpp"
+#include "scene-graph.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace jwt;
+
+namespace {
+  typedef SceneGraph G;
+
+  // Deterministic pseudo-random numbers for the comparison test
+  struct Lcg {
+    std::uint32_t state;
+
+    explicit Lcg(std::uint32_t seed) : state(seed) {}
+
+    std::uint32_t Next(std::uint32_t bound) {
+      state = state * 1664525u + 1013904223u;
+      return (state >> 8) % bound;
+    }
+
+    int Between(int lo, int hi) {
+      return lo + (int) Next((std::uint32_t) (hi - lo));
+    }
+  };
+
+  Box B(int x, int y, int w, int h) {
+    Box b = { x, y, w, h };
+    return b;
+  }
+
+  bool SamePixels(const Raster& a, const Raster& b) {
+    for (int y = 0; y < a.Height(); ++y) {
+      if (!std::equal(a.Row(y), a.Row(y) + a.Width(), b.Row(y))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Renders only what changed, as a window does between paints
+  void RenderDirty(G& g, Raster& r) {
+    std::vector<Box> dirty;
+    g.TakeDirty(dirty);
+
+    for (const Box& b : dirty) {
+      g.Render(r, b);
+    }
+  }
+
+  // Horizontal stripes, two pixels apart from the top of the node, so that
+  // what's drawn depends on where the node is & not just on the area
+  void Stripes(Raster& r, const Box& world, const Box& clip) {
+    for (int y = clip.y; y < clip.y + clip.h; ++y) {
+      if ((y - world.y) % 2 == 0) {
+        r.Clear(B(clip.x, y, clip.w, 1), 0xFF102030u);
+      }
+    }
+  }
+
+  std::uint32_t RandomColor(Lcg& rng) {
+    static const std::uint32_t alphas[] = { 0x00, 0x40, 0x80, 0xFF, 0xFF };
+    return (alphas[rng.Next(5)] << 24) | rng.Next(0x1000000);
+  }
+}
+
+TEST(RemovedIdsAndTheirDescendantsBecomeInvalid) {
+  G g;
+  G::Id a = g.Add(G::ROOT, B(0, 0, 10, 10), 0xFF0000FFu);
+  G::Id child = g.Add(a, B(1, 1, 2, 2), 0xFF00FF00u);
+  G::Id b = g.Add(G::ROOT, B(20, 0, 10, 10), 0xFFFF0000u);
+
+  CHECK_EQUAL(3u, g.Size());
+  CHECK_EQUAL(a, g.Parent(child));
+  CHECK_EQUAL(G::ROOT, g.Parent(a));
+
+  g.Remove(a);
+  CHECK(!g.Valid(a) && !g.Valid(child));
+  CHECK(g.Valid(b) && g.Valid(G::ROOT));
+  CHECK_EQUAL(1u, g.Size());
+
+  // Slots are reused under a new generation
+  G::Id c = g.Add(G::ROOT, B(0, 0, 1, 1));
+  CHECK(g.Valid(c) && c != a && c != child);
+  CHECK(!g.Valid(a) && !g.Valid(child));
+
+  g.Clear();
+  CHECK_EQUAL(0u, g.Size());
+  CHECK(g.Valid(G::ROOT) && !g.Valid(b));
+}
+
+TEST(TransformsScaleAndClipTheVisibleArea) {
+  G g;
+  G::Id group = g.Add(G::ROOT, B(0, 0, 50, 50));
+  g.SetTransform(group, 100, 10, 2.0, 0.5);
+
+  G::Id child = g.Add(group, B(10, 10, 20, 20), 0xFF000000u);
+  G::Id inner = g.Add(child, B(0, 0, 5, 5), 0xFF000000u);
+  g.SetTransform(inner, 3, 4);
+
+  std::vector<Box> dirty;
+  g.TakeDirty(dirty);
+
+  CHECK(g.Visible(group) == B(100, 10, 100, 25));
+  CHECK(g.Visible(child) == B(120, 15, 40, 10));
+
+  // Translation is in the parent's coordinates, so it's scaled too
+  CHECK(g.Visible(inner) == B(106, 12, 10, 3));
+
+  // Rounded outwards
+  g.SetTransform(child, 0, 0, 1.0, 1.0 / 3.0);
+  g.TakeDirty(dirty);
+  CHECK(g.Visible(child) == B(120, 11, 40, 4));
+
+  // CLIP cuts off descendants at the node's box
+  g.SetTransform(child, 0, 0);
+  g.SetBounds(child, B(0, 0, 60, 60));
+  g.SetFlags(group, G::CLIP, true);
+  g.TakeDirty(dirty);
+  CHECK(g.Visible(child) == B(100, 10, 100, 25));
+
+  // Hiding a node hides its subtree
+  g.SetFlags(group, G::VISIBLE, false);
+  g.TakeDirty(dirty);
+  CHECK(g.Visible(group).Empty());
+  CHECK(g.Visible(child).Empty());
+  CHECK(g.Visible(inner).Empty());
+}
+
+TEST(QueryIsInDrawingOrder) {
+  G g;
+  G::Id a = g.Add(G::ROOT, B(0, 0, 100, 100), 0xFF000000u);
+  G::Id a1 = g.Add(a, B(10, 10, 10, 10), 0xFF000000u);
+  G::Id b = g.Add(G::ROOT, B(5, 5, 100, 100), 0xFF000000u);
+  G::Id a2 = g.Add(a, B(15, 15, 10, 10), 0xFF000000u);
+
+  std::vector<G::Id> out;
+  g.Query(B(0, 0, 50, 50), out);
+  CHECK(out == (std::vector<G::Id>{ a, a1, a2, b }));
+
+  g.Raise(a);
+  g.Raise(a1);
+  g.Query(B(0, 0, 50, 50), out);
+  CHECK(out == (std::vector<G::Id>{ b, a, a2, a1 }));
+
+  g.Query(B(200, 200, 10, 10), out);
+  CHECK(out.empty());
+}
+
+TEST(RenderDrawsParentsBeforeChildren) {
+  G g;
+  Raster r(8, 4);
+
+  g.SetBackground(0xFF000000u);
+  G::Id a = g.Add(G::ROOT, B(0, 0, 4, 4), 0xFFFF0000u);
+  g.Add(a, B(1, 1, 2, 2), 0xFF00FF00u);
+  g.Add(G::ROOT, B(6, 0, 10, 2), 0x80FFFFFFu);
+
+  g.Render(r, r.Bounds());
+
+  CHECK_EQUAL(0xFFFF0000u, r.Pixel(0, 0));
+  CHECK_EQUAL(0xFF00FF00u, r.Pixel(1, 1));
+  CHECK_EQUAL(0xFF000000u, r.Pixel(5, 0));
+  CHECK_EQUAL(0xFF808080u, r.Pixel(6, 0));
+  CHECK_EQUAL(0xFF000000u, r.Pixel(7, 2));
+  CHECK_EQUAL(3u, g.NodesDrawn());
+}
+
+TEST(NothingChangedMeansNothingDirty) {
+  G g;
+  G::Id a = g.Add(G::ROOT, B(0, 0, 10, 10), 0xFF000000u);
+
+  std::vector<Box> dirty;
+  g.TakeDirty(dirty);
+  CHECK(dirty.size() == 1 && dirty[0] == B(0, 0, 10, 10));
+  CHECK(!g.Dirty());
+
+  g.SetColor(a, 0xFF000000u);
+  g.SetBounds(a, B(0, 0, 10, 10));
+  g.SetTransform(a, 0, 0);
+  g.SetFlags(a, G::VISIBLE, true);
+  g.Raise(a);
+  CHECK(!g.Dirty());
+
+  // A move covers where it was & where it is, without overlaps
+  dirty.clear();
+  g.SetTransform(a, 5, 0);
+  g.TakeDirty(dirty);
+  CHECK(dirty.size() == 1 && dirty[0] == B(0, 0, 15, 10));
+
+  dirty.clear();
+  g.SetTransform(a, 100, 0);
+  g.TakeDirty(dirty);
+  CHECK(dirty.size() == 2);
+  CHECK(!dirty[0].Intersects(dirty[1]));
+}
+
+TEST(RenderingTheDirtyAreasMatchesAFullRender) {
+  G g;
+  Lcg rng(5);
+
+  Raster incremental(300, 200), full(300, 200);
+  std::vector<G::Id> ids;
+
+  g.Render(incremental, incremental.Bounds());
+
+  for (int step = 0; step < 2000; ++step) {
+    for (int changes = 1 + (int) rng.Next(3); changes > 0; --changes) {
+      std::uint32_t op = rng.Next(20);
+
+      if (op < 5 || ids.size() < 4) {
+        G::Id parent = (ids.empty() || rng.Next(3) == 0) ? G::ROOT : ids[rng.Next((std::uint32_t) ids.size())];
+        Box b = B(rng.Between(-50, 300), rng.Between(-50, 200), (int) rng.Next(120), (int) rng.Next(80));
+        ids.push_back(g.Add(parent, b, RandomColor(rng)));
+        continue;
+      }
+
+      G::Id id = ids[rng.Next((std::uint32_t) ids.size())];
+
+      switch (op) {
+      case 5:
+        g.Remove(id);
+        ids.erase(std::remove_if(ids.begin(), ids.end(), [&](G::Id i) { return !g.Valid(i); }), ids.end());
+        break;
+      case 6:
+      case 7:
+        g.SetBounds(id, B(rng.Between(-50, 300), rng.Between(-50, 200), (int) rng.Next(120), (int) rng.Next(80)));
+        break;
+      case 8:
+      case 9: {
+        static const double scales[] = { 0.5, 1.0, 1.0, 1.5, 2.0 };
+        g.SetTransform(id, rng.Between(-40, 40), rng.Between(-40, 40), scales[rng.Next(5)], scales[rng.Next(5)]);
+        break;
+      }
+      case 10:
+      case 11:
+        g.SetColor(id, RandomColor(rng));
+        break;
+      case 12:
+        g.SetFlags(id, G::VISIBLE, rng.Next(3) != 0);
+        break;
+      case 13:
+        g.SetFlags(id, G::CLIP, rng.Next(2) != 0);
+        break;
+      case 14:
+      case 15:
+        g.Raise(id);
+        break;
+      case 16:
+        g.SetPainter(id, (rng.Next(2) == 0) ? G::Painter(Stripes) : G::Painter());
+        break;
+      case 17:
+        if (rng.Next(10) == 0) {
+          g.SetBackground(0xFF000000u | rng.Next(0x1000000));
+        }
+        break;
+      default:
+        g.Invalidate(id);
+        break;
+      }
+    }
+
+    RenderDirty(g, incremental);
+    g.Render(full, full.Bounds());
+
+    if (!SamePixels(incremental, full)) {
+      unit::Fail(__FILE__, __LINE__, "incremental render differs at step " + std::to_string(step));
+      return;
+    }
+  }
+
+  CHECK(g.Size() > 20);
+}
+
+TEST(ASmallChangeInALargeSceneRedrawsLittle) {
+  G g;
+
+  // 100 rows of 100 16x16 squares, 20px apart, each row a group
+  Raster r(2000, 2000);
+  std::vector<G::Id> squares;
+
+  for (int row = 0; row < 100; ++row) {
+    G::Id group = g.Add(G::ROOT, B(0, 0, 2000, 16));
+    g.SetTransform(group, 0, row * 20);
+    for (int column = 0; column < 100; ++column) {
+      squares.push_back(g.Add(group, B(column * 20, 0, 16, 16), 0xFF0000FFu));
+    }
+  }
+
+  RenderDirty(g, r);
+  CHECK_EQUAL(10100u, g.NodesDrawn());
+
+  // A colour redraws the square & the group behind it
+  std::uint64_t drawn = g.NodesDrawn(), written = r.PixelsWritten();
+
+  g.SetColor(squares[5050], 0xFFFF0000u);
+  RenderDirty(g, r);
+
+  CHECK_EQUAL(2u, g.NodesDrawn() - drawn);
+  CHECK_EQUAL(2u * 16 * 16, r.PixelsWritten() - written);     // background & fill
+  CHECK_EQUAL(0xFFFF0000u, r.Pixel(50 * 20 + 3, 50 * 20 + 3));
+
+  // A move redraws where it was & where it is, as one box
+  drawn = g.NodesDrawn();
+  written = r.PixelsWritten();
+
+  g.SetBounds(squares[5050], B(50 * 20 + 2, 0, 16, 16));
+  RenderDirty(g, r);
+
+  CHECK_EQUAL(2u, g.NodesDrawn() - drawn);
+  CHECK_EQUAL(18u * 16 + 16 * 16, r.PixelsWritten() - written);
+  CHECK_EQUAL(0xFFFFFFFFu, r.Pixel(50 * 20 + 1, 50 * 20 + 3));
+
+  // Against a full repaint
+  drawn = g.NodesDrawn();
+  written = r.PixelsWritten();
+  g.Render(r, r.Bounds());
+
+  CHECK_EQUAL(10100u, g.NodesDrawn() - drawn);
+  CHECK(r.PixelsWritten() - written >= 2000u * 2000);
+}
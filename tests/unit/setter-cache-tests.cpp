@@ -0,0 +1,167 @@
+#include "unit.hpp"
+#include "setter-cache.hpp"
+#include <set>
+#include <string>
+
+using namespace jwt;
+
+namespace {
+  // Straightforward 64-bit FNV-1a, to check Hash against
+  std::uint64_t Fnv1a(const void* data, std::size_t n, std::uint64_t h = 14695981039346656037ULL) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < n; ++i) {
+      h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return h;
+  }
+}
+
+TEST(SkipMissesUntilAValueIsStored) {
+  SetterCache c;
+
+  CHECK(!c.Skip(SetterCache::TEXT, 42));
+  c.Store(SetterCache::TEXT, 42);
+
+  CHECK(c.Skip(SetterCache::TEXT, 42));
+  CHECK(c.Skip(SetterCache::TEXT, 42));
+  CHECK(!c.Skip(SetterCache::TEXT, 43));
+
+  CHECK_EQUAL(2u, c.Skipped());
+  CHECK_EQUAL(1u, c.Written());
+}
+
+TEST(StoreReplacesTheLastValue) {
+  SetterCache c;
+  c.Store(SetterCache::VALUE, 1);
+  c.Store(SetterCache::VALUE, 2);
+
+  CHECK(!c.Skip(SetterCache::VALUE, 1));
+  CHECK(c.Skip(SetterCache::VALUE, 2));
+  CHECK_EQUAL(2u, c.Written());
+}
+
+TEST(KeysAreIndependent) {
+  SetterCache c;
+  c.Store(SetterCache::VALUE, 7);
+
+  CHECK(!c.Skip(SetterCache::RANGE, 7));
+  CHECK(!c.Skip(SetterCache::PART_TEXT + 1, 7));
+  CHECK(c.Skip(SetterCache::VALUE, 7));
+}
+
+TEST(ForgetDropsOnlyTheGivenKeys) {
+  SetterCache c;
+  c.Store(SetterCache::TEXT, 1);
+  for (unsigned int i = 0; i < 4; ++i) {
+    c.Store(SetterCache::PART_TEXT + i, 10 + i);
+  }
+
+  // As SetParts does when the part count changes
+  c.Forget(SetterCache::PART_TEXT + 2, SetterCache::PART_TEXT_LAST);
+  CHECK(c.Skip(SetterCache::PART_TEXT + 0, 10));
+  CHECK(c.Skip(SetterCache::PART_TEXT + 1, 11));
+  CHECK(!c.Skip(SetterCache::PART_TEXT + 2, 12));
+  CHECK(!c.Skip(SetterCache::PART_TEXT + 3, 13));
+
+  c.Forget(SetterCache::TEXT);
+  CHECK(!c.Skip(SetterCache::TEXT, 1));
+  CHECK(c.Skip(SetterCache::PART_TEXT + 0, 10));
+}
+
+TEST(ExternalChangeInvalidates) {
+  // The control's text is "a" & the cache knows it; the user then types "b"
+  // (which the cache can't see) & the program sets "a" again
+  SetterCache c;
+  std::uint64_t a = SetterCache::Hash(L"a");
+  c.Store(SetterCache::TEXT, a);
+
+  // Without invalidation the write that puts "a" back would be lost
+  CHECK(c.Skip(SetterCache::TEXT, a));
+
+  // Resync (& Edit's change notification) clear the cache
+  c.Clear();
+  CHECK(!c.Skip(SetterCache::TEXT, a));
+  c.Store(SetterCache::TEXT, a);
+  CHECK(c.Skip(SetterCache::TEXT, a));
+}
+
+TEST(DisabledCacheNeverSkips) {
+  SetterCache c;
+  c.Store(SetterCache::TEXT, 5);
+
+  c.Enable(false);
+  CHECK(!c.Enabled());
+  CHECK(!c.Skip(SetterCache::TEXT, 5));
+
+  // Writes are still counted but not remembered
+  c.Store(SetterCache::TEXT, 5);
+  CHECK_EQUAL(2u, c.Written());
+
+  c.Enable(true);
+  CHECK(!c.Skip(SetterCache::TEXT, 5));
+  CHECK_EQUAL(0u, c.Skipped());
+}
+
+TEST(HashIsFnv1aOverTheLengthAndCharacters) {
+  std::wstring s = L"Hello, world";
+  std::size_t n = s.size();
+  std::uint64_t expected = Fnv1a(s.data(), n * sizeof(wchar_t), Fnv1a(&n, sizeof(n)));
+  CHECK_EQUAL(expected, SetterCache::Hash(s));
+
+  const int values[] = { 100, -1, 0, 250 };
+  std::size_t count = 4;
+  expected = Fnv1a(values, sizeof(values), Fnv1a(&count, sizeof(count)));
+  CHECK_EQUAL(expected, SetterCache::Hash(values, count));
+}
+
+TEST(HashTellsLengthsApart) {
+  // Trailing nulls & zeros hash the same bytes apart from the length
+  CHECK(SetterCache::Hash(std::wstring(L"a")) != SetterCache::Hash(std::wstring(L"a\0", 2)));
+  CHECK(SetterCache::Hash(std::wstring()) != SetterCache::Hash(std::wstring(1, L'\0')));
+
+  const int zeros[] = { 0, 0 };
+  CHECK(SetterCache::Hash(zeros, 0) != SetterCache::Hash(zeros, 1));
+  CHECK(SetterCache::Hash(zeros, 1) != SetterCache::Hash(zeros, 2));
+}
+
+TEST(HashHasNoCollisionsAmongSimilarStrings) {
+  // Every one- & two-character string over a small alphabet, plus numbered
+  // labels: the kind of near-identical text status bars cycle through
+  std::set<std::uint64_t> seen;
+  std::size_t made = 0;
+
+  for (wchar_t a = 32; a < 160; ++a) {
+    seen.insert(SetterCache::Hash(std::wstring(1, a)));
+    ++made;
+
+    for (wchar_t b = 32; b < 160; ++b) {
+      seen.insert(SetterCache::Hash(std::wstring{ a, b }));
+      ++made;
+    }
+  }
+  for (int i = 0; i < 50000; ++i) {
+    seen.insert(SetterCache::Hash(L"Line " + std::to_wstring(i)));
+    ++made;
+  }
+
+  CHECK_EQUAL(made, seen.size());
+}
+
+TEST(CollidingValuesAreSkipped) {
+  // The documented limitation: the cache compares hashes, so two different
+  // values that hash alike look unchanged. Packed pairs are exact, though.
+  SetterCache c;
+  c.Store(SetterCache::RANGE, SetterCache::Pack(0, 100));
+
+  CHECK(c.Skip(SetterCache::RANGE, SetterCache::Pack(0, 100)));
+  CHECK(!c.Skip(SetterCache::RANGE, SetterCache::Pack(100, 0)));
+  CHECK(!c.Skip(SetterCache::RANGE, SetterCache::Pack(-1, 100)));
+
+  // Were "second" to hash like "first", setting it would be skipped: only
+  // the hash is asked about
+  std::uint64_t first = SetterCache::Hash(L"first");
+  std::uint64_t second = first;
+  c.Store(SetterCache::TEXT, first);
+  CHECK(c.Skip(SetterCache::TEXT, second));
+  CHECK(!c.Skip(SetterCache::TEXT, SetterCache::Hash(L"second")));
+}
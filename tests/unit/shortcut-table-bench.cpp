@@ -0,0 +1,70 @@
+#include "unit.hpp"
+#include "shortcut-table.hpp"
+
+using namespace jwt;
+
+//
+// Lookups in a table of 2k shortcuts. Build with -DJWT_BENCHMARKS=ON
+// -DCMAKE_BUILD_TYPE=Release.
+//
+
+namespace {
+  typedef ShortcutTable T;
+
+  const int LOOKUPS = 10000000;
+
+  // 2k bindings: every key & modifier combination bound globally, a quarter
+  // of them overridden by one of 16 panes
+  void Fill(ShortcutTable& t) {
+    int command = 0;
+
+    for (unsigned int modifiers = 0; modifiers < 8; ++modifiers) {
+      for (unsigned int vk = 1; vk <= 0xFF; ++vk) {
+        if (t.Size() == 1600) {
+          break;
+        }
+        t.Add(vk, modifiers, T::GLOBAL, 1, command++);
+      }
+    }
+
+    for (unsigned int i = 0; t.Size() < 2000; ++i) {
+      T::Scope pane = 100 + i % 16;
+      t.Add(1 + (i * 7) % 0xFF, i % 8, pane, pane, command++);
+    }
+  }
+}
+
+TEST(LookupsInATableOf2kShortcuts) {
+  ShortcutTable t;
+  Fill(t);
+  CHECK_EQUAL(2000u, t.Size());
+
+  // Compile outside the timing
+  t.Find('A', T::NONE);
+
+  T::Scope chain[] = { 200, 105, 300 };
+  unsigned long long hits = 0;
+
+  unit::Time("Find with a 3-window focus chain", LOOKUPS, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      unsigned int vk = 1 + (unsigned int) (i % 0xFF);
+      unsigned int modifiers = (unsigned int) (i / 0xFF) % 8;
+      hits += (t.Find(vk, modifiers, chain, 3) != nullptr);
+    }
+  });
+
+  unit::Time("Find of an unbound stroke", LOOKUPS, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      hits += (t.Find(1 + (unsigned int) (i % 0xFF), T::ALT | T::CONTROL | T::SHIFT, chain, 3) != nullptr);
+    }
+  });
+
+  unit::Time("recompile after a change", 1000, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      t.Remove(t.Add('Z', T::NONE, 999, 2, -1));
+      hits += (t.Find('Z', T::NONE) != nullptr);
+    }
+  });
+
+  CHECK(hits > 0);
+}
@@ -0,0 +1,249 @@
+#include "unit.hpp"
+#include "shortcut-table.hpp"
+#include <string>
+#include <vector>
+
+using namespace jwt;
+
+namespace {
+  typedef ShortcutTable T;
+
+  const unsigned int F5 = 0x74;    // VK_F5
+
+  // Deterministic pseudo-random numbers for the comparison test
+  struct Lcg {
+    std::uint32_t state;
+
+    explicit Lcg(std::uint32_t seed) : state(seed) {}
+
+    std::uint32_t Next(std::uint32_t bound) {
+      state = state * 1664525u + 1013904223u;
+      return (state >> 8) % bound;
+    }
+  };
+
+  // What Find should do, the slow way: for each scope in turn, the latest
+  // binding for the key
+  const T::Binding* NaiveFind(const std::vector<T::Binding>& bindings, unsigned int vk, unsigned int modifiers,
+                              const T::Scope* scopes, std::size_t count) {
+    for (std::size_t i = 0; i <= count; ++i) {
+      T::Scope scope = (i < count) ? scopes[i] : T::GLOBAL;
+
+      for (auto b = bindings.rbegin(); b != bindings.rend(); ++b) {
+        if (b->vk == vk && b->modifiers == modifiers && b->scope == scope) {
+          return &*b;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  int CommandOf(const T::Binding* b) {
+    return b ? b->command : -1;
+  }
+}
+
+TEST(EmptyTableFindsNothing) {
+  ShortcutTable t;
+
+  CHECK(t.Empty());
+  CHECK(!t.Find('S', T::CONTROL));
+  CHECK(!t.Find(0, T::NONE));
+}
+
+TEST(KeyAndModifiersMustBothMatch) {
+  ShortcutTable t;
+  t.Add('S', T::CONTROL, T::GLOBAL, 1, 100);
+  t.Add('S', T::CONTROL | T::SHIFT, T::GLOBAL, 1, 101);
+
+  CHECK_EQUAL(100, CommandOf(t.Find('S', T::CONTROL)));
+  CHECK_EQUAL(101, CommandOf(t.Find('S', T::CONTROL | T::SHIFT)));
+  CHECK(!t.Find('S', T::NONE));
+  CHECK(!t.Find('S', T::ALT));
+  CHECK(!t.Find('D', T::CONTROL));
+}
+
+TEST(MoreSpecificScopeWins) {
+  ShortcutTable t;
+  const T::Scope frame = 10, pane = 20, editor = 30;
+
+  t.Add(F5, 0, frame, frame, 1);
+  t.Add(F5, 0, pane, pane, 2);
+
+  // The focus is in the editor, inside the pane, inside the frame
+  T::Scope chain[] = { editor, pane, frame };
+  const T::Binding* b = t.Find(F5, 0, chain, 3);
+  CHECK(b && b->command == 2 && b->target == pane);
+
+  // Focus in the frame only
+  CHECK_EQUAL(1, CommandOf(t.Find(F5, 0, frame)));
+
+  // Focus somewhere unrelated: scoped bindings don't apply
+  CHECK(!t.Find(F5, 0, editor));
+}
+
+TEST(GlobalIsTheFallback) {
+  ShortcutTable t;
+  const T::Scope pane = 20, other = 40;
+
+  t.Add('N', T::CONTROL, T::GLOBAL, 1, 1);
+  t.Add('N', T::CONTROL, pane, pane, 2);
+
+  CHECK_EQUAL(2, CommandOf(t.Find('N', T::CONTROL, pane)));
+  CHECK_EQUAL(1, CommandOf(t.Find('N', T::CONTROL, other)));
+  CHECK_EQUAL(1, CommandOf(t.Find('N', T::CONTROL)));
+  CHECK_EQUAL(1, CommandOf(t.Find('N', T::CONTROL, nullptr, 0)));
+}
+
+TEST(LaterBindingHidesAnEarlierOne) {
+  ShortcutTable t;
+  const T::Scope pane = 20;
+
+  T::BindingId first = t.Add('K', 0, pane, pane, 1);
+  T::BindingId second = t.Add('K', 0, pane, pane, 2);
+  CHECK(first != second);
+
+  CHECK_EQUAL(2, CommandOf(t.Find('K', 0, pane)));
+
+  // Removing the later one uncovers the earlier
+  t.Remove(second);
+  CHECK_EQUAL(1, CommandOf(t.Find('K', 0, pane)));
+
+  t.Remove(first);
+  CHECK(!t.Find('K', 0, pane));
+  CHECK(t.Empty());
+}
+
+TEST(RemoveOfAnUnknownIdIsHarmless) {
+  ShortcutTable t;
+  T::BindingId id = t.Add('K', 0, T::GLOBAL, 1, 1);
+
+  t.Remove(id + 100);
+  t.Remove(id);
+  t.Remove(id);
+
+  CHECK(t.Empty());
+  CHECK(!t.Find('K', 0));
+}
+
+TEST(RemoveTargetDropsAllItsBindings) {
+  ShortcutTable t;
+  const std::uintptr_t a = 1, b = 2;
+
+  t.Add('A', 0, T::GLOBAL, a, 1);
+  t.Add('B', 0, 50, a, 2);
+  t.Add('A', 0, 50, b, 3);
+  t.Add('C', 0, T::GLOBAL, b, 4);
+  CHECK_EQUAL(4u, t.Size());
+
+  t.RemoveTarget(a);
+
+  CHECK_EQUAL(2u, t.Size());
+  CHECK(!t.Find('A', 0));
+  CHECK(!t.Find('B', 0, 50));
+  CHECK_EQUAL(3, CommandOf(t.Find('A', 0, 50)));
+  CHECK_EQUAL(4, CommandOf(t.Find('C', 0)));
+
+  // As a destroyed window's WM_DESTROY does, even if it bound nothing
+  t.RemoveTarget(a);
+  t.RemoveTarget(99);
+  CHECK_EQUAL(2u, t.Size());
+}
+
+TEST(ChangesAreSeenByTheNextFind) {
+  ShortcutTable t;
+  t.Add('A', 0, T::GLOBAL, 1, 1);
+  CHECK_EQUAL(1, CommandOf(t.Find('A', 0)));
+
+  // Each change recompiles on the next Find
+  t.Add('B', 0, T::GLOBAL, 1, 2);
+  CHECK_EQUAL(2, CommandOf(t.Find('B', 0)));
+
+  T::BindingId c = t.Add('A', 0, T::GLOBAL, 1, 3);
+  CHECK_EQUAL(3, CommandOf(t.Find('A', 0)));
+
+  t.Remove(c);
+  CHECK_EQUAL(1, CommandOf(t.Find('A', 0)));
+
+  // Growing well past the initial table size still finds everything
+  for (unsigned int vk = 1; vk <= 0xFF; ++vk) {
+    t.Add(vk, T::ALT, T::GLOBAL, 1, (int) (1000 + vk));
+  }
+  for (unsigned int vk = 1; vk <= 0xFF; ++vk) {
+    CHECK_EQUAL((int) (1000 + vk), CommandOf(t.Find(vk, T::ALT)));
+  }
+  CHECK_EQUAL(1, CommandOf(t.Find('A', 0)));
+}
+
+TEST(OutOfRangeKeysFindNothing) {
+  ShortcutTable t;
+  t.Add(0xFF, T::NONE, T::GLOBAL, 1, 1);
+
+  CHECK(!t.Find(0, T::NONE));
+  CHECK(!t.Find(0x100, T::NONE));
+  CHECK(!t.Find(0x1FF, T::NONE));
+}
+
+TEST(MatchesANaiveSearch) {
+  ShortcutTable t;
+  std::vector<T::Binding> naive;
+  std::vector<T::BindingId> ids;
+  Lcg rng(7);
+
+  const T::Scope scopes[] = { T::GLOBAL, 101, 102, 103, 104 };
+
+  for (int step = 0; step < 4000; ++step) {
+    std::uint32_t op = rng.Next(10);
+
+    if (op < 6 || naive.empty()) {
+      // Few keys & scopes, so bindings pile up on the same key
+      unsigned int vk = 'A' + rng.Next(8);
+      unsigned int modifiers = rng.Next(8);
+      T::Scope scope = scopes[rng.Next(5)];
+      std::uintptr_t target = 1 + rng.Next(6);
+
+      T::BindingId id = t.Add(vk, modifiers, scope, target, step);
+      T::Binding b = { vk, modifiers, scope, target, step, id };
+      naive.push_back(b);
+    }
+    else if (op < 9) {
+      std::size_t i = rng.Next((std::uint32_t) naive.size());
+      t.Remove(naive[i].id);
+      naive.erase(naive.begin() + i);
+    }
+    else {
+      std::uintptr_t target = 1 + rng.Next(6);
+      t.RemoveTarget(target);
+
+      std::vector<T::Binding> kept;
+      for (auto& b : naive) {
+        if (b.target != target) {
+          kept.push_back(b);
+        }
+      }
+      naive.swap(kept);
+    }
+
+    CHECK_EQUAL(naive.size(), t.Size());
+
+    // A handful of lookups with random focus chains
+    for (int q = 0; q < 4; ++q) {
+      unsigned int vk = 'A' + rng.Next(9);
+      unsigned int modifiers = rng.Next(8);
+
+      T::Scope chain[3];
+      std::size_t count = rng.Next(4);
+      for (std::size_t i = 0; i < count; ++i) {
+        chain[i] = scopes[1 + rng.Next(4)];
+      }
+
+      const T::Binding* expected = NaiveFind(naive, vk, modifiers, chain, count);
+      const T::Binding* found = t.Find(vk, modifiers, chain, count);
+
+      if (CommandOf(expected) != CommandOf(found)) {
+        unit::Fail(__FILE__, __LINE__, "Find disagrees with the naive search at step " + std::to_string(step));
+        return;
+      }
+    }
+  }
+}
@@ -0,0 +1,227 @@
+#include "unit.hpp"
+#include "status-model.hpp"
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace jwt;
+
+namespace {
+  // Records Flush's calls as one line each
+  struct RecordingSink
+    : StatusModel::Sink
+  {
+    std::vector<std::string> calls;
+
+    void Parts(const int* rightEdges, int count) {
+      std::string s = "parts";
+      for (int i = 0; i < count; ++i) {
+        s += " " + std::to_string(rightEdges[i]);
+      }
+      calls.push_back(s);
+    }
+
+    void Text(int part, const std::wstring& txt) {
+      calls.push_back("text " + std::to_string(part) + " " + std::string(txt.begin(), txt.end()));
+    }
+  };
+}
+
+TEST(NewModelIsCleanAndUnknown) {
+  StatusModel m;
+  RecordingSink sink;
+
+  CHECK(!m.Dirty());
+  CHECK(!m.Known(0));
+  CHECK(m.Text(0).empty());
+  CHECK_EQUAL(0u, m.Flush(sink));
+}
+
+TEST(FirstSetOfAnUnknownPartIsAlwaysDirty) {
+  StatusModel m;
+
+  // Even to empty: the control may be showing something else
+  CHECK(m.SetText(3, L""));
+  CHECK(m.Known(3));
+  CHECK(m.Dirty(3));
+}
+
+TEST(SettingTheSameTextIsNotAChange) {
+  StatusModel m;
+  RecordingSink sink;
+
+  CHECK(m.SetText(0, L"ready"));
+  m.Flush(sink);
+
+  CHECK(!m.SetText(0, L"ready"));
+  CHECK(!m.Dirty());
+
+  CHECK(m.SetText(0, L"busy"));
+  CHECK(m.Dirty(0));
+}
+
+TEST(FlushWritesLayoutThenDirtyPartsInOrder) {
+  StatusModel m;
+  RecordingSink sink;
+
+  const int parts[] = { 100, 200, -1 };
+  m.SetParts(parts, 3);
+  m.SetText(2, L"c");
+  m.SetText(0, L"a");
+
+  CHECK_EQUAL(3u, m.Flush(sink));
+  CHECK_EQUAL(3u, sink.calls.size());
+  if (sink.calls.size() == 3) {
+    CHECK_EQUAL(std::string("parts 100 200 -1"), sink.calls[0]);
+    CHECK_EQUAL(std::string("text 0 a"), sink.calls[1]);
+    CHECK_EQUAL(std::string("text 2 c"), sink.calls[2]);
+  }
+
+  CHECK(!m.Dirty());
+  CHECK_EQUAL(1u, m.Flushes());
+  CHECK_EQUAL(3u, m.Writes());
+}
+
+TEST(ManyChangesBetweenFlushesWriteOnce) {
+  StatusModel m;
+  RecordingSink sink;
+
+  for (int i = 0; i < 1000; ++i) {
+    m.SetText(1, std::to_wstring(i));
+  }
+
+  CHECK_EQUAL(1u, m.Flush(sink));
+  CHECK(sink.calls.size() == 1 && sink.calls[0] == "text 1 999");
+}
+
+TEST(SameLayoutIsNotAChange) {
+  StatusModel m;
+  RecordingSink sink;
+
+  const int parts[] = { 50, -1 };
+  m.SetParts(parts, 2);
+  m.Flush(sink);
+
+  m.SetParts(parts, 2);
+  CHECK(!m.Dirty());
+
+  const int wider[] = { 80, -1 };
+  m.SetParts(wider, 2);
+  CHECK(m.Dirty());
+}
+
+TEST(NewLayoutRewritesOnlyKnownParts) {
+  StatusModel m;
+  RecordingSink sink;
+
+  const int parts[] = { 50, 100, -1 };
+  m.SetParts(parts, 3);
+  m.SetText(1, L"b");
+  m.SetText(7, L"beyond");
+  m.Flush(sink);
+  sink.calls.clear();
+
+  const int other[] = { 60, 120, -1 };
+  m.SetParts(other, 3);
+
+  // Parts 0 & 2 were never set: writing them would blank the control
+  CHECK(!m.Dirty(0));
+  CHECK(m.Dirty(1));
+  CHECK(!m.Dirty(2));
+  CHECK(m.Dirty(7));
+
+  CHECK_EQUAL(3u, m.Flush(sink));
+}
+
+TEST(MarkCleanDropsPendingWrites) {
+  StatusModel m;
+  RecordingSink sink;
+
+  m.SetText(0, L"x");
+  m.MarkClean();
+
+  CHECK(!m.Dirty());
+  CHECK_EQUAL(0u, m.Flush(sink));
+  CHECK(m.Known(0));
+}
+
+TEST(ExtentIsForgottenWhenTextChanges) {
+  StatusModel m;
+  int cx = 0, cy = 0;
+
+  m.SetText(0, L"abc");
+  CHECK(!m.Extent(0, cx, cy));
+
+  m.SetExtent(0, 30, 12);
+  CHECK(m.Extent(0, cx, cy));
+  CHECK_EQUAL(30, cx);
+  CHECK_EQUAL(12, cy);
+
+  // Unchanged text keeps the measurement
+  m.SetText(0, L"abc");
+  CHECK(m.Extent(0, cx, cy));
+
+  m.SetText(0, L"abcd");
+  CHECK(!m.Extent(0, cx, cy));
+
+  m.SetExtent(0, 40, 12);
+  m.ForgetExtents();
+  CHECK(!m.Extent(0, cx, cy));
+}
+
+TEST(GatherPartsCopiesUpToTheLimit) {
+  std::array<int, StatusModel::MAX_PARTS> parts;
+
+  std::vector<int> edges(StatusModel::MAX_PARTS);
+  for (int i = 0; i < StatusModel::MAX_PARTS; ++i) {
+    edges[i] = (i + 1) * 10;
+  }
+
+  CHECK_EQUAL(StatusModel::MAX_PARTS, StatusModel::GatherParts(edges.begin(), edges.end(), parts));
+  CHECK_EQUAL(10, parts[0]);
+  CHECK_EQUAL(StatusModel::MAX_PARTS * 10, parts[StatusModel::MAX_PARTS - 1]);
+}
+
+TEST(GatherPartsThrowsWhenTooLong) {
+  // Laid out so that a write past the array would land in the guard
+  struct {
+    std::array<int, StatusModel::MAX_PARTS> parts;
+    int guard;
+  } out;
+  out.guard = 12345;
+
+  std::vector<int> edges(StatusModel::MAX_PARTS + 1, 7);
+
+  bool threw = false;
+  try {
+    StatusModel::GatherParts(edges.begin(), edges.end(), out.parts);
+  }
+  catch (const std::length_error&) {
+    threw = true;
+  }
+
+  CHECK(threw);
+  CHECK_EQUAL(12345, out.guard);
+}
+
+TEST(SetPartsThrowsWhenTooLongAndKeepsTheLayout) {
+  StatusModel m;
+  const int two[] = { 50, -1 };
+  m.SetParts(two, 2);
+  m.MarkClean();
+
+  std::vector<int> edges(StatusModel::MAX_PARTS + 1, 7);
+
+  bool threw = false;
+  try {
+    m.SetParts(edges.data(), (int) edges.size());
+  }
+  catch (const std::length_error&) {
+    threw = true;
+  }
+
+  CHECK(threw);
+  CHECK_EQUAL(2, m.PartCount());
+  CHECK(!m.Dirty());
+}
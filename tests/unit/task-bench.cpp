@@ -0,0 +1,92 @@
+#include "unit.hpp"
+#include "test-executors.hpp"
+#include "task.hpp"
+#include <future>
+#include <memory>
+
+using namespace jwt;
+using unit::ManualExecutor;
+using unit::ThreadExecutor;
+
+//
+// Resume latency: what a co_await ResumeOn costs, with & without a thread
+// switch. Build with -DJWT_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release.
+//
+
+#if JWT_HAS_COROUTINES
+
+namespace {
+  const int HOPS = 1000000;
+  const int ROUND_TRIPS = 20000;
+
+  Task<int> Immediate(int v) {
+    co_return v;
+  }
+}
+
+TEST(HopOnTheSameThread) {
+  ManualExecutor e;
+  int hops = 0;
+
+  // Each resumption posts the next, so one RunAll drains the lot
+  auto body = [&]() -> Task<> {
+    for (int i = 0; i < HOPS; ++i) {
+      co_await ResumeOn(e);
+      ++hops;
+    }
+  };
+
+  unit::Time("suspend, post & resume", HOPS, [&](std::uint64_t) {
+    Spawn(body(), CancellationToken(), nullptr);
+    e.RunAll();
+  });
+
+  CHECK_EQUAL(HOPS, hops);
+}
+
+TEST(AwaitACompletedTask) {
+  long long sum = 0;
+
+  auto body = [&]() -> Task<> {
+    for (int i = 0; i < HOPS; ++i) {
+      sum += co_await Immediate(i);
+    }
+  };
+
+  unit::Time("create & await a task", HOPS, [&](std::uint64_t) {
+    Spawn(body(), CancellationToken(), nullptr);
+  });
+
+  CHECK_EQUAL((long long) HOPS * (HOPS - 1) / 2, sum);
+}
+
+TEST(RoundTripBetweenThreads) {
+  std::unique_ptr<ThreadExecutor> worker(new ThreadExecutor);
+  std::unique_ptr<ThreadExecutor> ui(new ThreadExecutor);
+  std::promise<void> done;
+  int trips = 0;
+
+  auto body = [&]() -> Task<> {
+    for (int i = 0; i < ROUND_TRIPS; ++i) {
+      co_await ResumeOn(*worker);
+      co_await ResumeOn(*ui);
+      ++trips;
+    }
+
+    done.set_value();
+  };
+
+  unit::Time("to a worker & back", ROUND_TRIPS, [&](std::uint64_t) {
+    Spawn(body(), CancellationToken(), nullptr);
+    done.get_future().wait();
+  });
+
+  // Joining ui waits for the frame to be torn down on its thread, before
+  // body goes
+  worker.reset();
+  ui.reset();
+
+  CHECK_EQUAL(ROUND_TRIPS, trips);
+}
+
+#endif
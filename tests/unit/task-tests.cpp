@@ -0,0 +1,305 @@
+#include "unit.hpp"
+#include "test-executors.hpp"
+#include "task.hpp"
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace jwt;
+using unit::ManualExecutor;
+using unit::ThreadExecutor;
+
+#if JWT_HAS_COROUTINES
+
+namespace {
+  // Counts its destructions, to show a frame was torn down
+  struct Tracker {
+    int* destroyed;
+    explicit Tracker(int* d) : destroyed(d) {}
+    ~Tracker() { ++*destroyed; }
+  };
+
+  struct Errors {
+    std::vector<std::string> messages;
+
+    std::function<void(std::exception_ptr)> Sink() {
+      return [this](std::exception_ptr e) {
+        try {
+          std::rethrow_exception(e);
+        }
+        catch (const std::exception& x) {
+          messages.push_back(x.what());
+        }
+      };
+    }
+  };
+
+  // Stands in for a Window: its executor may only be asked for while it is
+  // alive, which ExecutorOf checks
+  struct Owner {
+    ManualExecutor* executor;
+    bool alive;
+    int lookups;
+  };
+
+  Executor& ExecutorOf(const void* p) {
+    Owner* o = static_cast<Owner*>(const_cast<void*>(p));
+    CHECK(o->alive);
+    ++o->lookups;
+    return *o->executor;
+  }
+
+  Task<int> Twice(ManualExecutor& e, int v) {
+    co_await ResumeOn(e);
+    co_return v * 2;
+  }
+}
+
+TEST(TaskRunsUpToItsFirstHop) {
+  ManualExecutor e;
+  std::string steps;
+
+  auto body = [&]() -> Task<> {
+    steps += "a";
+    co_await ResumeOn(e);
+    steps += "b";
+  };
+
+  Spawn(body(), CancellationToken(), nullptr);
+
+  CHECK_EQUAL(std::string("a"), steps);
+  CHECK_EQUAL(1u, e.Queued());
+
+  CHECK_EQUAL(1u, e.RunAll());
+  CHECK_EQUAL(std::string("ab"), steps);
+}
+
+TEST(AwaitedTaskYieldsItsResult) {
+  ManualExecutor e;
+  int result = 0;
+
+  auto body = [&]() -> Task<> {
+    result = co_await Twice(e, 21);
+  };
+
+  Spawn(body(), CancellationToken(), nullptr);
+
+  e.RunAll();
+  CHECK_EQUAL(42, result);
+}
+
+TEST(ExceptionsReachOnError) {
+  ManualExecutor e;
+  Errors errors;
+
+  auto body = [&]() -> Task<> {
+    co_await ResumeOn(e);
+    throw std::runtime_error("failed");
+  };
+
+  Spawn(body(), CancellationToken(), errors.Sink());
+
+  CHECK(errors.messages.empty());
+  e.RunAll();
+  CHECK_EQUAL(1u, errors.messages.size());
+  CHECK_EQUAL(std::string("failed"), errors.messages.at(0));
+}
+
+TEST(CancelledTaskUnwindsAtItsNextHop) {
+  ManualExecutor e;
+  CancellationSource source;
+  Errors errors;
+  int destroyed = 0;
+  bool after = false;
+
+  auto body = [&]() -> Task<> {
+    Tracker t(&destroyed);
+    co_await ResumeOn(e);
+    after = true;
+  };
+
+  Spawn(body(), source.Token(), errors.Sink());
+
+  source.Cancel();
+  e.RunAll();
+
+  CHECK(!after);
+  CHECK_EQUAL(1, destroyed);
+  CHECK(errors.messages.empty());
+}
+
+TEST(AlreadyCancelledTaskDoesNotSuspend) {
+  ManualExecutor e;
+  CancellationSource source;
+  source.Cancel();
+  bool after = false;
+
+  auto body = [&]() -> Task<> {
+    co_await ResumeOn(e);
+    after = true;
+  };
+
+  Spawn(body(), source.Token(), nullptr);
+
+  CHECK_EQUAL(0u, e.Queued());
+  CHECK(!after);
+}
+
+TEST(AwaitedTasksInheritTheToken) {
+  ManualExecutor e;
+  CancellationSource source;
+  int result = 0;
+  bool after = false;
+
+  auto body = [&]() -> Task<> {
+    result = co_await Twice(e, 1);
+    after = true;
+  };
+
+  Spawn(body(), source.Token(), nullptr);
+
+  // Twice's hop sees the cancellation, & the caller unwinds with it
+  source.Cancel();
+  e.RunAll();
+
+  CHECK_EQUAL(0, result);
+  CHECK(!after);
+}
+
+TEST(HopsMoveBetweenThreads) {
+  ManualExecutor ui;
+  std::thread::id back;
+  std::thread::id worker;
+  std::unique_ptr<ThreadExecutor> pool(new ThreadExecutor());
+
+  // Outlives every resumption: the frame refers to the closure's captures
+  auto body = [&]() -> Task<> {
+    co_await ResumeOn(*pool);
+    worker = std::this_thread::get_id();
+    co_await ResumeOn(ui);
+    back = std::this_thread::get_id();
+  };
+
+  Spawn(body(), CancellationToken(), nullptr);
+
+  while (ui.Queued() == 0) {
+    std::this_thread::yield();
+  }
+  CHECK(worker == pool->Id());
+  pool.reset();
+
+  ui.RunAll();
+  CHECK(back == std::this_thread::get_id());
+}
+
+TEST(HomeOwnerIsNotTouchedByTheHopBack) {
+  auto home = std::make_shared<ManualExecutor>();
+  ManualExecutor other;
+  Owner owner = { &other, false, 0 };     // "destroyed": must not be asked
+  bool back = false;
+
+  auto body = [&]() -> Task<> {
+    co_await ResumeOnAwaiter(&owner, &ExecutorOf);
+    back = true;
+  };
+
+  Task<> t = body();
+  t.WithHome(home, &owner);
+  Spawn(std::move(t), CancellationToken(), nullptr);
+
+  CHECK_EQUAL(0, owner.lookups);
+  CHECK_EQUAL(1u, home->RunAll());
+  CHECK_EQUAL(0u, other.Queued());
+  CHECK(back);
+}
+
+TEST(OtherOwnersAreLookedUp) {
+  auto home = std::make_shared<ManualExecutor>();
+  ManualExecutor theirs;
+  Owner spawnedFor = { home.get(), true, 0 };
+  Owner other = { &theirs, true, 0 };
+
+  auto body = [&]() -> Task<> {
+    co_await ResumeOnAwaiter(&other, &ExecutorOf);
+  };
+
+  Task<> t = body();
+  t.WithHome(home, &spawnedFor);
+  Spawn(std::move(t), CancellationToken(), nullptr);
+
+  CHECK_EQUAL(1, other.lookups);
+  CHECK_EQUAL(1u, theirs.RunAll());
+}
+
+TEST(AwaitedTasksInheritTheHome) {
+  auto home = std::make_shared<ManualExecutor>();
+  Owner owner = { nullptr, false, 0 };
+  bool back = false;
+
+  auto inner = [&]() -> Task<> {
+    co_await ResumeOnAwaiter(&owner, &ExecutorOf);
+    back = true;
+  };
+
+  auto body = [&]() -> Task<> {
+    co_await inner();
+  };
+
+  Task<> t = body();
+  t.WithHome(home, &owner);
+  Spawn(std::move(t), CancellationToken(), nullptr);
+
+  CHECK_EQUAL(1u, home->RunAll());
+  CHECK(back);
+}
+
+TEST(OwnerDestroyedWhileOnAWorker) {
+  // The documented pattern: spawned for a window, off to a worker, & back
+  // to a window that was destroyed in the meantime
+  auto home = std::make_shared<ManualExecutor>();
+  std::unique_ptr<Owner> owner(new Owner { home.get(), true, 0 });
+  const void* key = owner.get();
+  CancellationSource lifetime;
+  std::unique_ptr<ThreadExecutor> pool(new ThreadExecutor());
+  std::atomic<bool> onWorker(false);
+  std::atomic<bool> release(false);
+  bool after = false;
+  int destroyed = 0;
+
+  auto body = [&]() -> Task<> {
+    Tracker tracker(&destroyed);
+    co_await ResumeOn(*pool);
+
+    onWorker = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+
+    co_await ResumeOnAwaiter(key, &ExecutorOf);
+    after = true;
+  };
+
+  Task<> t = body();
+  t.WithHome(home, key);
+  Spawn(std::move(t), lifetime.Token(), nullptr);
+
+  while (!onWorker) {
+    std::this_thread::yield();
+  }
+
+  // What ~Window does, then the memory goes
+  lifetime.Cancel();
+  owner.reset();
+  release = true;
+
+  // Joins the worker, which unwinds the task there
+  pool.reset();
+
+  CHECK_EQUAL(0u, home->Queued());
+  CHECK(!after);
+  CHECK_EQUAL(1, destroyed);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "executor.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+//
+// Executors for tests of code that posts WorkItems.
+//
+
+namespace unit {
+
+  // Runs posted items when told to, on the calling thread
+  struct ManualExecutor
+    : jwt::Executor
+  {
+    void Post(jwt::WorkItem* w) {
+      std::lock_guard<std::mutex> lock(lock_);
+      items_.push_back(w);
+    }
+
+    size_t RunAll() {
+      size_t ran = 0;
+
+      for (;;) {
+        jwt::WorkItem* w;
+        {
+          std::lock_guard<std::mutex> lock(lock_);
+          if (items_.empty()) {
+            return ran;
+          }
+          w = items_.front();
+          items_.pop_front();
+        }
+
+        w->run(w);
+        ++ran;
+      }
+    }
+
+    size_t Queued() {
+      std::lock_guard<std::mutex> lock(lock_);
+      return items_.size();
+    }
+
+  private:
+    std::mutex lock_;
+    std::deque<jwt::WorkItem*> items_;
+  };
+
+  // Runs posted items on a thread of its own
+  struct ThreadExecutor
+    : jwt::Executor
+  {
+    ThreadExecutor() : stop_(false), thread_([this]() { Loop(); }) {}
+
+    ~ThreadExecutor() {
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+      }
+      wake_.notify_one();
+      thread_.join();
+    }
+
+    void Post(jwt::WorkItem* w) {
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        items_.push_back(w);
+      }
+      wake_.notify_one();
+    }
+
+    std::thread::id Id() const { return thread_.get_id(); }
+
+  private:
+    void Loop() {
+      std::unique_lock<std::mutex> lock(lock_);
+
+      for (;;) {
+        wake_.wait(lock, [this]() { return stop_ || !items_.empty(); });
+        if (items_.empty()) {
+          return;
+        }
+
+        jwt::WorkItem* w = items_.front();
+        items_.pop_front();
+
+        lock.unlock();
+        w->run(w);
+        lock.lock();
+      }
+    }
+
+    std::mutex lock_;
+    std::condition_variable wake_;
+    std::deque<jwt::WorkItem*> items_;
+    bool stop_;
+    std::thread thread_;
+  };
+
+}
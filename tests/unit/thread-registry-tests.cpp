@@ -0,0 +1,175 @@
+#include "unit.hpp"
+#include "thread-registry.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+using namespace jwt;
+
+namespace {
+  // Stands in for MessagePump: one per thread, registered by thread id, with
+  // an inbox other threads post to
+  struct FakePump
+    : std::enable_shared_from_this<FakePump>
+  {
+    static ThreadRegistry<FakePump, std::thread::id>& Registry() {
+      static ThreadRegistry<FakePump, std::thread::id> registry;
+      return registry;
+    }
+
+    static std::atomic<int>& Live() {
+      static std::atomic<int> live(0);
+      return live;
+    }
+
+    FakePump() : thread(std::this_thread::get_id()) {
+      Registry().Add(thread, this);
+      ++Live();
+    }
+
+    ~FakePump() {
+      Registry().Remove(this);
+      --Live();
+    }
+
+    void Post(int v) {
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        inbox_.push_back(v);
+      }
+      wake_.notify_one();
+    }
+
+    // Runs until count items have arrived; returns their sum
+    int Pump(size_t count) {
+      std::unique_lock<std::mutex> lock(lock_);
+      wake_.wait(lock, [this, count]() { return inbox_.size() >= count; });
+
+      int sum = 0;
+      for (int v : inbox_) {
+        sum += v;
+      }
+      return sum;
+    }
+
+    std::thread::id thread;
+
+  private:
+    std::mutex lock_;
+    std::condition_variable wake_;
+    std::vector<int> inbox_;
+  };
+
+  void ThreadExiting(FakePump& p) {
+    FakePump::Registry().Remove(&p);
+  }
+
+  thread_local ThreadOwned<FakePump> threadPump_(&ThreadExiting);
+
+  // Finds the pump of another thread, waiting for it to be created
+  FakePump* WaitFor(std::thread::id id) {
+    FakePump* p;
+    while (!(p = FakePump::Registry().Find(id))) {
+      std::this_thread::yield();
+    }
+    return p;
+  }
+}
+
+TEST(EachThreadGetsOnePump) {
+  CHECK(!threadPump_.Created());
+
+  FakePump& p = threadPump_.Get();
+  CHECK(&p == &threadPump_.Get());
+  CHECK(FakePump::Registry().Find(std::this_thread::get_id()) == &p);
+
+  FakePump* other = nullptr;
+  std::thread t([&other]() {
+    other = &threadPump_.Get();
+  });
+  t.join();
+
+  CHECK(other != nullptr);
+  CHECK(other != &p);
+}
+
+TEST(PumpsDispatchConcurrently) {
+  // Each thread posts to the other's pump, found through the registry, &
+  // can only finish once the other is pumping at the same time
+  std::atomic<int> a(0);
+  std::atomic<int> b(0);
+  std::thread::id idA;
+  std::thread::id idB;
+  std::atomic<bool> ready(false);
+
+  // Neither pump may go while the other thread could still be posting to it
+  std::atomic<int> done(0);
+  auto finish = [&done]() {
+    ++done;
+    while (done < 2) {
+      std::this_thread::yield();
+    }
+  };
+
+  std::thread ta([&]() {
+    threadPump_.Get();
+    while (!ready) {
+      std::this_thread::yield();
+    }
+    WaitFor(idB)->Post(1);
+    a = threadPump_.Get().Pump(1);
+    finish();
+  });
+
+  std::thread tb([&]() {
+    threadPump_.Get();
+    while (!ready) {
+      std::this_thread::yield();
+    }
+    WaitFor(idA)->Post(2);
+    b = threadPump_.Get().Pump(1);
+    finish();
+  });
+
+  idA = ta.get_id();
+  idB = tb.get_id();
+  ready = true;
+
+  ta.join();
+  tb.join();
+
+  CHECK_EQUAL(2, a.load());
+  CHECK_EQUAL(1, b.load());
+}
+
+TEST(ExitedThreadsPumpOutlivesItsLookup) {
+  int before = FakePump::Live();
+
+  // What a static window does: keep a reference past the thread-locals
+  std::shared_ptr<FakePump> kept;
+  std::thread::id id;
+
+  std::thread t([&]() {
+    kept = threadPump_.Share();
+    id = std::this_thread::get_id();
+  });
+  t.join();
+
+  // Unregistered when the thread went, but still alive
+  CHECK(FakePump::Registry().Find(id) == nullptr);
+  CHECK_EQUAL(before + 1, FakePump::Live().load());
+
+  kept.reset();
+  CHECK_EQUAL(before, FakePump::Live().load());
+}
+
+TEST(UnsharedPumpGoesWithItsThread) {
+  int before = FakePump::Live();
+
+  std::thread t([]() {
+    threadPump_.Get();
+  });
+  t.join();
+
+  CHECK_EQUAL(before, FakePump::Live().load());
+}
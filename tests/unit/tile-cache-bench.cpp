@@ -0,0 +1,73 @@
+#include "unit.hpp"
+#include "tile-cache.hpp"
+#include <iostream>
+
+using namespace jwt;
+
+//
+// Scrolling a 1920x1080 view over a 100k x 100k canvas. Build with
+// -DJWT_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release.
+//
+
+namespace {
+  const int CANVAS = 100000;
+  const int VIEW_W = 1920, VIEW_H = 1080;
+  const int STEP = 40;
+
+  // Rows of 20px "text lines", each a run of 8px "glyphs": enough drawing
+  // that rendering a tile costs noticeably more than copying it
+  void Draw(Raster& tile, const Box& area) {
+    for (int y = 0; y < tile.Height(); ++y) {
+      int line = (area.y + y) / 20, inLine = (area.y + y) % 20;
+      if (inLine < 4 || inLine > 15) {
+        continue;
+      }
+
+      std::uint32_t* row = tile.Row(y);
+      for (int x = 0; x < tile.Width(); ++x) {
+        int glyph = (area.x + x) / 8;
+        if (((glyph * 2654435761u) ^ (line * 40503u)) % 7 != 0 && (area.x + x) % 8 < 6) {
+          row[x] = 0xFF202020u;
+        }
+      }
+    }
+  }
+
+  // Times n scroll steps of (dx, dy) from (x, y) & reports tiles per frame
+  void Scroll(const char* what, TileCache& c, Raster& target, int x, int y, int dx, int dy, std::uint64_t frames) {
+    std::uint64_t renders = c.Renders(), hits = c.Hits();
+
+    unit::Time(what, frames, [&](std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i) {
+        Box view = { x + dx * (int) i, y + dy * (int) i, VIEW_W, VIEW_H };
+        c.Compose(target, view);
+      }
+    });
+
+    std::cout << "    " << (double) (c.Renders() - renders) / frames << " tiles rendered, "
+      << (double) (c.Hits() - hits) / frames << " reused per frame\n";
+  }
+}
+
+TEST(ScrollingAHugeCanvas) {
+  TileCache c(Draw);
+  c.SetExtent(CANVAS, CANVAS);
+  Raster target(VIEW_W, VIEW_H);
+
+  const std::uint64_t FRAMES = 2000;
+
+  // Straight down, then back up over what's still cached
+  Scroll("Frame scrolling down", c, target, 0, 0, 0, STEP, FRAMES);
+  std::uint64_t renders = c.Renders();
+  Scroll("Frame scrolling back up a pixel at a time", c, target, 0, (int) (FRAMES - 1) * STEP, 0, -1, 200);
+  CHECK_EQUAL(renders, c.Renders());
+
+  Scroll("Frame scrolling diagonally", c, target, 10000, 10000, STEP, STEP, FRAMES);
+
+  // Every frame somewhere new: the cost without a cache
+  renders = c.Renders();
+  Scroll("Frame jumping a screen at a time", c, target, 0, 0, VIEW_W, VIEW_H, 40);
+  CHECK(c.Renders() - renders >= 40 * 8 * 5);
+
+  CHECK(c.Bytes() <= c.Budget());
+}
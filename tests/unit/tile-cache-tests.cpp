@@ -0,0 +1,291 @@
+#include "unit.hpp"
+#include "tile-cache.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace jwt;
+
+namespace {
+  const int TILE = 16;
+  const std::size_t TILE_BYTES = TILE * TILE * 4;
+
+  // Deterministic pseudo-random numbers for the comparison test
+  struct Lcg {
+    std::uint32_t state;
+
+    explicit Lcg(std::uint32_t seed) : state(seed) {}
+
+    std::uint32_t Next(std::uint32_t bound) {
+      state = state * 1664525u + 1013904223u;
+      return (state >> 8) % bound;
+    }
+
+    int Between(int lo, int hi) {
+      return lo + (int) Next((std::uint32_t) (hi - lo));
+    }
+  };
+
+  Box B(int x, int y, int w, int h) {
+    Box b = { x, y, w, h };
+    return b;
+  }
+
+  // A canvas whose every pixel says where it is, in 8x8 blocks that each
+  // have a version, & that records which tiles it renders
+  struct Canvas {
+    std::vector<Box> rendered;
+    std::vector<std::uint32_t> versions;
+    int blocksW;
+
+    explicit Canvas(int w = 0, int h = 0) : versions((std::size_t) (w / 8) * (h / 8), 0), blocksW(w / 8) {}
+
+    std::uint32_t At(int x, int y) const {
+      std::uint32_t version = (versions.empty()) ? 0 : versions[(std::size_t) (y / 8) * blocksW + x / 8];
+      return (version << 24) | ((std::uint32_t) (x & 0xFFF) << 12) | (std::uint32_t) (y & 0xFFF);
+    }
+
+    TileCache::Renderer Renderer() {
+      return [this](Raster& tile, const Box& area) {
+        rendered.push_back(area);
+
+        for (int y = 0; y < tile.Height(); ++y) {
+          for (int x = 0; x < tile.Width(); ++x) {
+            tile.Row(y)[x] = At(area.x + x, area.y + y);
+          }
+        }
+      };
+    }
+
+    std::size_t Rendered(const Box& tile) const {
+      return (std::size_t) std::count(rendered.begin(), rendered.end(), tile);
+    }
+  };
+
+  Box Tile(int tx, int ty) {
+    return B(tx * TILE, ty * TILE, TILE, TILE);
+  }
+
+  void Touch(TileCache& c, int tx, int ty) {
+    c.Visit(Tile(tx, ty), [](const Raster&, const Box&, int, int) {});
+  }
+}
+
+TEST(TilesAreReusedInLeastRecentlyUsedOrder) {
+  Canvas canvas;
+  TileCache c(canvas.Renderer(), 4 * TILE_BYTES, TILE);
+
+  Touch(c, 0, 0);
+  Touch(c, 1, 0);
+  Touch(c, 2, 0);
+  Touch(c, 3, 0);
+  CHECK_EQUAL(4u, c.Tiles());
+  CHECK_EQUAL(4u, c.Renders());
+  CHECK_EQUAL(4 * TILE_BYTES, c.Bytes());
+
+  // (0, 0) becomes the most recently used, so (1, 0) goes next
+  Touch(c, 0, 0);
+  CHECK_EQUAL(1u, c.Hits());
+
+  Touch(c, 4, 0);
+  CHECK_EQUAL(4u, c.Tiles());
+  CHECK_EQUAL(5u, c.Renders());
+
+  Touch(c, 0, 0);
+  Touch(c, 2, 0);
+  Touch(c, 3, 0);
+  CHECK_EQUAL(4u, c.Hits());
+  CHECK_EQUAL(5u, c.Renders());
+
+  Touch(c, 1, 0);
+  CHECK_EQUAL(6u, c.Renders());
+  CHECK_EQUAL(2u, canvas.Rendered(Tile(1, 0)));
+  CHECK_EQUAL(4u, c.Tiles());
+
+  // A smaller budget drops the least recently used at once
+  c.SetBudget(2 * TILE_BYTES);
+  CHECK_EQUAL(2u, c.Tiles());
+
+  Touch(c, 1, 0);
+  Touch(c, 3, 0);
+  CHECK_EQUAL(6u, c.Renders());
+
+  c.Clear();
+  CHECK_EQUAL(0u, c.Tiles());
+  CHECK_EQUAL(0u, c.Bytes());
+}
+
+TEST(AVisitCanNeedMoreTilesThanTheBudget) {
+  Canvas canvas;
+  TileCache c(canvas.Renderer(), 2 * TILE_BYTES, TILE);
+
+  // 3x3 tiles, all of which must be valid while the Visit hands them out
+  std::vector<Box> seen;
+  c.Visit(B(0, 0, 3 * TILE, 3 * TILE), [&](const Raster& tile, const Box& src, int x, int y) {
+    CHECK_EQUAL(canvas.At(x, y), tile.Pixel(src.x, src.y));
+    seen.push_back(B(x, y, src.w, src.h));
+  });
+
+  CHECK_EQUAL(9u, seen.size());
+  CHECK_EQUAL(9u, c.Renders());
+  CHECK(seen[1] == B(TILE, 0, TILE, TILE));
+  CHECK(seen[3] == B(0, TILE, TILE, TILE));
+
+  // The excess goes afterwards, oldest first
+  CHECK_EQUAL(2u, c.Tiles());
+  CHECK(c.Bytes() <= c.Budget());
+
+  Touch(c, 2, 2);
+  Touch(c, 1, 2);
+  CHECK_EQUAL(9u, c.Renders());
+  Touch(c, 0, 0);
+  CHECK_EQUAL(10u, c.Renders());
+}
+
+TEST(InvalidateRendersOnlyTheTouchedTilesAgain) {
+  Canvas canvas;
+  TileCache c(canvas.Renderer(), 100 * TILE_BYTES, TILE);
+
+  Box view = B(0, 0, 4 * TILE, 4 * TILE);
+  c.Visit(view, [](const Raster&, const Box&, int, int) {});
+  CHECK_EQUAL(16u, c.Renders());
+
+  // Inside one tile, then straddling a corner of four
+  c.Invalidate(B(TILE + 2, TILE + 2, 3, 3));
+  c.Invalidate(B(3 * TILE - 1, 2 * TILE - 1, 2, 2));
+  canvas.rendered.clear();
+
+  c.Visit(view, [](const Raster&, const Box&, int, int) {});
+  CHECK_EQUAL(21u, c.Renders());
+  CHECK_EQUAL(5u, canvas.rendered.size());
+  CHECK_EQUAL(1u, canvas.Rendered(Tile(1, 1)));
+  CHECK_EQUAL(1u, canvas.Rendered(Tile(2, 1)));
+  CHECK_EQUAL(1u, canvas.Rendered(Tile(3, 1)));
+  CHECK_EQUAL(1u, canvas.Rendered(Tile(2, 2)));
+  CHECK_EQUAL(1u, canvas.Rendered(Tile(3, 2)));
+
+  // Tiles that aren't cached, or areas off the canvas, cost nothing
+  c.Invalidate(B(50 * TILE, 0, 10, 10));
+  c.Invalidate(B(-100, -100, 50, 50));
+  c.Visit(view, [](const Raster&, const Box&, int, int) {});
+  CHECK_EQUAL(21u, c.Renders());
+
+  // Stale tiles are the first to be reused
+  c.SetBudget(16 * TILE_BYTES);
+  c.Invalidate(Tile(3, 3));
+  Touch(c, 9, 9);
+  CHECK_EQUAL(16u, c.Tiles());
+
+  canvas.rendered.clear();
+  c.Visit(view, [](const Raster&, const Box&, int, int) {});
+  CHECK(canvas.rendered.size() == 1 && canvas.rendered[0] == Tile(3, 3));
+
+  c.InvalidateAll();
+  canvas.rendered.clear();
+  c.Visit(view, [](const Raster&, const Box&, int, int) {});
+  CHECK_EQUAL(16u, canvas.rendered.size());
+}
+
+TEST(ShrinkingTheExtentDropsTilesThatNoLongerFit) {
+  Canvas canvas;
+  TileCache c(canvas.Renderer(), 100 * TILE_BYTES, TILE);
+
+  c.Visit(B(0, 0, 4 * TILE, 4 * TILE), [](const Raster&, const Box&, int, int) {});
+  CHECK_EQUAL(16u, c.Tiles());
+
+  // Tiles still partly inside stay
+  c.SetExtent(2 * TILE + 8, TILE + 4);
+  CHECK_EQUAL(2 * TILE + 8, c.ExtentW());
+  CHECK_EQUAL(6u, c.Tiles());
+
+  // & a Visit stops at the edge, without rendering anything new
+  std::vector<Box> seen;
+  c.Visit(B(0, 0, 4 * TILE, 4 * TILE), [&](const Raster&, const Box& src, int x, int y) {
+    seen.push_back(B(x, y, src.w, src.h));
+  });
+
+  CHECK_EQUAL(16u, c.Renders());
+  CHECK_EQUAL(6u, seen.size());
+  CHECK(seen[2] == B(2 * TILE, 0, 8, TILE));
+  CHECK(seen[5] == B(2 * TILE, TILE, 8, 4));
+
+  c.Visit(B(3 * TILE, 0, TILE, TILE), [&](const Raster&, const Box&, int, int) {
+    CHECK(false);
+  });
+
+  c.SetExtent(0, 0);
+  CHECK_EQUAL(0u, c.Tiles());
+}
+
+TEST(ComposePutsEveryPixelInPlace) {
+  Canvas canvas;
+  TileCache c(canvas.Renderer(), 100 * TILE_BYTES, TILE);
+  c.SetExtent(5 * TILE + 3, 4 * TILE);
+
+  const std::uint32_t UNTOUCHED = 0xDEADBEEFu;
+
+  // Unaligned, hanging off the top left & right of the canvas, & bigger
+  // than the target on the bottom
+  Box viewports[] = {
+    B(-5, -7, 40, 30),
+    B(3, 9, 45, 30),
+    B(4 * TILE + 1, 2 * TILE + 5, 40, 60),
+    B(0, 0, 5 * TILE + 3, 4 * TILE)
+  };
+
+  for (const Box& viewport : viewports) {
+    Raster target(std::min(viewport.w, 50), std::min(viewport.h, 35));
+    target.Clear(target.Bounds(), UNTOUCHED);
+
+    c.Compose(target, viewport);
+
+    for (int y = 0; y < target.Height(); ++y) {
+      for (int x = 0; x < target.Width(); ++x) {
+        int cx = viewport.x + x, cy = viewport.y + y;
+        bool inside = cx >= 0 && cy >= 0 && cx < c.ExtentW() && cy < c.ExtentH();
+
+        if (target.Pixel(x, y) != (inside ? canvas.At(cx, cy) : UNTOUCHED)) {
+          unit::Fail(__FILE__, __LINE__, "wrong pixel at " + std::to_string(x) + ", " + std::to_string(y));
+          return;
+        }
+      }
+    }
+  }
+}
+
+TEST(ComposeShowsInvalidatedChanges) {
+  Canvas canvas(40 * TILE, 30 * TILE);
+  TileCache c(canvas.Renderer(), 30 * TILE_BYTES, TILE);
+  c.SetExtent(40 * TILE, 30 * TILE);
+
+  Lcg rng(3);
+  Raster target(5 * TILE, 4 * TILE);
+
+  for (int step = 0; step < 400; ++step) {
+    // Change a few blocks of the canvas, telling the cache
+    for (int i = (int) rng.Next(4); i > 0; --i) {
+      int bx = (int) rng.Next(40 * TILE / 8), by = (int) rng.Next(30 * TILE / 8);
+      ++canvas.versions[(std::size_t) by * canvas.blocksW + bx];
+      c.Invalidate(B(bx * 8, by * 8, 8, 8));
+    }
+
+    // Scroll a little, mostly, or jump
+    Box viewport = B(rng.Between(-TILE, 36 * TILE), rng.Between(-TILE, 27 * TILE), target.Width(), target.Height());
+    c.Compose(target, viewport);
+
+    for (int y = 0; y < target.Height(); ++y) {
+      for (int x = 0; x < target.Width(); ++x) {
+        int cx = viewport.x + x, cy = viewport.y + y;
+
+        if (cx >= 0 && cy >= 0 && cx < c.ExtentW() && cy < c.ExtentH() && target.Pixel(x, y) != canvas.At(cx, cy)) {
+          unit::Fail(__FILE__, __LINE__, "stale pixel at step " + std::to_string(step));
+          return;
+        }
+      }
+    }
+
+    CHECK(c.Bytes() <= c.Budget());
+  }
+
+  CHECK(c.Hits() > 0);
+}
@@ -0,0 +1,209 @@
+#include "unit.hpp"
+#include "timer-wheel.hpp"
+#include <stdexcept>
+
+using namespace jwt;
+
+namespace {
+  typedef TimerWheel::Time Time;
+
+  Time Next(const TimerWheel& w) {
+    Time t = 0;
+    CHECK(w.NextDeadline(t));
+    return t;
+  }
+}
+
+TEST(OneShotFiresOnceAtItsDeadline) {
+  TimerWheel w;
+  int calls = 0;
+
+  w.Schedule(100, 0, [&]() { ++calls; });
+
+  CHECK_EQUAL(0u, w.Advance(99));
+  CHECK_EQUAL(1u, w.Advance(100));
+  CHECK_EQUAL(0u, w.Advance(1000));
+  CHECK_EQUAL(1, calls);
+  CHECK(w.Empty());
+}
+
+TEST(CancelledTimerDoesNotFire) {
+  TimerWheel w;
+  int calls = 0;
+
+  TimerWheel::TimerId id = w.Schedule(50, 0, [&]() { ++calls; });
+
+  CHECK(w.Cancel(id));
+  CHECK(!w.Cancel(id));
+  CHECK(!w.Cancel(TimerWheel::INVALID_TIMER));
+
+  w.Advance(100);
+  CHECK_EQUAL(0, calls);
+}
+
+TEST(StaleIdDoesNotCancelReusedNode) {
+  TimerWheel w;
+  int calls = 0;
+
+  TimerWheel::TimerId first = w.Schedule(10, 0, []() {});
+  w.Advance(10);
+
+  // Takes the node the first timer used
+  w.Schedule(20, 0, [&]() { ++calls; });
+
+  CHECK(!w.Cancel(first));
+  w.Advance(20);
+  CHECK_EQUAL(1, calls);
+}
+
+TEST(TimersFireInDeadlineOrderAcrossLevels) {
+  TimerWheel w;
+  std::vector<Time> fired;
+
+  // Level 0, 1, 2, 3 & the overflow list
+  const Time deadlines[] = { 5, 64 * 3 + 1, 64 * 64 * 7 + 3, 64 * 64 * 64 * 2 + 9, Time(64) * 64 * 64 * 64 * 3 + 1 };
+
+  for (int i = 4; i >= 0; --i) {
+    Time d = deadlines[i];
+    w.Schedule(d, 0, [&w, &fired]() { fired.push_back(w.Now()); });
+  }
+
+  w.Advance(deadlines[4]);
+
+  CHECK_EQUAL(5u, fired.size());
+  for (size_t i = 0; i < fired.size() && i < 5; ++i) {
+    CHECK_EQUAL(deadlines[i], fired[i]);
+  }
+}
+
+TEST(NextDeadlineIsNeverLate) {
+  TimerWheel w;
+  w.Schedule(64 * 64 + 10, 0, []() {});
+
+  // Cascades may come first, but following NextDeadline must land on the
+  // deadline itself
+  Time t = 0;
+  size_t fired = 0;
+  while (w.NextDeadline(t)) {
+    CHECK(t <= 64 * 64 + 10);
+    fired += w.Advance(t);
+  }
+
+  CHECK_EQUAL(1u, fired);
+  CHECK_EQUAL(Time(64 * 64 + 10), w.Now());
+}
+
+TEST(PeriodicTimerRepeatsWithoutDrift) {
+  TimerWheel w;
+  std::vector<Time> fired;
+
+  w.Schedule(10, 10, [&]() { fired.push_back(w.Now()); });
+
+  // Serviced a little late each time; deadlines stay on the 10s
+  const Time calls[] = { 13, 21, 34, 40, 47 };
+  for (Time t : calls) {
+    w.Advance(t);
+  }
+
+  CHECK_EQUAL(4u, fired.size());
+  CHECK_EQUAL(Time(50), Next(w));
+}
+
+TEST(PeriodicTimerSkipsMissedPeriods) {
+  TimerWheel w;
+  int calls = 0;
+
+  w.Schedule(16, 16, [&]() { ++calls; });
+
+  // A long stall: one call, not one per missed period
+  CHECK_EQUAL(1u, w.Advance(16000));
+  CHECK_EQUAL(1, calls);
+
+  // Back on the original phase
+  CHECK_EQUAL(Time(16016), Next(w));
+  CHECK_EQUAL(1u, w.Advance(16016));
+  CHECK_EQUAL(2, calls);
+}
+
+TEST(PeriodicTimerSkipsToThePhaseAfterTheTarget) {
+  TimerWheel w;
+  int calls = 0;
+
+  w.Schedule(10, 7, [&]() { ++calls; });
+
+  // Deadlines 10, 17, 24, ... 101, 108: 101 has passed by 105
+  w.Advance(105);
+  CHECK_EQUAL(1, calls);
+  CHECK_EQUAL(Time(108), Next(w));
+}
+
+TEST(CallbackMayCancelItself) {
+  TimerWheel w;
+  int calls = 0;
+  TimerWheel::TimerId id = TimerWheel::INVALID_TIMER;
+
+  id = w.Schedule(5, 5, [&]() {
+    if (++calls == 3) {
+      w.Cancel(id);
+    }
+  });
+
+  for (Time t = 5; t <= 50; t += 5) {
+    w.Advance(t);
+  }
+
+  CHECK_EQUAL(3, calls);
+  CHECK(w.Empty());
+}
+
+TEST(CallbackMayScheduleInThePast) {
+  TimerWheel w;
+  int calls = 0;
+
+  w.Schedule(10, 0, [&]() {
+    w.Schedule(0, 0, [&]() { ++calls; });
+  });
+
+  // Past deadlines are picked up by the next Advance, however soon
+  w.Advance(10);
+  CHECK_EQUAL(0, calls);
+  CHECK_EQUAL(Time(10), Next(w));
+
+  w.Advance(10);
+  CHECK_EQUAL(1, calls);
+}
+
+TEST(TimersDueWithAThrowingCallbackStayDue) {
+  TimerWheel w;
+  int calls = 0;
+
+  w.Schedule(10, 0, []() { throw std::runtime_error("boom"); });
+  w.Schedule(10, 0, [&]() { ++calls; });
+
+  bool threw = false;
+  try {
+    w.Advance(10);
+  }
+  catch (const std::runtime_error&) {
+    threw = true;
+  }
+
+  CHECK(threw);
+  CHECK_EQUAL(0, calls);
+
+  w.Advance(10);
+  CHECK_EQUAL(1, calls);
+}
+
+TEST(TimeNeverRunsBackwards) {
+  TimerWheel w(1000);
+  int calls = 0;
+
+  w.Schedule(1005, 0, [&]() { ++calls; });
+
+  CHECK_EQUAL(0u, w.Advance(10));
+  CHECK_EQUAL(Time(1000), w.Now());
+
+  w.Advance(1005);
+  CHECK_EQUAL(1, calls);
+}
@@ -0,0 +1,22 @@
+#include "unit.hpp"
+#include <exception>
+
+int main() {
+  for (const unit::Test& t : unit::Tests()) {
+    int before = unit::Failures();
+
+    try {
+      t.run();
+    }
+    catch (const std::exception& e) {
+      unit::Fail(t.name, 0, std::string("threw ") + e.what());
+    }
+    catch (...) {
+      unit::Fail(t.name, 0, "threw");
+    }
+
+    std::cout << ((unit::Failures() == before) ? "pass " : "FAIL ") << t.name << "\n";
+  }
+
+  return (unit::Failures() == 0) ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+//
+// Just enough of a test harness for the portable parts of JWT: tests
+// register themselves with TEST & report failures with CHECK/CHECK_EQUAL.
+// unit-main.cpp runs them all & returns non-zero if any failed.
+//
+
+namespace unit {
+
+  struct Test {
+    const char* name;
+    void (*run)();
+  };
+
+  inline std::vector<Test>& Tests() {
+    static std::vector<Test> tests;
+    return tests;
+  }
+
+  inline int& Failures() {
+    static int failures = 0;
+    return failures;
+  }
+
+  struct Register {
+    Register(const char* name, void (*run)()) {
+      Tests().push_back(Test { name, run });
+    }
+  };
+
+  inline void Fail(const char* file, int line, const std::string& what) {
+    std::cerr << file << "(" << line << "): " << what << "\n";
+    ++Failures();
+  }
+
+  template<typename T>
+  std::string Show(const T& t) {
+    std::ostringstream s;
+    s << t;
+    return s.str();
+  }
+
+  inline std::string Show(std::uint8_t b) {
+    return Show((unsigned) b);
+  }
+
+  // For the benchmarks: calls f(iterations) once & prints the mean time
+  // per iteration
+  template<typename F>
+  double Time(const char* what, std::uint64_t iterations, F f) {
+    auto start = std::chrono::steady_clock::now();
+    f(iterations);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    double ns = elapsed.count() / (double) iterations;
+    std::cout << "  " << what << ": " << ns << " ns\n";
+    return ns;
+  }
+}
+
+#define TEST(name) \
+  static void name(); \
+  static unit::Register name##_register(#name, name); \
+  static void name()
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      unit::Fail(__FILE__, __LINE__, "CHECK(" #cond ") failed"); \
+    } \
+  } while (false)
+
+#define CHECK_EQUAL(expected, actual) \
+  do { \
+    auto e_ = (expected); \
+    auto a_ = (actual); \
+    if (!(e_ == a_)) { \
+      unit::Fail(__FILE__, __LINE__, "CHECK_EQUAL(" #expected ", " #actual "): expected " + \
+        unit::Show(e_) + ", got " + unit::Show(a_)); \
+    } \
+  } while (false)
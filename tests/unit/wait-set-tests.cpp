@@ -0,0 +1,172 @@
+#include "unit.hpp"
+#include "wait-set.hpp"
+#include <set>
+#include <stdexcept>
+#include <string>
+
+using namespace jwt;
+
+namespace {
+  // Handles are ints (0 is "none"); a handle is signalled while it is in
+  // the set, like a manual-reset event
+  struct FakeHandles {
+    std::set<int> signalled;
+    int polls = 0;
+
+    // As WaitForMultipleObjects with a zero timeout: the first signalled
+    size_t operator()(const int* h, size_t count) {
+      ++polls;
+      for (size_t i = 0; i < count; ++i) {
+        if (signalled.count(h[i])) {
+          return i;
+        }
+      }
+      return count;
+    }
+
+    // As the blocking wait: the lowest signalled index
+    size_t First(const WaitSet<int>& w) {
+      return (*this)(w.Handles(), w.Size());
+    }
+  };
+
+  struct Ignore {
+    void operator()(std::exception_ptr) {}
+  };
+}
+
+TEST(OnlyTheSignalledHandleRuns) {
+  WaitSet<int> w;
+  FakeHandles fake;
+  std::string ran;
+
+  w.Add(1, [&]() { ran += "1"; });
+  w.Add(2, [&]() { ran += "2"; });
+  w.Add(3, [&]() { ran += "3"; });
+
+  fake.signalled = { 2 };
+  CHECK_EQUAL(1u, w.Dispatch(fake.First(w), std::ref(fake), Ignore()));
+  CHECK_EQUAL(std::string("2"), ran);
+}
+
+TEST(BusyFirstHandleDoesNotStarveTheRest) {
+  // Index 0 is signalled on every wake, like a post event under a steady
+  // stream of Posts
+  WaitSet<int> w;
+  FakeHandles fake;
+  int posts = 0;
+  int timers = 0;
+  int completions = 0;
+
+  w.Add(1, [&]() { ++posts; });
+  w.Add(2, [&]() { ++timers; });
+  w.Add(3, [&]() { ++completions; });
+
+  fake.signalled = { 1, 2, 3 };
+  for (int wake = 0; wake < 10; ++wake) {
+    CHECK_EQUAL(0u, fake.First(w));
+    CHECK_EQUAL(3u, w.Dispatch(0, std::ref(fake), Ignore()));
+  }
+
+  CHECK_EQUAL(10, posts);
+  CHECK_EQUAL(10, timers);
+  CHECK_EQUAL(10, completions);
+}
+
+TEST(EachHandleRunsOncePerWake) {
+  WaitSet<int> w;
+  FakeHandles fake;
+  std::string ran;
+
+  for (int h = 1; h <= 6; ++h) {
+    w.Add(h, [&ran, h]() { ran += std::to_string(h); });
+  }
+
+  fake.signalled = { 2, 4, 5 };
+  w.Dispatch(fake.First(w), std::ref(fake), Ignore());
+  CHECK_EQUAL(std::string("245"), ran);
+}
+
+TEST(RemovedInACallbackIsSkipped) {
+  WaitSet<int> w;
+  FakeHandles fake;
+  std::string ran;
+
+  w.Add(1, [&]() { ran += "1"; w.Remove(2); });
+  w.Add(2, [&]() { ran += "2"; });
+  w.Add(3, [&]() { ran += "3"; });
+
+  fake.signalled = { 1, 2, 3 };
+  CHECK_EQUAL(2u, w.Dispatch(0, std::ref(fake), Ignore()));
+  CHECK_EQUAL(std::string("13"), ran);
+
+  // Cleared, then dropped by Compact
+  CHECK_EQUAL(3u, w.Size());
+  w.Compact();
+  CHECK_EQUAL(2u, w.Size());
+  CHECK_EQUAL(1, w.Handles()[0]);
+  CHECK_EQUAL(3, w.Handles()[1]);
+}
+
+TEST(AddedInACallbackWaitsForTheNextWake) {
+  WaitSet<int> w;
+  FakeHandles fake;
+  std::string ran;
+
+  // Enough adds to move the vectors
+  w.Add(1, [&]() {
+    ran += "1";
+    for (int h = 10; h < 100; ++h) {
+      w.Add(h, [&ran]() { ran += "+"; });
+    }
+  });
+
+  fake.signalled = { 1, 10 };
+  w.Dispatch(0, std::ref(fake), Ignore());
+  CHECK_EQUAL(std::string("1"), ran);
+
+  fake.signalled = { 10 };
+  w.Dispatch(fake.First(w), std::ref(fake), Ignore());
+  CHECK_EQUAL(std::string("1+"), ran);
+}
+
+TEST(RemovingItselfIsSafe) {
+  WaitSet<int> w;
+  FakeHandles fake;
+  int runs = 0;
+
+  w.Add(1, [&]() { ++runs; w.Remove(1); });
+
+  fake.signalled = { 1 };
+  w.Dispatch(0, std::ref(fake), Ignore());
+  CHECK_EQUAL(1, runs);
+
+  w.Compact();
+  CHECK_EQUAL(0u, w.Size());
+  CHECK(w.Handles() == nullptr);
+  CHECK(!w.Remove(1));
+}
+
+TEST(ExceptionsAreReportedAndTheRestStillRun) {
+  WaitSet<int> w;
+  FakeHandles fake;
+  std::vector<std::string> reported;
+  bool ran = false;
+
+  w.Add(1, []() { throw std::runtime_error("one"); });
+  w.Add(2, [&]() { ran = true; });
+
+  fake.signalled = { 1, 2 };
+  w.Dispatch(0, std::ref(fake), [&](std::exception_ptr e) {
+    try {
+      std::rethrow_exception(e);
+    }
+    catch (const std::exception& x) {
+      reported.push_back(x.what());
+    }
+  });
+
+  CHECK(ran);
+  CHECK_EQUAL(1u, reported.size());
+  CHECK_EQUAL(std::string("one"), reported.at(0));
+}
@@ -0,0 +1,200 @@
+#include "unit.hpp"
+#include "warm-pool.hpp"
+#include <memory>
+#include <string>
+
+using namespace jwt;
+
+namespace {
+  // Stands in for a dialog: counts how many exist & remembers its state
+  struct FakeDialog {
+    static int alive;
+
+    int serial;
+    std::string text;
+    bool visible;
+
+    explicit FakeDialog(int s) : serial(s), visible(false) { ++alive; }
+    ~FakeDialog() { --alive; }
+  };
+
+  int FakeDialog::alive = 0;
+
+  const std::size_t DIALOG_BYTES = 100;
+
+  struct Fixture {
+    int serial;
+    int resets;
+
+    Fixture() : serial(0), resets(0) {
+      FakeDialog::alive = 0;
+    }
+
+    WarmPool<FakeDialog>::Factory Factory() {
+      return [this]() { return std::unique_ptr<FakeDialog>(new FakeDialog(++serial)); };
+    }
+
+    WarmPool<FakeDialog>::Reset Reset() {
+      return [this](FakeDialog& d) {
+        d.text.clear();
+        d.visible = false;
+        ++resets;
+      };
+    }
+  };
+
+  // What DialogPool does: one WarmOne per idle slice until it's had enough
+  int IdleSlices(WarmPool<FakeDialog>& p) {
+    int slices = 0;
+    while (p.NeedsWarming()) {
+      p.WarmOne();
+      ++slices;
+    }
+    return slices;
+  }
+}
+
+TEST(CapacityIsTheSmallerOfCountAndBudget) {
+  Fixture f;
+
+  WarmPool<FakeDialog> byCount(f.Factory(), f.Reset(), 3, DIALOG_BYTES, 10 * DIALOG_BYTES);
+  CHECK_EQUAL(3u, byCount.Capacity());
+
+  WarmPool<FakeDialog> byBudget(f.Factory(), f.Reset(), 10, DIALOG_BYTES, 2 * DIALOG_BYTES + 99);
+  CHECK_EQUAL(2u, byBudget.Capacity());
+
+  WarmPool<FakeDialog> none(f.Factory(), f.Reset(), 10, DIALOG_BYTES, DIALOG_BYTES - 1);
+  CHECK_EQUAL(0u, none.Capacity());
+  CHECK(!none.NeedsWarming());
+
+  // A zero item size counts as one byte rather than dividing by zero
+  WarmPool<FakeDialog> tiny(f.Factory(), f.Reset(), 4, 0, 2);
+  CHECK_EQUAL(2u, tiny.Capacity());
+
+  // Nothing is built up front
+  CHECK_EQUAL(0, FakeDialog::alive);
+}
+
+TEST(WarmOneBuildsOnePerSlice) {
+  Fixture f;
+  WarmPool<FakeDialog> p(f.Factory(), f.Reset(), 3, DIALOG_BYTES, 1000);
+
+  CHECK(p.NeedsWarming());
+  CHECK(p.WarmOne());
+  CHECK_EQUAL(1u, p.Ready());
+  CHECK(p.WarmOne());
+  CHECK(!p.WarmOne());
+  CHECK_EQUAL(3u, p.Ready());
+
+  // Full: further slices build nothing
+  CHECK(!p.WarmOne());
+  CHECK_EQUAL(3u, p.Built());
+  CHECK_EQUAL(3, FakeDialog::alive);
+}
+
+TEST(AcquireCountsHitsAndMisses) {
+  Fixture f;
+  WarmPool<FakeDialog> p(f.Factory(), f.Reset(), 2, DIALOG_BYTES, 1000);
+
+  CHECK_EQUAL(2, IdleSlices(p));
+
+  std::unique_ptr<FakeDialog> a = p.Acquire();
+  std::unique_ptr<FakeDialog> b = p.Acquire();
+  CHECK_EQUAL(2u, p.Hits());
+  CHECK_EQUAL(0u, p.Misses());
+
+  // Nothing ready: built on the spot
+  std::unique_ptr<FakeDialog> c = p.Acquire();
+  CHECK(c && c->serial == 3);
+  CHECK_EQUAL(1u, p.Misses());
+  CHECK_EQUAL(3u, p.Built());
+
+  // Loans don't count against the budget, so the pool refills
+  CHECK(p.NeedsWarming());
+  CHECK_EQUAL(2, IdleSlices(p));
+  CHECK_EQUAL(5, FakeDialog::alive);
+}
+
+TEST(ReleaseResetsAndKeeps) {
+  Fixture f;
+  WarmPool<FakeDialog> p(f.Factory(), f.Reset(), 2, DIALOG_BYTES, 1000);
+
+  std::unique_ptr<FakeDialog> d = p.Acquire();
+  d->text = "typed";
+  d->visible = true;
+  int serial = d->serial;
+
+  p.Release(std::move(d));
+  CHECK_EQUAL(1, f.resets);
+  CHECK_EQUAL(1u, p.Ready());
+
+  // The same object comes back, reset
+  std::unique_ptr<FakeDialog> again = p.Acquire();
+  CHECK_EQUAL(serial, again->serial);
+  CHECK(again->text.empty() && !again->visible);
+  CHECK_EQUAL(1u, p.Hits());
+
+  p.Release(nullptr);
+  CHECK_EQUAL(0u, p.Ready());
+}
+
+TEST(ReleaseBeyondCapacityDestroys) {
+  Fixture f;
+  WarmPool<FakeDialog> p(f.Factory(), f.Reset(), 2, DIALOG_BYTES, 1000);
+
+  std::unique_ptr<FakeDialog> loans[4];
+  for (auto& d : loans) {
+    d = p.Acquire();
+  }
+  CHECK_EQUAL(4, FakeDialog::alive);
+
+  for (auto& d : loans) {
+    p.Release(std::move(d));
+  }
+
+  // Two kept; the others were destroyed without being reset
+  CHECK_EQUAL(2u, p.Ready());
+  CHECK_EQUAL(2, FakeDialog::alive);
+  CHECK_EQUAL(2, f.resets);
+}
+
+TEST(SetBudgetTrimsAndRegrows) {
+  Fixture f;
+  WarmPool<FakeDialog> p(f.Factory(), f.Reset(), 4, DIALOG_BYTES, 4 * DIALOG_BYTES);
+
+  CHECK_EQUAL(4, IdleSlices(p));
+
+  // Memory pressure: halve the budget
+  p.SetBudget(2 * DIALOG_BYTES);
+  CHECK_EQUAL(2 * DIALOG_BYTES, p.Budget());
+  CHECK_EQUAL(2u, p.Ready());
+  CHECK_EQUAL(2, FakeDialog::alive);
+  CHECK(!p.NeedsWarming());
+
+  p.SetBudget(0);
+  CHECK_EQUAL(0u, p.Ready());
+  CHECK_EQUAL(0, FakeDialog::alive);
+
+  // More room again: warming picks up where it is wanted
+  p.SetBudget(3 * DIALOG_BYTES);
+  CHECK_EQUAL(3, IdleSlices(p));
+  CHECK_EQUAL(7u, p.Built());
+}
+
+TEST(ClearAndDestructionFreeReadyObjects) {
+  Fixture f;
+
+  {
+    WarmPool<FakeDialog> p(f.Factory(), f.Reset(), 3, DIALOG_BYTES, 1000);
+    IdleSlices(p);
+
+    p.Clear();
+    CHECK_EQUAL(0, FakeDialog::alive);
+    CHECK(p.NeedsWarming());
+
+    IdleSlices(p);
+    CHECK_EQUAL(3, FakeDialog::alive);
+  }
+
+  CHECK_EQUAL(0, FakeDialog::alive);
+}
@@ -0,0 +1,71 @@
+#include "unit.hpp"
+#include "windowless-model.hpp"
+
+using namespace jwt;
+
+//
+// Hit tests & area queries over 100k controls. Build with -DJWT_BENCHMARKS=ON
+// -DCMAKE_BUILD_TYPE=Release.
+//
+
+namespace {
+  typedef WindowlessModel M;
+
+  const int COLUMNS = 250;
+  const int CELL_W = 80, CELL_H = 24, GAP = 4;
+  const int CONTROLS = 100000;
+
+  const int HIT_TESTS = 10000000;
+  const int QUERIES = 1000000;
+}
+
+TEST(HitTestAndQueryOver100kControls) {
+  M m;
+  std::vector<M::Id> ids;
+  ids.reserve(CONTROLS);
+
+  for (int i = 0; i < CONTROLS; ++i) {
+    ids.push_back(m.Add((i % 3 == 0) ? M::LABEL : M::PUSH_BUTTON, M::Box()));
+  }
+  LayoutGrid(m, ids, 0, 0, COLUMNS, CELL_W, CELL_H, GAP);
+
+  std::vector<M::Box> dirty;
+  m.TakeDirty(dirty);
+
+  const int width = COLUMNS * (CELL_W + GAP);
+  const int height = (CONTROLS / COLUMNS) * (CELL_H + GAP);
+  unsigned long long hits = 0;
+
+  unit::Time("HitTest", HIT_TESTS, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      int x = (int) ((i * 7919) % width), y = (int) ((i * 104729) % height);
+      hits += (m.HitTest(x, y) != M::INVALID_ID);
+    }
+  });
+
+  std::vector<M::Id> out;
+  unsigned long long found = 0;
+
+  // About a screenful: 1280x720 covers some 400 controls
+  unit::Time("Query of a 1280x720 view", QUERIES, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      M::Box view = { (int) ((i * 7919) % (width - 1280)), (int) ((i * 104729) % (height - 720)), 1280, 720 };
+      m.Query(view, out);
+      found += out.size();
+    }
+  });
+
+  unit::Time("SetBounds moving a control a cell over", QUERIES, [&](std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) {
+      M::Id id = ids[(std::size_t) (i % CONTROLS)];
+      M::Box b = m.Bounds(id);
+      b.x += (i & 1) ? -(CELL_W + GAP) : (CELL_W + GAP);
+      m.SetBounds(id, b);
+    }
+    dirty.clear();
+    m.TakeDirty(dirty);
+  });
+
+  CHECK(hits > 0);
+  CHECK(found / QUERIES > 300);
+}
@@ -0,0 +1,358 @@
+#include "unit.hpp"
+#include "windowless-model.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace jwt;
+
+namespace {
+  typedef WindowlessModel M;
+
+  // Deterministic pseudo-random numbers for the comparison test
+  struct Lcg {
+    std::uint32_t state;
+
+    explicit Lcg(std::uint32_t seed) : state(seed) {}
+
+    std::uint32_t Next(std::uint32_t bound) {
+      state = state * 1664525u + 1013904223u;
+      return (state >> 8) % bound;
+    }
+
+    int Between(int lo, int hi) {
+      return lo + (int) Next((std::uint32_t) (hi - lo));
+    }
+  };
+
+  M::Box B(int x, int y, int w, int h) {
+    M::Box b = { x, y, w, h };
+    return b;
+  }
+
+  // What the model should hold, the slow way: live controls bottom first
+  struct Naive {
+    std::vector<M::Id> ids;
+
+    M::Id HitTest(const M& m, int x, int y) const {
+      for (auto i = ids.rbegin(); i != ids.rend(); ++i) {
+        if (m.Has(*i, M::VISIBLE) && m.Bounds(*i).Contains(x, y)) {
+          return *i;
+        }
+      }
+      return M::INVALID_ID;
+    }
+
+    std::vector<M::Id> Query(const M& m, const M::Box& area) const {
+      std::vector<M::Id> out;
+      if (area.Empty()) {
+        return out;
+      }
+      for (M::Id id : ids) {
+        if (m.Has(id, M::VISIBLE) && m.Bounds(id).Intersects(area)) {
+          out.push_back(id);
+        }
+      }
+      return out;
+    }
+
+    void ToFront(M::Id id) {
+      ids.erase(std::find(ids.begin(), ids.end(), id));
+      ids.push_back(id);
+    }
+  };
+
+  M::Box RandomBox(Lcg& rng) {
+    // Around the origin, so negative coordinates & cell edges get covered;
+    // mostly small, some spanning several cells
+    int size = (rng.Next(10) == 0) ? 300 : 60;
+    return B(rng.Between(-400, 400), rng.Between(-400, 400), 1 + (int) rng.Next(size), 1 + (int) rng.Next(size));
+  }
+}
+
+TEST(AddedControlsHaveDefaults) {
+  M m;
+  M::Id b = m.Add(M::PUSH_BUTTON, B(0, 0, 10, 10), L"OK");
+  M::Id l = m.Add(M::LABEL, B(0, 20, 10, 10));
+
+  CHECK(m.Valid(b) && m.Valid(l));
+  CHECK_EQUAL(2u, m.Size());
+  CHECK(m.Has(b, M::VISIBLE | M::ENABLED | M::FOCUSABLE));
+  CHECK(m.Has(l, M::VISIBLE | M::ENABLED));
+  CHECK(!m.Has(l, M::FOCUSABLE));
+  CHECK(m.Text(b) == L"OK");
+  CHECK_EQUAL((unsigned int) M::LABEL, m.Kind(l));
+}
+
+TEST(RemovedIdsStayInvalidWhenTheSlotIsReused) {
+  M m;
+  M::Id a = m.Add(M::PUSH_BUTTON, B(0, 0, 10, 10), L"a");
+  M::Id b = m.Add(M::PUSH_BUTTON, B(20, 0, 10, 10), L"b");
+
+  m.Remove(a);
+  CHECK(!m.Valid(a));
+  CHECK_EQUAL(1u, m.Size());
+
+  // The slot is reused under a new generation
+  M::Id c = m.Add(M::CHECK_BOX, B(40, 0, 10, 10), L"c");
+  CHECK(c != a);
+  CHECK_EQUAL(a & 0xFFFFFFFFu, c & 0xFFFFFFFFu);
+  CHECK(m.Valid(c) && !m.Valid(a));
+  CHECK(m.Text(c) == L"c");
+
+  // The old id finds nothing where it was, & removing it again is harmless
+  CHECK_EQUAL(M::INVALID_ID, m.HitTest(5, 5));
+  m.Remove(a);
+  CHECK(m.Valid(c) && m.Valid(b));
+  CHECK_EQUAL(2u, m.Size());
+
+  CHECK(!m.Valid(M::INVALID_ID));
+  CHECK(!m.Valid(((M::Id) 7 << 32) | 1000));
+}
+
+TEST(ClearRemovesEverything) {
+  M m;
+  std::vector<M::Id> ids;
+  for (int i = 0; i < 10; ++i) {
+    ids.push_back(m.Add(M::PUSH_BUTTON, B(i * 10, 0, 10, 10)));
+  }
+  m.SetFocus(ids[3]);
+
+  m.Clear();
+  CHECK_EQUAL(0u, m.Size());
+  CHECK_EQUAL(M::INVALID_ID, m.Focus());
+  for (M::Id id : ids) {
+    CHECK(!m.Valid(id));
+  }
+
+  std::vector<M::Id> out;
+  m.Query(B(-1000, -1000, 2000, 2000), out);
+  CHECK(out.empty());
+}
+
+TEST(HitTestFindsTheTopmostVisible) {
+  M m;
+  M::Id under = m.Add(M::PUSH_BUTTON, B(0, 0, 100, 100));
+  M::Id over = m.Add(M::PUSH_BUTTON, B(50, 50, 100, 100));
+
+  CHECK_EQUAL(under, m.HitTest(10, 10));
+  CHECK_EQUAL(over, m.HitTest(60, 60));
+
+  // Edges: right & bottom are outside
+  CHECK_EQUAL(over, m.HitTest(149, 149));
+  CHECK_EQUAL(M::INVALID_ID, m.HitTest(150, 60));
+
+  m.BringToFront(under);
+  CHECK_EQUAL(under, m.HitTest(60, 60));
+
+  m.SetState(under, M::VISIBLE, false);
+  CHECK_EQUAL(over, m.HitTest(60, 60));
+  CHECK_EQUAL(M::INVALID_ID, m.HitTest(10, 10));
+}
+
+TEST(NegativeCoordinates) {
+  M m;
+  // Straddles the origin, & so cells -1 & 0 on both axes
+  M::Id a = m.Add(M::PUSH_BUTTON, B(-10, -10, 20, 20));
+  M::Id b = m.Add(M::PUSH_BUTTON, B(-200, -130, 5, 5));
+
+  CHECK_EQUAL(a, m.HitTest(-1, -1));
+  CHECK_EQUAL(a, m.HitTest(-10, 9));
+  CHECK_EQUAL(M::INVALID_ID, m.HitTest(-11, 0));
+  CHECK_EQUAL(b, m.HitTest(-196, -126));
+  CHECK_EQUAL(M::INVALID_ID, m.HitTest(-195, -126));
+
+  // The cell just left of the origin isn't confused with the one right of it
+  m.Add(M::PUSH_BUTTON, B(1, 1, 5, 5));
+  CHECK_EQUAL(M::INVALID_ID, m.HitTest(-63, -63));
+
+  std::vector<M::Id> out;
+  m.Query(B(-300, -300, 250, 250), out);
+  CHECK(out.size() == 1 && out[0] == b);
+
+  m.Query(B(-5, -5, 3, 3), out);
+  CHECK(out.size() == 1 && out[0] == a);
+}
+
+TEST(QueryIsBottomFirst) {
+  M m;
+  M::Id a = m.Add(M::PUSH_BUTTON, B(0, 0, 200, 200));
+  M::Id b = m.Add(M::PUSH_BUTTON, B(10, 10, 10, 10));
+  M::Id c = m.Add(M::PUSH_BUTTON, B(150, 150, 10, 10));
+
+  std::vector<M::Id> out;
+  m.Query(B(0, 0, 300, 300), out);
+  CHECK(out == (std::vector<M::Id>{ a, b, c }));
+
+  m.BringToFront(a);
+  m.Query(B(0, 0, 300, 300), out);
+  CHECK(out == (std::vector<M::Id>{ b, c, a }));
+
+  // a spans several cells but is listed once
+  m.Query(B(100, 100, 100, 100), out);
+  CHECK(out == (std::vector<M::Id>{ c, a }));
+
+  m.Query(B(0, 0, 0, 10), out);
+  CHECK(out.empty());
+}
+
+TEST(MatchesABruteForceSearch) {
+  M m;
+  Naive naive;
+  Lcg rng(11);
+  std::vector<M::Id> out;
+
+  for (int step = 0; step < 3000; ++step) {
+    std::uint32_t op = rng.Next(10);
+
+    if (op < 4 || naive.ids.empty()) {
+      naive.ids.push_back(m.Add(M::PUSH_BUTTON, RandomBox(rng)));
+    }
+    else {
+      M::Id id = naive.ids[rng.Next((std::uint32_t) naive.ids.size())];
+
+      switch (op) {
+      case 4:
+        m.Remove(id);
+        naive.ids.erase(std::find(naive.ids.begin(), naive.ids.end(), id));
+        break;
+      case 5:
+      case 6:
+        m.SetBounds(id, RandomBox(rng));
+        break;
+      case 7:
+        m.BringToFront(id);
+        naive.ToFront(id);
+        break;
+      default:
+        m.SetState(id, M::VISIBLE, rng.Next(3) != 0);
+        break;
+      }
+    }
+
+    CHECK_EQUAL(naive.ids.size(), m.Size());
+
+    for (int q = 0; q < 8; ++q) {
+      int x = rng.Between(-500, 500), y = rng.Between(-500, 500);
+      if (m.HitTest(x, y) != naive.HitTest(m, x, y)) {
+        unit::Fail(__FILE__, __LINE__, "HitTest disagrees at step " + std::to_string(step));
+        return;
+      }
+    }
+
+    M::Box area = B(rng.Between(-500, 500), rng.Between(-500, 500), (int) rng.Next(400), (int) rng.Next(400));
+    if (rng.Next(20) == 0) {
+      area = B(-100000, -100000, 200000, 200000);
+    }
+
+    m.Query(area, out);
+    if (out != naive.Query(m, area)) {
+      unit::Fail(__FILE__, __LINE__, "Query disagrees at step " + std::to_string(step));
+      return;
+    }
+  }
+}
+
+TEST(FocusMovesInStackingOrderAndWraps) {
+  M m;
+  M::Id a = m.Add(M::PUSH_BUTTON, B(0, 0, 10, 10));
+  M::Id label = m.Add(M::LABEL, B(20, 0, 10, 10));
+  M::Id b = m.Add(M::PUSH_BUTTON, B(40, 0, 10, 10));
+  M::Id c = m.Add(M::CHECK_BOX, B(60, 0, 10, 10));
+  (void) label;
+
+  CHECK_EQUAL(M::INVALID_ID, m.Focus());
+
+  // Nothing focused: forwards starts at the first, backwards at the last
+  CHECK_EQUAL(a, m.NextFocus(false, false));
+  CHECK_EQUAL(c, m.NextFocus(true, false));
+
+  CHECK_EQUAL(a, m.FocusNext());
+  CHECK_EQUAL(b, m.FocusNext());      // the label is skipped
+  CHECK_EQUAL(c, m.FocusNext());
+  CHECK_EQUAL(a, m.FocusNext());      // wraps
+  CHECK_EQUAL(a, m.Focus());
+
+  CHECK_EQUAL(c, m.FocusNext(true));  // wraps backwards
+  CHECK_EQUAL(b, m.FocusNext(true));
+  CHECK_EQUAL(a, m.FocusNext(true));
+}
+
+TEST(NextFocusWithoutWrapStopsAtTheEnds) {
+  M m;
+  M::Id a = m.Add(M::PUSH_BUTTON, B(0, 0, 10, 10));
+  M::Id b = m.Add(M::PUSH_BUTTON, B(20, 0, 10, 10));
+
+  m.SetFocus(b);
+  CHECK_EQUAL(M::INVALID_ID, m.NextFocus(false, false));
+  CHECK_EQUAL(a, m.NextFocus(false, true));
+  CHECK_EQUAL(a, m.NextFocus(true, false));
+
+  // Asking doesn't move anything
+  CHECK_EQUAL(b, m.Focus());
+
+  m.SetFocus(a);
+  CHECK_EQUAL(M::INVALID_ID, m.NextFocus(true, false));
+  CHECK_EQUAL(b, m.NextFocus(false, false));
+}
+
+TEST(FocusSkipsControlsThatCantTakeIt) {
+  M m;
+  M::Id a = m.Add(M::PUSH_BUTTON, B(0, 0, 10, 10));
+  M::Id b = m.Add(M::PUSH_BUTTON, B(20, 0, 10, 10));
+  M::Id c = m.Add(M::PUSH_BUTTON, B(40, 0, 10, 10));
+
+  m.SetState(b, M::ENABLED, false);
+  CHECK(!m.SetFocus(b));
+
+  m.SetFocus(a);
+  CHECK_EQUAL(c, m.FocusNext());
+
+  // Hiding the focused control drops the focus
+  m.SetState(c, M::VISIBLE, false);
+  CHECK_EQUAL(M::INVALID_ID, m.Focus());
+  CHECK_EQUAL(a, m.FocusNext());
+  CHECK_EQUAL(a, m.FocusNext());
+
+  m.SetState(a, M::FOCUSABLE, false);
+  CHECK_EQUAL(M::INVALID_ID, m.FocusNext());
+  CHECK_EQUAL(M::INVALID_ID, m.NextFocus(false, true));
+}
+
+TEST(ChangesRecordTheAreasToRepaint) {
+  M m;
+  M::Id a = m.Add(M::PUSH_BUTTON, B(0, 0, 10, 10));
+
+  std::vector<M::Box> dirty;
+  m.TakeDirty(dirty);
+  CHECK(dirty.size() == 1 && dirty[0] == B(0, 0, 10, 10));
+  CHECK(!m.Dirty());
+
+  // A move repaints where it was & where it is
+  dirty.clear();
+  m.SetBounds(a, B(50, 50, 10, 10));
+  m.TakeDirty(dirty);
+  CHECK(dirty.size() == 2 && dirty[0] == B(0, 0, 10, 10) && dirty[1] == B(50, 50, 10, 10));
+
+  // No-op changes record nothing
+  m.SetBounds(a, B(50, 50, 10, 10));
+  m.SetText(a, L"");
+  m.SetState(a, M::VISIBLE, true);
+  CHECK(!m.Dirty());
+}
+
+TEST(LayoutGridPlacesInRows) {
+  M m;
+  std::vector<M::Id> ids;
+  for (int i = 0; i < 5; ++i) {
+    ids.push_back(m.Add(M::PUSH_BUTTON, B(0, 0, 1, 1)));
+  }
+
+  LayoutGrid(m, ids, 10, 20, 2, 30, 15, 5);
+
+  CHECK(m.Bounds(ids[0]) == B(10, 20, 30, 15));
+  CHECK(m.Bounds(ids[1]) == B(45, 20, 30, 15));
+  CHECK(m.Bounds(ids[2]) == B(10, 40, 30, 15));
+  CHECK(m.Bounds(ids[4]) == B(10, 60, 30, 15));
+  CHECK_EQUAL(ids[3], m.HitTest(50, 45));
+}